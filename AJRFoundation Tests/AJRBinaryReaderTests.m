@@ -0,0 +1,224 @@
+/*
+ AJRBinaryReaderTests.m
+ AJRFoundation
+
+ Copyright © 2023, AJ Raftis and AJRFoundation authors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of AJRFoundation nor the names of its contributors may be
+   used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL AJ RAFTIS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import <XCTest/XCTest.h>
+
+#import <AJRFoundation/AJRFoundation.h>
+
+@interface AJRBinaryReaderTests : XCTestCase
+
+@end
+
+@implementation AJRBinaryReaderTests
+
+- (void)testRoundTrip {
+    AJRBinaryWriter *writer = [AJRBinaryWriter binaryWriter];
+    [writer appendInt8:-5];
+    [writer appendUInt8:250];
+    [writer appendInt16:-1234 endianness:AJREndiannessLittle];
+    [writer appendUInt16:0xBEEF];
+    [writer appendInt32:-123456789];
+    [writer appendUInt32:0xDEADBEEF endianness:AJREndiannessLittle];
+    [writer appendInt64:-1234567890123456789];
+    [writer appendUInt64:0x0102030405060708 endianness:AJREndiannessLittle];
+    [writer appendFloat:3.5f];
+    [writer appendDouble:-2.25 endianness:AJREndiannessLittle];
+
+    NSData *data = writer.data;
+    XCTAssert(data.length == 1 + 1 + 2 + 2 + 4 + 4 + 8 + 8 + 4 + 8);
+    // Spot check the byte order actually written.
+    const uint8_t *bytes = data.bytes;
+    XCTAssert(bytes[4] == 0xBE && bytes[5] == 0xEF);
+    XCTAssert(bytes[10] == 0xEF && bytes[13] == 0xDE);
+
+    AJRBinaryReader *reader = [AJRBinaryReader binaryReaderWithData:data];
+    NSError *localError = nil;
+    int8_t i8; uint8_t u8; int16_t i16; uint16_t u16; int32_t i32; uint32_t u32; int64_t i64; uint64_t u64; float f; double d;
+    XCTAssert([reader readInt8:&i8 error:&localError] && i8 == -5);
+    XCTAssert([reader readUInt8:&u8 error:&localError] && u8 == 250);
+    XCTAssert([reader readInt16:&i16 endianness:AJREndiannessLittle error:&localError] && i16 == -1234);
+    XCTAssert([reader readUInt16:&u16 error:&localError] && u16 == 0xBEEF);
+    XCTAssert([reader readInt32:&i32 error:&localError] && i32 == -123456789);
+    XCTAssert([reader readUInt32:&u32 endianness:AJREndiannessLittle error:&localError] && u32 == 0xDEADBEEF);
+    XCTAssert([reader readInt64:&i64 error:&localError] && i64 == -1234567890123456789);
+    XCTAssert([reader readUInt64:&u64 endianness:AJREndiannessLittle error:&localError] && u64 == 0x0102030405060708);
+    XCTAssert([reader readFloat:&f error:&localError] && f == 3.5f);
+    XCTAssert([reader readDouble:&d endianness:AJREndiannessLittle error:&localError] && d == -2.25);
+    XCTAssert(reader.isAtEnd && localError == nil);
+
+    // And the stream functions agree with the cursor on the layout.
+    AJRBinaryReader *streamReader = [AJRBinaryReader binaryReaderWithData:data];
+    XCTAssert([streamReader skipBytes:4 error:&localError]);
+    XCTAssert(AJRReadUInt16(streamReader, &u16, AJREndiannessBig, &localError) && u16 == 0xBEEF);
+    XCTAssert([streamReader skipBytes:4 error:&localError]);
+    XCTAssert(AJRReadUInt32(streamReader, &u32, AJREndiannessLittle, &localError) && u32 == 0xDEADBEEF);
+}
+
+- (void)testBounds {
+    uint8_t bytes[] = { 1, 2, 3 };
+    AJRBinaryReader *reader = [[AJRBinaryReader alloc] initWithBytesNoCopy:bytes length:sizeof(bytes)];
+    NSError *localError = nil;
+    uint32_t value = 0;
+
+    XCTAssert(![reader readUInt32:&value error:&localError]);
+    XCTAssert(localError != nil && [localError.domain isEqualToString:AJRStreamErrorDomain]);
+    // A failed read doesn't move the cursor.
+    XCTAssert(reader.offset == 0);
+
+    localError = nil;
+    const uint8_t *pointer = [reader readBytesNoCopyOfLength:2 error:&localError];
+    XCTAssert(pointer == bytes && reader.remainingLength == 1);
+    XCTAssert(![reader seekToOffset:4 error:&localError] && localError != nil);
+    XCTAssert([reader seekToOffset:3 error:NULL] && reader.isAtEnd);
+
+    size_t readLength = 1;
+    XCTAssert([reader readBytes:&value length:sizeof(value) bytesRead:&readLength error:NULL] && readLength == 0);
+    XCTAssert(![reader readUInt32s:&value count:SIZE_MAX endianness:AJREndiannessBig error:NULL]);
+}
+
+- (void)testVariableLengthIntegers {
+    AJRBinaryWriter *writer = [AJRBinaryWriter binaryWriter];
+    uint64_t unsignedValues[] = { 0, 1, 127, 128, 300, 16383, 16384, UINT32_MAX, UINT64_MAX };
+    int64_t signedValues[] = { 0, -1, 1, -64, 64, INT64_MIN, INT64_MAX };
+
+    for (NSInteger x = 0; x < AJRCountOf(unsignedValues); x++) {
+        [writer appendVarUInt:unsignedValues[x]];
+    }
+    for (NSInteger x = 0; x < AJRCountOf(signedValues); x++) {
+        [writer appendVarInt:signedValues[x]];
+    }
+    // 300 is the classic example.
+    XCTAssert(writer.bytes[5] == 0xAC && writer.bytes[6] == 0x02);
+
+    AJRBinaryReader *reader = [AJRBinaryReader binaryReaderWithData:writer.data];
+    NSError *localError = nil;
+    for (NSInteger x = 0; x < AJRCountOf(unsignedValues); x++) {
+        uint64_t value;
+        XCTAssert([reader readVarUInt:&value error:&localError] && value == unsignedValues[x]);
+    }
+    for (NSInteger x = 0; x < AJRCountOf(signedValues); x++) {
+        int64_t value;
+        XCTAssert([reader readVarInt:&value error:&localError] && value == signedValues[x]);
+    }
+    XCTAssert(reader.isAtEnd && localError == nil);
+
+    uint64_t value;
+    uint8_t truncated[] = { 0x80, 0x80 };
+    reader = [[AJRBinaryReader alloc] initWithBytesNoCopy:truncated length:sizeof(truncated)];
+    XCTAssert(![reader readVarUInt:&value error:&localError] && localError != nil && reader.offset == 0);
+
+    uint8_t overflow[] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x02 };
+    localError = nil;
+    reader = [[AJRBinaryReader alloc] initWithBytesNoCopy:overflow length:sizeof(overflow)];
+    XCTAssert(![reader readVarUInt:&value error:&localError] && localError != nil);
+}
+
+- (void)testArrays {
+    uint32_t values[1000];
+    double doubles[1000];
+    for (NSInteger x = 0; x < 1000; x++) {
+        values[x] = (uint32_t)(x * 2654435761u);
+        doubles[x] = x / 7.0;
+    }
+
+    NSMutableData *data = [NSMutableData dataWithBytes:"hdr" length:3];
+    AJRBinaryWriter *writer = [[AJRBinaryWriter alloc] initWithMutableData:data];
+    // Odd offsets, so nothing is aligned.
+    [writer appendUInt32s:values count:1000 endianness:AJREndiannessBig];
+    [writer appendDoubles:doubles count:1000 endianness:AJREndiannessLittle];
+    XCTAssert(writer.data == data && data.length == 3 + 1000 * 4 + 1000 * 8);
+
+    AJRBinaryReader *reader = [AJRBinaryReader binaryReaderWithData:data];
+    uint32_t readValues[1000];
+    double readDoubles[1000];
+    uint32_t first;
+    XCTAssert([reader skipBytes:3 error:NULL]);
+    XCTAssert([reader readUInt32s:readValues count:1000 endianness:AJREndiannessBig error:NULL]);
+    XCTAssert([reader readDoubles:readDoubles count:1000 endianness:AJREndiannessLittle error:NULL]);
+    XCTAssert(memcmp(values, readValues, sizeof(values)) == 0);
+    XCTAssert(memcmp(doubles, readDoubles, sizeof(doubles)) == 0);
+
+    [reader seekToOffset:3 error:NULL];
+    XCTAssert([reader readUInt32:&first endianness:AJREndiannessBig error:NULL] && first == values[0]);
+    // Not enough left, so nothing is read.
+    XCTAssert([reader seekToOffset:data.length - 8 error:NULL]);
+    XCTAssert(![reader readUInt32s:readValues count:1000 endianness:AJREndiannessBig error:NULL] && reader.offset == data.length - 8);
+
+    [writer removeAllBytes];
+    XCTAssert(writer.length == 0 && writer.data.length == 0);
+}
+
+- (void)testCursorPerformance {
+    AJRBinaryWriter *writer = [AJRBinaryWriter binaryWriterWithCapacity:1000000 * 6];
+    for (uint32_t x = 0; x < 1000000; x++) {
+        [writer appendUInt32:x];
+        [writer appendUInt16:(uint16_t)x];
+    }
+    NSData *data = writer.data;
+
+    [self measureBlock:^{
+        AJRBinaryReader *reader = [AJRBinaryReader binaryReaderWithData:data];
+        uint64_t sum = 0;
+        uint32_t value32;
+        uint16_t value16;
+        while ([reader readUInt32:&value32 error:NULL] && [reader readUInt16:&value16 error:NULL]) {
+            sum += value32 + value16;
+        }
+        XCTAssert(sum > 0);
+    }];
+}
+
+- (void)testStreamPerformance {
+    // The same decode as testCursorPerformance, through the stream functions, for comparison.
+    AJRBinaryWriter *writer = [AJRBinaryWriter binaryWriterWithCapacity:1000000 * 6];
+    for (uint32_t x = 0; x < 1000000; x++) {
+        [writer appendUInt32:x];
+        [writer appendUInt16:(uint16_t)x];
+    }
+    NSData *data = writer.data;
+
+    [self measureBlock:^{
+        NSInputStream *stream = [NSInputStream inputStreamWithData:data];
+        [stream open];
+        uint64_t sum = 0;
+        uint32_t value32;
+        uint16_t value16;
+        for (NSInteger x = 0; x < 1000000; x++) {
+            AJRReadUInt32(stream, &value32, AJREndiannessBig, NULL);
+            AJRReadUInt16(stream, &value16, AJREndiannessBig, NULL);
+            sum += value32 + value16;
+        }
+        XCTAssert(sum > 0);
+        [stream close];
+    }];
+}
+
+@end
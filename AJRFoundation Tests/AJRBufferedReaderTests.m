@@ -0,0 +1,268 @@
+/*
+ AJRBufferedReaderTests.m
+ AJRFoundation
+
+ Copyright © 2023, AJ Raftis and AJRFoundation authors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of AJRFoundation nor the names of its contributors may be
+   used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL AJ RAFTIS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import <XCTest/XCTest.h>
+
+#import <AJRFoundation/AJRFoundation.h>
+
+#import "AJRBufferedReaderP.h"
+
+#import <fcntl.h>
+
+@interface AJRBufferedReaderTests : XCTestCase
+
+@end
+
+@implementation AJRBufferedReaderTests
+
+- (AJRBufferedReader *)_readerForString:(NSString *)string encoding:(NSStringEncoding)encoding bufferSize:(size_t)bufferSize {
+    NSInputStream *input = [NSInputStream inputStreamWithData:[string dataUsingEncoding:encoding]];
+    input.encoding = encoding;
+    return [[AJRBufferedReader alloc] initWithInputStream:input bufferSize:bufferSize];
+}
+
+- (NSString *)_temporaryFileWithLineCount:(NSInteger)count {
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
+    NSMutableString *string = [NSMutableString string];
+    for (NSInteger x = 0; x < count; x++) {
+        [string appendFormat:@"Line %ld: The quick brown fox jumps over the lazy dog.\n", (long)x];
+    }
+    [string writeToFile:path atomically:NO encoding:NSUTF8StringEncoding error:NULL];
+    return path;
+}
+
+- (void)testLineEndings {
+    NSString *longLine = [@"" stringByPaddingToLength:100 withString:@"0123456789" startingAtIndex:0];
+    NSString *string = [NSString stringWithFormat:@"one\ntwo\r\nthree\rfour\r\r%@\nlast", longLine];
+    NSError *localError = nil;
+
+    // Use a tiny buffer, so that lines and line endings span refills.
+    for (size_t bufferSize = 16; bufferSize <= 64; bufferSize += 3) {
+        AJRBufferedReader *reader = [self _readerForString:string encoding:NSUTF8StringEncoding bufferSize:bufferSize];
+        XCTAssertEqualObjects([reader readLineReturningError:&localError], @"one");
+        XCTAssertEqualObjects([reader readLineReturningError:&localError], @"two");
+        XCTAssertEqualObjects([reader readLineReturningError:&localError], @"three");
+        XCTAssertEqualObjects([reader readLineReturningError:&localError], @"four");
+        XCTAssertEqualObjects([reader readLineReturningError:&localError], @"");
+        XCTAssertEqualObjects([reader readLineReturningError:&localError], longLine);
+        XCTAssertEqualObjects([reader readLineReturningError:&localError], @"last");
+        XCTAssert([reader readLineReturningError:&localError] == nil && localError == nil);
+        XCTAssert(reader.offset == [string lengthOfBytesUsingEncoding:NSUTF8StringEncoding]);
+    }
+}
+
+- (void)testWideEncodings {
+    NSString *string = @"uno\ndós\r\ntrês\rquatro";
+    NSError *localError = nil;
+
+    for (NSNumber *encoding in @[@(NSUTF16LittleEndianStringEncoding), @(NSUTF16BigEndianStringEncoding), @(NSUTF32LittleEndianStringEncoding)]) {
+        AJRBufferedReader *reader = [self _readerForString:string encoding:encoding.unsignedIntegerValue bufferSize:16];
+        XCTAssertEqualObjects([reader readLineReturningError:&localError], @"uno");
+        XCTAssertEqualObjects([reader readLineReturningError:&localError], @"dós");
+        XCTAssertEqualObjects([reader readLineReturningError:&localError], @"três");
+        XCTAssertEqualObjects([reader readLineReturningError:&localError], @"quatro");
+        XCTAssert([reader readLineReturningError:&localError] == nil && localError == nil);
+    }
+}
+
+- (void)testCharacters {
+    NSError *localError = nil;
+    AJRBufferedReader *reader = [self _readerForString:@"aé€😀" encoding:NSUTF8StringEncoding bufferSize:16];
+    uint32_t character;
+    size_t bytesRead;
+
+    XCTAssert([reader readCharacter:&character bytesRead:&bytesRead error:&localError] && character == 'a' && bytesRead == 1);
+    XCTAssert([reader readCharacter:&character bytesRead:&bytesRead error:&localError] && character == 0xE9 && bytesRead == 2);
+    XCTAssert([reader readCharacter:&character bytesRead:&bytesRead error:&localError] && character == 0x20AC && bytesRead == 3);
+    XCTAssert([reader readCharacter:&character bytesRead:&bytesRead error:&localError] && character == 0x1F600 && bytesRead == 4);
+    XCTAssert([reader readCharacter:&character bytesRead:&bytesRead error:&localError] && bytesRead == 0);
+    XCTAssert(localError == nil);
+
+    // Switching encodings mid-stream should apply to the bytes not yet consumed.
+    reader = [self _readerForString:@"aé" encoding:NSISOLatin1StringEncoding bufferSize:16];
+    reader.encoding = NSUTF16LittleEndianStringEncoding;
+    reader.encoding = NSISOLatin1StringEncoding;
+    XCTAssert([reader readCharacter:&character bytesRead:&bytesRead error:&localError] && character == 'a');
+    XCTAssert([reader readCharacter:&character bytesRead:&bytesRead error:&localError] && character == 0xE9);
+
+    // Invalid and truncated UTF-8.
+    uint8_t invalid[] = { 0xEE, 0xEE, 0xEE, 0xEE };
+    NSInputStream *input = [NSInputStream inputStreamWithData:[NSData dataWithBytes:invalid length:sizeof(invalid)]];
+    reader = [[AJRBufferedReader alloc] initWithInputStream:input];
+    XCTAssert(![reader readCharacter:&character bytesRead:&bytesRead error:&localError] && localError != nil);
+    localError = nil;
+    input = [NSInputStream inputStreamWithData:[NSData dataWithBytes:invalid length:1]];
+    reader = [[AJRBufferedReader alloc] initWithInputStream:input];
+    XCTAssert([reader readCharacter:NULL error:&localError] == (size_t)-1 && localError != nil);
+}
+
+- (void)testMixedReads {
+    NSError *localError = nil;
+    NSMutableData *data = [[@"header\n" dataUsingEncoding:NSUTF8StringEncoding] mutableCopy];
+    uint32_t value = 0x01020304;
+    [data appendBytes:&value length:sizeof(value)];
+    [data appendData:[@"trailer\n" dataUsingEncoding:NSUTF8StringEncoding]];
+
+    AJRBufferedReader *reader = [[AJRBufferedReader alloc] initWithInputStream:[NSInputStream inputStreamWithData:data]];
+    uint32_t read = 0;
+    XCTAssertEqualObjects([reader readLineReturningError:&localError], @"header");
+    XCTAssert([reader readUInt32:&read endianness:AJRGetCurrentArchitectureEndianness() error:&localError] && read == value);
+    XCTAssertEqualObjects([reader readLineReturningError:&localError], @"trailer");
+    XCTAssert(localError == nil);
+}
+
+- (void)testLinesInterleavedWithOtherReads {
+    NSError *localError = nil;
+
+    // Reading bytes or characters after a line consumes past the '\n' the reader remembers, and the refill that follows has to forget it. Vary the line length, so that the refill lands everywhere in the buffer.
+    for (NSInteger length = 1; length <= 40; length++) {
+        NSString *line = [@"" stringByPaddingToLength:length withString:@"abcdefghij" startingAtIndex:0];
+        NSData *data = [AJRFormat(@"%@\n0123456789%@\nxyz%@\n", line, line, line) dataUsingEncoding:NSUTF8StringEncoding];
+
+        for (NSInteger exact = 0; exact < 2; exact++) {
+            NSInputStream *input = [NSInputStream inputStreamWithData:data];
+            AJRBufferedReader *reader;
+            if (exact) {
+                // Streams can't seek, so the reader attached to one only reads the bytes it needs.
+                [input open];
+                reader = AJRBufferedReaderAttachedToReader((id <AJRByteReader>)input);
+            } else {
+                reader = [[AJRBufferedReader alloc] initWithInputStream:input bufferSize:16];
+            }
+
+            char bytes[10];
+            size_t bytesRead = 0;
+            uint32_t character;
+            XCTAssertEqualObjects([reader readLineReturningError:&localError], line);
+            XCTAssert([reader readBytes:bytes length:sizeof(bytes) bytesRead:&bytesRead error:&localError] && bytesRead == sizeof(bytes));
+            XCTAssert(memcmp(bytes, "0123456789", sizeof(bytes)) == 0);
+            XCTAssertEqualObjects([reader readLineReturningError:&localError], line);
+            XCTAssert([reader readCharacter:&character bytesRead:&bytesRead error:&localError] && character == 'x');
+            XCTAssert([reader readCharacter:&character bytesRead:&bytesRead error:&localError] && character == 'y');
+            XCTAssert([reader readCharacter:&character bytesRead:&bytesRead error:&localError] && character == 'z');
+            XCTAssertEqualObjects([reader readLineReturningError:&localError], line);
+            XCTAssert([reader readLineReturningError:&localError] == nil && localError == nil);
+        }
+    }
+}
+
+- (void)testDelimitedRecords {
+    NSError *localError = nil;
+    NSData *delimiter = [@"\r\n" dataUsingEncoding:NSUTF8StringEncoding];
+    NSData *data = [@"first\r\nsec\rond\n\r\nthird" dataUsingEncoding:NSUTF8StringEncoding];
+
+    // A tiny buffer makes sure delimiters straddling a refill are still found.
+    for (size_t bufferSize = 1; bufferSize <= 32; bufferSize++) {
+        AJRBufferedReader *reader = [[AJRBufferedReader alloc] initWithInputStream:[NSInputStream inputStreamWithData:data] bufferSize:bufferSize];
+        XCTAssertEqualObjects([reader readDataToDelimiter:delimiter consumeDelimiter:YES error:&localError], [@"first" dataUsingEncoding:NSUTF8StringEncoding]);
+        XCTAssertEqualObjects([reader readDataToDelimiter:delimiter consumeDelimiter:YES error:&localError], [@"sec\rond\n" dataUsingEncoding:NSUTF8StringEncoding]);
+        XCTAssertEqualObjects([reader readDataToDelimiter:delimiter consumeDelimiter:YES error:&localError], [@"third" dataUsingEncoding:NSUTF8StringEncoding]);
+        XCTAssert([reader readDataToDelimiter:delimiter consumeDelimiter:YES error:&localError] == nil && localError == nil);
+    }
+
+    AJRBufferedReader *reader = [[AJRBufferedReader alloc] initWithInputStream:[NSInputStream inputStreamWithData:data]];
+    XCTAssert([reader readDataToByte:'\n' consumeDelimiter:NO error:&localError].length == 6);
+    XCTAssert([reader readDataToByte:'\n' consumeDelimiter:NO error:&localError].length == 0);
+    XCTAssert([reader readDataToByte:'\n' consumeDelimiter:YES error:&localError].length == 0);
+    XCTAssert([reader readDataToDelimiter:[NSData data] consumeDelimiter:YES error:&localError] == nil && localError != nil);
+    XCTAssertEqualObjects(localError.domain, NSPOSIXErrorDomain);
+    XCTAssert(localError.code == EINVAL);
+}
+
+- (void)testFileHandleIsLeftAfterLine {
+    NSString *path = [self _temporaryFileWithLineCount:100];
+    NSFileHandle *handle = [NSFileHandle fileHandleForReadingAtPath:path];
+    NSError *localError = nil;
+
+    // AJRReadLine() reads ahead on seekable handles, so make sure it hands back what it didn't use.
+    XCTAssertEqualObjects([handle readLineReturningError:&localError], @"Line 0: The quick brown fox jumps over the lazy dog.");
+    XCTAssertEqualObjects([handle readLineReturningError:&localError], @"Line 1: The quick brown fox jumps over the lazy dog.");
+    NSData *data = [handle readDataOfLength:7];
+    XCTAssertEqualObjects([[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding], @"Line 2:");
+
+    NSInteger count = 0;
+    while ([handle readLineReturningError:&localError] != nil) {
+        count++;
+    }
+    XCTAssert(count == 98 && localError == nil);
+
+    [handle closeFile];
+    [[NSFileManager defaultManager] removeItemAtPath:path error:NULL];
+}
+
+- (void)testFileDescriptor {
+    NSString *path = [self _temporaryFileWithLineCount:1000];
+    AJRBufferedReader *reader = [AJRBufferedReader bufferedReaderWithFileDescriptor:open([path fileSystemRepresentation], O_RDONLY) closeOnDealloc:YES];
+    NSError *localError = nil;
+    NSInteger count = 0;
+    NSString *line;
+
+    while ((line = [reader readLineReturningError:&localError]) != nil) {
+        XCTAssertEqualObjects(line, AJRFormat(@"Line %ld: The quick brown fox jumps over the lazy dog.", (long)count));
+        count++;
+    }
+    XCTAssert(count == 1000 && localError == nil);
+
+    [[NSFileManager defaultManager] removeItemAtPath:path error:NULL];
+}
+
+- (void)testLineReadingPerformance {
+    NSString *path = [self _temporaryFileWithLineCount:200000];
+
+    [self measureBlock:^{
+        AJRBufferedReader *reader = [AJRBufferedReader bufferedReaderWithFileDescriptor:open([path fileSystemRepresentation], O_RDONLY) closeOnDealloc:YES];
+        NSInteger count = 0;
+        while ([reader readLineReturningError:NULL] != nil) {
+            count++;
+        }
+        XCTAssert(count == 200000);
+    }];
+
+    [[NSFileManager defaultManager] removeItemAtPath:path error:NULL];
+}
+
+- (void)testFileHandleLineReadingPerformance {
+    NSString *path = [self _temporaryFileWithLineCount:20000];
+
+    [self measureBlock:^{
+        NSFileHandle *handle = [NSFileHandle fileHandleForReadingAtPath:path];
+        NSInteger count = 0;
+        while ([handle readLineReturningError:NULL] != nil) {
+            count++;
+        }
+        XCTAssert(count == 20000);
+        [handle closeFile];
+    }];
+
+    [[NSFileManager defaultManager] removeItemAtPath:path error:NULL];
+}
+
+@end
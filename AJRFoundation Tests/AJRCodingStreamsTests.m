@@ -0,0 +1,137 @@
+/*
+ AJRCodingStreamsTests.m
+ AJRFoundation
+
+ Copyright © 2023, AJ Raftis and AJRFoundation authors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of AJRFoundation nor the names of its contributors may be
+   used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL AJ RAFTIS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import <XCTest/XCTest.h>
+
+#import <AJRFoundation/AJRFoundation.h>
+
+@interface AJRCodingStreamsTests : XCTestCase
+
+@end
+
+@implementation AJRCodingStreamsTests
+
+- (NSData *)sampleDataOfLength:(NSUInteger)length {
+    NSMutableData *data = [NSMutableData dataWithLength:length];
+    uint8_t *bytes = data.mutableBytes;
+    for (NSUInteger x = 0; x < length; x++) {
+        bytes[x] = (uint8_t)(x * 2654435761u >> 13);
+    }
+    return data;
+}
+
+// Feeds data to the coder in pieces of ever changing size.
+- (NSData *)code:(NSData *)data with:(id <AJRIncrementalCoder>)coder error:(NSError **)error {
+    NSMutableData *output = [NSMutableData data];
+    const uint8_t *bytes = data.bytes;
+    NSUInteger offset = 0;
+    NSUInteger size = 0;
+
+    while (offset < data.length) {
+        NSUInteger length = MIN(size++ % 71, data.length - offset);
+        if (![coder codeBytes:bytes + offset length:length intoData:output error:error]) {
+            return nil;
+        }
+        offset += length;
+    }
+    return [coder finishIntoData:output error:error] ? output : nil;
+}
+
+- (void)testBase64MatchesWholeData {
+    for (NSUInteger length = 0; length < 400; length += 7) {
+        NSData *data = [self sampleDataOfLength:length];
+        for (NSInteger lineBreak = 0; lineBreak < 5; lineBreak++) {
+            NSString *expected = [data ajr_base64EncodedStringWithLineBreakAtPosition:lineBreak];
+            NSData *encoded = [self code:data with:[[AJRBase64Encoder alloc] initWithLineBreakPosition:lineBreak] error:NULL];
+            XCTAssert([encoded isEqualToData:[expected dataUsingEncoding:NSASCIIStringEncoding]], @"length %ld, line break %ld", (long)length, (long)lineBreak);
+
+            NSData *decoded = [self code:encoded with:[[AJRBase64Decoder alloc] init] error:NULL];
+            XCTAssert([decoded isEqualToData:data]);
+        }
+    }
+
+    NSError *localError = nil;
+    XCTAssert([self code:[@"YWFh\nY" dataUsingEncoding:NSASCIIStringEncoding] with:[[AJRBase64Decoder alloc] init] error:&localError] == nil);
+    XCTAssert(localError != nil);
+}
+
+- (void)testUUMatchesWholeData {
+    for (NSUInteger length = 0; length < 400; length += 11) {
+        NSData *data = [self sampleDataOfLength:length];
+        NSString *expected = [data ajr_uuEncodedStringWithFilename:@"test" andPosixFilePermissions:0600];
+        NSData *encoded = [self code:data with:[[AJRUUEncoder alloc] initWithFilename:@"test" posixFilePermissions:0600] error:NULL];
+        XCTAssert([encoded isEqualToData:[expected dataUsingEncoding:NSASCIIStringEncoding]], @"length %ld", (long)length);
+
+        AJRUUDecoder *decoder = [[AJRUUDecoder alloc] init];
+        NSData *decoded = [self code:encoded with:decoder error:NULL];
+        XCTAssert([decoded isEqualToData:data]);
+        XCTAssert([decoder.filename isEqualToString:@"test"]);
+        XCTAssert(decoder.permissions == 0600);
+    }
+}
+
+- (void)testStreams {
+    NSData *data = [self sampleDataOfLength:100000];
+
+    // Encode through an output stream, a piece at a time.
+    NSOutputStream *memory = [NSOutputStream outputStreamToMemory];
+    AJRCodingOutputStream *encoding = [AJRCodingOutputStream outputStreamWithOutputStream:memory coder:[[AJRBase64Encoder alloc] initWithLineBreakPosition:19]];
+    [encoding open];
+    for (NSUInteger offset = 0; offset < data.length; offset += 1000) {
+        XCTAssert([encoding write:(const uint8_t *)data.bytes + offset maxLength:MIN(1000, data.length - offset)] == MIN(1000, data.length - offset));
+    }
+    [encoding close];
+    NSData *encoded = [memory propertyForKey:NSStreamDataWrittenToMemoryStreamKey];
+    XCTAssert([encoded isEqualToData:[[data ajr_base64EncodedStringWithLineBreakAtPosition:19] dataUsingEncoding:NSASCIIStringEncoding]]);
+
+    // And decode it back through an input stream.
+    AJRCodingInputStream *decoding = [AJRCodingInputStream inputStreamWithInputStream:[NSInputStream inputStreamWithData:encoded] coder:[[AJRBase64Decoder alloc] init]];
+    NSMutableData *decoded = [NSMutableData data];
+    uint8_t buffer[777];
+    NSInteger length;
+    [decoding open];
+    while ((length = [decoding read:buffer maxLength:sizeof(buffer)]) > 0) {
+        [decoded appendBytes:buffer length:length];
+    }
+    XCTAssert(length == 0);
+    XCTAssert(decoding.streamStatus == NSStreamStatusAtEnd);
+    [decoding close];
+    XCTAssert([decoded isEqualToData:data]);
+
+    // Errors from the coder come out of the stream.
+    decoding = [AJRCodingInputStream inputStreamWithInputStream:[NSInputStream inputStreamWithData:[@"YWFhY" dataUsingEncoding:NSASCIIStringEncoding]] coder:[[AJRBase64Decoder alloc] init]];
+    [decoding open];
+    XCTAssert([decoding read:buffer maxLength:sizeof(buffer)] == 3);
+    XCTAssert([decoding read:buffer maxLength:sizeof(buffer)] == -1);
+    XCTAssert(decoding.streamError != nil);
+}
+
+@end
@@ -0,0 +1,147 @@
+/*
+ AJRDateParserTests.m
+ AJRFoundation
+
+ Copyright © 2023, AJ Raftis and AJRFoundation authors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of AJRFoundation nor the names of its contributors may be
+   used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL AJ RAFTIS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import <XCTest/XCTest.h>
+
+#import <AJRFoundation/AJRFoundation.h>
+
+@interface AJRDateParserTests : XCTestCase
+
+@end
+
+@implementation AJRDateParserTests
+
+- (void)assertParser:(AJRDateParser *)parser matchesFunctionForString:(NSString *)string {
+    NSError *expectedError = nil;
+    NSError *error = nil;
+    NSDate *expected = AJRDateFromStringAndFormat(string, parser.format, parser.calendar, &expectedError);
+    NSDate *date = [parser dateFromString:string error:&error];
+
+    XCTAssertEqualObjects(date, expected, @"\"%@\" with format \"%@\"", string, parser.format);
+    XCTAssertEqual(error.code, expectedError.code, @"\"%@\" with format \"%@\"", string, parser.format);
+    XCTAssertEqualObjects(error.localizedDescription, expectedError.localizedDescription);
+
+    NSData *data = [string dataUsingEncoding:NSUTF8StringEncoding];
+    XCTAssertEqualObjects([parser dateFromUTF8Bytes:data.bytes length:data.length error:NULL], expected, @"\"%@\" as UTF-8", string);
+
+    unichar characters[string.length + 1];
+    [string getCharacters:characters range:(NSRange){0, string.length}];
+    XCTAssertEqualObjects([parser dateFromCharacters:characters length:string.length error:NULL], expected, @"\"%@\" as UTF-16", string);
+}
+
+- (void)testMatchesDateFromStringAndFormat {
+    NSArray<NSString *> *strings = @[@"", @"06", @"0616", @"061671", @"06161971", @"061", @"0616197", @"123456789", @" 0616 ",
+                                     @"6/16/71", @"6/16/1971", @"1971-6-16", @"June 16, 1971", @"June 16", @"June", @"Jun 1971", @"jUnE 16 71",
+                                     @"June 31, 1971", @"13/1/1971", @"0/1/1971", @"2/29/2000", @"2/29/1900", @"2/29/2024", @"12/31/1999",
+                                     @"Squidward 16", @"16 Squidward", @"16th of June", @"Dec 25, 1600", @"1/1/1200", @"3/8/2026", @"11/1/2026",
+                                     @"Juño 16, 1971"];
+    NSArray *formats = @[[NSNull null], @"%m/%d/%y", @"%d/%m/%Y", @"%y-%m-%d", @"%m %d", @"%m/%y", @"%B %e, %Y", @"", @"%H:%M"];
+
+    AJRLogSetOutputStream([NSOutputStream outputStreamToMemory], AJRLogLevelWarning);
+    for (id format in formats) {
+        AJRDateParser *parser = [[AJRDateParser alloc] initWithFormat:format == [NSNull null] ? nil : format];
+        for (NSString *string in strings) {
+            [self assertParser:parser matchesFunctionForString:string];
+        }
+    }
+    AJRLogSetOutputStream(nil, AJRLogLevelWarning);
+}
+
+- (void)testTimeZones {
+    NSArray *timeZones = @[[NSTimeZone timeZoneForSecondsFromGMT:0],
+                           [NSTimeZone timeZoneForSecondsFromGMT:-8 * 60 * 60],
+                           [NSTimeZone timeZoneWithName:@"America/Los_Angeles"],
+                           [NSTimeZone timeZoneWithName:@"America/Sao_Paulo"],
+                           [NSTimeZone timeZoneWithName:@"Asia/Kolkata"]];
+
+    for (NSTimeZone *timeZone in timeZones) {
+        NSCalendar *calendar = [[NSCalendar alloc] initWithCalendarIdentifier:NSCalendarIdentifierGregorian];
+        calendar.timeZone = timeZone;
+        AJRDateParser *parser = [[AJRDateParser alloc] initWithFormat:@"%m/%d/%Y" calendar:calendar];
+        // Sao Paulo has, in the past, started daylight saving time at midnight.
+        for (NSString *string in @[@"1/1/1970", @"3/10/2024", @"11/3/2024", @"10/15/2017", @"11/4/2018", @"2/29/2000", @"7/4/1776"]) {
+            [self assertParser:parser matchesFunctionForString:string];
+        }
+    }
+
+    NSCalendar *calendar = [[NSCalendar alloc] initWithCalendarIdentifier:NSCalendarIdentifierHebrew];
+    AJRDateParser *parser = [[AJRDateParser alloc] initWithFormat:@"%m/%d/%Y" calendar:calendar];
+    [self assertParser:parser matchesFunctionForString:@"6/16/5731"];
+}
+
+- (void)testReferenceDate {
+    AJRDateParser *parser = [[AJRDateParser alloc] initWithFormat:@"%m/%d/%Y"];
+    NSDate *expected = AJRDateFromStringAndFormat(@"6/16/1971", parser.format, parser.calendar, NULL);
+    NSError *error = nil;
+
+    parser.referenceDate = AJRDateFromStringAndFormat(@"3/1/1971", parser.format, parser.calendar, NULL);
+    // Missing fields come from the reference date, whether the string is parsed in place as ASCII, or has to take the slow path because it isn't ASCII.
+    for (NSString *string in @[@"6/16", @"June 16", @"6– 16", @"June\u00A016", @"Jun\u2009\u200916"]) {
+        XCTAssertEqualObjects([parser dateFromString:string error:&error], expected, @"\"%@\"", string);
+        XCTAssert(error == nil);
+
+        NSData *data = [string dataUsingEncoding:NSUTF8StringEncoding];
+        XCTAssertEqualObjects([parser dateFromUTF8Bytes:data.bytes length:data.length error:NULL], expected, @"\"%@\" as UTF-8", string);
+    }
+}
+
+- (void)testBatches {
+    AJRDateParser *parser = [[AJRDateParser alloc] initWithFormat:@"%y-%m-%d"];
+    NSArray *strings = @[@"1971-06-16", @"bogus", @"2000-02-29"];
+    NSArray *dates = [parser datesFromStrings:strings];
+
+    XCTAssert(dates.count == 3);
+    XCTAssertEqualObjects(dates[0], AJRDateFromStringAndFormat(strings[0], @"%y-%m-%d", nil, NULL));
+    XCTAssertEqualObjects(dates[1], [NSNull null]);
+    XCTAssertEqualObjects(dates[2], AJRDateFromStringAndFormat(strings[2], @"%y-%m-%d", nil, NULL));
+
+    NSTimeInterval intervals[3];
+    [parser getTimeIntervals:intervals fromStrings:strings];
+    XCTAssert(intervals[0] == [dates[0] timeIntervalSinceReferenceDate]);
+    XCTAssert(isnan(intervals[1]));
+    XCTAssert(intervals[2] == [dates[2] timeIntervalSinceReferenceDate]);
+}
+
+- (void)testParsingPerformance {
+    NSMutableArray *strings = [NSMutableArray array];
+    for (NSInteger x = 0; x < 50000; x++) {
+        [strings addObject:AJRFormat(@"%ld/%ld/%ld", (long)(x % 12 + 1), (long)(x % 28 + 1), (long)(1950 + x % 70))];
+    }
+    AJRDateParser *parser = [[AJRDateParser alloc] initWithFormat:@"%m/%d/%Y"];
+    NSTimeInterval *intervals = malloc(sizeof(NSTimeInterval) * strings.count);
+
+    [self measureBlock:^{
+        [parser getTimeIntervals:intervals fromStrings:strings];
+    }];
+    free(intervals);
+}
+
+@end
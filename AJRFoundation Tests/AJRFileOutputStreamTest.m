@@ -176,4 +176,74 @@
     }
 }
 
+- (void)testBufferedIO {
+    NSString *filename = [NSTemporaryDirectory() stringByAppendingPathComponent:@"AJRFileTest5.txt"];
+    int file = open([filename UTF8String], O_CREAT | O_WRONLY | O_TRUNC, 0644);
+    NSError *localError = nil;
+    
+    XCTAssert(file >= 0, "Failed to open file: %@: %s", filename, strerror(errno));
+    if (file >= 0) {
+        [self queueFileToRemove:filename];
+        
+        @autoreleasepool {
+            AJRFileOutputStream *outputStream = [AJRFileOutputStream outputStreamWithFileDescriptor:file closeOnDeallocate:YES];
+            [outputStream open];
+            [outputStream setBuffering:AJRFileOutputStreamBufferingFull size:32];
+            XCTAssert(outputStream.buffering == AJRFileOutputStreamBufferingFull && outputStream.bufferSize == 32);
+            
+            [outputStream writeString:@"This is "];
+            [outputStream writeString:@"a test.\n"];
+            XCTAssert(outputStream.bufferedLength == 16 && outputStream.writeCallCount == 0);
+            XCTAssert([outputStream flushWithError:&localError] && localError == nil);
+            XCTAssert(outputStream.bufferedLength == 0 && outputStream.writeCallCount == 1);
+            
+            // Too big for the buffer, so it should be gathered with what's buffered into a single writev().
+            [outputStream writeString:@"Buffered, "];
+            [outputStream writeString:@"and this is longer than the buffer.\n"];
+            XCTAssert(outputStream.bufferedLength == 0 && outputStream.writeCallCount == 2);
+            
+            [outputStream setBuffering:AJRFileOutputStreamBufferingLine size:0];
+            XCTAssert(outputStream.bufferSize == AJRFileOutputStreamDefaultBufferSize);
+            [outputStream writeString:@"Line "];
+            XCTAssert(outputStream.bufferedLength == 5);
+            [outputStream writeString:@"buffered.\n"];
+            XCTAssert(outputStream.bufferedLength == 0 && outputStream.writeCallCount == 3);
+            
+            // And this should be flushed when the stream closes.
+            [outputStream writeString:@"Done."];
+        }
+        
+        NSString *result = [[NSString alloc] initWithContentsOfFile:filename encoding:NSUTF8StringEncoding error:NULL];
+        XCTAssertEqualObjects(result, @"This is a test.\nBuffered, and this is longer than the buffer.\nLine buffered.\nDone.");
+    }
+}
+
+- (NSUInteger)_writeCallCountForFragments:(NSInteger)count buffering:(AJRFileOutputStreamBuffering)buffering {
+    int file = open("/dev/null", O_WRONLY);
+    AJRFileOutputStream *outputStream = [AJRFileOutputStream outputStreamWithFileDescriptor:file closeOnDeallocate:YES];
+    [outputStream open];
+    [outputStream setBuffering:buffering size:0];
+    // Roughly what the XML archiver produces: lots of small fragments.
+    for (NSInteger x = 0; x < count; x++) {
+        [outputStream writeString:@"<element "];
+        [outputStream writeString:@"name=\"value\""];
+        [outputStream writeString:@"/>\n"];
+    }
+    [outputStream close];
+    return outputStream.writeCallCount;
+}
+
+- (void)testBufferingSystemCallCounts {
+    NSUInteger unbuffered = [self _writeCallCountForFragments:10000 buffering:AJRFileOutputStreamBufferingNone];
+    NSUInteger buffered = [self _writeCallCountForFragments:10000 buffering:AJRFileOutputStreamBufferingFull];
+    
+    AJRPrintf(@"write calls for 30000 fragments: unbuffered: %lu, buffered: %lu\n", (unsigned long)unbuffered, (unsigned long)buffered);
+    XCTAssert(unbuffered == 30000);
+    XCTAssert(buffered < unbuffered / 100);
+    
+    [self measureBlock:^{
+        [self _writeCallCountForFragments:10000 buffering:AJRFileOutputStreamBufferingFull];
+    }];
+}
+
 @end
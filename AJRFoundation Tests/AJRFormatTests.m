@@ -298,4 +298,116 @@
     AJRLogSetOutputStream(nil, AJRLogLevelWarning);
 }
 
+- (void)test:(NSString *)expectedResult vsSpecification:(AJRFormatSpecification *)specification, ... {
+    va_list ap;
+
+    va_start(ap, specification);
+    NSString *formatted = [specification stringWithArguments:ap];
+    va_end(ap);
+    XCTAssert([expectedResult isEqualToString:formatted], @"String != specification's string: '%@' vs. '%@'. Format string was '%@'.", expectedResult, formatted, specification.format);
+
+    va_start(ap, specification);
+    NSData *data = [specification UTF8DataWithArguments:ap];
+    va_end(ap);
+    XCTAssertEqualObjects(data, [expectedResult dataUsingEncoding:NSUTF8StringEncoding], @"UTF-8 output didn't match for '%@'.", specification.format);
+
+    va_start(ap, specification);
+    data = [specification UTF16DataWithArguments:ap];
+    va_end(ap);
+    XCTAssertEqualObjects([[NSString alloc] initWithData:data encoding:NSUTF16LittleEndianStringEncoding], expectedResult, @"UTF-16 output didn't match for '%@'.", specification.format);
+}
+
+- (void)testSpecifications {
+    // Constant strings are cached, other strings aren't.
+    XCTAssert([AJRFormatSpecification specificationWithFormat:@"%d: %@"] == [AJRFormatSpecification specificationWithFormat:@"%d: %@"]);
+    NSString *format = [NSMutableString stringWithString:@"%d: %@"];
+    XCTAssert([AJRFormatSpecification specificationWithFormat:format] != [AJRFormatSpecification specificationWithFormat:format]);
+
+    AJRFormatSpecification *specification = [[AJRFormatSpecification alloc] initWithFormat:@"Line %ld of %@: %5.2f%%"];
+    [self test:@"Line 12 of input.txt: 99.50%" vsSpecification:specification, 12L, @"input.txt", 99.5];
+    [self test:@"Line 13 of (null):  1.25%" vsSpecification:specification, 13L, nil, 1.25];
+
+    specification = [[AJRFormatSpecification alloc] initWithFormat:@"caf\u00e9 %-6@| %s %C %B"];
+    [self test:@"café naïve | plain NSObject YES" vsSpecification:specification, @"naïve", "plain", [[NSObject alloc] init], YES];
+    specification = [[AJRFormatSpecification alloc] initWithFormat:@"[%.3@] [%4@] \U0001F600"];
+    [self test:@"[😀😀😀] [   😀] 😀" vsSpecification:specification, @"😀😀😀😀", @"😀"];
+
+    // %n counts characters, not UTF-16 units or bytes.
+    int count = 0;
+    [self test:@"é😀abc" vsSpecification:[[AJRFormatSpecification alloc] initWithFormat:@"é😀%@%n"], @"abc", &count];
+    XCTAssert(count == 5);
+
+    // A negative width left justifies, and a negative precision is ignored.
+    [self test:@"42   |" vsFormat:@"%*d|", -5, 42];
+    [self test:@"1.500000|" vsFormat:@"%.*f|", -1, 1.5];
+    [self test:@"1.5  |" vsFormat:@"%*.1f|", -5, 1.5];
+
+    // Long floating point results no longer get cut off at 80 characters.
+    [self testFormat:@"%.100f", 1.0 / 3.0];
+
+    [self test:@"" vsSpecification:[[AJRFormatSpecification alloc] initWithFormat:@""]];
+    [self test:@"trailing " vsSpecification:[[AJRFormatSpecification alloc] initWithFormat:@"trailing %-"]];
+}
+
+- (void)testFormatPerformance {
+    [self measureBlock:^{
+        for (NSInteger x = 0; x < 100000; x++) {
+            @autoreleasepool {
+                AJRFormat(@"%@: line %ld, column %ld: %s (%.3f)", @"AJRFormat.m", (long)x, (long)(x % 80), "message", 1.0 / (x + 1));
+            }
+        }
+    }];
+}
+
+- (void)testFormattingToBuffers {
+    char buffer[16];
+
+    XCTAssert(AJRFormatToBuffer(buffer, sizeof(buffer), @"%@: %d", @"count", 42) == 9);
+    XCTAssert(strcmp(buffer, "count: 42") == 0);
+
+    // Truncation reports the full length, and doesn't split characters.
+    XCTAssert(AJRFormatToBuffer(buffer, sizeof(buffer), @"%@", @"0123456789abcdéf") == 17);
+    XCTAssert(strcmp(buffer, "0123456789abcd") == 0);
+    XCTAssert(AJRFormatToBuffer(buffer, 1, @"%d", 12) == 2);
+    XCTAssert(buffer[0] == '\0');
+    XCTAssert(AJRFormatToBuffer(NULL, 0, @"%d", 123) == 3);
+
+    // The growable variant uses the buffer while the output fits, and moves to the heap when it doesn't.
+    char *result = NULL;
+    XCTAssert(AJRFormatToGrowableBuffer(buffer, sizeof(buffer), &result, @"%@: %d", @"count", 42) == 9);
+    XCTAssert(result == buffer && strcmp(buffer, "count: 42") == 0);
+    XCTAssert(AJRFormatToGrowableBuffer(buffer, sizeof(buffer), &result, @"%@", @"0123456789abcde") == 15);
+    XCTAssert(result == buffer && strcmp(buffer, "0123456789abcde") == 0);
+    XCTAssert(AJRFormatToGrowableBuffer(buffer, sizeof(buffer), &result, @"%@", @"0123456789abcdéf") == 17);
+    XCTAssert(result != buffer && strcmp(result, "0123456789abcdéf") == 0);
+    free(result);
+    NSString *longText = [@"" stringByPaddingToLength:3000 withString:@"abc😀" startingAtIndex:0];
+    NSUInteger longLength = AJRFormatToGrowableBuffer(buffer, sizeof(buffer), &result, @"<%@> %ld", longText, 12L);
+    XCTAssertEqualObjects([[NSString alloc] initWithBytes:result length:longLength encoding:NSUTF8StringEncoding], AJRFormat(@"<%@> %ld", longText, 12L));
+    XCTAssert(result[longLength] == '\0');
+    free(result);
+
+    NSMutableString *string = [NSMutableString stringWithString:@"Total: "];
+    AJRFormatAppend(string, @"%5.1f%% of %@", 12.5, [@"" stringByPaddingToLength:600 withString:@"é" startingAtIndex:0]);
+    XCTAssertEqualObjects(string, AJRFormat(@"Total: %5.1f%% of %@", 12.5, [@"" stringByPaddingToLength:600 withString:@"é" startingAtIndex:0]));
+
+    NSOutputStream *stream = [NSOutputStream outputStreamToMemory];
+    [stream open];
+    NSString *longString = [@"" stringByPaddingToLength:2000 withString:@"abc😀" startingAtIndex:0];
+    NSInteger written = AJRFormatToOutputStream(stream, @"<%@> %ld", longString, 12L);
+    NSString *expected = AJRFormat(@"<%@> %ld", longString, 12L);
+    XCTAssert(written == [expected lengthOfBytesUsingEncoding:NSUTF8StringEncoding]);
+    XCTAssertEqualObjects([stream ajr_dataAsStringUsingEncoding:NSUTF8StringEncoding], expected);
+    [stream close];
+
+    int pipes[2];
+    XCTAssert(pipe(pipes) == 0);
+    XCTAssert(AJRFormatToFileDescriptor(pipes[1], @"%s=%B\n", "flag", YES) == 9);
+    close(pipes[1]);
+    char result[16] = { 0 };
+    XCTAssert(read(pipes[0], result, sizeof(result) - 1) == 9);
+    close(pipes[0]);
+    XCTAssert(strcmp(result, "flag=YES\n") == 0);
+}
+
 @end
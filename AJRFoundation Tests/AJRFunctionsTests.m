@@ -411,6 +411,118 @@
     XCTAssert(!AJRApproximateEquals(1.000001, 1.000002, 6));
 }
 
+- (void)testByteHashing {
+    // The published wyhash test vectors, each hashed with its index as the seed.
+    const char *messages[] = { "", "a", "abc", "message digest", "abcdefghijklmnopqrstuvwxyz", "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789", "12345678901234567890123456789012345678901234567890123456789012345678901234567890" };
+    const uint64_t expected[] = { 0x93228a4de0eec5a2, 0xc5bac3db178713c4, 0xa97f2f7b1d9b3314, 0x786d1f1df3801df4, 0xdca5a8138ad37c87, 0xb9e734f117cfaf70, 0x6cc5eab49a92d617 };
+    for (NSInteger x = 0; x < AJRCountOf(messages); x++) {
+        XCTAssert(AJRHashBytesWithSeed(messages[x], strlen(messages[x]), x) == expected[x], @"hash of \"%s\"", messages[x]);
+    }
+    XCTAssert(AJRHashBytes("abc", 3) == AJRHashBytesWithSeed("abc", 3, 0));
+    XCTAssert(AJRHashBytesWithSeed("abc", 3, 1) != AJRHashBytesWithSeed("abc", 3, 2));
+
+    // Hashing in pieces must match hashing all at once, however the input is split.
+    uint8_t bytes[600];
+    for (NSInteger x = 0; x < AJRCountOf(bytes); x++) {
+        bytes[x] = (uint8_t)(x * 2654435761u >> 11);
+    }
+    for (size_t length = 0; length <= AJRCountOf(bytes); length += (length < 130 ? 1 : 37)) {
+        uint64_t whole = AJRHashBytesWithSeed(bytes, length, 42);
+        for (size_t piece = 1; piece < 100; piece += 7) {
+            AJRHashState state;
+            AJRHashStateInitialize(&state, 42);
+            for (size_t offset = 0; offset < length; offset += piece) {
+                AJRHashStateUpdate(&state, bytes + offset, MIN(piece, length - offset));
+            }
+            XCTAssert(AJRHashStateFinalize(&state) == whole, @"length %zu in pieces of %zu", length, piece);
+        }
+    }
+
+    // Case folding.
+    XCTAssert(AJRHashBytesFoldingASCII("Hello, World!", 13, 0) == AJRHashBytesWithSeed("hello, world!", 13, 0));
+    XCTAssert(AJRHashStringFoldingCase(@"Content-Type", 7) == AJRHashStringFoldingCase(@"CONTENT-TYPE", 7));
+    XCTAssert(AJRHashStringFoldingCase(@"Content-Type", 7) == AJRHashUTF8FoldingCase("content-type", 12, 7));
+    XCTAssert(AJRHashStringFoldingCase(@"ÉCOLE", 0) == AJRHashStringFoldingCase(@"école", 0));
+    XCTAssert(AJRHashUTF8FoldingCase("\xC3\x89COLE", 6, 0) == AJRHashStringFoldingCase(@"école", 0));
+    XCTAssert(AJRHashStringFoldingCase(@"école", 0) != AJRHashStringFoldingCase(@"ecole", 0));
+    XCTAssert(AJRHashString(@"caf\u00e9", 3) == AJRHashBytesWithSeed("caf\xC3\xA9", 5, 3));
+    NSMutableString *longString = [NSMutableString string];
+    for (NSInteger x = 0; x < 500; x++) {
+        [longString appendFormat:@"Key%ld ", (long)x];
+    }
+    XCTAssert(AJRHashStringFoldingCase(longString, 0) == AJRHashStringFoldingCase([longString lowercaseString], 0));
+    [longString appendString:@"Ünïcödé"];
+    XCTAssert(AJRHashStringFoldingCase(longString, 0) == AJRHashStringFoldingCase([longString uppercaseString], 0));
+    XCTAssert(AJRHashString(longString, 0) == AJRHashBytesWithSeed(longString.UTF8String, strlen(longString.UTF8String), 0));
+}
+
+- (void)testByteHashCollisions {
+    // A million keys that differ by little, which is what identifiers tend to look like. The full hashes shouldn't collide at all, and the low bits, which is what a table would use, should be spread evenly over the buckets.
+    const NSInteger count = 1 << 20;
+    const NSInteger bucketCount = 1 << 16;
+    uint64_t *hashes = (uint64_t *)malloc(count * sizeof(uint64_t));
+    uint32_t *buckets = (uint32_t *)calloc(bucketCount, sizeof(uint32_t));
+    char key[32];
+
+    for (NSInteger x = 0; x < count; x++) {
+        int length = snprintf(key, sizeof(key), "key-%ld", (long)x);
+        hashes[x] = AJRHashBytes(key, length);
+        buckets[hashes[x] & (bucketCount - 1)]++;
+    }
+    qsort_b(hashes, count, sizeof(uint64_t), ^int(const void *left, const void *right) {
+        uint64_t a = *(const uint64_t *)left, b = *(const uint64_t *)right;
+        return a < b ? -1 : (a > b ? 1 : 0);
+    });
+    NSInteger collisions = 0;
+    for (NSInteger x = 1; x < count; x++) {
+        if (hashes[x] == hashes[x - 1]) {
+            collisions++;
+        }
+    }
+    XCTAssert(collisions == 0, @"%ld collisions", (long)collisions);
+
+    // With 16 keys per bucket, the chi-squared statistic should be close to the number of buckets. A poor hash is off by orders of magnitude.
+    double expected = (double)count / bucketCount;
+    double chiSquared = 0.0;
+    for (NSInteger x = 0; x < bucketCount; x++) {
+        chiSquared += (buckets[x] - expected) * (buckets[x] - expected) / expected;
+    }
+    XCTAssert(chiSquared < bucketCount * 1.1, @"chi-squared of %g", chiSquared);
+
+    free(hashes);
+    free(buckets);
+}
+
+- (void)testByteHashPerformance {
+    NSMutableData *data = [NSMutableData dataWithLength:64 * 1024 * 1024];
+    uint8_t *bytes = [data mutableBytes];
+    for (NSInteger x = 0; x < data.length; x++) {
+        bytes[x] = (uint8_t)(x * 2654435761u >> 13);
+    }
+
+    [self measureBlock:^{
+        uint64_t hash = AJRHashBytes(bytes, data.length);
+        XCTAssert(hash != 0);
+    }];
+}
+
+- (void)testShortKeyHashPerformance {
+    NSMutableArray<NSString *> *keys = [NSMutableArray array];
+    for (NSInteger x = 0; x < 100000; x++) {
+        [keys addObject:[NSString stringWithFormat:@"Identifier%ld", (long)x]];
+    }
+
+    [self measureBlock:^{
+        uint64_t combined = 0;
+        for (NSInteger pass = 0; pass < 10; pass++) {
+            for (NSString *key in keys) {
+                combined ^= AJRHashStringFoldingCase(key, 0);
+            }
+        }
+        XCTAssert(combined != 0);
+    }];
+}
+
 - (void)testMath {
     // Just calling these to make sure we get different values. I suppose a better test would be to insert a bunch of sequential integers into a hash table and then verify that we got a good distribution in the hash function.
     XCTAssert(AJRHash32((uint32_t)1) == AJRHash32((uint32_t)1));
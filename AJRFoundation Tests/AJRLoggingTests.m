@@ -37,6 +37,22 @@
 
 @end
 
+@interface AJRLoggingCountingObject : NSObject
+
+@property (nonatomic,assign) NSInteger descriptionCount;
+@property (nonatomic,strong) NSString *value;
+
+@end
+
+@implementation AJRLoggingCountingObject
+
+- (NSString *)description {
+    self.descriptionCount += 1;
+    return self.value;
+}
+
+@end
+
 @implementation AJRLoggingTest
 
 - (void)testBasicLogging
@@ -138,4 +154,33 @@ static void AJRLoggingTestFunction(void) {
     AJRLogSetOutputStream(nil, AJRLogLevelInfo);
 }
 
+- (void)testLongMessages {
+    NSOutputStream *stream = [NSOutputStream outputStreamToMemory];
+    AJRLoggingCountingObject *object = [[AJRLoggingCountingObject alloc] init];
+
+    AJRLogSetOutputStream(stream, AJRLogLevelInfo);
+    AJRLogSetLogLevel(AJRLogLevelInfo, @"Test");
+
+    // Short enough to fit in the stack buffer, but with no room left for the newline.
+    object.value = [@"" stringByPaddingToLength:1024 - 14 withString:@"x" startingAtIndex:0];
+    AJRLog(@"Test", AJRLogLevelInfo, @"%@", object);
+    // Much too long for the stack buffer, and including characters that take more than one byte.
+    object.value = [@"" stringByPaddingToLength:5000 withString:@"abé😀" startingAtIndex:0];
+    AJRLog(@"Test", AJRLogLevelInfo, @"%@", object);
+    // Already ends with a newline, so doesn't get another.
+    object.value = [[@"" stringByPaddingToLength:3000 withString:@"y" startingAtIndex:0] stringByAppendingString:@"\n"];
+    AJRLog(@"Test", AJRLogLevelInfo, @"%@", object);
+
+    // Each message is only formatted once, however long it is.
+    XCTAssert(object.descriptionCount == 3, @"description was called %ld times", (long)object.descriptionCount);
+    NSString *expected = [NSString stringWithFormat:@"Test <INFO>: %@\nTest <INFO>: %@\nTest <INFO>: %@",
+                          [@"" stringByPaddingToLength:1024 - 14 withString:@"x" startingAtIndex:0],
+                          [@"" stringByPaddingToLength:5000 withString:@"abé😀" startingAtIndex:0],
+                          object.value];
+    XCTAssertEqualObjects([stream ajr_dataAsStringUsingEncoding:NSUTF8StringEncoding], expected);
+
+    AJRLogSetLogLevel(AJRLogLevelDefault, @"Test");
+    AJRLogSetOutputStream(nil, AJRLogLevelInfo);
+}
+
 @end
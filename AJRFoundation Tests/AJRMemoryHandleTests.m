@@ -1115,4 +1115,75 @@
     }];
 }
 
+- (void)testMappedFiles {
+    NSURL *url = [NSURL fileURLWithPath:[NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]]];
+    NSMutableData *original = [NSMutableData dataWithLength:1024 * 1024];
+    NSError *localError = nil;
+
+    for (NSUInteger x = 0; x < original.length; x++) {
+        ((uint8_t *)original.mutableBytes)[x] = (uint8_t)(x % 251);
+    }
+    XCTAssert([original writeToURL:url atomically:NO]);
+
+    // Read only.
+    AJRMemoryHandle *file = [AJRMemoryHandle memoryHandleByMappingFileAtURL:url mapping:AJRMemoryHandleMappingReadOnly error:&localError];
+    XCTAssert(file != nil && localError == nil);
+    XCTAssert(file.isMapped && !file.canWrite);
+    XCTAssertEqualObjects([file readDataOfLength:16], [original subdataWithRange:(NSRange){0, 16}]);
+    XCTAssert([file offsetInFile] == 16);
+    XCTAssert(![file writeBytes:"nope" length:4 bytesWritten:NULL error:&localError] && localError != nil);
+    localError = nil;
+
+    // Positional reads don't touch the offset, and can run concurrently.
+    dispatch_apply(64, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t index) {
+        NSUInteger offset = index * 16384;
+        NSData *data = [file readDataOfLength:4096 atOffset:offset error:NULL];
+        XCTAssertEqualObjects(data, [original subdataWithRange:(NSRange){offset, 4096}]);
+    });
+    XCTAssert([file offsetInFile] == 16);
+    XCTAssert([[file readDataOfLength:100 atOffset:original.length - 10 error:&localError] length] == 10);
+    XCTAssert([[file readDataOfLength:100 atOffset:original.length + 10 error:&localError] length] == 0);
+    XCTAssert(localError == nil);
+    [file closeFile];
+    XCTAssert([file readDataOfLength:100 atOffset:0 error:&localError] == nil && localError != nil);
+    localError = nil;
+
+    // Copy on write.
+    file = [AJRMemoryHandle memoryHandleByMappingFileAtURL:url mapping:AJRMemoryHandleMappingCopyOnWrite error:&localError];
+    XCTAssert(file != nil && localError == nil);
+    XCTAssert(file.isMapped && file.canWrite);
+    XCTAssert([file writeBytes:"ABCD" length:4 bytesWritten:NULL error:&localError] && localError == nil);
+    XCTAssert(file.isMapped);
+    XCTAssertEqualObjects([file readDataOfLength:4 atOffset:0 error:NULL], [@"ABCD" dataUsingEncoding:NSUTF8StringEncoding]);
+    // Growing the data moves it into memory.
+    [file seekToEndOfFile];
+    XCTAssert([file writeBytes:"EFGH" length:4 bytesWritten:NULL error:&localError] && localError == nil);
+    XCTAssert(!file.isMapped && file.data.length == original.length + 4);
+    XCTAssertEqualObjects([file readDataOfLength:4 atOffset:0 error:NULL], [@"ABCD" dataUsingEncoding:NSUTF8StringEncoding]);
+    [file closeFile];
+
+    // And the file itself is never changed.
+    XCTAssertEqualObjects([NSData dataWithContentsOfURL:url], original);
+
+    XCTAssert([AJRMemoryHandle memoryHandleByMappingFileAtURL:[url URLByAppendingPathExtension:@"missing"] mapping:AJRMemoryHandleMappingReadOnly error:&localError] == nil && localError != nil);
+    localError = nil;
+
+    // Empty files can't be mapped, but a copy-on-write handle on one must still be writable, while a read only one must not be.
+    XCTAssert([[NSData data] writeToURL:url atomically:NO]);
+    file = [AJRMemoryHandle memoryHandleByMappingFileAtURL:url mapping:AJRMemoryHandleMappingReadOnly error:&localError];
+    XCTAssert(file != nil && localError == nil);
+    XCTAssert(!file.canWrite && file.data.length == 0);
+    XCTAssert(![file writeBytes:"nope" length:4 bytesWritten:NULL error:&localError] && localError != nil);
+    localError = nil;
+    file = [AJRMemoryHandle memoryHandleByMappingFileAtURL:url mapping:AJRMemoryHandleMappingCopyOnWrite error:&localError];
+    XCTAssert(file != nil && localError == nil);
+    XCTAssert(file.canWrite && !file.isMapped);
+    XCTAssert([file writeBytes:"ABCD" length:4 bytesWritten:NULL error:&localError] && localError == nil);
+    XCTAssertEqualObjects(file.data, [@"ABCD" dataUsingEncoding:NSUTF8StringEncoding]);
+    [file closeFile];
+    XCTAssert([[NSData dataWithContentsOfURL:url] length] == 0);
+
+    [[NSFileManager defaultManager] removeItemAtURL:url error:NULL];
+}
+
 @end
@@ -32,6 +32,13 @@
 #import <XCTest/XCTest.h>
 
 #import <AJRFoundation/AJRFoundation.h>
+#import <AJRFoundation/AJRFoundation_Private.h>
+
+@interface AJRPlugInManager (Testing)
+
+- (instancetype)_initWithBundles:(nullable NSArray<NSBundle *> *)bundles registeringLazily:(BOOL)registersLazily usingCache:(BOOL)usesCache;
+
+@end
 
 @interface AJRPlugInManagerTest : XCTestCase
 
@@ -165,6 +172,163 @@
     XCTAssert(extension != nil);
 }
 
+- (void)testManifestCache {
+    NSURL *directory = [NSURL fileURLWithPath:[NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]]];
+    NSURL *manifestURL = [directory URLByAppendingPathComponent:@"Test.ajrplugindata"];
+    NSURL *cacheURL = [directory URLByAppendingPathComponent:@"Caches/AJRPlugInManager.cache"];
+    NSString *xml = @"<?xml version=\"1.0\" encoding=\"utf-8\" ?>\n<plugindata owner=\"test\" version=\"1\">\n    <!-- A comment -->\n    <ajrconstant name=\"a&amp;b\" class=\"NSObject\"><child value=\"1\"/></ajrconstant>\n    <ajrconstant name=\"two\"/>\n</plugindata>\n";
+    NSError *error = nil;
+
+    XCTAssert([[NSFileManager defaultManager] createDirectoryAtURL:directory withIntermediateDirectories:YES attributes:nil error:&error], @"%@", error);
+    XCTAssert([xml writeToURL:manifestURL atomically:YES encoding:NSUTF8StringEncoding error:&error], @"%@", error);
+
+    // First pass parses, and writes the cache.
+    AJRPlugInManifestCache *cache = [[AJRPlugInManifestCache alloc] initWithURL:cacheURL];
+    AJRPlugInManifest *manifest = [cache manifestForURL:manifestURL error:&error];
+    XCTAssert(manifest != nil, @"%@", error);
+    XCTAssert([cache missCount] == 1 && [cache hitCount] == 0);
+    XCTAssert([[manifest nodes] count] == 2);
+    XCTAssert([[[manifest nodes][0] valueForAttribute:@"name"] isEqualToString:@"a&b"]);
+    XCTAssertEqualObjects([[manifest nodes][0] XMLString], @"<ajrconstant name=\"a&amp;b\" class=\"NSObject\"><child value=\"1\"></child></ajrconstant>");
+    XCTAssert([cache needsSynchronize]);
+    XCTAssert([cache synchronizeWithError:&error], @"%@", error);
+    XCTAssert(![cache needsSynchronize]);
+
+    // Second pass should come entirely from the cache file.
+    cache = [[AJRPlugInManifestCache alloc] initWithURL:cacheURL];
+    AJRPlugInManifest *cached = [cache manifestForURL:manifestURL error:&error];
+    XCTAssert(cached != nil, @"%@", error);
+    XCTAssert([cache missCount] == 0 && [cache hitCount] == 1);
+    XCTAssertEqualObjects([[cached nodes] valueForKey:@"XMLString"], [[manifest nodes] valueForKey:@"XMLString"]);
+    XCTAssert(![cache needsSynchronize]);
+
+    // Changing the file invalidates the entry.
+    xml = [xml stringByReplacingOccurrencesOfString:@"\"two\"" withString:@"\"three\""];
+    XCTAssert([xml writeToURL:manifestURL atomically:YES encoding:NSUTF8StringEncoding error:&error], @"%@", error);
+    cache = [[AJRPlugInManifestCache alloc] initWithURL:cacheURL];
+    manifest = [cache manifestForURL:manifestURL error:&error];
+    XCTAssert([cache missCount] == 1 && [cache hitCount] == 0);
+    XCTAssert([[[manifest nodes][1] valueForAttribute:@"name"] isEqualToString:@"three"]);
+
+    // A corrupt cache is ignored, rather than trusted.
+    XCTAssert([[NSData dataWithBytes:"AJPM garbage" length:12] writeToURL:cacheURL atomically:YES]);
+    cache = [[AJRPlugInManifestCache alloc] initWithURL:cacheURL];
+    XCTAssert([cache manifestForURL:manifestURL error:&error] != nil, @"%@", error);
+    XCTAssert([cache missCount] == 1);
+
+    [[NSFileManager defaultManager] removeItemAtURL:directory error:NULL];
+}
+
+- (void)testLazyRegistration {
+    AJRPlugInManager *plugInManager = [[AJRPlugInManager alloc] _initWithBundles:nil registeringLazily:YES usingCache:YES];
+    
+    XCTAssert([plugInManager registersLazily]);
+    XCTAssert([[plugInManager extensionPointNames] containsObject:@"value_transformer"]);
+    XCTAssert([[plugInManager extensionPointNames] containsObject:@"ajrconstant"]);
+    
+    // Looking up by class should find the extension-point, even though it hasn't been registered yet.
+    AJRPlugInExtensionPoint *extensionPoint = [plugInManager extensionPointForClass:NSClassFromString(@"AJRFoundation.AJRValueTransformers")];
+    XCTAssert(extensionPoint != nil);
+    XCTAssert([extensionPoint registered]);
+    XCTAssert([[extensionPoint name] isEqualToString:@"value_transformer"]);
+    XCTAssert([extensionPoint extensionForName:@"AJRNullTransformer"] != nil);
+    XCTAssert([plugInManager extensionPointForName:@"value_transformer"] == extensionPoint);
+    XCTAssert([plugInManager extensionPointForName:@"ajr_no_such_extension_point"] == nil);
+}
+
+/*! Builds count bundles in directory. The first defines an extension-point, and each of the rest adds one extension to it. */
+- (NSArray<NSBundle *> *)_syntheticBundlesInDirectory:(NSURL *)directory count:(NSUInteger)count {
+    NSMutableArray<NSBundle *> *bundles = [NSMutableArray array];
+    NSString *infoPlist = @"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<!DOCTYPE plist PUBLIC \"-//Apple//DTD PLIST 1.0//EN\" \"http://www.apple.com/DTDs/PropertyList-1.0.dtd\">\n<plist version=\"1.0\"><dict><key>CFBundleIdentifier</key><string>com.ajr.synthetic.%lu</string><key>CFBundlePackageType</key><string>BNDL</string></dict></plist>\n";
+    
+    for (NSUInteger x = 0; x < count; x++) {
+        NSURL *bundleURL = [directory URLByAppendingPathComponent:AJRFormat(@"Synthetic%lu.bundle", (unsigned long)x)];
+        NSURL *resourcesURL = [bundleURL URLByAppendingPathComponent:@"Contents/Resources"];
+        NSMutableString *xml = [NSMutableString stringWithString:@"<?xml version=\"1.0\" encoding=\"utf-8\" ?>\n<plugindata owner=\"synthetic\" version=\"1\">\n"];
+        NSError *error = nil;
+        
+        if (x == 0) {
+            [xml appendString:@"    <extension-point name=\"ajr_synthetic\">\n        <attribute name=\"index\" type=\"integer\" required=\"YES\" />\n        <attribute name=\"label\" type=\"string\" />\n        <element name=\"option\" key=\"options\" type=\"array\">\n            <attribute name=\"value\" type=\"float\" />\n        </element>\n    </extension-point>\n"];
+        } else {
+            [xml appendFormat:@"    <ajr_synthetic name=\"synthetic-%lu\" index=\"%lu\" label=\"Synthetic %lu\">\n        <option value=\"1.5\" />\n        <option value=\"2.5\" />\n    </ajr_synthetic>\n", (unsigned long)x, (unsigned long)x, (unsigned long)x];
+        }
+        [xml appendString:@"</plugindata>\n"];
+        
+        XCTAssert([[NSFileManager defaultManager] createDirectoryAtURL:resourcesURL withIntermediateDirectories:YES attributes:nil error:&error], @"%@", error);
+        XCTAssert([AJRFormat(infoPlist, (unsigned long)x) writeToURL:[bundleURL URLByAppendingPathComponent:@"Contents/Info.plist"] atomically:NO encoding:NSUTF8StringEncoding error:&error], @"%@", error);
+        XCTAssert([xml writeToURL:[resourcesURL URLByAppendingPathComponent:AJRFormat(@"Synthetic%lu.ajrplugindata", (unsigned long)x)] atomically:NO encoding:NSUTF8StringEncoding error:&error], @"%@", error);
+        
+        NSBundle *bundle = [NSBundle bundleWithURL:bundleURL];
+        XCTAssert(bundle != nil);
+        if (bundle) {
+            [bundles addObject:bundle];
+        }
+    }
+    
+    return bundles;
+}
+
+- (void)testParallelScanningIsDeterministic {
+    NSURL *directory = [NSURL fileURLWithPath:[NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]]];
+    NSArray<NSBundle *> *bundles = [self _syntheticBundlesInDirectory:directory count:64];
+    
+    // Scan a few times, since an ordering problem wouldn't necessarily show up every time.
+    for (NSInteger pass = 0; pass < 4; pass++) {
+        AJRPlugInManager *plugInManager = [[AJRPlugInManager alloc] _initWithBundles:bundles registeringLazily:NO usingCache:NO];
+        AJRPlugInExtensionPoint *extensionPoint = [plugInManager extensionPointForName:@"ajr_synthetic"];
+        
+        XCTAssert(extensionPoint != nil);
+        XCTAssert([[extensionPoint extensions] count] == [bundles count] - 1);
+        [[extensionPoint extensions] enumerateObjectsUsingBlock:^(AJRPlugInExtension *extension, NSUInteger index, BOOL *stop) {
+            XCTAssertEqualObjects([extension valueForKey:@"index"], @(index + 1));
+            XCTAssert([[extension valueForKey:@"options"] count] == 2);
+        }];
+    }
+    
+    [[NSFileManager defaultManager] removeItemAtURL:directory error:NULL];
+}
+
+- (void)testStartupPerformance {
+    NSURL *directory = [NSURL fileURLWithPath:[NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]]];
+    NSArray<NSBundle *> *bundles = [self _syntheticBundlesInDirectory:directory count:300];
+    
+    [self measureBlock:^{
+        AJRPlugInManager *plugInManager = [[AJRPlugInManager alloc] _initWithBundles:bundles registeringLazily:NO usingCache:NO];
+        XCTAssert([[[plugInManager extensionPointForName:@"ajr_synthetic"] extensions] count] == [bundles count] - 1);
+    }];
+    
+    [[NSFileManager defaultManager] removeItemAtURL:directory error:NULL];
+}
+
+- (void)testValueTransformers {
+    AJRPlugInAttribute *attribute = [[AJRPlugInAttribute alloc] init];
+    NSError *error = nil;
+    
+    attribute.type = @"integer";
+    XCTAssert([attribute valueTransformer] != nil);
+    XCTAssertEqualObjects([attribute valueForString:@"42" bundle:nil error:&error], @(42));
+    attribute.type = @"float";
+    XCTAssertEqualObjects([attribute valueForString:@"2.5" bundle:nil error:&error], @(2.5));
+    attribute.type = @"boolean";
+    XCTAssertEqualObjects([attribute valueForString:@"YES" bundle:nil error:&error], @YES);
+    attribute.type = @"class";
+    XCTAssert([attribute valueForString:@"NSString" bundle:nil error:&error] == [NSString class]);
+    attribute.type = @"bundle";
+    XCTAssert([attribute valueForString:@"$main-bundle" bundle:nil error:&error] == [NSBundle mainBundle]);
+    XCTAssert([attribute valueForString:nil bundle:nil error:&error] == nil);
+    
+    // Unknown types resolve to nil, but pick up a transformer as soon as one's registered.
+    attribute.type = @"ajr_test_uppercase";
+    XCTAssert([attribute valueTransformer] == nil);
+    AJRRegisterPluinTransformer(@"ajr_test_uppercase", ^id(NSString *raw, NSBundle *bundle, NSError **error) {
+        return [raw uppercaseString];
+    });
+    XCTAssert([attribute valueTransformer] != nil);
+    XCTAssertEqualObjects([attribute valueForString:@"loud" bundle:nil error:&error], @"LOUD");
+    XCTAssert(AJRPlugInTransformerForType(@"ajr_test_uppercase") != nil);
+    XCTAssert(AJRPlugInTransformerForType(@"ajr_no_such_type") == nil);
+}
+
 - (void)testDebugStuff {
     // This just makes a few calls to make sure we're actually getting 100% coverage, but is called on code that's only used as part of debugging.
     AJRPlugInExtensionPoint *extensionPoint = [[AJRPlugInManager sharedPlugInManager] extensionPointForName:@"ajrconstant"];
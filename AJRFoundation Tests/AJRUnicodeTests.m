@@ -0,0 +1,252 @@
+/*
+ AJRUnicodeTests.m
+ AJRFoundation
+
+ Copyright © 2023, AJ Raftis and AJRFoundation authors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of AJRFoundation nor the names of its contributors may be
+   used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL AJ RAFTIS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import <XCTest/XCTest.h>
+
+#import <AJRFoundation/AJRFoundation.h>
+
+@interface AJRUnicodeTests : XCTestCase
+
+@end
+
+@implementation AJRUnicodeTests
+
+static NSString *AJRUnicodeSample(NSInteger repeat) {
+    NSMutableString *string = [NSMutableString string];
+    for (NSInteger x = 0; x < repeat; x++) {
+        [string appendString:@"The quick brown fox jumps over the lazy dog. Ünïcödé, Ελληνικά, русский, 日本語, and 😀🎉 too.\n"];
+    }
+    return string;
+}
+
+- (void)testUTF8ToUTF16 {
+    NSString *string = AJRUnicodeSample(20);
+    const char *utf8 = [string UTF8String];
+    size_t length = strlen(utf8);
+    size_t expectedLength = AJRUTF16LengthOfUTF8(utf8, length);
+    XCTAssert(expectedLength == string.length);
+
+    unichar *characters = (unichar *)malloc(expectedLength * sizeof(unichar));
+    size_t consumed = 0, written = 0;
+    XCTAssert(AJRUTF8ToUTF16(utf8, length, characters, expectedLength, &consumed, &written) == AJRUnicodeConversionSuccess);
+    XCTAssert(consumed == length);
+    XCTAssert(written == expectedLength);
+    XCTAssertEqualObjects([NSString stringWithCharacters:characters length:written], string);
+
+    // A short buffer stops on a whole character, so the conversion can be picked up where it left off.
+    size_t total = 0;
+    size_t read = 0;
+    while (read < length) {
+        AJRUnicodeConversionResult result = AJRUTF8ToUTF16(utf8 + read, length - read, characters + total, MIN(total + 7, expectedLength) - total, &consumed, &written);
+        XCTAssert(result == AJRUnicodeConversionSuccess || result == AJRUnicodeConversionOutputFull);
+        read += consumed;
+        total += written;
+    }
+    XCTAssertEqualObjects([NSString stringWithCharacters:characters length:total], string);
+    free(characters);
+}
+
+- (void)testUTF16ToUTF8 {
+    NSString *string = AJRUnicodeSample(20);
+    NSInteger length = string.length;
+    unichar *characters = (unichar *)malloc(length * sizeof(unichar));
+    [string getCharacters:characters range:(NSRange){0, length}];
+
+    size_t expectedLength = AJRUTF8LengthOfUTF16(characters, length);
+    XCTAssert(expectedLength == strlen([string UTF8String]));
+
+    char *bytes = (char *)malloc(expectedLength);
+    size_t consumed = 0, written = 0;
+    XCTAssert(AJRUTF16ToUTF8(characters, length, bytes, expectedLength, &consumed, &written) == AJRUnicodeConversionSuccess);
+    XCTAssert(consumed == length);
+    XCTAssert(written == expectedLength);
+    XCTAssert(memcmp(bytes, [string UTF8String], written) == 0);
+
+    // Only a whole character is written, so three bytes isn't enough room for the emoji.
+    const unichar emoji[] = { 'a', 0xD83D, 0xDE00 };
+    XCTAssert(AJRUTF16ToUTF8(emoji, 3, bytes, 4, &consumed, &written) == AJRUnicodeConversionOutputFull);
+    XCTAssert(consumed == 1 && written == 1);
+    XCTAssert(AJRUTF16ToUTF8(emoji, 2, bytes, 8, &consumed, &written) == AJRUnicodeConversionIncompleteInput);
+    XCTAssert(consumed == 1);
+    const unichar unpaired[] = { 'a', 0xDE00, 'b' };
+    XCTAssert(AJRUTF16ToUTF8(unpaired, 3, bytes, 8, &consumed, &written) == AJRUnicodeConversionInvalidInput);
+    XCTAssert(consumed == 1);
+
+    free(characters);
+    free(bytes);
+}
+
+- (void)testUTF8Validation {
+    struct {
+        const char *bytes;
+        BOOL valid;
+        size_t offset;
+    } cases[] = {
+        { "plain ascii", YES, 0 },
+        { "caf\xC3\xA9", YES, 0 },
+        { "\xF0\x9F\x98\x80", YES, 0 },
+        { "ab\xC0\xAF", NO, 2 },            // Overlong '/'.
+        { "abc\xE0\x80\xAF", NO, 3 },       // Overlong, three bytes.
+        { "\xED\xA0\x80", NO, 0 },          // An encoded surrogate.
+        { "x\xF4\x90\x80\x80", NO, 1 },     // Past U+10FFFF.
+        { "xy\x80", NO, 2 },                // A stray continuation byte.
+        { "caf\xC3", NO, 3 },               // Cut off.
+        { "\xFE", NO, 0 },
+    };
+    for (NSInteger x = 0; x < AJRCountOf(cases); x++) {
+        size_t offset = 0;
+        XCTAssert(AJRUTF8Validate(cases[x].bytes, strlen(cases[x].bytes), &offset) == cases[x].valid, @"case %ld", (long)x);
+        if (!cases[x].valid) {
+            XCTAssert(offset == cases[x].offset, @"case %ld", (long)x);
+        }
+    }
+
+    unichar characters[8];
+    size_t consumed = 0;
+    XCTAssert(AJRUTF8ToUTF16("caf\xC3", 4, characters, 8, &consumed, NULL) == AJRUnicodeConversionIncompleteInput);
+    XCTAssert(consumed == 3);
+    XCTAssert(AJRUTF8ToUTF16("ab\xC0\xAF", 4, characters, 8, &consumed, NULL) == AJRUnicodeConversionInvalidInput);
+    XCTAssert(consumed == 2);
+}
+
+- (void)testCaseFolding {
+    XCTAssert(AJRUnicodeFoldCase('A') == 'a');
+    XCTAssert(AJRUnicodeFoldCase('a') == 'a');
+    XCTAssert(AJRUnicodeFoldCase(0x00C9) == 0x00E9);      // É
+    XCTAssert(AJRUnicodeFoldCase(0x017F) == 's');         // Long s
+    XCTAssert(AJRUnicodeFoldCase(0x03A3) == 0x03C3);      // Σ
+    XCTAssert(AJRUnicodeFoldCase(0x03C2) == 0x03C3);      // Final ς
+    XCTAssert(AJRUnicodeFoldCase(0x212A) == 'k');         // Kelvin sign
+    XCTAssert(AJRUnicodeFoldCase(0x1E9E) == 0x00DF);      // Capital sharp s
+    XCTAssert(AJRUnicodeFoldCase(0x00DF) == 0x00DF);
+    XCTAssert(AJRUnicodeFoldCase(0x10400) == 0x10428);    // Deseret
+    XCTAssert(AJRUnicodeFoldCase(0x1F600) == 0x1F600);
+
+    // Anything Foundation considers equal ignoring case should fold alike. This sticks to scripts whose casing is long settled, since Foundation may know a newer Unicode.
+    for (unichar character = 1; character < 0x0530; character++) {
+        NSString *string = [NSString stringWithCharacters:&character length:1];
+        NSString *folded = [string stringByFoldingWithOptions:NSCaseInsensitiveSearch locale:nil];
+        if (folded.length == 1) {
+            XCTAssert(AJRUnicodeFoldCase(character) == AJRUnicodeFoldCase([folded characterAtIndex:0]), @"U+%04X", character);
+        }
+    }
+
+    NSString *string = @"ÜNÏCÖDÉ Straße ΣΊΣΥΦΟΣ 𐐀";
+    NSInteger length = string.length;
+    unichar characters[64];
+    [string getCharacters:characters range:(NSRange){0, length}];
+    AJRUTF16FoldCase(characters, length, characters);
+    XCTAssertEqualObjects([NSString stringWithCharacters:characters length:length], @"ünïcödé straße σίσυφοσ 𐐨");
+
+    const char *utf8 = [string UTF8String];
+    char folded[128];
+    size_t written = 0;
+    XCTAssert(AJRUTF8FoldCase(utf8, strlen(utf8), folded, sizeof(folded), NULL, &written) == AJRUnicodeConversionSuccess);
+    XCTAssertEqualObjects([[NSString alloc] initWithBytes:folded length:written encoding:NSUTF8StringEncoding], @"ünïcödé straße σίσυφοσ 𐐨");
+
+    // Ⱥ needs two bytes, but its folding needs three.
+    XCTAssert(AJRUTF8FoldCase("\xC8\xBA", 2, folded, 2, NULL, &written) == AJRUnicodeConversionOutputFull);
+    XCTAssert(AJRUTF8FoldCase("\xC8\xBA", 2, folded, 3, NULL, &written) == AJRUnicodeConversionSuccess);
+    XCTAssert(written == 3 && memcmp(folded, "\xE2\xB1\xA5", 3) == 0);
+}
+
+- (void)testCaseMapping {
+    XCTAssert(utoupper('q') == 'Q');
+    XCTAssert(utoupper(0x00E9) == 0x00C9);
+    XCTAssert(utolower('Q') == 'q');
+}
+
+#pragma mark - Performance
+
+- (void)testUTF8ToUTF16Performance {
+    NSData *data = [AJRUnicodeSample(100000) dataUsingEncoding:NSUTF8StringEncoding];
+    size_t length = AJRUTF16LengthOfUTF8(data.bytes, data.length);
+    unichar *characters = (unichar *)malloc(length * sizeof(unichar));
+
+    [self measureBlock:^{
+        XCTAssert(AJRUTF8ToUTF16(data.bytes, data.length, characters, length, NULL, NULL) == AJRUnicodeConversionSuccess);
+    }];
+    free(characters);
+}
+
+- (void)testUTF8ToUTF16PerformanceWithNSString {
+    NSData *data = [AJRUnicodeSample(100000) dataUsingEncoding:NSUTF8StringEncoding];
+
+    [self measureBlock:^{
+        NSString *string = [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding];
+        XCTAssert(string.length > 0);
+    }];
+}
+
+- (void)testUTF16ToUTF8Performance {
+    NSString *string = AJRUnicodeSample(100000);
+    NSInteger length = string.length;
+    unichar *characters = (unichar *)malloc(length * sizeof(unichar));
+    [string getCharacters:characters range:(NSRange){0, length}];
+    size_t byteLength = AJRUTF8LengthOfUTF16(characters, length);
+    char *bytes = (char *)malloc(byteLength);
+
+    [self measureBlock:^{
+        XCTAssert(AJRUTF16ToUTF8(characters, length, bytes, byteLength, NULL, NULL) == AJRUnicodeConversionSuccess);
+    }];
+    free(characters);
+    free(bytes);
+}
+
+- (void)testUTF16ToUTF8PerformanceWithNSString {
+    NSString *source = AJRUnicodeSample(100000);
+    NSInteger length = source.length;
+    unichar *characters = (unichar *)malloc(length * sizeof(unichar));
+    [source getCharacters:characters range:(NSRange){0, length}];
+
+    [self measureBlock:^{
+        @autoreleasepool {
+            NSString *string = [[NSString alloc] initWithCharactersNoCopy:characters length:length freeWhenDone:NO];
+            XCTAssert(strlen([string UTF8String]) > 0);
+            XCTAssert([string dataUsingEncoding:NSUTF8StringEncoding].length > 0);
+        }
+    }];
+    free(characters);
+}
+
+- (void)testCaseFoldingPerformance {
+    NSString *string = AJRUnicodeSample(100000);
+    NSInteger length = string.length;
+    unichar *characters = (unichar *)malloc(length * sizeof(unichar));
+    [string getCharacters:characters range:(NSRange){0, length}];
+
+    [self measureBlock:^{
+        AJRUTF16FoldCase(characters, length, characters);
+    }];
+    free(characters);
+}
+
+@end
@@ -0,0 +1,139 @@
+/*
+ AJRZipDocumentTests.m
+ AJRFoundation
+
+ Copyright © 2023, AJ Raftis and AJRFoundation authors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of AJRFoundation nor the names of its contributors may be
+   used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL AJ RAFTIS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import <XCTest/XCTest.h>
+
+#import <AJRFoundation/AJRFoundation.h>
+
+#import "AJRZipDocument.h"
+#import "AJRZipEntry.h"
+#import "AJRZipTestArchive.h"
+
+@interface AJRZipDocumentTests : XCTestCase
+
+@end
+
+@implementation AJRZipDocumentTests
+
+- (AJRZipDocument *)documentFromArchive:(AJRZipTestArchive *)archive {
+    NSError *localError = nil;
+    NSURL *url = [archive writeToTemporaryFile:&localError];
+    XCTAssert(url != nil && localError == nil);
+
+    AJRZipDocument *document = [[AJRZipDocument alloc] initWithURL:url error:&localError];
+    XCTAssert(document != nil && localError == nil);
+    // The document keeps the file open, so it's fine to remove it now.
+    [NSFileManager.defaultManager removeItemAtURL:url error:NULL];
+    return document;
+}
+
+- (NSArray<NSString *> *)namesOfEntries:(NSArray<AJRZipEntry *> *)entries {
+    NSMutableArray *names = [NSMutableArray array];
+    for (AJRZipEntry *entry in entries) {
+        [names addObject:entry.name];
+    }
+    return names;
+}
+
+- (void)testPathLookup {
+    AJRZipTestArchive *archive = [[AJRZipTestArchive alloc] init];
+    NSData *data = [@"contents" dataUsingEncoding:NSUTF8StringEncoding];
+
+    [archive addEntryWithPath:@"top.txt" data:data deflated:NO];
+    // Implied by its child, and then listed explicitly afterwards.
+    [archive addEntryWithPath:@"implied/child.txt" data:data deflated:NO];
+    [archive addDirectoryWithPath:@"implied/"];
+    // Listed explicitly before its children.
+    [archive addDirectoryWithPath:@"explicit/"];
+    [archive addEntryWithPath:@"explicit/nested/deep.txt" data:data deflated:YES];
+    [archive addDirectoryWithPath:@"empty/"];
+
+    AJRZipDocument *document = [self documentFromArchive:archive];
+    AJRZipEntry *entry;
+
+    XCTAssert([document entryForPath:@"/"] == document.rootEntry);
+
+    entry = [document entryForPath:@"/top.txt"];
+    XCTAssert(entry != nil && entry.isLeaf);
+    XCTAssertEqualObjects(entry.name, @"top.txt");
+    XCTAssertEqualObjects(entry.parentDirectoryPath, @"/");
+    XCTAssertEqualObjects([document dataForEntry:entry error:NULL], data);
+
+    // Directories are indexed with a trailing slash, whether they were listed or implied.
+    for (NSString *path in @[@"/implied/", @"/explicit/", @"/explicit/nested/", @"/empty/"]) {
+        entry = [document entryForPath:path];
+        XCTAssert(entry != nil && !entry.isLeaf, @"Missing directory %@", path);
+        XCTAssertEqualObjects(entry.path, path);
+        XCTAssert([[[document entryForPath:entry.parentDirectoryPath] childEntries] indexOfObjectIdenticalTo:entry] != NSNotFound, @"%@ isn't a child of its parent", path);
+    }
+    XCTAssert([document entryForPath:@"/implied"] == nil);
+
+    // An explicit listing of a directory we'd already implied doesn't create a second copy.
+    entry = [document entryForPath:@"/implied/"];
+    XCTAssertEqualObjects([self namesOfEntries:entry.childEntries], @[@"child.txt"]);
+    XCTAssertEqualObjects([self namesOfEntries:document.rootEntry.childEntries], (@[@"empty", @"explicit", @"implied", @"top.txt"]));
+
+    entry = [document entryForPath:@"/explicit/nested/deep.txt"];
+    XCTAssert(entry != nil && entry.isLeaf);
+    XCTAssertEqualObjects(entry.parentDirectoryPath, @"/explicit/nested/");
+    XCTAssertEqualObjects([document dataForEntry:entry error:NULL], data);
+
+    XCTAssert([document entryForPath:@"/missing.txt"] == nil);
+    XCTAssert([document entryForPath:@"top.txt"] == nil);
+}
+
+- (void)testChildOrdering {
+    AJRZipTestArchive *archive = [[AJRZipTestArchive alloc] init];
+    NSData *data = [@"x" dataUsingEncoding:NSUTF8StringEncoding];
+    NSArray *names = @[@"delta.txt", @"Bravo.txt", @"alpha.txt", @"charlie.txt", @"Echo.txt"];
+
+    for (NSString *name in names) {
+        [archive addEntryWithPath:[@"dir/" stringByAppendingString:name] data:data deflated:NO];
+    }
+
+    AJRZipDocument *document = [self documentFromArchive:archive];
+    AJRZipEntry *directory = [document entryForPath:@"/dir/"];
+    NSArray *sorted = @[@"alpha.txt", @"Bravo.txt", @"charlie.txt", @"delta.txt", @"Echo.txt"];
+
+    // Until someone asks for the sorted children, they stay in archive order.
+    XCTAssertEqualObjects([self namesOfEntries:directory.unsortedChildEntries], names);
+    XCTAssertEqualObjects([self namesOfEntries:directory.childEntries], sorted);
+
+    // Adding a child marks the children as needing sorting again.
+    AJRZipEntry *child = [[AJRZipEntry alloc] initWithPath:@"dir/aardvark.txt" headerOffset:0 CRC:0 compressedSize:1 uncompressedSize:1 compressionType:0];
+    XCTAssert([directory addChildEntry:child]);
+    XCTAssertEqualObjects([self namesOfEntries:directory.childEntries], [@[@"aardvark.txt"] arrayByAddingObjectsFromArray:sorted]);
+
+    // Leaves can't have children.
+    XCTAssert(![child addChildEntry:directory]);
+}
+
+@end
@@ -0,0 +1,179 @@
+/*
+ AJRZipEntryReaderTests.m
+ AJRFoundation
+
+ Copyright © 2023, AJ Raftis and AJRFoundation authors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of AJRFoundation nor the names of its contributors may be
+   used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL AJ RAFTIS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import <XCTest/XCTest.h>
+
+#import <AJRFoundation/AJRFoundation.h>
+
+#import "AJRZipDocument.h"
+#import "AJRZipEntry.h"
+#import "AJRZipEntryReader.h"
+#import "AJRZipTestArchive.h"
+
+@interface AJRZipEntryReaderTests : XCTestCase
+
+@end
+
+@implementation AJRZipEntryReaderTests
+
+// Compressible, but not so compressible that the deflater emits just a few huge blocks. The run of zeros at the end compresses to long chains of matches, which leaves the inflater holding output after it's consumed the last of its input.
+- (NSData *)sampleDataOfLength:(NSUInteger)length zeroTail:(NSUInteger)zeroTail {
+    NSMutableData *data = [NSMutableData dataWithLength:length + zeroTail];
+    uint8_t *bytes = data.mutableBytes;
+    const char *alphabet = "abcdefgh ijklmnop\n";
+    uint32_t seed = 1;
+
+    for (NSUInteger x = 0; x < length; x++) {
+        seed = seed * 1103515245 + 12345;
+        bytes[x] = alphabet[(seed >> 16) % strlen(alphabet)];
+    }
+    return data;
+}
+
+- (AJRZipDocument *)documentWithEntries:(NSDictionary<NSString *, NSData *> *)entries deflated:(BOOL)deflated url:(NSURL **)url {
+    AJRZipTestArchive *archive = [[AJRZipTestArchive alloc] init];
+    NSError *localError = nil;
+
+    for (NSString *path in entries) {
+        [archive addEntryWithPath:path data:entries[path] deflated:deflated];
+    }
+    *url = [archive writeToTemporaryFile:&localError];
+    XCTAssert(*url != nil && localError == nil);
+
+    AJRZipDocument *document = [[AJRZipDocument alloc] initWithURL:*url error:&localError];
+    XCTAssert(document != nil && localError == nil);
+    return document;
+}
+
+- (void)assertReader:(AJRZipEntryReader *)reader matchesData:(NSData *)data inRange:(NSRange)range {
+    NSError *localError = nil;
+    NSData *read = [reader dataOfLength:range.length atOffset:range.location error:&localError];
+    XCTAssert(localError == nil, @"Reading %@ failed: %@", NSStringFromRange(range), localError);
+    XCTAssert([read isEqualToData:[data subdataWithRange:range]], @"Reading %@ returned the wrong bytes", NSStringFromRange(range));
+}
+
+- (void)testStoredEntry {
+    NSData *data = [self sampleDataOfLength:100000 zeroTail:0];
+    NSURL *url;
+    AJRZipDocument *document = [self documentWithEntries:@{@"stored.txt" : data} deflated:NO url:&url];
+    AJRZipEntry *entry = [document entryForPath:@"/stored.txt"];
+    NSError *localError = nil;
+    AJRZipEntryReader *reader = [document readerForEntry:entry error:&localError];
+    uint8_t buffer[64];
+
+    XCTAssert(reader != nil && localError == nil);
+    XCTAssert(reader.isStored);
+    XCTAssert(reader.length == data.length);
+    [self assertReader:reader matchesData:data inRange:(NSRange){0, 10}];
+    [self assertReader:reader matchesData:data inRange:(NSRange){54321, 4000}];
+    [self assertReader:reader matchesData:data inRange:(NSRange){data.length - 1, 1}];
+
+    // Reads past the end are clipped, and reads at the end return nothing.
+    XCTAssert([reader readBytes:buffer length:sizeof(buffer) atOffset:data.length - 10 error:&localError] == 10 && localError == nil);
+    XCTAssert([reader readBytes:buffer length:sizeof(buffer) atOffset:data.length error:&localError] == 0 && localError == nil);
+
+    [NSFileManager.defaultManager removeItemAtURL:url error:NULL];
+}
+
+- (void)testDeflatedRandomAccess {
+    NSData *data = [self sampleDataOfLength:600000 zeroTail:300000];
+    NSURL *url;
+    AJRZipDocument *document = [self documentWithEntries:@{@"deflated.txt" : data} deflated:YES url:&url];
+    AJRZipEntry *entry = [document entryForPath:@"/deflated.txt"];
+    NSError *localError = nil;
+    AJRZipEntryReader *reader = [document readerForEntry:entry error:&localError];
+    uint32_t seed = 7;
+
+    XCTAssert(reader != nil && localError == nil);
+    XCTAssert(!reader.isStored);
+    XCTAssert(reader.length == data.length);
+    XCTAssert([[document dataForEntry:entry error:&localError] isEqualToData:data] && localError == nil);
+
+    // Forwards, backwards, within the current window, and right up to the end of the entry, which is where the inflater runs out of input before it runs out of output.
+    [self assertReader:reader matchesData:data inRange:(NSRange){0, 100}];
+    [self assertReader:reader matchesData:data inRange:(NSRange){500000, 70000}];
+    [self assertReader:reader matchesData:data inRange:(NSRange){560000, 100}];
+    [self assertReader:reader matchesData:data inRange:(NSRange){1000, 1000}];
+    [self assertReader:reader matchesData:data inRange:(NSRange){data.length - 1, 1}];
+    [self assertReader:reader matchesData:data inRange:(NSRange){data.length - 100000, 100000}];
+    for (NSInteger x = 0; x < 50; x++) {
+        NSUInteger location, length;
+        seed = seed * 1103515245 + 12345;
+        location = (seed >> 8) % data.length;
+        seed = seed * 1103515245 + 12345;
+        length = MIN((NSUInteger)((seed >> 8) % 70000) + 1, data.length - location);
+        [self assertReader:reader matchesData:data inRange:(NSRange){location, length}];
+    }
+
+    [NSFileManager.defaultManager removeItemAtURL:url error:NULL];
+}
+
+- (void)testCheckpointSeeking {
+    NSData *data = [self sampleDataOfLength:2 * 1024 * 1024 zeroTail:200000];
+    NSURL *url;
+    AJRZipDocument *document = [self documentWithEntries:@{@"deflated.txt" : data} deflated:YES url:&url];
+    AJRZipEntry *entry = [document entryForPath:@"/deflated.txt"];
+    NSError *localError = nil;
+    AJRZipEntryReader *reader = [document readerForEntry:entry error:&localError];
+    NSUInteger checkpointCount;
+
+    XCTAssert(reader != nil && localError == nil);
+    reader.buildsCheckpointIndex = YES;
+    reader.checkpointSpacing = 64 * 1024;
+    XCTAssert([reader buildCheckpointIndex:&localError] && localError == nil);
+    checkpointCount = reader.checkpointCount;
+    XCTAssert(checkpointCount > 4, @"Expected several checkpoints, but only found %ld", (long)checkpointCount);
+
+    // Building the index again shouldn't add any checkpoints.
+    XCTAssert([reader buildCheckpointIndex:&localError] && localError == nil);
+    XCTAssert(reader.checkpointCount == checkpointCount);
+
+    // Walk backwards through the entry, so every read has to resume from a checkpoint, including reads that straddle one.
+    for (NSUInteger location = data.length; location > 0; ) {
+        NSUInteger length = MIN((NSUInteger)50000, location);
+        location -= length;
+        [self assertReader:reader matchesData:data inRange:(NSRange){location, length}];
+    }
+    [self assertReader:reader matchesData:data inRange:(NSRange){data.length - 1, 1}];
+    [self assertReader:reader matchesData:data inRange:(NSRange){0, data.length}];
+
+    // A fresh reader builds its checkpoints as a side effect of reading, and then reads the same bytes.
+    reader = [document readerForEntry:entry error:&localError];
+    reader.buildsCheckpointIndex = YES;
+    reader.checkpointSpacing = 64 * 1024;
+    [self assertReader:reader matchesData:data inRange:(NSRange){data.length - 10, 10}];
+    XCTAssert(reader.checkpointCount == checkpointCount);
+    [self assertReader:reader matchesData:data inRange:(NSRange){1024 * 1024, 1000}];
+
+    [NSFileManager.defaultManager removeItemAtURL:url error:NULL];
+}
+
+@end
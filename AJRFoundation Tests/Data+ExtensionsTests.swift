@@ -0,0 +1,76 @@
+/*
+ Data+ExtensionsTests.swift
+ AJRFoundation
+
+ Copyright © 2023, AJ Raftis and AJRFoundation authors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of AJRFoundation nor the names of its contributors may be
+   used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL AJ RAFTIS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+import XCTest
+
+import AJRFoundation
+
+class Data_ExtensionsTests: XCTestCase {
+
+    func testHexDecoding() {
+        XCTAssert(Data(hexString: "") == Data())
+        XCTAssert(Data(hexString: "00ff7f80") == Data([0x00, 0xFF, 0x7F, 0x80]))
+        // Either case, or a mix of both, decodes.
+        XCTAssert(Data(hexString: "0123456789abcdef") == Data([0x01, 0x23, 0x45, 0x67, 0x89, 0xAB, 0xCD, 0xEF]))
+        XCTAssert(Data(hexString: "0123456789ABCDEF") == Data([0x01, 0x23, 0x45, 0x67, 0x89, 0xAB, 0xCD, 0xEF]))
+        XCTAssert(Data(hexString: "aBcD") == Data([0xAB, 0xCD]))
+
+        // Odd lengths, since every byte needs two digits.
+        XCTAssert(Data(hexString: "a") == nil)
+        XCTAssert(Data(hexString: "abc") == nil)
+
+        // Bad characters, both in the first pair, and far enough in that the string is decoded in blocks.
+        XCTAssert(Data(hexString: "0g") == nil)
+        XCTAssert(Data(hexString: "g0") == nil)
+        XCTAssert(Data(hexString: "0123456789abcdef0123456789abcdef01x3") == nil)
+        XCTAssert(Data(hexString: "0123456789abcdef0123456789abcdef 123") == nil)
+        XCTAssert(Data(hexString: "éé") == nil)
+    }
+
+    func testHexEncoding() {
+        let data = Data([0x01, 0x23, 0x45, 0x67, 0x89, 0xAB, 0xCD, 0xEF])
+
+        XCTAssert(Data().hexString == "")
+        XCTAssert(Data().hexString(uppercase: false) == "")
+        // hexString has always been uppercase, unlike -[NSData ajr_hexEncodedString].
+        XCTAssert(data.hexString == "0123456789ABCDEF")
+        XCTAssert(data.hexString(uppercase: true) == "0123456789ABCDEF")
+        XCTAssert(data.hexString(uppercase: false) == "0123456789abcdef")
+        XCTAssert(data.hexString(uppercase: false) == (data as NSData).ajr_hexEncodedString())
+
+        // Every byte value, long enough to go through the block encoder, and back again.
+        let all = Data((0 ... 255).map { UInt8($0) })
+        XCTAssert(Data(hexString: all.hexString) == all)
+        XCTAssert(Data(hexString: all.hexString(uppercase: false)) == all)
+        XCTAssert(all.hexString.lowercased() == all.hexString(uppercase: false))
+    }
+
+}
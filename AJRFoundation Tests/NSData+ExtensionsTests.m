@@ -116,6 +116,152 @@ NSDictionary *uuTestSet = nil;
     XCTAssert([data length] == 4 && bytes[0] == 0x69 && bytes[1] == 0xa6 && bytes[2] == 0x9a && bytes[3] == 0x69);
 }
 
+// A straightforward, one character at a time implementation, used to check the vectorized code paths.
+static NSString *AJRReferenceBase64Encode(const uint8_t *bytes, NSInteger length, NSInteger lineBreakPosition) {
+    const char *alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    NSMutableString *result = [NSMutableString string];
+    NSInteger count = 0;
+
+    for (NSInteger x = 0; x < length; x += 3) {
+        [result appendFormat:@"%c", alphabet[bytes[x] >> 2]];
+        if (x + 1 < length) {
+            [result appendFormat:@"%c", alphabet[((bytes[x] & 0x03) << 4) | (bytes[x + 1] >> 4)]];
+            if (x + 2 < length) {
+                [result appendFormat:@"%c%c", alphabet[((bytes[x + 1] & 0x0F) << 2) | (bytes[x + 2] >> 6)], alphabet[bytes[x + 2] & 0x3F]];
+            } else {
+                [result appendFormat:@"%c=", alphabet[(bytes[x + 1] & 0x0F) << 2]];
+            }
+        } else {
+            [result appendFormat:@"%c=", alphabet[(bytes[x] & 0x03) << 4]];
+        }
+        if (lineBreakPosition != AJRBase64NoLineBreak) {
+            count = (count + 1) % lineBreakPosition;
+            if (count == 0) {
+                [result appendString:@"\n"];
+            }
+        }
+    }
+
+    return result;
+}
+
+- (void)testBase64MatchesReference {
+    NSMutableData *data = [NSMutableData dataWithLength:1024];
+    uint8_t *bytes = [data mutableBytes];
+    for (NSInteger x = 0; x < data.length; x++) {
+        bytes[x] = (uint8_t)(x * 2654435761u >> 13);
+    }
+
+    // Cover every remainder and every alignment the vector loops might pick up or drop.
+    for (NSInteger length = 0; length < 300; length++) {
+        for (NSInteger lineBreak = 0; lineBreak < 5; lineBreak++) {
+            NSRange range = (NSRange){length % 7, length};
+            NSString *expected = AJRReferenceBase64Encode(bytes + range.location, length, lineBreak);
+            // The encoder rounds a range that doesn't end on a whole 3 byte quantum up into the bytes that follow it, when there are any, while the reference stops at the end of the range and pads. Ending the data at the end of the range leaves nothing to round into, so both encode exactly the range.
+            NSString *encoded = AJRBase64EncodedString(bytes, NSMaxRange(range), range, lineBreak);
+            XCTAssert([encoded isEqualToString:expected], @"length %ld, line break %ld:\n%@\n%@", (long)length, (long)lineBreak, encoded, expected);
+            XCTAssert(AJRBase64EncodedLength(length, lineBreak) == encoded.length);
+
+            NSError *localError = nil;
+            NSData *decoded = [NSData ajr_dataWithBase64EncodedString:encoded error:&localError];
+            XCTAssert(localError == nil);
+            XCTAssert([decoded isEqualToData:[data subdataWithRange:range]]);
+        }
+    }
+
+    // Junk in the middle of a block has to drop us out of the vector loop, and back in again afterwards.
+    NSString *encoded = [data ajr_base64EncodedString];
+    for (NSInteger x = 0; x < 200; x += 13) {
+        NSMutableString *dirty = [encoded mutableCopy];
+        [dirty insertString:@" \r\n\t" atIndex:x * 3];
+        [dirty insertString:@"=" atIndex:x];
+        NSData *decoded = [NSData ajr_dataWithBase64EncodedString:dirty error:NULL];
+        XCTAssert([decoded isEqualToData:data], @"Failed with junk at %ld", (long)x);
+    }
+}
+
+- (void)testBase64EncodingPerformance {
+    NSMutableData *data = [NSMutableData dataWithLength:16 * 1024 * 1024];
+    uint8_t *bytes = [data mutableBytes];
+    for (NSInteger x = 0; x < data.length; x++) {
+        bytes[x] = (uint8_t)(x * 2654435761u >> 13);
+    }
+
+    [self measureBlock:^{
+        NSString *encoded = [data ajr_base64EncodedString];
+        XCTAssert(encoded.length == AJRBase64EncodedLength(data.length, AJRBase64NoLineBreak));
+    }];
+}
+
+- (void)testBase64DecodingPerformance {
+    NSMutableData *data = [NSMutableData dataWithLength:16 * 1024 * 1024];
+    uint8_t *bytes = [data mutableBytes];
+    for (NSInteger x = 0; x < data.length; x++) {
+        bytes[x] = (uint8_t)(x * 2654435761u >> 13);
+    }
+    NSString *encoded = [data ajr_base64EncodedStringWithLineBreakAtPosition:19];
+
+    [self measureBlock:^{
+        NSData *decoded = [NSData ajr_dataWithBase64EncodedString:encoded error:NULL];
+        XCTAssert(decoded.length == data.length);
+    }];
+}
+
+- (void)testHex {
+    const uint8_t bytes[] = { 0x01, 0x23, 0x45, 0x67, 0x89, 0xAB, 0xCD, 0xEF };
+    NSData *data = [NSData dataWithBytes:bytes length:sizeof(bytes)];
+
+    XCTAssertEqualObjects([data ajr_hexEncodedString], @"0123456789abcdef");
+    XCTAssertEqualObjects([data ajr_hexEncodedStringUsingUppercase:YES], @"0123456789ABCDEF");
+    XCTAssertEqualObjects([[NSData data] ajr_hexEncodedString], @"");
+
+    // Long enough for the vector paths, and with every byte value, checked against a simple encoding.
+    NSMutableData *all = [NSMutableData dataWithLength:1027];
+    uint8_t *allBytes = [all mutableBytes];
+    for (NSInteger x = 0; x < all.length; x++) {
+        allBytes[x] = (uint8_t)(x * 7);
+    }
+    NSMutableString *expected = [NSMutableString string];
+    for (NSInteger x = 0; x < all.length; x++) {
+        [expected appendFormat:@"%02x", allBytes[x]];
+    }
+    XCTAssertEqualObjects([all ajr_hexEncodedString], expected);
+    XCTAssertEqualObjects([all ajr_hexEncodedStringUsingUppercase:YES], [expected uppercaseString]);
+    XCTAssertEqualObjects([[expected uppercaseString] dataFromHexEncodedString], all);
+
+    // Decoding stops exactly at the first bad character, wherever it falls in a block.
+    const char *hex = [expected UTF8String];
+    uint8_t *decoded = (uint8_t *)malloc(all.length);
+    for (size_t bad = 0; bad < 70; bad++) {
+        char *dirty = strdup(hex);
+        dirty[bad] = 'g';
+        size_t consumed = 0;
+        size_t written = AJRHexDecodeCharacters(dirty, strlen(dirty), decoded, &consumed);
+        XCTAssert(consumed == (bad & ~1));
+        XCTAssert(written == bad / 2);
+        XCTAssert(memcmp(decoded, allBytes, written) == 0);
+        free(dirty);
+    }
+    size_t consumed = 0;
+    XCTAssert(AJRHexDecodeCharacters(hex, 65, decoded, &consumed) == 32);
+    XCTAssert(consumed == 64);
+    free(decoded);
+}
+
+- (void)testHexPerformance {
+    NSMutableData *data = [NSMutableData dataWithLength:16 * 1024 * 1024];
+    uint8_t *bytes = [data mutableBytes];
+    for (NSInteger x = 0; x < data.length; x++) {
+        bytes[x] = (uint8_t)(x * 2654435761u >> 13);
+    }
+
+    [self measureBlock:^{
+        NSString *encoded = [data ajr_hexEncodedString];
+        NSData *decoded = [encoded dataFromHexEncodedString];
+        XCTAssert(decoded.length == data.length);
+    }];
+}
+
 - (void)testUUEncoding {
     NSData *data = [testString dataUsingEncoding:NSUTF8StringEncoding];
     
@@ -137,4 +137,78 @@
     XCTAssert(interval == (1.0 * AJRSecondsPerHour) + (15.0 * AJRSecondsPerMinute) + 10.0 + (15.0 / AJRMillisPerSecond));
 }
 
+- (void)testTimePeriodUnits {
+    XCTAssert([NSDate millisecondsForTimePeriodString:@"1234" defaultValue:0] == 1234);
+    XCTAssert([NSDate millisecondsForTimePeriodString:@"1234 milliseconds" defaultValue:0] == 1234);
+    XCTAssert([NSDate millisecondsForTimePeriodString:@"2 minutes" defaultValue:0] == 2 * AJRMillisPerMinute);
+    XCTAssert([NSDate millisecondsForTimePeriodString:@"2 Months" defaultValue:0] == 2 * AJRMillisPer30DayMonth);
+    XCTAssert([NSDate millisecondsForTimePeriodString:@"1.5h" defaultValue:0] == 90 * AJRMillisPerMinute);
+    XCTAssert([NSDate millisecondsForTimePeriodString:@"1d 1w 1y" defaultValue:0] == AJRMillisPerDay + AJRMillisPerWeek + AJRMillisPer365DayYear);
+    XCTAssert([NSDate millisecondsForTimePeriodString:@"hour" defaultValue:0] == AJRMillisPerHour);
+    XCTAssert([NSDate millisecondsForTimePeriodString:@"1e3 ms" defaultValue:0] == 1000);
+    // Scanning stops at the first thing that isn't a term.
+    XCTAssert([NSDate millisecondsForTimePeriodString:@"1s, 2s" defaultValue:0] == 1000);
+    XCTAssert([NSDate millisecondsForTimePeriodString:@"" defaultValue:5] == 5);
+    XCTAssert([NSDate millisecondsForTimePeriodString:@"0s" defaultValue:5] == 5);
+    XCTAssert([NSDate millisecondsForTimePeriodString:@"never" defaultValue:5] == 5);
+
+    XCTAssert([NSDate timeIntervalForTimePeriodString:@"90" defaultValue:0] == 90.0);
+    XCTAssert([NSDate timeIntervalForTimePeriodString:@"-1.5m" defaultValue:0] == -90.0);
+    XCTAssert([NSDate timeIntervalForTimePeriodString:@"0s" defaultValue:5] == 0.0);
+    XCTAssert([NSDate timeIntervalForTimePeriodString:@"never" defaultValue:5] == 5.0);
+    XCTAssert([NSDate timeIntervalForTimePeriodString:nil defaultValue:5] == 5.0);
+}
+
+- (void)testTimePeriodParsing {
+    AJRTimePeriod period;
+
+    AJRParseTimePeriod(@" 1h\n15m 10s 15ms ", &period);
+    XCTAssert(period.termCount == 4);
+    XCTAssert(!period.isClockTime);
+    XCTAssert(period.milliseconds == 4510015);
+    XCTAssert(period.periodInterval == 4510.015);
+    XCTAssert(period.timeInterval == period.periodInterval);
+
+    // A bare number is milliseconds or seconds depending on which you ask for.
+    AJRParseTimePeriod(@"250", &period);
+    XCTAssert(period.milliseconds == 250);
+    XCTAssert(period.timeInterval == 250.0);
+
+    AJRParseTimePeriod(@"1:02:03.5", &period);
+    XCTAssert(period.isClockTime);
+    XCTAssert(period.timeInterval == 3723.5);
+    // The terms stop at the colon, just as they always have.
+    XCTAssert(period.termCount == 1);
+    XCTAssert(period.milliseconds == 1);
+
+    AJRParseTimePeriod(@"9:9:1:02:03", &period);
+    XCTAssert(period.timeInterval == 9.0 * AJRSecondsPerDay + 3723.0);
+
+    AJRParseTimePeriod(@"", &period);
+    XCTAssert(period.termCount == 0 && period.milliseconds == 0 && period.timeInterval == 0.0);
+
+    // The cache hands back the same answers, including for strings that change after being cached.
+    NSMutableString *mutable = [@"5s" mutableCopy];
+    for (NSInteger x = 0; x < 2; x++) {
+        AJRParseTimePeriodUsingCache(mutable, &period);
+        XCTAssert(period.milliseconds == 5000);
+    }
+    [mutable setString:@"7s"];
+    AJRParseTimePeriodUsingCache(mutable, &period);
+    XCTAssert(period.milliseconds == 7000);
+    AJRParseTimePeriodUsingCache(@"5s", &period);
+    XCTAssert(period.milliseconds == 5000);
+}
+
+- (void)testTimePeriodPerformance {
+    NSArray<NSString *> *inputs = @[@"1h 15m 10s 15ms", @"250", @"30 seconds", @"01:12:01.234", @"2 weeks"];
+    [self measureBlock:^{
+        long long total = 0;
+        for (NSInteger x = 0; x < 100000; x++) {
+            total += [NSDate millisecondsForTimePeriodString:inputs[x % inputs.count] defaultValue:0];
+        }
+        XCTAssert(total != 0);
+    }];
+}
+
 @end
@@ -227,6 +227,8 @@
     XCTAssert([test millisecondsForKey:@"milliseconds-notfound" defaultValue:10.0] == 10.0);
     XCTAssert([test millisecondsForKeyPath:@"subdictionary.milliseconds" defaultValue:10.0] == milliseconds);
     XCTAssert([test millisecondsForKeyPath:@"subdictionary.milliseconds-notfound" defaultValue:10.0] == 10.0);
+    XCTAssert([test millisecondsForKey:@"milliseconds-nounits" defaultValue:10.0] == 1234);
+    XCTAssert([test timeIntervalForKey:@"milliseconds" defaultValue:10.0] == milliseconds / 1000.0);
 
     XCTAssert([[test numberForKey:@"char" defaultValue:@(1)] isEqualToNumber:@(charValue)]);
     XCTAssert([[test numberForKey:@"char-notfound" defaultValue:@(1)] isEqualToNumber:@(1)]);
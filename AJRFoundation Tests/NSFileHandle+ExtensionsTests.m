@@ -360,6 +360,73 @@
     [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
 }
 
+- (void)testReadToDelimiter {
+    NSError *localError = nil;
+    NSString *path = [[NSFileManager defaultManager] temporaryFilename];
+    NSMutableData *contents = [NSMutableData data];
+    NSData *delimiter = [@"\r\n" dataUsingEncoding:NSUTF8StringEncoding];
+
+    // Records of growing length, so that some span many read ahead chunks.
+    for (NSInteger x = 0; x < 200; x++) {
+        NSMutableData *record = [NSMutableData dataWithLength:x * 37];
+        memset(record.mutableBytes, 'a' + x % 26, record.length);
+        [contents appendData:record];
+        [contents appendData:delimiter];
+    }
+    [contents appendData:[@"tail" dataUsingEncoding:NSUTF8StringEncoding]];
+    XCTAssert([contents writeToFile:path atomically:NO]);
+
+    NSFileHandle *fileHandle = [NSFileHandle fileHandleForReadingAtPath:path];
+    for (NSInteger x = 0; x < 200; x++) {
+        NSData *record = [fileHandle readToDelimiter:delimiter error:&localError];
+        XCTAssert(record.length == x * 37, @"Expected %d bytes, got %d bytes", (int)(x * 37), (int)record.length);
+        XCTAssert(record.length == 0 || ((const uint8_t *)record.bytes)[record.length - 1] == 'a' + x % 26);
+        // The delimiter isn't consumed, and nothing past it should have been taken from the file.
+        uint8_t bytes[2];
+        size_t readLength = 0;
+        XCTAssert([fileHandle readBytes:bytes length:2 bytesRead:&readLength error:&localError] && readLength == 2);
+        XCTAssert(bytes[0] == '\r' && bytes[1] == '\n');
+    }
+    XCTAssertEqualObjects([fileHandle readToDelimiter:delimiter error:&localError], [@"tail" dataUsingEncoding:NSUTF8StringEncoding]);
+    XCTAssert([fileHandle readToDelimiter:delimiter error:&localError] == nil);
+    XCTAssert(localError == nil);
+    [fileHandle closeFile];
+
+    // Pipes can't seek, so the handle must not read past the delimiter, and the delimiter itself is consumed.
+    NSPipe *pipe = [NSPipe pipe];
+    [pipe.fileHandleForWriting writeData:[@"one\r\ntwo" dataUsingEncoding:NSUTF8StringEncoding]];
+    [pipe.fileHandleForWriting closeFile];
+    XCTAssertEqualObjects([pipe.fileHandleForReading readToDelimiter:delimiter error:&localError], [@"one" dataUsingEncoding:NSUTF8StringEncoding]);
+    XCTAssertEqualObjects([pipe.fileHandleForReading readDataToEndOfFile], [@"two" dataUsingEncoding:NSUTF8StringEncoding]);
+    XCTAssert(localError == nil);
+
+    [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+}
+
+- (void)testReadToBytePerformance {
+    NSString *path = [[NSFileManager defaultManager] temporaryFilename];
+    NSMutableData *contents = [NSMutableData dataWithLength:4 * 1024 * 1024];
+    uint8_t *bytes = contents.mutableBytes;
+    for (NSInteger x = 0; x < contents.length; x++) {
+        bytes[x] = x % 1000 == 999 ? '\n' : 'x';
+    }
+    XCTAssert([contents writeToFile:path atomically:NO]);
+
+    [self measureBlock:^{
+        NSFileHandle *fileHandle = [NSFileHandle fileHandleForReadingAtPath:path];
+        NSInteger count = 0;
+        NSData *record;
+        while ((record = [fileHandle readToByte:'\n' error:NULL]) != nil) {
+            [fileHandle readDataOfLength:1];
+            count++;
+        }
+        XCTAssert(count == (contents.length + 999) / 1000);
+        [fileHandle closeFile];
+    }];
+
+    [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+}
+
 - (void)testReadingAndWritingDataTypes {
     float testFloatValue = 1234.5678;
     double testDoubleValue = 12345678.12345678;
@@ -1125,6 +1192,80 @@
     [NSFileManager.defaultManager removeItemAtPath:path error:NULL];
 }
 
+- (void)testEditStrategies {
+    // Use a block aligned range, so that fallocate() can be used where it's available.
+    NSInteger count = 512 * 1024;
+    NSString *path = [self createFileOfIntegers:count];
+    NSError *localError = nil;
+    AJRFileEditStrategy strategy = AJRFileEditStrategyNone;
+    NSRange range = { 0, 64 * 1024 };
+    NSFileHandle *file;
+
+    file = [NSFileHandle fileHandleForUpdatingAtPath:path createIfNecessary:NO withPermissions:0666 error:&localError];
+    XCTAssert([file removeBytesInRange:range strategy:&strategy error:&localError] && localError == nil);
+    XCTAssert(strategy == AJRFileEditStrategyFallocate || strategy == AJRFileEditStrategyCopyFileRange || strategy == AJRFileEditStrategyReadWrite);
+    AJRPrintf(@"remove strategy: %ld\n", (long)strategy);
+    XCTAssert([[NSFileManager.defaultManager attributesOfItemAtPath:path error:NULL] fileSize] == count * sizeof(uint32_t) - range.length);
+
+    // Put it back, which has to grow the file.
+    NSData *data = [self dataWithBigEndianInts:range.length / sizeof(uint32_t)];
+    XCTAssert([file replaceDataInRange:(NSRange){0, 0} withData:data strategy:&strategy error:&localError] && localError == nil);
+    XCTAssert(strategy == AJRFileEditStrategyFallocate || strategy == AJRFileEditStrategyCopyFileRange || strategy == AJRFileEditStrategyReadWrite);
+    AJRPrintf(@"insert strategy: %ld\n", (long)strategy);
+    XCTAssert([[NSFileManager.defaultManager attributesOfItemAtPath:path error:NULL] fileSize] == count * sizeof(uint32_t));
+
+    // And removing the end of the file is just a truncate.
+    XCTAssert([file removeBytesInRange:(NSRange){(count - 10) * sizeof(uint32_t), 10 * sizeof(uint32_t)} strategy:&strategy error:&localError] && localError == nil);
+    XCTAssert(strategy == AJRFileEditStrategyTruncate);
+    [file closeFile];
+
+    const uint32_t *values = [[NSData dataWithContentsOfFile:path] bytes];
+    for (NSInteger x = 0; x < count - 10; x++) {
+        uint32_t value = x < (NSInteger)(range.length / sizeof(uint32_t)) ? CFSwapInt32BigToHost(values[x]) : CFSwapInt32LittleToHost(values[x]);
+        if (value != x) {
+            XCTFail(@"Expected %ld, but found %u", (long)x, value);
+            break;
+        }
+    }
+    [NSFileManager.defaultManager removeItemAtPath:path error:NULL];
+}
+
+- (void)testLargeUnalignedInsert {
+    // Grow the file by more than AJRFileLargeBufferSize, and by an amount that isn't block aligned, so that the tail has to be moved backwards in multiple chunks rather than via fallocate().
+    NSInteger count = 9 * 1024 * 1024 / sizeof(uint32_t) + 17;
+    NSString *path = [NSFileManager.defaultManager temporaryFilename];
+    NSData *original = [self dataWithBigEndianInts:count];
+    NSError *localError = nil;
+    AJRFileEditStrategy strategy = AJRFileEditStrategyNone;
+    NSRange range = { 101, 10 };
+    NSMutableData *insert = [NSMutableData dataWithLength:4 * 1024 * 1024 + 133];
+    uint8_t *insertBytes = insert.mutableBytes;
+    for (NSUInteger x = 0; x < insert.length; x++) {
+        insertBytes[x] = (uint8_t)(x * 7 + 3);
+    }
+
+    XCTAssert([original writeToFile:path atomically:NO]);
+    NSFileHandle *file = [NSFileHandle fileHandleForUpdatingAtPath:path createIfNecessary:NO withPermissions:0666 error:&localError];
+    XCTAssert(file != nil && localError == nil);
+    XCTAssert([file replaceDataInRange:range withData:insert strategy:&strategy error:&localError] && localError == nil);
+    XCTAssert(strategy == AJRFileEditStrategyCopyFileRange || strategy == AJRFileEditStrategyReadWrite);
+    [file closeFile];
+
+    NSMutableData *expected = [original mutableCopy];
+    [expected replaceBytesInRange:range withBytes:insert.bytes length:insert.length];
+    NSData *result = [NSData dataWithContentsOfFile:path];
+    XCTAssert(result.length == expected.length);
+    XCTAssert([result isEqualToData:expected]);
+
+    // And shrink it back, which moves the tail forward by the same amount.
+    file = [NSFileHandle fileHandleForUpdatingAtPath:path createIfNecessary:NO withPermissions:0666 error:&localError];
+    XCTAssert([file replaceDataInRange:(NSRange){range.location, insert.length} withData:[original subdataWithRange:range] strategy:&strategy error:&localError] && localError == nil);
+    [file closeFile];
+    XCTAssert([[NSData dataWithContentsOfFile:path] isEqualToData:original]);
+
+    [NSFileManager.defaultManager removeItemAtPath:path error:NULL];
+}
+
 #if defined(AJR_DEBUG)
 - (void)testRegisterErrors {
     NSOutputStream *outputStream = [NSOutputStream outputStreamToMemory];
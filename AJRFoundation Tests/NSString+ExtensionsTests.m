@@ -251,6 +251,51 @@ static NSString *longString = @"Lorem ipsum dolor sit amet, consectetur adipisci
     [self checkLineLength:80 in:output];
 }
 
+- (void)testStringWrappingDetails {
+    XCTAssertEqualObjects([@"one two three four" stringByWrappingToWidth:8], @"one two\nthree\nfour");
+    XCTAssertEqualObjects([@"abcdefghij" stringByWrappingToWidth:4], @"abcd\nefgh\nij");
+    XCTAssertEqualObjects([@"a\n\nb\n" stringByWrappingToWidth:4], @"a\n\nb\n");
+    XCTAssertEqualObjects([@"one two three" stringByWrappingToWidth:8 firstLinePrefix:@"* " prefix:@"  " lineSeparator:@"\n" splitURLs:YES], @"* one two\n  three");
+    XCTAssertEqualObjects([@"one two|three four" stringByWrappingToWidth:5 firstLinePrefix:nil prefix:@"> " lineSeparator:@"|" splitURLs:YES], @"> one|> two|> three|> four");
+    XCTAssertEqualObjects([@"http://a/very/long/url tail" stringByWrappingToWidth:8 withLineSeparator:@"\n" splitURLs:NO], @"http://a/very/long/url\ntail");
+    XCTAssertEqualObjects([@"ab c<ahref>d" stringByWrappingToWidth:8 withLineSeparator:@"\n" splitURLs:NO], @"ab c<ahref>\nd");
+    XCTAssertEqualObjects([@"ab c<ahref>d" stringByWrappingToWidth:8 withLineSeparator:@"\n" splitURLs:YES], @"ab\nc<ahref>\nd");
+    // Hard splits don't divide a surrogate pair.
+    XCTAssertEqualObjects([@"a😀b" stringByWrappingToWidth:2], @"a\n😀\nb");
+    XCTAssertEqualObjects([@"" stringByWrappingToWidth:10], @"");
+}
+
+- (void)testStringWrappingToWriter {
+    NSMutableString *input = [NSMutableString string];
+    for (NSInteger x = 0; x < 200; x++) {
+        [input appendString:longString];
+        [input appendString:@" 😀 \n"];
+    }
+    NSString *expected = [input stringByWrappingToWidth:72 firstLinePrefix:@"- " prefix:@"  " lineSeparator:@"\n" splitURLs:NO];
+
+    NSOutputStream *stream = [NSOutputStream outputStreamToMemory];
+    [stream open];
+    NSError *localError = nil;
+    XCTAssert([input writeByWrappingToWidth:72 firstLinePrefix:@"- " prefix:@"  " lineSeparator:@"\n" splitURLs:NO to:stream error:&localError]);
+    XCTAssertNil(localError);
+    [stream close];
+    XCTAssertEqualObjects([stream ajr_dataAsStringUsingEncoding:NSUTF8StringEncoding], expected);
+    [self checkLineLength:74 in:expected];
+}
+
+- (void)testStringWrappingPerformance {
+    NSMutableString *input = [NSMutableString string];
+    for (NSInteger x = 0; x < 100; x++) {
+        [input appendString:longString];
+        [input appendString:@"\n"];
+    }
+    [self measureBlock:^{
+        for (NSInteger x = 0; x < 20; x++) {
+            [input stringByWrappingToWidth:80 withLineSeparator:@"\n" splitURLs:NO];
+        }
+    }];
+}
+
 - (void)testEscapingHTML {
     XCTAssert([[@"This is a string with < and > and & in it." stringByEscapingHTML] isEqualToString:@"This is a string with &lt; and &gt; and &amp; in it."]);
 }
@@ -472,6 +517,23 @@ static NSString *longString = @"Lorem ipsum dolor sit amet, consectetur adipisci
     XCTAssert(data.length == 2);
     XCTAssert(bytes[0] == 0x12);
     XCTAssert(bytes[1] == 0x34);
+
+    // Strings that aren't stored as ASCII are converted a block at a time.
+    data = [@"c0ffee😀" dataFromHexEncodedString];
+    bytes = data.bytes;
+    XCTAssert(data.length == 3);
+    XCTAssert(bytes[0] == 0xC0);
+    XCTAssert(bytes[2] == 0xEE);
+
+    NSMutableString *string = [NSMutableString string];
+    for (NSInteger x = 0; x < 1000; x++) {
+        [string appendString:@"a5"];
+    }
+    [string appendString:@"é"];
+    data = [string dataFromHexEncodedString];
+    bytes = data.bytes;
+    XCTAssert(data.length == 1000);
+    XCTAssert(bytes[0] == 0xA5 && bytes[999] == 0xA5);
 }
 
 - (void)testWordCounts {
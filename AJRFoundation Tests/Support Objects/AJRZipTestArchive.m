@@ -0,0 +1,153 @@
+/*
+ AJRZipTestArchive.m
+ AJRFoundation
+
+ Copyright © 2023, AJ Raftis and AJRFoundation authors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of AJRFoundation nor the names of its contributors may be
+   used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL AJ RAFTIS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import "AJRZipTestArchive.h"
+
+#import <AJRFoundation/AJRFoundation.h>
+#import <zlib.h>
+
+static void AJRAppendUInt16(NSMutableData *data, uint16_t value) {
+    uint8_t bytes[2] = { value & 0xFF, value >> 8 };
+    [data appendBytes:bytes length:sizeof(bytes)];
+}
+
+static void AJRAppendUInt32(NSMutableData *data, uint32_t value) {
+    uint8_t bytes[4] = { value & 0xFF, (value >> 8) & 0xFF, (value >> 16) & 0xFF, value >> 24 };
+    [data appendBytes:bytes length:sizeof(bytes)];
+}
+
+@implementation AJRZipTestArchive
+{
+    NSMutableData *_archive;
+    NSMutableData *_directory;
+    uint16_t _entryCount;
+}
+
+- (id)init {
+    if ((self = [super init])) {
+        _archive = [NSMutableData data];
+        _directory = [NSMutableData data];
+    }
+    return self;
+}
+
+- (NSData *)deflateData:(NSData *)data {
+    z_stream stream = { 0 };
+    NSMutableData *output;
+
+    // Raw deflate, with no zlib header, which is what zip archives contain.
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return nil;
+    }
+    output = [NSMutableData dataWithLength:deflateBound(&stream, (uLong)data.length)];
+    stream.next_in = (Bytef *)data.bytes;
+    stream.avail_in = (uInt)data.length;
+    stream.next_out = output.mutableBytes;
+    stream.avail_out = (uInt)output.length;
+    if (deflate(&stream, Z_FINISH) != Z_STREAM_END) {
+        (void)deflateEnd(&stream);
+        return nil;
+    }
+    output.length = stream.total_out;
+    (void)deflateEnd(&stream);
+    return output;
+}
+
+- (void)addEntryWithPath:(NSString *)path data:(NSData *)data compression:(uint16_t)compression contents:(NSData *)contents {
+    NSData *name = [path dataUsingEncoding:NSUTF8StringEncoding];
+    uint32_t crc = (uint32_t)crc32(crc32(0, NULL, 0), data.bytes, (uInt)data.length);
+    uint32_t headerOffset = (uint32_t)_archive.length;
+
+    // Local file header.
+    AJRAppendUInt32(_archive, 0x04034b50);
+    AJRAppendUInt16(_archive, 20);
+    AJRAppendUInt16(_archive, 0);
+    AJRAppendUInt16(_archive, compression);
+    AJRAppendUInt16(_archive, 0);
+    AJRAppendUInt16(_archive, 0);
+    AJRAppendUInt32(_archive, crc);
+    AJRAppendUInt32(_archive, (uint32_t)contents.length);
+    AJRAppendUInt32(_archive, (uint32_t)data.length);
+    AJRAppendUInt16(_archive, (uint16_t)name.length);
+    AJRAppendUInt16(_archive, 0);
+    [_archive appendData:name];
+    [_archive appendData:contents];
+
+    // Central directory entry.
+    AJRAppendUInt32(_directory, 0x02014b50);
+    AJRAppendUInt16(_directory, 20);
+    AJRAppendUInt16(_directory, 20);
+    AJRAppendUInt16(_directory, 0);
+    AJRAppendUInt16(_directory, compression);
+    AJRAppendUInt16(_directory, 0);
+    AJRAppendUInt16(_directory, 0);
+    AJRAppendUInt32(_directory, crc);
+    AJRAppendUInt32(_directory, (uint32_t)contents.length);
+    AJRAppendUInt32(_directory, (uint32_t)data.length);
+    AJRAppendUInt16(_directory, (uint16_t)name.length);
+    AJRAppendUInt16(_directory, 0);
+    AJRAppendUInt16(_directory, 0);
+    AJRAppendUInt16(_directory, 0);
+    AJRAppendUInt16(_directory, 0);
+    AJRAppendUInt32(_directory, 0);
+    AJRAppendUInt32(_directory, headerOffset);
+    [_directory appendData:name];
+
+    _entryCount += 1;
+}
+
+- (void)addEntryWithPath:(NSString *)path data:(NSData *)data deflated:(BOOL)deflated {
+    [self addEntryWithPath:path data:data compression:deflated ? 8 : 0 contents:deflated ? [self deflateData:data] : data];
+}
+
+- (void)addDirectoryWithPath:(NSString *)path {
+    [self addEntryWithPath:path data:[NSData data] compression:0 contents:[NSData data]];
+}
+
+- (NSURL *)writeToTemporaryFile:(NSError **)error {
+    NSMutableData *file = [_archive mutableCopy];
+    NSURL *url = [NSURL fileURLWithPath:[[NSFileManager.defaultManager temporaryFilename] stringByAppendingPathExtension:@"zip"]];
+
+    [file appendData:_directory];
+    // End of central directory record.
+    AJRAppendUInt32(file, 0x06054b50);
+    AJRAppendUInt16(file, 0);
+    AJRAppendUInt16(file, 0);
+    AJRAppendUInt16(file, _entryCount);
+    AJRAppendUInt16(file, _entryCount);
+    AJRAppendUInt32(file, (uint32_t)_directory.length);
+    AJRAppendUInt32(file, (uint32_t)_archive.length);
+    AJRAppendUInt16(file, 0);
+
+    return [file writeToURL:url options:0 error:error] ? url : nil;
+}
+
+@end
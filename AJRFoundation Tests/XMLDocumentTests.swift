@@ -0,0 +1,167 @@
+/*
+ XMLDocumentTests.swift
+ AJRFoundation
+
+ Copyright © 2023, AJ Raftis and AJRFoundation authors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of AJRFoundation nor the names of its contributors may be
+   used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL AJ RAFTIS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// These exercise our own XML DOM, which is only compiled where Foundation doesn't supply one.
+#if os(Linux) || os(iOS) || os(tvOS) || os(watchOS)
+
+import XCTest
+import AJRFoundation
+
+class XMLDocumentTests: XCTestCase {
+
+    let sample = "<root a=\"1\"><one>1</one><two><three>3 &amp; 4</three></two></root>"
+
+    func temporaryFile(containing text: String) throws -> URL {
+        let url = FileManager.default.temporaryDirectory.appendingPathComponent(UUID().uuidString)
+        try text.data(using: .utf8)!.write(to: url)
+        return url
+    }
+
+    // MARK: - Parsing
+
+    func testParsingData() throws {
+        let document = try XMLDocument(data: sample.data(using: .utf8)!)
+        XCTAssert(document.rootElement()?.name == "root")
+        XCTAssert(document.rootElement()?.description == sample)
+
+        // The parser reads the data's bytes in place, so make sure a slice that doesn't start at zero is read from the right place.
+        var padded = "garbage".data(using: .utf8)!
+        padded.append(sample.data(using: .utf8)!)
+        let slice = padded[7...]
+        XCTAssert(slice.startIndex == 7)
+        let fromSlice = try XMLDocument(data: slice)
+        XCTAssert(fromSlice.rootElement()?.description == sample)
+    }
+
+    func testParsingFileDescriptor() throws {
+        let url = try temporaryFile(containing: sample)
+        defer {
+            try? FileManager.default.removeItem(at: url)
+        }
+
+        let handle = try FileHandle(forReadingFrom: url)
+        defer {
+            try? handle.close()
+        }
+        let document = try XMLDocument(fileDescriptor: handle.fileDescriptor, baseURL: url)
+        XCTAssert(document.rootElement()?.description == sample)
+        XCTAssert(document.baseURL == url)
+
+        // The descriptor belongs to the caller, so it has to still be usable.
+        try handle.seek(toOffset: 0)
+        XCTAssert(try handle.readToEnd() == sample.data(using: .utf8))
+    }
+
+    func testParsingFileURL() throws {
+        let url = try temporaryFile(containing: sample)
+        defer {
+            try? FileManager.default.removeItem(at: url)
+        }
+
+        let document = try XMLDocument(contentsOf: url)
+        XCTAssert(document.rootElement()?.description == sample)
+        XCTAssert(document.baseURL == url)
+    }
+
+    func testFileDescriptorInjectsHTMLDocType() throws {
+        let text = "<html><body><p>One&nbsp;two</p></body></html>"
+        let url = try temporaryFile(containing: text)
+        defer {
+            try? FileManager.default.removeItem(at: url)
+        }
+
+        // Reading from a descriptor has to honor the option the same way parsing data does.
+        let handle = try FileHandle(forReadingFrom: url)
+        defer {
+            try? handle.close()
+        }
+        let fromDescriptor = try XMLDocument(fileDescriptor: handle.fileDescriptor, baseURL: url, options: .documentInjectHTMLDocType)
+        let fromData = try XMLDocument(data: text.data(using: .utf8)!, options: .documentInjectHTMLDocType)
+        XCTAssert(fromDescriptor.rootElement()?.description == fromData.rootElement()?.description)
+        XCTAssert(fromDescriptor.baseURL == url)
+    }
+
+    // MARK: - Serialization
+
+    func makeDocument() -> XMLDocument {
+        let document = XMLDocument()
+        let root = XMLElement(name: "root")
+        let two = XMLElement(name: "two")
+
+        root.addAttribute(withName: "a", stringValue: "1")
+        root.addChild(XMLElement(name: "one", stringValue: "1"))
+        root.addChild(XMLNode.comment(withStringValue: " note ") as! XMLNode)
+        two.addChild(XMLElement(name: "three", stringValue: "3 & 4"))
+        root.addChild(two)
+        document.addChild(root)
+
+        return document
+    }
+
+    func assertSerialization(of document: XMLDocument, options: XMLNode.Options, equals expected: String, file: StaticString = #filePath, line: UInt = #line) {
+        XCTAssert(document.xmlString(options: options) == expected, "Expected:\n\(expected)\nGot:\n\(document.xmlString(options: options))", file: file, line: line)
+        XCTAssert(document.xmlData(options: options) == expected.data(using: .utf8), file: file, line: line)
+    }
+
+    func testSerialization() {
+        // The expected strings are exactly what the original, string building serializer produced.
+        let document = makeDocument()
+        let body = "<root a=\"1\"><one>1</one><!-- note --><two><three>3 &amp; 4</three></two></root>"
+        let prettyBody = "<root a=\"1\">\n    <one>1</one>\n    <!-- note -->\n    <two>\n        <three>3 &amp; 4</three>\n    </two>\n</root>"
+
+        assertSerialization(of: document, options: [], equals: body)
+        assertSerialization(of: document, options: .nodePrettyPrint, equals: prettyBody)
+        XCTAssert(document.xmlData == body.data(using: .utf8))
+
+        document.version = "1.0"
+        document.characterEncoding = "UTF-8"
+        assertSerialization(of: document, options: [], equals: "<?xml version=\"1.0\" encoding=\"UTF-8\"?>" + body)
+        assertSerialization(of: document, options: .nodePrettyPrint, equals: "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n" + prettyBody)
+
+        document.isStandalone = true
+        assertSerialization(of: document, options: [], equals: "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>" + body)
+
+        // Serializing an element on its own still indents it for where it sits in the document.
+        XCTAssert(document.children?.first?.xmlString(options: .nodePrettyPrint) == prettyBody)
+        XCTAssert(XMLDocument().xmlData(options: .nodePrettyPrint).isEmpty)
+    }
+
+    func testParsedDocumentSerialization() throws {
+        let text = "<?xml version=\"1.0\" encoding=\"UTF-8\"?><root a=\"1\"><one>1</one><two><three>3 &amp; 4</three></two></root>"
+        let document = try XMLDocument(data: text.data(using: .utf8)!)
+        for options : XMLNode.Options in [[], .nodePrettyPrint] {
+            XCTAssert(document.xmlData(options: options) == document.xmlString(options: options).data(using: .utf8))
+        }
+    }
+
+}
+
+#endif
@@ -0,0 +1,171 @@
+/*
+ XMLElementTests.swift
+ AJRFoundation
+
+ Copyright © 2023, AJ Raftis and AJRFoundation authors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of AJRFoundation nor the names of its contributors may be
+   used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL AJ RAFTIS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// These exercise our own XML DOM, which is only compiled where Foundation doesn't supply one.
+#if os(Linux) || os(iOS) || os(tvOS) || os(watchOS)
+
+import XCTest
+import AJRFoundation
+
+class XMLElementTests: XCTestCase {
+
+    func attribute(_ name: String, _ value: String) -> XMLNode {
+        return XMLNode.attribute(withName: name, stringValue: value) as! XMLNode
+    }
+
+    func attributeNames(_ element: XMLElement) -> [String] {
+        return element.attributes?.compactMap { $0.name } ?? []
+    }
+
+    // MARK: - Attributes
+
+    func testAttributeOrder() {
+        // Past eight attributes the map builds a hash index, so check both sides of that.
+        for count in [3, 20] {
+            let element = XMLElement(name: "e")
+            let names = (0 ..< count).map { "attribute\(count - $0)" }
+            for name in names {
+                element.addAttribute(attribute(name, name))
+            }
+            XCTAssert(attributeNames(element) == names)
+            for name in names {
+                XCTAssert(element.attribute(forName: name)?.stringValue == name)
+            }
+
+            // Setting an existing attribute replaces its value where it stands.
+            element.addAttribute(attribute(names[1], "new"))
+            XCTAssert(attributeNames(element) == names)
+            XCTAssert(element.attribute(forName: names[1])?.stringValue == "new")
+
+            // Removing closes up the gap, and adding again goes on the end.
+            element.removeAttribute(forName: names[0])
+            XCTAssert(attributeNames(element) == Array(names[1...]))
+            XCTAssert(element.attribute(forName: names[0]) == nil)
+            XCTAssert(element.attribute(forName: names[2])?.stringValue == names[2])
+            element.addAttribute(attribute(names[0], "back"))
+            XCTAssert(attributeNames(element) == Array(names[1...]) + [names[0]])
+            XCTAssert(element.attribute(forName: names[0])?.stringValue == "back")
+        }
+    }
+
+    func testAttributeSerializationOrder() {
+        let element = XMLElement(name: "e")
+        element.addAttribute(withName: "z", stringValue: "1")
+        element.addAttribute(withName: "a", stringValue: "2")
+        element.addAttribute(withName: "m", stringValue: "3")
+        XCTAssert(element.xmlString(options: []) == "<e z=\"1\" a=\"2\" m=\"3\"></e>")
+    }
+
+    func testReplacingAttributes() {
+        let element = XMLElement(name: "e")
+        let a = attribute("a", "1")
+        let b = attribute("b", "2")
+        let c = attribute("c", "3")
+        element.attributes = [a, b, c]
+
+        // Replacing keeps the position, even when the name changes.
+        XCTAssert(element.replaceAttribute(b, with: attribute("x", "4")) === b)
+        XCTAssert(attributeNames(element) == ["a", "x", "c"])
+        XCTAssert(element.attribute(forName: "b") == nil)
+        XCTAssert(element.attribute(forName: "x")?.stringValue == "4")
+
+        // Renaming onto another attribute replaces that one, rather than leaving the name twice.
+        element.replaceAttribute(element.attribute(forName: "x")!, with: attribute("c", "5"))
+        XCTAssert(attributeNames(element) == ["a", "c"])
+        XCTAssert(element.attribute(forName: "c")?.stringValue == "5")
+
+        // Replacing an attribute we don't have just adds the new one.
+        element.replaceAttribute(attribute("missing", ""), with: attribute("d", "6"))
+        XCTAssert(attributeNames(element) == ["a", "c", "d"])
+
+        element.attributes = nil
+        XCTAssert(attributeNames(element) == [])
+    }
+
+    func testAttributeEquality() {
+        let first = XMLElement(name: "e")
+        let second = XMLElement(name: "e")
+        first.addAttribute(withName: "a", stringValue: "1")
+        first.addAttribute(withName: "b", stringValue: "2")
+        second.addAttribute(withName: "b", stringValue: "2")
+        second.addAttribute(withName: "a", stringValue: "1")
+        XCTAssert(first.isEqual(second))
+        second.addAttribute(withName: "c", stringValue: "3")
+        XCTAssert(!first.isEqual(second))
+    }
+
+    // MARK: - Children by Name
+
+    func names(_ elements: [XMLElement]?) -> [String] {
+        return elements?.compactMap { $0.stringValue } ?? []
+    }
+
+    func testChildNameIndex() {
+        let parent = XMLElement(name: "parent")
+        XCTAssert(parent.elements(forName: "item") == nil)
+
+        parent.addChild(XMLElement(name: "item", stringValue: "1"))
+        parent.addChild(XMLElement(name: "other", stringValue: "2"))
+        parent.addChild(XMLElement(name: "item", stringValue: "3"))
+        XCTAssert(names(parent.elements(forName: "item")) == ["1", "3"])
+        XCTAssert(names(parent.elements(forName: "missing")) == [])
+
+        // Each mutation has to discard the index built by the query above.
+        parent.insertChild(XMLElement(name: "item", stringValue: "0"), at: 0)
+        XCTAssert(names(parent.elements(forName: "item")) == ["0", "1", "3"])
+
+        parent.removeChild(at: 1)
+        XCTAssert(names(parent.elements(forName: "item")) == ["0", "3"])
+
+        let other = parent.elements(forName: "other")!.first!
+        parent.removeChild(other)
+        XCTAssert(names(parent.elements(forName: "other")) == [])
+
+        parent.replaceChild(at: 0, with: XMLElement(name: "other", stringValue: "4"))
+        XCTAssert(names(parent.elements(forName: "item")) == ["3"])
+        XCTAssert(names(parent.elements(forName: "other")) == ["4"])
+
+        parent.children = [XMLElement(name: "item", stringValue: "5"), XMLNode.text(withStringValue: "text") as! XMLNode, XMLElement(name: "item", stringValue: "6")]
+        XCTAssert(names(parent.elements(forName: "item")) == ["5", "6"])
+        XCTAssert(names(parent.elements(forName: "other")) == [])
+
+        // So does renaming one of the children.
+        parent.elements(forName: "item")!.first!.name = "renamed"
+        XCTAssert(names(parent.elements(forName: "item")) == ["6"])
+        XCTAssert(names(parent.elements(forName: "renamed")) == ["5"])
+
+        parent.removeAllChildren()
+        XCTAssert(names(parent.elements(forName: "item")) == [])
+    }
+
+}
+
+#endif
@@ -33,10 +33,16 @@
 
 #import <AJRFoundation/AJRActivity.h>
 #import <AJRFoundation/AJRAutoreleasedMemory.h>
+#import <AJRFoundation/AJRBase64Coder.h>
+#import <AJRFoundation/AJRBinaryReader.h>
+#import <AJRFoundation/AJRBinaryWriter.h>
+#import <AJRFoundation/AJRBufferedReader.h>
 #import <AJRFoundation/AJRCaseInsensitiveString.h>
 #import <AJRFoundation/AJRClassEnumerator.h>
+#import <AJRFoundation/AJRCodingStreams.h>
 #import <AJRFoundation/AJRCollection.h>
 #import <AJRFoundation/AJRConversions.h>
+#import <AJRFoundation/AJRDateParser.h>
 #import <AJRFoundation/AJRDelegateProxy.h>
 #import <AJRFoundation/AJREditableObject.h>
 #import <AJRFoundation/AJREditingContext.h>
@@ -79,6 +85,7 @@
 #import <AJRFoundation/AJRUnicode.h>
 #import <AJRFoundation/AJRUniqueObject.h>
 #import <AJRFoundation/AJRUnitsFormatter.h>
+#import <AJRFoundation/AJRUUCoder.h>
 #import <AJRFoundation/AJRVariableEnumerator.h>
 #import <AJRFoundation/AJRXMLArchiver.h>
 #import <AJRFoundation/AJRXMLCoder.h>
@@ -92,6 +99,7 @@
 #import <AJRFoundation/NSCoder+Extensions.h>
 #import <AJRFoundation/NSData+Base64.h>
 #import <AJRFoundation/NSData+Extensions.h>
+#import <AJRFoundation/NSData+Hex.h>
 #import <AJRFoundation/NSData+UU.h>
 #import <AJRFoundation/NSDate+Extensions.h>
 #import <AJRFoundation/NSDictionary+Extensions.h>
@@ -34,6 +34,7 @@
 
 #import <AJRFoundation/AJRFoundation.h>
 
+#import <AJRFoundation/AJRPlugInManifest.h>
 #import <AJRFoundation/AJRXMLCollectionPlaceholder.h>
 
 #endif /* AJRFoundationPrivate_h */
@@ -75,8 +75,8 @@ static NSMutableCharacterSet *operatorSet;
         operatorStartSet = [[NSMutableCharacterSet alloc] init];
         operatorSet = [[NSMutableCharacterSet alloc] init];
         
-        // Since we depend on the plug-in manager, make sure it's initialized.
-        [AJRPlugInManager initializePlugInManager];
+        // Since we depend on the plug-in manager, make sure it's initialized, and that the extension-points filling our registries are registered.
+        [AJRPlugInManager initializePlugInManagerRegisteringExtensionPointsNamed:@[@"ajrconstant", @"ajrfunction", @"ajroperator", @"ajrvariabletype"]];
     });
 }
 
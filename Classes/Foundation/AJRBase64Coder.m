@@ -0,0 +1,150 @@
+/*
+ AJRBase64Coder.m
+ AJRFoundation
+
+ Copyright © 2023, AJ Raftis and AJRFoundation authors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of AJRFoundation nor the names of its contributors may be
+   used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL AJ RAFTIS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import "AJRBase64Coder.h"
+
+#import "AJRFunctions.h"
+#import "NSData+Base64.h"
+#import "NSError+Extensions.h"
+
+@implementation AJRBase64Encoder {
+    size_t _lineLength;
+    // Input that didn't make up a whole quantum on the last call.
+    uint8_t _partial[3];
+    size_t _partialLength;
+    // The number of quanta written to the current line.
+    size_t _column;
+}
+
+- (instancetype)init {
+    return [self initWithLineBreakPosition:AJRBase64NoLineBreak];
+}
+
+- (instancetype)initWithLineBreakPosition:(NSInteger)lineBreakPosition {
+    if ((self = [super init])) {
+        _lineBreakPosition = lineBreakPosition;
+        _lineLength = (size_t)ABS(lineBreakPosition);
+    }
+    return self;
+}
+
+- (void)_appendGroups:(const uint8_t *)bytes count:(size_t)groups toData:(NSMutableData *)output {
+    size_t encodedLength = groups * 4 + (_lineLength ? (_column + groups) / _lineLength : 0);
+    NSUInteger start = output.length;
+
+    [output setLength:start + encodedLength];
+    char *cursor = (char *)output.mutableBytes + start;
+
+    if (_lineLength == 0) {
+        AJRBase64EncodeBytes(bytes, groups * 3, AJRBase64NoLineBreak, cursor);
+    } else {
+        while (groups > 0) {
+            size_t count = MIN(_lineLength - _column, groups);
+            cursor += AJRBase64EncodeBytes(bytes, count * 3, AJRBase64NoLineBreak, cursor);
+            bytes += count * 3;
+            groups -= count;
+            _column += count;
+            if (_column == _lineLength) {
+                *cursor++ = '\n';
+                _column = 0;
+            }
+        }
+    }
+}
+
+- (BOOL)codeBytes:(const void *)bytes length:(size_t)length intoData:(NSMutableData *)output error:(NSError **)error {
+    const uint8_t *input = bytes;
+
+    if (_partialLength > 0) {
+        size_t count = MIN(3 - _partialLength, length);
+        memcpy(_partial + _partialLength, input, count);
+        _partialLength += count;
+        input += count;
+        length -= count;
+        if (_partialLength < 3) {
+            return YES;
+        }
+        [self _appendGroups:_partial count:1 toData:output];
+        _partialLength = 0;
+    }
+
+    size_t groups = length / 3;
+    [self _appendGroups:input count:groups toData:output];
+    _partialLength = length - groups * 3;
+    memcpy(_partial, input + groups * 3, _partialLength);
+
+    return YES;
+}
+
+- (BOOL)finishIntoData:(NSMutableData *)output error:(NSError **)error {
+    if (_partialLength > 0) {
+        char tail[4];
+        [output appendBytes:tail length:AJRBase64EncodeBytes(_partial, _partialLength, AJRBase64NoLineBreak, tail)];
+        if (_lineLength && ++_column == _lineLength) {
+            [output appendBytes:"\n" length:1];
+        }
+    }
+    _partialLength = 0;
+    _column = 0;
+    return YES;
+}
+
+@end
+
+@implementation AJRBase64Decoder {
+    AJRBase64DecodeState _state;
+}
+
+- (BOOL)codeBytes:(const void *)bytes length:(size_t)length intoData:(NSMutableData *)output error:(NSError **)error {
+    NSUInteger start = output.length;
+
+    [output setLength:start + AJRBase64MaximumDecodedLength(length + 3)];
+    size_t decodedLength = AJRBase64DecodeCharactersWithState(bytes, length, (uint8_t *)output.mutableBytes + start, &_state);
+    [output setLength:start + decodedLength];
+
+    return YES;
+}
+
+- (BOOL)finishIntoData:(NSMutableData *)output error:(NSError **)error {
+    NSError *localError = nil;
+    uint8_t tail[2];
+    size_t tailLength = 0;
+
+    if (AJRBase64FinishDecoding(&_state, tail, &tailLength)) {
+        [output appendBytes:tail length:tailLength];
+    } else {
+        localError = [NSError errorWithDomain:AJRDataErrorDomain message:@"Warning: B64 data stream is truncated."];
+    }
+
+    return AJRAssertOrPropagateError(localError == nil, error, localError);
+}
+
+@end
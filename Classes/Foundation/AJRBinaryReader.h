@@ -0,0 +1,130 @@
+/*
+ AJRBinaryReader.h
+ AJRFoundation
+
+ Copyright © 2023, AJ Raftis and AJRFoundation authors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of AJRFoundation nor the names of its contributors may be
+   used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL AJ RAFTIS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import <AJRFoundation/AJRStreamUtilities.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*!
+ A cursor that decodes typed binary values directly out of a contiguous region of memory, such as an NSData, a memory mapped file, or a buffer you manage yourself.
+
+ Where the AJRReadInt32() family of functions issues a stream read for every value, AJRBinaryReader simply checks the bounds and decodes the value in place, which makes it the right tool for formats with many small fields. Reading past the end of the region never raises. Instead, the read fails, the offset is left unchanged, and `error` is initialized in the AJRStreamErrorDomain.
+
+ The reader also conforms to AJRByteReader, so it can be handed to anything that reads from a stream.
+ */
+@interface AJRBinaryReader : NSObject <AJRByteReader>
+
++ (instancetype)binaryReaderWithData:(NSData *)data;
+
+/*!
+ Creates a reader over the bytes of `data`. The bytes aren't copied, but `data` is retained for the life of the reader. If `data` is mutable, you must not change its length while reading.
+ */
+- (instancetype)initWithData:(NSData *)data;
+/*!
+ Creates a reader over `length` bytes at `bytes`. The bytes aren't copied or retained, so they must remain valid as long as the reader is in use.
+ */
+- (instancetype)initWithBytesNoCopy:(const void *)bytes length:(size_t)length;
+
+/*! The data being read, if the reader was created with one. */
+@property (nullable,nonatomic,readonly) NSData *data;
+@property (nonatomic,readonly) const uint8_t *bytes;
+@property (nonatomic,readonly) size_t length;
+/*! The offset of the next byte to read. */
+@property (nonatomic,readonly) size_t offset;
+/*! The number of bytes from offset to the end of the region. */
+@property (nonatomic,readonly) size_t remainingLength;
+@property (nonatomic,readonly) BOOL isAtEnd;
+
+/*! The endianness used by the typed readers that don't take an explicit endianness. Defaults to AJREndiannessBig, like the other byte readers. */
+@property (nonatomic,assign) AJREndianness endianness;
+@property (nonatomic,assign) NSStringEncoding encoding;
+@property (nonatomic,readonly,nullable) NSString *encodingName;
+
+#pragma mark - Positioning
+
+- (BOOL)seekToOffset:(size_t)offset error:(out NSError * _Nullable * _Nullable)error;
+- (BOOL)skipBytes:(size_t)length error:(out NSError * _Nullable * _Nullable)error;
+
+#pragma mark - Raw Bytes
+
+/*!
+ Returns a pointer to the next `length` bytes and advances past them. Nothing is copied, so the pointer is only valid as long as the underlying region is.
+ */
+- (nullable const void *)readBytesNoCopyOfLength:(size_t)length error:(out NSError * _Nullable * _Nullable)error;
+/*! Returns a copy of the next `length` bytes. */
+- (nullable NSData *)readDataOfLength:(size_t)length error:(out NSError * _Nullable * _Nullable)error;
+/*!
+ The AJRByteReader primitive. Like read(2), this reads fewer than `length` bytes when fewer remain, and sets `readLength` to 0 at the end of the region.
+ */
+- (BOOL)readBytes:(void *)buffer length:(size_t)length bytesRead:(out nullable size_t *)readLength error:(out NSError * _Nullable * _Nullable)error;
+
+#pragma mark - Typed Values
+
+- (BOOL)readInt8:(out int8_t *)value error:(out NSError * _Nullable * _Nullable)error;
+- (BOOL)readUInt8:(out uint8_t *)value error:(out NSError * _Nullable * _Nullable)error;
+- (BOOL)readInt16:(out int16_t *)value error:(out NSError * _Nullable * _Nullable)error;
+- (BOOL)readInt16:(out int16_t *)value endianness:(AJREndianness)endianness error:(out NSError * _Nullable * _Nullable)error;
+- (BOOL)readUInt16:(out uint16_t *)value error:(out NSError * _Nullable * _Nullable)error;
+- (BOOL)readUInt16:(out uint16_t *)value endianness:(AJREndianness)endianness error:(out NSError * _Nullable * _Nullable)error;
+- (BOOL)readInt32:(out int32_t *)value error:(out NSError * _Nullable * _Nullable)error;
+- (BOOL)readInt32:(out int32_t *)value endianness:(AJREndianness)endianness error:(out NSError * _Nullable * _Nullable)error;
+- (BOOL)readUInt32:(out uint32_t *)value error:(out NSError * _Nullable * _Nullable)error;
+- (BOOL)readUInt32:(out uint32_t *)value endianness:(AJREndianness)endianness error:(out NSError * _Nullable * _Nullable)error;
+- (BOOL)readInt64:(out int64_t *)value error:(out NSError * _Nullable * _Nullable)error;
+- (BOOL)readInt64:(out int64_t *)value endianness:(AJREndianness)endianness error:(out NSError * _Nullable * _Nullable)error;
+- (BOOL)readUInt64:(out uint64_t *)value error:(out NSError * _Nullable * _Nullable)error;
+- (BOOL)readUInt64:(out uint64_t *)value endianness:(AJREndianness)endianness error:(out NSError * _Nullable * _Nullable)error;
+- (BOOL)readFloat:(out float *)value error:(out NSError * _Nullable * _Nullable)error;
+- (BOOL)readFloat:(out float *)value endianness:(AJREndianness)endianness error:(out NSError * _Nullable * _Nullable)error;
+- (BOOL)readDouble:(out double *)value error:(out NSError * _Nullable * _Nullable)error;
+- (BOOL)readDouble:(out double *)value endianness:(AJREndianness)endianness error:(out NSError * _Nullable * _Nullable)error;
+
+/*!
+ Reads an unsigned LEB128 variable length integer, as used by Protocol Buffers, DWARF, and WebAssembly. Fails if the value is truncated or doesn't fit in 64 bits.
+ */
+- (BOOL)readVarUInt:(out uint64_t *)value error:(out NSError * _Nullable * _Nullable)error;
+/*! Reads a zig-zag encoded, signed variable length integer. */
+- (BOOL)readVarInt:(out int64_t *)value error:(out NSError * _Nullable * _Nullable)error;
+
+#pragma mark - Arrays
+
+/*!
+ Reads `count` consecutive values into `values`. The whole array is bounds checked once and copied with a single memcpy(), after which the values are byte swapped in place if necessary. If there aren't `count` values left, nothing is read.
+ */
+- (BOOL)readUInt16s:(out uint16_t *)values count:(size_t)count endianness:(AJREndianness)endianness error:(out NSError * _Nullable * _Nullable)error;
+- (BOOL)readUInt32s:(out uint32_t *)values count:(size_t)count endianness:(AJREndianness)endianness error:(out NSError * _Nullable * _Nullable)error;
+- (BOOL)readUInt64s:(out uint64_t *)values count:(size_t)count endianness:(AJREndianness)endianness error:(out NSError * _Nullable * _Nullable)error;
+- (BOOL)readFloats:(out float *)values count:(size_t)count endianness:(AJREndianness)endianness error:(out NSError * _Nullable * _Nullable)error;
+- (BOOL)readDoubles:(out double *)values count:(size_t)count endianness:(AJREndianness)endianness error:(out NSError * _Nullable * _Nullable)error;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,334 @@
+/*
+ AJRBinaryReader.m
+ AJRFoundation
+
+ Copyright © 2023, AJ Raftis and AJRFoundation authors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of AJRFoundation nor the names of its contributors may be
+   used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL AJ RAFTIS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import "AJRBinaryReader.h"
+
+#import "AJRFileOutputStream.h"
+#import "AJRFunctions.h"
+#import "NSError+Extensions.h"
+
+@implementation AJRBinaryReader {
+    const uint8_t *_bytes;
+    size_t _length;
+    size_t _offset;
+}
+
+#pragma mark - Creation
+
++ (instancetype)binaryReaderWithData:(NSData *)data {
+    return [[self alloc] initWithData:data];
+}
+
+- (instancetype)initWithData:(NSData *)data {
+    if ((self = [self initWithBytesNoCopy:data.bytes length:data.length])) {
+        _data = data;
+    }
+    return self;
+}
+
+- (instancetype)initWithBytesNoCopy:(const void *)bytes length:(size_t)length {
+    if ((self = [super init])) {
+        _bytes = bytes;
+        _length = length;
+        _endianness = AJREndiannessBig;
+        _encoding = NSUTF8StringEncoding;
+    }
+    return self;
+}
+
+#pragma mark - Properties
+
+- (size_t)remainingLength {
+    return _length - _offset;
+}
+
+- (BOOL)isAtEnd {
+    return _offset == _length;
+}
+
+- (NSString *)encodingName {
+    return AJRIANANameFromStringEncoding(_encoding);
+}
+
+#pragma mark - Bounds
+
+- (NSError *)_errorReadingLength:(size_t)length {
+    return [NSError errorWithDomain:AJRStreamErrorDomain format:@"Attempt to read %zu bytes at offset %zu, but only %zu bytes remain.", length, _offset, _length - _offset];
+}
+
+/*!
+ Returns the address of the next `length` bytes and advances past them, or returns NULL, leaving the offset alone, if there aren't that many bytes left. This is the only place reads are bounds checked.
+ */
+static inline const uint8_t *AJRBinaryReaderTake(AJRBinaryReader *self, size_t length, NSError **error) {
+    if (length > self->_length - self->_offset) {
+        AJRSetOutParameter(error, [self _errorReadingLength:length]);
+        return NULL;
+    }
+    const uint8_t *bytes = self->_bytes + self->_offset;
+    self->_offset += length;
+    return bytes;
+}
+
+#pragma mark - Positioning
+
+- (BOOL)seekToOffset:(size_t)offset error:(NSError **)error {
+    if (offset > _length) {
+        AJRSetOutParameter(error, [NSError errorWithDomain:AJRStreamErrorDomain format:@"Attempt to seek to offset %zu past the end of %zu bytes.", offset, _length]);
+        return NO;
+    }
+    _offset = offset;
+    return YES;
+}
+
+- (BOOL)skipBytes:(size_t)length error:(NSError **)error {
+    return AJRBinaryReaderTake(self, length, error) != NULL;
+}
+
+#pragma mark - Raw Bytes
+
+- (const void *)readBytesNoCopyOfLength:(size_t)length error:(NSError **)error {
+    return AJRBinaryReaderTake(self, length, error);
+}
+
+- (NSData *)readDataOfLength:(size_t)length error:(NSError **)error {
+    const uint8_t *bytes = AJRBinaryReaderTake(self, length, error);
+    return bytes ? [NSData dataWithBytes:bytes length:length] : nil;
+}
+
+- (BOOL)readBytes:(void *)buffer length:(size_t)length bytesRead:(size_t *)readLength error:(NSError **)error {
+    length = MIN(length, _length - _offset);
+    memcpy(buffer, _bytes + _offset, length);
+    _offset += length;
+    AJRSetOutParameter(readLength, length);
+    return YES;
+}
+
+#pragma mark - Typed Values
+
+- (BOOL)readInt8:(int8_t *)value error:(NSError **)error {
+    const uint8_t *bytes = AJRBinaryReaderTake(self, sizeof(int8_t), error);
+    if (bytes) {
+        AJRSetOutParameter(value, (int8_t)bytes[0]);
+    }
+    return bytes != NULL;
+}
+
+- (BOOL)readUInt8:(uint8_t *)value error:(NSError **)error {
+    const uint8_t *bytes = AJRBinaryReaderTake(self, sizeof(uint8_t), error);
+    if (bytes) {
+        AJRSetOutParameter(value, bytes[0]);
+    }
+    return bytes != NULL;
+}
+
+- (BOOL)readInt16:(int16_t *)value error:(NSError **)error {
+    return [self readInt16:value endianness:_endianness error:error];
+}
+
+- (BOOL)readInt16:(int16_t *)value endianness:(AJREndianness)endianness error:(NSError **)error {
+    const uint8_t *bytes = AJRBinaryReaderTake(self, sizeof(int16_t), error);
+    if (bytes) {
+        AJRSetOutParameter(value, (int16_t)AJRDecodeUInt16(bytes, endianness));
+    }
+    return bytes != NULL;
+}
+
+- (BOOL)readUInt16:(uint16_t *)value error:(NSError **)error {
+    return [self readUInt16:value endianness:_endianness error:error];
+}
+
+- (BOOL)readUInt16:(uint16_t *)value endianness:(AJREndianness)endianness error:(NSError **)error {
+    const uint8_t *bytes = AJRBinaryReaderTake(self, sizeof(uint16_t), error);
+    if (bytes) {
+        AJRSetOutParameter(value, AJRDecodeUInt16(bytes, endianness));
+    }
+    return bytes != NULL;
+}
+
+- (BOOL)readInt32:(int32_t *)value error:(NSError **)error {
+    return [self readInt32:value endianness:_endianness error:error];
+}
+
+- (BOOL)readInt32:(int32_t *)value endianness:(AJREndianness)endianness error:(NSError **)error {
+    const uint8_t *bytes = AJRBinaryReaderTake(self, sizeof(int32_t), error);
+    if (bytes) {
+        AJRSetOutParameter(value, (int32_t)AJRDecodeUInt32(bytes, endianness));
+    }
+    return bytes != NULL;
+}
+
+- (BOOL)readUInt32:(uint32_t *)value error:(NSError **)error {
+    return [self readUInt32:value endianness:_endianness error:error];
+}
+
+- (BOOL)readUInt32:(uint32_t *)value endianness:(AJREndianness)endianness error:(NSError **)error {
+    const uint8_t *bytes = AJRBinaryReaderTake(self, sizeof(uint32_t), error);
+    if (bytes) {
+        AJRSetOutParameter(value, AJRDecodeUInt32(bytes, endianness));
+    }
+    return bytes != NULL;
+}
+
+- (BOOL)readInt64:(int64_t *)value error:(NSError **)error {
+    return [self readInt64:value endianness:_endianness error:error];
+}
+
+- (BOOL)readInt64:(int64_t *)value endianness:(AJREndianness)endianness error:(NSError **)error {
+    const uint8_t *bytes = AJRBinaryReaderTake(self, sizeof(int64_t), error);
+    if (bytes) {
+        AJRSetOutParameter(value, (int64_t)AJRDecodeUInt64(bytes, endianness));
+    }
+    return bytes != NULL;
+}
+
+- (BOOL)readUInt64:(uint64_t *)value error:(NSError **)error {
+    return [self readUInt64:value endianness:_endianness error:error];
+}
+
+- (BOOL)readUInt64:(uint64_t *)value endianness:(AJREndianness)endianness error:(NSError **)error {
+    const uint8_t *bytes = AJRBinaryReaderTake(self, sizeof(uint64_t), error);
+    if (bytes) {
+        AJRSetOutParameter(value, AJRDecodeUInt64(bytes, endianness));
+    }
+    return bytes != NULL;
+}
+
+- (BOOL)readFloat:(float *)value error:(NSError **)error {
+    return [self readFloat:value endianness:_endianness error:error];
+}
+
+- (BOOL)readFloat:(float *)value endianness:(AJREndianness)endianness error:(NSError **)error {
+    const uint8_t *bytes = AJRBinaryReaderTake(self, sizeof(float), error);
+    if (bytes) {
+        uint32_t bits = AJRDecodeUInt32(bytes, endianness);
+        float work;
+        memcpy(&work, &bits, sizeof(work));
+        AJRSetOutParameter(value, work);
+    }
+    return bytes != NULL;
+}
+
+- (BOOL)readDouble:(double *)value error:(NSError **)error {
+    return [self readDouble:value endianness:_endianness error:error];
+}
+
+- (BOOL)readDouble:(double *)value endianness:(AJREndianness)endianness error:(NSError **)error {
+    const uint8_t *bytes = AJRBinaryReaderTake(self, sizeof(double), error);
+    if (bytes) {
+        uint64_t bits = AJRDecodeUInt64(bytes, endianness);
+        double work;
+        memcpy(&work, &bits, sizeof(work));
+        AJRSetOutParameter(value, work);
+    }
+    return bytes != NULL;
+}
+
+#pragma mark - Variable Length Integers
+
+- (BOOL)readVarUInt:(uint64_t *)value error:(NSError **)error {
+    uint64_t work = 0;
+    size_t offset = _offset;
+
+    for (NSInteger shift = 0; shift < 64; shift += 7) {
+        if (offset == _length) {
+            AJRSetOutParameter(error, [NSError errorWithDomain:AJRStreamErrorDomain format:@"Variable length integer at offset %zu is truncated.", _offset]);
+            return NO;
+        }
+        uint8_t byte = _bytes[offset++];
+        // The tenth byte may only contribute the single remaining bit.
+        if (shift == 63 && byte > 1) {
+            break;
+        }
+        work |= (uint64_t)(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            _offset = offset;
+            AJRSetOutParameter(value, work);
+            return YES;
+        }
+    }
+
+    AJRSetOutParameter(error, [NSError errorWithDomain:AJRStreamErrorDomain format:@"Variable length integer at offset %zu doesn't fit in 64 bits.", _offset]);
+    return NO;
+}
+
+- (BOOL)readVarInt:(int64_t *)value error:(NSError **)error {
+    uint64_t work;
+    if ([self readVarUInt:&work error:error]) {
+        AJRSetOutParameter(value, (int64_t)(work >> 1) ^ -(int64_t)(work & 1));
+        return YES;
+    }
+    return NO;
+}
+
+#pragma mark - Arrays
+
+// Copies count values of the given width, in bits, and then swaps them in place if they're not already in host order. The swap loop is simple enough that the compiler vectorizes it.
+#define AJRBinaryReaderReadArray(values, count, width, endianness, error) ({ \
+    BOOL _success = NO; \
+    if (count > SIZE_MAX / (width / 8)) { \
+        AJRSetOutParameter(error, [self _errorReadingLength:SIZE_MAX]); \
+    } else { \
+        const uint8_t *_source = AJRBinaryReaderTake(self, count * (width / 8), error); \
+        if (_source) { \
+            uint ## width ## _t *_values = (uint ## width ## _t *)values; \
+            memcpy(_values, _source, count * (width / 8)); \
+            if (endianness != AJRGetCurrentArchitectureEndianness()) { \
+                for (size_t _x = 0; _x < count; _x++) { \
+                    _values[_x] = __builtin_bswap ## width(_values[_x]); \
+                } \
+            } \
+            _success = YES; \
+        } \
+    } \
+    _success; \
+})
+
+- (BOOL)readUInt16s:(uint16_t *)values count:(size_t)count endianness:(AJREndianness)endianness error:(NSError **)error {
+    return AJRBinaryReaderReadArray(values, count, 16, endianness, error);
+}
+
+- (BOOL)readUInt32s:(uint32_t *)values count:(size_t)count endianness:(AJREndianness)endianness error:(NSError **)error {
+    return AJRBinaryReaderReadArray(values, count, 32, endianness, error);
+}
+
+- (BOOL)readUInt64s:(uint64_t *)values count:(size_t)count endianness:(AJREndianness)endianness error:(NSError **)error {
+    return AJRBinaryReaderReadArray(values, count, 64, endianness, error);
+}
+
+- (BOOL)readFloats:(float *)values count:(size_t)count endianness:(AJREndianness)endianness error:(NSError **)error {
+    return AJRBinaryReaderReadArray(values, count, 32, endianness, error);
+}
+
+- (BOOL)readDoubles:(double *)values count:(size_t)count endianness:(AJREndianness)endianness error:(NSError **)error {
+    return AJRBinaryReaderReadArray(values, count, 64, endianness, error);
+}
+
+@end
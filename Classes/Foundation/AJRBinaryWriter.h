@@ -0,0 +1,114 @@
+/*
+ AJRBinaryWriter.h
+ AJRFoundation
+
+ Copyright © 2023, AJ Raftis and AJRFoundation authors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of AJRFoundation nor the names of its contributors may be
+   used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL AJ RAFTIS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import <AJRFoundation/AJRStreamUtilities.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*!
+ The counterpart to AJRBinaryReader. Encodes typed binary values by appending them to a contiguous, growable buffer, with no stream call per value.
+
+ The buffer grows geometrically, so appending is amortized constant time. Calling removeAllBytes keeps the allocation, which lets one writer be reused for many messages without allocating.
+
+ The writer also conforms to AJRByteWriter, so it can be handed to anything that writes to a stream, including the AJRWriteString() family of functions.
+ */
+@interface AJRBinaryWriter : NSObject <AJRByteWriter>
+
++ (instancetype)binaryWriter;
++ (instancetype)binaryWriterWithCapacity:(size_t)capacity;
+
+- (instancetype)init;
+- (instancetype)initWithCapacity:(size_t)capacity;
+/*!
+ Creates a writer that appends to the end of `data`. The data is written to directly, but while writing, its length may include some unused capacity. Asking the writer for its data trims it back to the bytes actually written.
+ */
+- (instancetype)initWithMutableData:(NSMutableData *)data;
+
+/*! The bytes written so far, including anything that was already in the data passed to initWithMutableData:. This isn't a copy, so it will change if you continue writing. */
+@property (nonatomic,readonly) NSData *data;
+/*! The bytes written so far, which remain valid until the next write. */
+@property (nonatomic,readonly) const uint8_t *bytes;
+@property (nonatomic,readonly) size_t length;
+
+@property (nonatomic,assign) AJREndianness endianness;
+@property (nonatomic,assign) NSStringEncoding encoding;
+@property (nonatomic,readonly,nullable) NSString *encodingName;
+
+/*! Makes sure at least `length` more bytes can be written without growing the buffer. */
+- (void)reserveCapacity:(size_t)length;
+/*! Discards everything written, but keeps the buffer for reuse. */
+- (void)removeAllBytes;
+
+#pragma mark - Raw Bytes
+
+/*! The AJRByteWriter primitive. Writing to memory can't fail, so this always returns YES. */
+- (BOOL)writeBytes:(const void *)bytes length:(size_t)length bytesWritten:(nullable out size_t *)bytesWritten error:(out NSError * _Nullable * _Nullable)error;
+- (void)appendBytes:(const void *)bytes length:(size_t)length;
+- (void)appendData:(NSData *)data;
+
+#pragma mark - Typed Values
+
+- (void)appendInt8:(int8_t)value;
+- (void)appendUInt8:(uint8_t)value;
+- (void)appendInt16:(int16_t)value;
+- (void)appendInt16:(int16_t)value endianness:(AJREndianness)endianness;
+- (void)appendUInt16:(uint16_t)value;
+- (void)appendUInt16:(uint16_t)value endianness:(AJREndianness)endianness;
+- (void)appendInt32:(int32_t)value;
+- (void)appendInt32:(int32_t)value endianness:(AJREndianness)endianness;
+- (void)appendUInt32:(uint32_t)value;
+- (void)appendUInt32:(uint32_t)value endianness:(AJREndianness)endianness;
+- (void)appendInt64:(int64_t)value;
+- (void)appendInt64:(int64_t)value endianness:(AJREndianness)endianness;
+- (void)appendUInt64:(uint64_t)value;
+- (void)appendUInt64:(uint64_t)value endianness:(AJREndianness)endianness;
+- (void)appendFloat:(float)value;
+- (void)appendFloat:(float)value endianness:(AJREndianness)endianness;
+- (void)appendDouble:(double)value;
+- (void)appendDouble:(double)value endianness:(AJREndianness)endianness;
+
+/*! Appends an unsigned LEB128 variable length integer. See -[AJRBinaryReader readVarUInt:error:]. */
+- (void)appendVarUInt:(uint64_t)value;
+/*! Appends a zig-zag encoded, signed variable length integer. */
+- (void)appendVarInt:(int64_t)value;
+
+#pragma mark - Arrays
+
+/*! Appends `count` values, copying them with a single memcpy() and then byte swapping them in place if necessary. */
+- (void)appendUInt16s:(const uint16_t *)values count:(size_t)count endianness:(AJREndianness)endianness;
+- (void)appendUInt32s:(const uint32_t *)values count:(size_t)count endianness:(AJREndianness)endianness;
+- (void)appendUInt64s:(const uint64_t *)values count:(size_t)count endianness:(AJREndianness)endianness;
+- (void)appendFloats:(const float *)values count:(size_t)count endianness:(AJREndianness)endianness;
+- (void)appendDoubles:(const double *)values count:(size_t)count endianness:(AJREndianness)endianness;
+
+@end
+
+NS_ASSUME_NONNULL_END
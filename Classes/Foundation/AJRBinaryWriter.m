@@ -0,0 +1,273 @@
+/*
+ AJRBinaryWriter.m
+ AJRFoundation
+
+ Copyright © 2023, AJ Raftis and AJRFoundation authors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of AJRFoundation nor the names of its contributors may be
+   used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL AJ RAFTIS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import "AJRBinaryWriter.h"
+
+#import "AJRFunctions.h"
+
+#define AJRBinaryWriterMinimumCapacity 64
+
+@implementation AJRBinaryWriter {
+    NSMutableData *_data;
+    uint8_t *_bytes;
+    size_t _length;
+    size_t _capacity;
+}
+
+#pragma mark - Creation
+
++ (instancetype)binaryWriter {
+    return [[self alloc] init];
+}
+
++ (instancetype)binaryWriterWithCapacity:(size_t)capacity {
+    return [[self alloc] initWithCapacity:capacity];
+}
+
+- (instancetype)init {
+    return [self initWithCapacity:AJRBinaryWriterMinimumCapacity];
+}
+
+- (instancetype)initWithCapacity:(size_t)capacity {
+    if ((self = [self initWithMutableData:[NSMutableData dataWithCapacity:capacity]])) {
+        [self reserveCapacity:capacity];
+    }
+    return self;
+}
+
+- (instancetype)initWithMutableData:(NSMutableData *)data {
+    if ((self = [super init])) {
+        _data = data;
+        _bytes = data.mutableBytes;
+        _length = data.length;
+        _capacity = _length;
+        _endianness = AJREndiannessBig;
+        _encoding = NSUTF8StringEncoding;
+    }
+    return self;
+}
+
+#pragma mark - Properties
+
+- (NSData *)data {
+    if (_capacity != _length) {
+        _data.length = _length;
+        _bytes = _data.mutableBytes;
+        _capacity = _length;
+    }
+    return _data;
+}
+
+- (NSString *)encodingName {
+    return AJRIANANameFromStringEncoding(_encoding);
+}
+
+#pragma mark - Buffer Management
+
+- (void)_growToFit:(size_t)length {
+    size_t capacity = MAX(MAX(_capacity * 2, _length + length), (size_t)AJRBinaryWriterMinimumCapacity);
+    _data.length = capacity;
+    _bytes = _data.mutableBytes;
+    _capacity = capacity;
+}
+
+/*!
+ Returns the address at which the next `length` bytes should be written, and accounts for them as written.
+ */
+static inline uint8_t *AJRBinaryWriterAppend(AJRBinaryWriter *self, size_t length) {
+    if (length > self->_capacity - self->_length) {
+        [self _growToFit:length];
+    }
+    uint8_t *bytes = self->_bytes + self->_length;
+    self->_length += length;
+    return bytes;
+}
+
+- (void)reserveCapacity:(size_t)length {
+    if (length > _capacity - _length) {
+        [self _growToFit:length];
+    }
+}
+
+- (void)removeAllBytes {
+    _length = 0;
+}
+
+#pragma mark - Raw Bytes
+
+- (BOOL)writeBytes:(const void *)bytes length:(size_t)length bytesWritten:(size_t *)bytesWritten error:(NSError **)error {
+    [self appendBytes:bytes length:length];
+    AJRSetOutParameter(bytesWritten, length);
+    return YES;
+}
+
+- (void)appendBytes:(const void *)bytes length:(size_t)length {
+    if (length > 0) {
+        memcpy(AJRBinaryWriterAppend(self, length), bytes, length);
+    }
+}
+
+- (void)appendData:(NSData *)data {
+    [self appendBytes:data.bytes length:data.length];
+}
+
+#pragma mark - Typed Values
+
+- (void)appendInt8:(int8_t)value {
+    *AJRBinaryWriterAppend(self, sizeof(int8_t)) = (uint8_t)value;
+}
+
+- (void)appendUInt8:(uint8_t)value {
+    *AJRBinaryWriterAppend(self, sizeof(uint8_t)) = value;
+}
+
+- (void)appendInt16:(int16_t)value {
+    AJREncodeUInt16(AJRBinaryWriterAppend(self, sizeof(int16_t)), (uint16_t)value, _endianness);
+}
+
+- (void)appendInt16:(int16_t)value endianness:(AJREndianness)endianness {
+    AJREncodeUInt16(AJRBinaryWriterAppend(self, sizeof(int16_t)), (uint16_t)value, endianness);
+}
+
+- (void)appendUInt16:(uint16_t)value {
+    AJREncodeUInt16(AJRBinaryWriterAppend(self, sizeof(uint16_t)), value, _endianness);
+}
+
+- (void)appendUInt16:(uint16_t)value endianness:(AJREndianness)endianness {
+    AJREncodeUInt16(AJRBinaryWriterAppend(self, sizeof(uint16_t)), value, endianness);
+}
+
+- (void)appendInt32:(int32_t)value {
+    AJREncodeUInt32(AJRBinaryWriterAppend(self, sizeof(int32_t)), (uint32_t)value, _endianness);
+}
+
+- (void)appendInt32:(int32_t)value endianness:(AJREndianness)endianness {
+    AJREncodeUInt32(AJRBinaryWriterAppend(self, sizeof(int32_t)), (uint32_t)value, endianness);
+}
+
+- (void)appendUInt32:(uint32_t)value {
+    AJREncodeUInt32(AJRBinaryWriterAppend(self, sizeof(uint32_t)), value, _endianness);
+}
+
+- (void)appendUInt32:(uint32_t)value endianness:(AJREndianness)endianness {
+    AJREncodeUInt32(AJRBinaryWriterAppend(self, sizeof(uint32_t)), value, endianness);
+}
+
+- (void)appendInt64:(int64_t)value {
+    AJREncodeUInt64(AJRBinaryWriterAppend(self, sizeof(int64_t)), (uint64_t)value, _endianness);
+}
+
+- (void)appendInt64:(int64_t)value endianness:(AJREndianness)endianness {
+    AJREncodeUInt64(AJRBinaryWriterAppend(self, sizeof(int64_t)), (uint64_t)value, endianness);
+}
+
+- (void)appendUInt64:(uint64_t)value {
+    AJREncodeUInt64(AJRBinaryWriterAppend(self, sizeof(uint64_t)), value, _endianness);
+}
+
+- (void)appendUInt64:(uint64_t)value endianness:(AJREndianness)endianness {
+    AJREncodeUInt64(AJRBinaryWriterAppend(self, sizeof(uint64_t)), value, endianness);
+}
+
+- (void)appendFloat:(float)value {
+    [self appendFloat:value endianness:_endianness];
+}
+
+- (void)appendFloat:(float)value endianness:(AJREndianness)endianness {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    AJREncodeUInt32(AJRBinaryWriterAppend(self, sizeof(float)), bits, endianness);
+}
+
+- (void)appendDouble:(double)value {
+    [self appendDouble:value endianness:_endianness];
+}
+
+- (void)appendDouble:(double)value endianness:(AJREndianness)endianness {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    AJREncodeUInt64(AJRBinaryWriterAppend(self, sizeof(double)), bits, endianness);
+}
+
+#pragma mark - Variable Length Integers
+
+- (void)appendVarUInt:(uint64_t)value {
+    uint8_t bytes[10];
+    size_t length = 0;
+    while (value >= 0x80) {
+        bytes[length++] = (uint8_t)value | 0x80;
+        value >>= 7;
+    }
+    bytes[length++] = (uint8_t)value;
+    memcpy(AJRBinaryWriterAppend(self, length), bytes, length);
+}
+
+- (void)appendVarInt:(int64_t)value {
+    [self appendVarUInt:((uint64_t)value << 1) ^ (uint64_t)(value >> 63)];
+}
+
+#pragma mark - Arrays
+
+// The destination may not be aligned for the type, so values that need swapping are stored with memcpy(), which the compiler still turns into plain, vectorizable stores.
+#define AJRBinaryWriterAppendArray(values, count, width, endianness) { \
+    const uint ## width ## _t *_values = (const uint ## width ## _t *)values; \
+    uint8_t *_destination = AJRBinaryWriterAppend(self, count * (width / 8)); \
+    if (endianness == AJRGetCurrentArchitectureEndianness()) { \
+        memcpy(_destination, _values, count * (width / 8)); \
+    } else { \
+        for (size_t _x = 0; _x < count; _x++) { \
+            uint ## width ## _t _swapped = __builtin_bswap ## width(_values[_x]); \
+            memcpy(_destination + _x * (width / 8), &_swapped, width / 8); \
+        } \
+    } \
+}
+
+- (void)appendUInt16s:(const uint16_t *)values count:(size_t)count endianness:(AJREndianness)endianness {
+    AJRBinaryWriterAppendArray(values, count, 16, endianness);
+}
+
+- (void)appendUInt32s:(const uint32_t *)values count:(size_t)count endianness:(AJREndianness)endianness {
+    AJRBinaryWriterAppendArray(values, count, 32, endianness);
+}
+
+- (void)appendUInt64s:(const uint64_t *)values count:(size_t)count endianness:(AJREndianness)endianness {
+    AJRBinaryWriterAppendArray(values, count, 64, endianness);
+}
+
+- (void)appendFloats:(const float *)values count:(size_t)count endianness:(AJREndianness)endianness {
+    AJRBinaryWriterAppendArray(values, count, 32, endianness);
+}
+
+- (void)appendDoubles:(const double *)values count:(size_t)count endianness:(AJREndianness)endianness {
+    AJRBinaryWriterAppendArray(values, count, 64, endianness);
+}
+
+@end
@@ -0,0 +1,118 @@
+/*
+ AJRBufferedReader.h
+ AJRFoundation
+
+ Copyright © 2023, AJ Raftis and AJRFoundation authors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of AJRFoundation nor the names of its contributors may be
+   used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL AJ RAFTIS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import <AJRFoundation/AJRStreamUtilities.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*!
+ The default size of the refill buffer used by AJRBufferedReader.
+ */
+extern const size_t AJRBufferedReaderDefaultBufferSize;
+
+/*!
+ Reads characters, lines, and raw bytes from an input stream, file descriptor, or any other AJRByteReader through a large refill buffer.
+
+ Where AJRReadLine() and AJRReadCharacter() have to treat a generic reader carefully, consuming no more bytes than they return, AJRBufferedReader is free to read ahead. Lines are located with memchr() over the buffered bytes, UTF-8 characters are decoded natively, and other encodings go through a single iconv converter that lives as long as the reader's encoding doesn't change. If you're reading a large text file line by line, this is the object you want.
+
+ Because the reader reads ahead, you shouldn't read from the underlying stream or file descriptor directly while the buffered reader is in use. Doing so will skip whatever data the reader has already buffered.
+
+ The reader adopts the AJRByteReaderMethods conveniences, so all of readLineReturningError:, readCharacter:error:, and the integer and float readers work and consume the buffered data.
+ */
+@interface AJRBufferedReader : NSObject <AJRByteReader>
+
++ (instancetype)bufferedReaderWithInputStream:(NSInputStream *)stream;
++ (instancetype)bufferedReaderWithFileDescriptor:(int)fileDescriptor closeOnDealloc:(BOOL)closeOnDealloc;
++ (instancetype)bufferedReaderWithReader:(id <AJRByteReader>)reader;
+
+/*!
+ Creates a reader on `stream`. The stream is opened, if necessary. The encoding and endianness of the stream are adopted by the reader.
+ */
+- (instancetype)initWithInputStream:(NSInputStream *)stream;
+- (instancetype)initWithInputStream:(NSInputStream *)stream bufferSize:(size_t)bufferSize;
+/*!
+ Creates a reader on `fileDescriptor`. Reads are issued with read(2) directly. If `closeOnDealloc` is YES, the descriptor is closed when the reader is deallocated.
+ */
+- (instancetype)initWithFileDescriptor:(int)fileDescriptor closeOnDealloc:(BOOL)closeOnDealloc;
+- (instancetype)initWithFileDescriptor:(int)fileDescriptor closeOnDealloc:(BOOL)closeOnDealloc bufferSize:(size_t)bufferSize;
+/*!
+ Creates a reader on top of any other AJRByteReader. The encoding and endianness of `reader` are adopted by the buffered reader.
+ */
+- (instancetype)initWithReader:(id <AJRByteReader>)reader;
+- (instancetype)initWithReader:(id <AJRByteReader>)reader bufferSize:(size_t)bufferSize;
+
+/*! The number of bytes the reader requests from its source each time it refills. The buffer grows beyond this size when a single line doesn't fit. */
+@property (nonatomic,readonly) size_t bufferSize;
+/*! The number of bytes consumed from the reader so far. This doesn't include bytes that have been read ahead, but not yet returned. */
+@property (nonatomic,readonly) unsigned long long offset;
+/*! The number of bytes currently held in the buffer and not yet consumed. */
+@property (nonatomic,readonly) size_t bufferedLength;
+
+@property (nonatomic,assign) AJREndianness endianness;
+/*! The encoding used by readCharacter:error: and readLineReturningError:. Changing the encoding is allowed at any time, and affects all bytes not yet consumed. */
+@property (nonatomic,assign) NSStringEncoding encoding;
+@property (nonatomic,readonly,nullable) NSString *encodingName;
+
+/*!
+ Reads bytes into `buffer`, first from the buffered data and then from the source. Unlike a single read(2), this continues reading until `length` bytes have been read, or EOF is reached.
+ */
+- (BOOL)readBytes:(void *)buffer length:(size_t)length bytesRead:(out nullable size_t *)readLength error:(out NSError * _Nullable * _Nullable)error;
+
+/*!
+ The primitive used by AJRReadCharacter(). Returns NO on error. On EOF, returns YES and sets `bytesRead` to 0.
+ */
+- (BOOL)readCharacter:(out uint32_t *)character bytesRead:(out nullable size_t *)bytesRead error:(out NSError * _Nullable * _Nullable)error;
+/*!
+ The primitive used by AJRReadLine(). Returns nil at EOF without producing an error.
+ */
+- (nullable NSString *)readLineWithError:(out NSError * _Nullable * _Nullable)error;
+
+/*!
+ Reads raw bytes up to the next occurrence of `delimiter`, which may be more than one byte long, such as the CR/LF that terminates records in many network protocols. The buffered bytes are searched with memchr() or memmem(), and anything read past the delimiter stays buffered for the next call.
+
+ @param delimiter The bytes to search for. Must not be empty.
+ @param consumeDelimiter If YES, the delimiter is consumed, but not included in the returned data. If NO, the delimiter is left as the next bytes to read.
+ @param error On failure, initialized with the error.
+
+ @returns The bytes before the delimiter. If EOF is reached first, the remaining bytes are returned, and if no bytes remain, returns nil without producing an error.
+ */
+- (nullable NSData *)readDataToDelimiter:(NSData *)delimiter consumeDelimiter:(BOOL)consumeDelimiter error:(out NSError * _Nullable * _Nullable)error;
+/*!
+ The same as readDataToDelimiter:consumeDelimiter:error:, but for a single byte delimiter.
+ */
+- (nullable NSData *)readDataToByte:(uint8_t)byte consumeDelimiter:(BOOL)consumeDelimiter error:(out NSError * _Nullable * _Nullable)error;
+
+@end
+
+@interface AJRBufferedReader (AJRByteReaderMethods) <AJRByteReaderMethods>
+@end
+
+NS_ASSUME_NONNULL_END
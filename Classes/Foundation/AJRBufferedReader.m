@@ -0,0 +1,730 @@
+/*
+ AJRBufferedReader.m
+ AJRFoundation
+
+ Copyright © 2023, AJ Raftis and AJRFoundation authors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of AJRFoundation nor the names of its contributors may be
+   used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL AJ RAFTIS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import "AJRBufferedReaderP.h"
+
+#import "AJRFunctions.h"
+#import "AJRLogging.h"
+#import "AJRMemoryHandle.h"
+#import "NSError+Extensions.h"
+#import "NSString+Extensions.h"
+
+#import <iconv.h>
+#import <objc/runtime.h>
+#import <unistd.h>
+
+const size_t AJRBufferedReaderDefaultBufferSize = 65536;
+
+#define AJR_ICONV_ERROR ((iconv_t)(-1))
+#define AJRNotFound SIZE_MAX
+// Small enough that a short line doesn't cause us to read, and then seek back over, a lot of data, but large enough to usually catch the whole line.
+#define AJRMinimumSeekBackReadAhead 256
+// We're going to assume that we'll have a valid character after 16 bytes, or else we're in trouble.
+#define AJRMaximumCharacterLength 16
+
+typedef NS_ENUM(uint8_t, AJRBufferedReaderMode) {
+    /// Fill the buffer as much as possible on every read.
+    AJRBufferedReaderModeReadAhead,
+    /// Attached to a seekable reader. Lines are read ahead, but anything not consumed is handed back by seeking the reader.
+    AJRBufferedReaderModeSeekBack,
+    /// Attached to a reader that can't seek. Only the bytes actually needed are read.
+    AJRBufferedReaderModeExact,
+};
+
+@interface AJRBufferedReader ()
+
+- (instancetype)_initWithAttachedReader:(id <AJRByteReader>)reader mode:(AJRBufferedReaderMode)mode;
+
+@property (nonatomic,readonly) AJRBufferedReaderMode mode;
+
+@end
+
+@implementation AJRBufferedReader {
+    id <AJRByteReader> _reader;
+    // When attached to a reader, the reader owns us, so we can't retain it back.
+    __unsafe_unretained id <AJRByteReader> _attachedReader;
+    int _fileDescriptor;
+    BOOL _closesFileDescriptor;
+    AJRBufferedReaderMode _mode;
+    BOOL _readingAhead;
+    size_t _readAheadSize;
+
+    uint8_t *_buffer;
+    size_t _capacity;
+    size_t _start;
+    size_t _end;
+    // The index of the next known '\n' at or after _start, or AJRNotFound. When not found, _lineFeedScanned is the index we've already searched up to.
+    size_t _lineFeed;
+    size_t _lineFeedScanned;
+
+    iconv_t _converter;
+}
+
++ (void)load {
+    AJRAddReaderConveniencesToReader(self);
+}
+
+#pragma mark - Creation
+
++ (instancetype)bufferedReaderWithInputStream:(NSInputStream *)stream {
+    return [[self alloc] initWithInputStream:stream];
+}
+
++ (instancetype)bufferedReaderWithFileDescriptor:(int)fileDescriptor closeOnDealloc:(BOOL)closeOnDealloc {
+    return [[self alloc] initWithFileDescriptor:fileDescriptor closeOnDealloc:closeOnDealloc];
+}
+
++ (instancetype)bufferedReaderWithReader:(id <AJRByteReader>)reader {
+    return [[self alloc] initWithReader:reader];
+}
+
+- (instancetype)_initWithBufferSize:(size_t)bufferSize {
+    if ((self = [super init])) {
+        _fileDescriptor = -1;
+        _bufferSize = MAX(bufferSize, (size_t)AJRMaximumCharacterLength);
+        _capacity = _bufferSize;
+        _buffer = malloc(_capacity);
+        _lineFeed = AJRNotFound;
+        _readAheadSize = _bufferSize;
+        _converter = AJR_ICONV_ERROR;
+        _encoding = NSUTF8StringEncoding;
+        _endianness = AJREndiannessBig;
+    }
+    return self;
+}
+
+- (instancetype)initWithInputStream:(NSInputStream *)stream {
+    return [self initWithInputStream:stream bufferSize:AJRBufferedReaderDefaultBufferSize];
+}
+
+- (instancetype)initWithInputStream:(NSInputStream *)stream bufferSize:(size_t)bufferSize {
+    if (stream.streamStatus == NSStreamStatusNotOpen) {
+        [stream open];
+    }
+    return [self initWithReader:(id <AJRByteReader>)stream bufferSize:bufferSize];
+}
+
+- (instancetype)initWithFileDescriptor:(int)fileDescriptor closeOnDealloc:(BOOL)closeOnDealloc {
+    return [self initWithFileDescriptor:fileDescriptor closeOnDealloc:closeOnDealloc bufferSize:AJRBufferedReaderDefaultBufferSize];
+}
+
+- (instancetype)initWithFileDescriptor:(int)fileDescriptor closeOnDealloc:(BOOL)closeOnDealloc bufferSize:(size_t)bufferSize {
+    if ((self = [self _initWithBufferSize:bufferSize])) {
+        _fileDescriptor = fileDescriptor;
+        _closesFileDescriptor = closeOnDealloc;
+    }
+    return self;
+}
+
+- (instancetype)initWithReader:(id <AJRByteReader>)reader {
+    return [self initWithReader:reader bufferSize:AJRBufferedReaderDefaultBufferSize];
+}
+
+- (instancetype)initWithReader:(id <AJRByteReader>)reader bufferSize:(size_t)bufferSize {
+    if ((self = [self _initWithBufferSize:bufferSize])) {
+        _reader = reader;
+        _encoding = reader.encoding;
+        _endianness = reader.endianness;
+    }
+    return self;
+}
+
+- (instancetype)_initWithAttachedReader:(id <AJRByteReader>)reader mode:(AJRBufferedReaderMode)mode {
+    if ((self = [self _initWithBufferSize:mode == AJRBufferedReaderModeExact ? AJRMaximumCharacterLength : AJRBufferedReaderDefaultBufferSize])) {
+        _attachedReader = reader;
+        _mode = mode;
+        _readAheadSize = AJRMinimumSeekBackReadAhead;
+        _encoding = reader.encoding;
+        _endianness = reader.endianness;
+    }
+    return self;
+}
+
+- (void)dealloc {
+    if (_converter != AJR_ICONV_ERROR) {
+        iconv_close(_converter);
+    }
+    if (_closesFileDescriptor && _fileDescriptor >= 0) {
+        close(_fileDescriptor);
+    }
+    free(_buffer);
+}
+
+#pragma mark - Properties
+
+- (size_t)bufferedLength {
+    return _end - _start;
+}
+
+- (void)setEncoding:(NSStringEncoding)encoding {
+    if (encoding == 0) {
+        encoding = NSUTF8StringEncoding;
+    }
+    if (_encoding != encoding) {
+        _encoding = encoding;
+        if (_converter != AJR_ICONV_ERROR) {
+            iconv_close(_converter);
+            _converter = AJR_ICONV_ERROR;
+        }
+    }
+}
+
+- (NSString *)encodingName {
+    return AJRIANANameFromStringEncoding(_encoding);
+}
+
+#pragma mark - Buffer Management
+
+- (BOOL)_readFromSource:(uint8_t *)bytes length:(size_t)length bytesRead:(size_t *)bytesRead error:(NSError **)error {
+    id <AJRByteReader> reader = _reader ?: _attachedReader;
+    if (reader != nil) {
+        *bytesRead = 0;
+        return [reader readBytes:bytes length:length bytesRead:bytesRead error:error];
+    }
+
+    ssize_t result;
+    do {
+        result = read(_fileDescriptor, bytes, length);
+    } while (result < 0 && errno == EINTR);
+    if (result < 0) {
+        AJRSetOutParameter(error, [NSError errorWithDomain:NSPOSIXErrorDomain errorNumber:errno]);
+        return NO;
+    }
+    *bytesRead = (size_t)result;
+    return YES;
+}
+
+- (void)_consume:(size_t)length {
+    _start += length;
+    _offset += length;
+}
+
+/*!
+ Makes sure at least `length` unconsumed bytes are in the buffer, unless EOF is reached first. Returns NO only on error.
+ */
+- (BOOL)_fillToLength:(size_t)length error:(NSError **)error {
+    size_t available = _end - _start;
+    if (available >= length) {
+        return YES;
+    }
+
+    if (_capacity - _start < length || (_mode == AJRBufferedReaderModeReadAhead && _start > _capacity / 2)) {
+        // Slide the unconsumed bytes to the front of the buffer, growing it if a single line or character doesn't fit.
+        if (_start > 0) {
+            memmove(_buffer, _buffer + _start, available);
+            if (_lineFeed == AJRNotFound || _lineFeed >= _start) {
+                if (_lineFeed != AJRNotFound) {
+                    _lineFeed -= _start;
+                }
+                _lineFeedScanned = _lineFeedScanned > _start ? _lineFeedScanned - _start : 0;
+            } else {
+                // The cached '\n' was consumed by something other than a line read, so forget it rather than letting the subtraction wrap.
+                _lineFeed = AJRNotFound;
+                _lineFeedScanned = 0;
+            }
+            _start = 0;
+            _end = available;
+        }
+        if (_capacity < length) {
+            _capacity = MAX(length, _capacity * 2);
+            _buffer = realloc(_buffer, _capacity);
+        }
+    }
+
+    while (_end - _start < length) {
+        size_t request = length - (_end - _start);
+        if (_mode == AJRBufferedReaderModeReadAhead) {
+            request = _capacity - _end;
+        } else if (_mode == AJRBufferedReaderModeSeekBack && _readingAhead) {
+            request = MIN(_capacity - _end, MAX(request, _readAheadSize));
+        }
+        size_t bytesRead = 0;
+        if (![self _readFromSource:_buffer + _end length:request bytesRead:&bytesRead error:error]) {
+            return NO;
+        }
+        if (bytesRead == 0) {
+            break;
+        }
+        _end += bytesRead;
+    }
+
+    return YES;
+}
+
+/*! Hands bytes we read, but didn't consume, back to a seekable reader. */
+- (void)_returnUnconsumedBytes {
+    size_t unconsumed = _end - _start;
+    if (unconsumed > 0) {
+        NSFileHandle *handle = (NSFileHandle *)_attachedReader;
+        @try {
+            [handle seekToFileOffset:[handle offsetInFile] - unconsumed];
+        } @catch (NSException *exception) {
+            AJRLog(nil, AJRLogLevelWarning, @"Failed to return %zu read ahead bytes to %@: %@", unconsumed, handle, exception);
+        }
+        _start = _end = 0;
+    }
+    _lineFeed = AJRNotFound;
+    _lineFeedScanned = 0;
+}
+
+/*!
+ Brackets an operation, like reading a line, that doesn't know up front how many bytes it needs. In seek back mode, the reader is allowed to read ahead until the matching call to _endReadingAheadFromOffset:, at which point anything not consumed is handed back.
+ */
+- (unsigned long long)_beginReadingAhead {
+    _readingAhead = YES;
+    return _offset;
+}
+
+- (void)_endReadingAheadFromOffset:(unsigned long long)offset {
+    _readingAhead = NO;
+    if (_mode == AJRBufferedReaderModeSeekBack) {
+        [self _returnUnconsumedBytes];
+        // Aim to read about two lines, or records, worth on the next call.
+        _readAheadSize = MIN(_bufferSize, MAX((size_t)AJRMinimumSeekBackReadAhead, (size_t)(_offset - offset) * 2));
+    }
+}
+
+#pragma mark - Reading Bytes
+
+- (BOOL)readBytes:(void *)bytes length:(size_t)length bytesRead:(size_t *)readLength error:(NSError **)error {
+    NSError *localError = nil;
+    size_t total = MIN(length, _end - _start);
+
+    memcpy(bytes, _buffer + _start, total);
+    [self _consume:total];
+
+    while (total < length) {
+        size_t remaining = length - total;
+        if (remaining >= _bufferSize || _mode != AJRBufferedReaderModeReadAhead) {
+            // Large reads go straight into the caller's buffer, there's no point in copying them through ours.
+            size_t bytesRead = 0;
+            if (![self _readFromSource:(uint8_t *)bytes + total length:remaining bytesRead:&bytesRead error:&localError]) {
+                break;
+            }
+            if (bytesRead == 0) {
+                break;
+            }
+            total += bytesRead;
+            _offset += bytesRead;
+        } else {
+            if (![self _fillToLength:remaining error:&localError]) {
+                break;
+            }
+            size_t available = MIN(remaining, _end - _start);
+            if (available == 0) {
+                break;
+            }
+            memcpy((uint8_t *)bytes + total, _buffer + _start, available);
+            [self _consume:available];
+            total += available;
+        }
+    }
+
+    if (localError == nil) {
+        AJRSetOutParameter(readLength, total);
+    }
+    return AJRAssertOrPropagateError(localError == nil, error, localError);
+}
+
+#pragma mark - Reading Characters
+
+- (NSError *)_illegalSequenceError {
+    return [NSError errorWithDomain:NSPOSIXErrorDomain errorNumber:EILSEQ];
+}
+
+- (BOOL)_readUTF8Character:(uint32_t *)characterOut bytesRead:(size_t *)bytesRead error:(NSError **)error {
+    if (![self _fillToLength:1 error:error]) {
+        return NO;
+    }
+    if (_end == _start) {
+        *characterOut = 0;
+        *bytesRead = 0;
+        return YES;
+    }
+
+    const uint8_t *bytes = _buffer + _start;
+    uint32_t character = bytes[0];
+    size_t length;
+    uint32_t minimum;
+
+    if (character < 0x80) {
+        [self _consume:1];
+        *characterOut = character;
+        *bytesRead = 1;
+        return YES;
+    } else if ((character & 0xE0) == 0xC0) {
+        length = 2;
+        character &= 0x1F;
+        minimum = 0x80;
+    } else if ((character & 0xF0) == 0xE0) {
+        length = 3;
+        character &= 0x0F;
+        minimum = 0x800;
+    } else if ((character & 0xF8) == 0xF0) {
+        length = 4;
+        character &= 0x07;
+        minimum = 0x10000;
+    } else {
+        AJRSetOutParameter(error, [self _illegalSequenceError]);
+        return NO;
+    }
+
+    if (![self _fillToLength:length error:error]) {
+        return NO;
+    }
+    if (_end - _start < length) {
+        // Truncated by EOF.
+        AJRSetOutParameter(error, [self _illegalSequenceError]);
+        return NO;
+    }
+
+    bytes = _buffer + _start;
+    for (size_t x = 1; x < length; x++) {
+        if ((bytes[x] & 0xC0) != 0x80) {
+            AJRSetOutParameter(error, [self _illegalSequenceError]);
+            return NO;
+        }
+        character = (character << 6) | (bytes[x] & 0x3F);
+    }
+    // Reject overlong forms, surrogates, and anything beyond the Unicode range, just like iconv would.
+    if (character < minimum || character > 0x10FFFF || (character >= 0xD800 && character <= 0xDFFF)) {
+        AJRSetOutParameter(error, [self _illegalSequenceError]);
+        return NO;
+    }
+
+    [self _consume:length];
+    *characterOut = character;
+    *bytesRead = length;
+    return YES;
+}
+
+- (BOOL)_readConvertedCharacter:(uint32_t *)characterOut bytesRead:(size_t *)bytesRead error:(NSError **)error {
+    if (_converter == AJR_ICONV_ERROR) {
+        _converter = iconv_open("UTF-32LE", [self.encodingName ?: @"UTF-8" UTF8String]);
+        AJRAssert(_converter != AJR_ICONV_ERROR, @"Failed to open iconv_open. This should never fail.");
+    }
+
+    size_t consumed = 0;
+    size_t needed = 1;
+
+    while (YES) {
+        if (![self _fillToLength:needed error:error]) {
+            return NO;
+        }
+        size_t available = _end - _start;
+        if (available == 0 && consumed == 0) {
+            // Clean EOF.
+            *characterOut = 0;
+            *bytesRead = 0;
+            return YES;
+        }
+        if (available < needed || consumed + needed > AJRMaximumCharacterLength) {
+            // Either EOF in the middle of a character, or we've read more than any character should ever need.
+            iconv(_converter, NULL, NULL, NULL, NULL);
+            AJRSetOutParameter(error, [self _illegalSequenceError]);
+            return NO;
+        }
+
+        uint8_t output[4];
+        char *input = (char *)(_buffer + _start);
+        char *outputPointer = (char *)output;
+        size_t length = MIN(available, (size_t)AJRMaximumCharacterLength);
+        size_t inputLeft = length;
+        size_t outputLeft = sizeof(output);
+        size_t result = iconv(_converter, &input, &inputLeft, &outputPointer, &outputLeft);
+        int conversionError = errno;
+
+        // iconv may consume bytes without producing output, for example a byte order mark, so account for them as we go.
+        [self _consume:length - inputLeft];
+        consumed += length - inputLeft;
+
+        if (outputLeft == 0) {
+            *characterOut = ((uint32_t)output[0] << 0) | ((uint32_t)output[1] << 8) | ((uint32_t)output[2] << 16) | ((uint32_t)output[3] << 24);
+            *bytesRead = consumed;
+            return YES;
+        }
+        if (result == (size_t)-1 && conversionError == EILSEQ) {
+            iconv(_converter, NULL, NULL, NULL, NULL);
+            AJRSetOutParameter(error, [self _illegalSequenceError]);
+            return NO;
+        }
+        // Otherwise the input was incomplete, so we need at least one more byte.
+        needed = inputLeft + 1;
+    }
+}
+
+- (BOOL)readCharacter:(uint32_t *)characterOut bytesRead:(size_t *)bytesReadOut error:(NSError **)error {
+    NSError *localError = nil;
+    uint32_t character = 0;
+    size_t bytesRead = 0;
+    BOOL success;
+
+    if (_encoding == NSUTF8StringEncoding) {
+        success = [self _readUTF8Character:&character bytesRead:&bytesRead error:&localError];
+    } else if (_encoding == NSISOLatin1StringEncoding) {
+        // Latin-1 maps directly onto the first 256 code points.
+        success = [self _fillToLength:1 error:&localError];
+        if (success && _end > _start) {
+            character = _buffer[_start];
+            bytesRead = 1;
+            [self _consume:1];
+        }
+    } else {
+        success = [self _readConvertedCharacter:&character bytesRead:&bytesRead error:&localError];
+    }
+
+    if (success) {
+        AJRSetOutParameter(characterOut, character);
+        AJRSetOutParameter(bytesReadOut, bytesRead);
+    }
+    return AJRAssertOrPropagateError(success, error, localError);
+}
+
+#pragma mark - Reading Lines
+
+- (NSString *)_stringWithBytes:(const uint8_t *)bytes length:(size_t)length {
+    if (_encoding == NSASCIIStringEncoding) {
+        // Treat this encoding as completely "raw", meaning all characters above 127 will just be passed through, as is, with no interpretation of the encoding.
+        return [NSString stringWithRawBytes:bytes length:length];
+    }
+    return [[NSString alloc] initWithBytes:bytes length:length encoding:_encoding];
+}
+
+- (NSString *)_readLineFrom8BitEncodingWithError:(NSError **)error {
+    // Relative to _start, since filling the buffer may slide the bytes around.
+    size_t scanned = 0;
+
+    while (YES) {
+        size_t available = _end - _start;
+
+        // Find the next '\n'. We remember where it is, so that a file with '\r' line endings doesn't cause us to search the remainder of the buffer on every line.
+        if (_lineFeed == AJRNotFound || _lineFeed < _start) {
+            size_t from = MAX(_lineFeedScanned, _start);
+            const uint8_t *lineFeed = from < _end ? memchr(_buffer + from, '\n', _end - from) : NULL;
+            if (lineFeed) {
+                _lineFeed = lineFeed - _buffer;
+            } else {
+                _lineFeed = AJRNotFound;
+                _lineFeedScanned = _end;
+            }
+        }
+        size_t limit = _lineFeed == AJRNotFound ? available : _lineFeed - _start;
+
+        // And now any '\r' before it.
+        const uint8_t *carriageReturn = scanned < limit ? memchr(_buffer + _start + scanned, '\r', limit - scanned) : NULL;
+        if (carriageReturn) {
+            size_t length = carriageReturn - (_buffer + _start);
+            // We need to see one byte past the '\r' to distinguish cr/nl from cr endings.
+            if (![self _fillToLength:length + 2 error:error]) {
+                return nil;
+            }
+            NSString *line = [self _stringWithBytes:_buffer + _start length:length];
+            BOOL followedByLineFeed = _end - _start > length + 1 && _buffer[_start + length + 1] == '\n';
+            [self _consume:length + (followedByLineFeed ? 2 : 1)];
+            return line;
+        }
+        if (_lineFeed != AJRNotFound) {
+            NSString *line = [self _stringWithBytes:_buffer + _start length:limit];
+            [self _consume:limit + 1];
+            return line;
+        }
+
+        scanned = available;
+        if (![self _fillToLength:available + 1 error:error]) {
+            return nil;
+        }
+        if (_end - _start == available) {
+            // EOF. On EOF, if we've not read anything yet, we return nil, because that makes for a nice loop structure.
+            if (available == 0) {
+                return nil;
+            }
+            NSString *line = [self _stringWithBytes:_buffer + _start length:available];
+            [self _consume:available];
+            return line;
+        }
+    }
+}
+
+- (NSString *)_readLineFromWideEncodingWithError:(NSError **)error {
+    NSMutableData *characters = [NSMutableData dataWithCapacity:256 * sizeof(uint32_t)];
+    NSError *localError = nil;
+
+    while (YES) {
+        uint32_t character;
+        size_t bytesRead;
+        if (![self readCharacter:&character bytesRead:&bytesRead error:&localError]) {
+            AJRSetOutParameter(error, localError);
+            return nil;
+        }
+        if (bytesRead == 0) {
+            if (characters.length == 0) {
+                return nil;
+            }
+            break;
+        }
+        if (character == '\n') {
+            break;
+        }
+        if (character == '\r') {
+            uint32_t next;
+            if (![self readCharacter:&next bytesRead:&bytesRead error:&localError]) {
+                AJRSetOutParameter(error, localError);
+                return nil;
+            }
+            if (bytesRead > 0 && next != '\n') {
+                // The bytes we just read are still in the buffer, since the buffer only slides when filling, so just back up.
+                _start -= bytesRead;
+                _offset -= bytesRead;
+                _lineFeed = AJRNotFound;
+                _lineFeedScanned = 0;
+            }
+            break;
+        }
+        [characters appendBytes:&character length:sizeof(character)];
+    }
+
+    return [[NSString alloc] initWithData:characters encoding:AJR_IS_BIG_ENDIAN ? NSUTF32BigEndianStringEncoding : NSUTF32LittleEndianStringEncoding];
+}
+
+- (NSString *)readLineWithError:(NSError **)error {
+    NSError *localError = nil;
+    unsigned long long offset = [self _beginReadingAhead];
+    NSString *line;
+
+    if (AJREncodingIs8Bit(_encoding)) {
+        line = [self _readLineFrom8BitEncodingWithError:&localError];
+    } else {
+        line = [self _readLineFromWideEncodingWithError:&localError];
+    }
+    [self _endReadingAheadFromOffset:offset];
+
+    return AJRAssertOrPropagateError(line, error, localError);
+}
+
+#pragma mark - Reading Delimited Data
+
+- (NSData *)_readDataToDelimiter:(const uint8_t *)delimiter length:(size_t)delimiterLength consumeDelimiter:(BOOL)consumeDelimiter error:(NSError **)error {
+    // Relative to _start. Everything before this is known not to begin a delimiter.
+    size_t scanned = 0;
+
+    while (YES) {
+        size_t available = _end - _start;
+
+        if (available >= delimiterLength) {
+            const uint8_t *base = _buffer + _start;
+            const uint8_t *found;
+            if (delimiterLength == 1) {
+                found = memchr(base + scanned, delimiter[0], available - scanned);
+            } else {
+                found = memmem(base + scanned, available - scanned, delimiter, delimiterLength);
+            }
+            if (found) {
+                size_t length = found - base;
+                NSData *data = [NSData dataWithBytes:base length:length];
+                [self _consume:length + (consumeDelimiter ? delimiterLength : 0)];
+                return data;
+            }
+            // The delimiter could still start in the last few bytes, once more data arrives.
+            scanned = available - (delimiterLength - 1);
+        }
+
+        if (![self _fillToLength:available + 1 error:error]) {
+            return nil;
+        }
+        if (_end - _start == available) {
+            // EOF. Like lines, return nil if there was nothing left at all, otherwise return whatever remains.
+            if (available == 0) {
+                return nil;
+            }
+            NSData *data = [NSData dataWithBytes:_buffer + _start length:available];
+            [self _consume:available];
+            return data;
+        }
+    }
+}
+
+- (NSData *)readDataToDelimiter:(NSData *)delimiter consumeDelimiter:(BOOL)consumeDelimiter error:(NSError **)error {
+    if (delimiter.length == 0) {
+        AJRSetOutParameter(error, [NSError errorWithDomain:NSPOSIXErrorDomain code:EINVAL message:@"The delimiter must be at least one byte long."]);
+        return nil;
+    }
+
+    NSError *localError = nil;
+    unsigned long long offset = [self _beginReadingAhead];
+    NSData *data = [self _readDataToDelimiter:delimiter.bytes length:delimiter.length consumeDelimiter:consumeDelimiter error:&localError];
+    [self _endReadingAheadFromOffset:offset];
+
+    return AJRAssertOrPropagateError(data, error, localError);
+}
+
+- (NSData *)readDataToByte:(uint8_t)byte consumeDelimiter:(BOOL)consumeDelimiter error:(NSError **)error {
+    NSError *localError = nil;
+    unsigned long long offset = [self _beginReadingAhead];
+    NSData *data = [self _readDataToDelimiter:&byte length:1 consumeDelimiter:consumeDelimiter error:&localError];
+    [self _endReadingAheadFromOffset:offset];
+
+    return AJRAssertOrPropagateError(data, error, localError);
+}
+
+@end
+
+#pragma mark - Readers Attached to AJRByteReaders
+
+static BOOL AJRReaderIsSeekable(id <AJRByteReader> reader) {
+    if ([reader isKindOfClass:[NSFileHandle class]]) {
+        if ([reader isKindOfClass:[AJRMemoryHandle class]]) {
+            return YES;
+        }
+        @try {
+            return lseek([(NSFileHandle *)reader fileDescriptor], 0, SEEK_CUR) >= 0;
+        } @catch (NSException *exception) {
+            return NO;
+        }
+    }
+    return NO;
+}
+
+static NSInteger AJRAttachedReaderKey = 0;
+
+AJRBufferedReader *AJRBufferedReaderAttachedToReader(id <AJRByteReader> reader) {
+    AJRBufferedReader *bufferedReader = objc_getAssociatedObject(reader, &AJRAttachedReaderKey);
+    if (bufferedReader == nil) {
+        bufferedReader = [[AJRBufferedReader alloc] _initWithAttachedReader:reader mode:AJRReaderIsSeekable(reader) ? AJRBufferedReaderModeSeekBack : AJRBufferedReaderModeExact];
+        objc_setAssociatedObject(reader, &AJRAttachedReaderKey, bufferedReader, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+    }
+    // The reader's encoding may change between calls, and that needs to apply to anything we're holding on to.
+    bufferedReader.encoding = reader.encoding;
+    return bufferedReader;
+}
+
+BOOL AJRBufferedReaderReturnsUnconsumedBytes(AJRBufferedReader *bufferedReader) {
+    return bufferedReader.mode != AJRBufferedReaderModeExact;
+}
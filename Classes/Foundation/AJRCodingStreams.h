@@ -0,0 +1,88 @@
+/*
+ AJRCodingStreams.h
+ AJRFoundation
+
+ Copyright © 2023, AJ Raftis and AJRFoundation authors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of AJRFoundation nor the names of its contributors may be
+   used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL AJ RAFTIS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*!
+ An object that transforms bytes a piece at a time, such as a Base64 or uuencode encoder or decoder. Any partial state, like a quantum that hasn't been completed, or the position on the current line, is carried between calls, so the concatenated output is the same no matter how the input is split up.
+ */
+@protocol AJRIncrementalCoder <NSObject>
+
+/*!
+ Codes length bytes, appending whatever output they complete to output.
+
+ @returns NO if the input is malformed.
+ */
+- (BOOL)codeBytes:(const void *)bytes length:(size_t)length intoData:(NSMutableData *)output error:(out NSError * _Nullable * _Nullable)error;
+
+/*!
+ Appends any output still held by the coder, such as a final partial quantum, padding, or a trailer, to output. After this, the coder is back in its initial state.
+
+ @returns NO if the input ended somewhere it shouldn't have.
+ */
+- (BOOL)finishIntoData:(NSMutableData *)output error:(out NSError * _Nullable * _Nullable)error;
+
+@end
+
+/*!
+ Codes all of data in one go. This is mostly useful when you already have a coder configured the way you want it.
+ */
+extern NSData * _Nullable AJRCodeData(id <AJRIncrementalCoder> coder, NSData *data, NSError * _Nullable * _Nullable error);
+
+/*!
+ An input stream that reads from another stream, passing what it reads through a coder. This lets you, for example, decode a Base64 attachment from a file without ever holding more than a chunk of it in memory.
+ */
+@interface AJRCodingInputStream : NSInputStream
+
++ (instancetype)inputStreamWithInputStream:(NSInputStream *)source coder:(id <AJRIncrementalCoder>)coder;
+- (instancetype)initWithInputStream:(NSInputStream *)source coder:(id <AJRIncrementalCoder>)coder;
+
+@property (nonatomic,readonly) NSInputStream *source;
+@property (nonatomic,readonly) id <AJRIncrementalCoder> coder;
+
+@end
+
+/*!
+ An output stream that passes what's written to it through a coder, and writes the result to another stream. Closing the stream finishes the coder, writes anything it was holding, and then closes the destination.
+ */
+@interface AJRCodingOutputStream : NSOutputStream
+
++ (instancetype)outputStreamWithOutputStream:(NSOutputStream *)destination coder:(id <AJRIncrementalCoder>)coder;
+- (instancetype)initWithOutputStream:(NSOutputStream *)destination coder:(id <AJRIncrementalCoder>)coder;
+
+@property (nonatomic,readonly) NSOutputStream *destination;
+@property (nonatomic,readonly) id <AJRIncrementalCoder> coder;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,253 @@
+/*
+ AJRCodingStreams.m
+ AJRFoundation
+
+ Copyright © 2023, AJ Raftis and AJRFoundation authors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of AJRFoundation nor the names of its contributors may be
+   used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL AJ RAFTIS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import "AJRCodingStreams.h"
+
+#import "AJRFileOutputStream.h"
+#import "AJRFunctions.h"
+#import "NSError+Extensions.h"
+
+// How much we read from the source stream at a time.
+#define AJRCodingStreamChunkSize 16384
+
+NSData *AJRCodeData(id <AJRIncrementalCoder> coder, NSData *data, NSError **error) {
+    NSMutableData *output = [NSMutableData data];
+    NSError *localError = nil;
+
+    if (![coder codeBytes:data.bytes length:data.length intoData:output error:&localError]
+        || ![coder finishIntoData:output error:&localError]) {
+        output = nil;
+    }
+
+    return AJRAssertOrPropagateError(output, error, localError);
+}
+
+@implementation AJRCodingInputStream {
+    NSError *_error;
+    NSMutableData *_pending;
+    NSUInteger _pendingOffset;
+    BOOL _atEnd;
+    BOOL _closed;
+    uint8_t _chunk[AJRCodingStreamChunkSize];
+}
+
++ (instancetype)inputStreamWithInputStream:(NSInputStream *)source coder:(id <AJRIncrementalCoder>)coder {
+    return [[self alloc] initWithInputStream:source coder:coder];
+}
+
+- (instancetype)initWithInputStream:(NSInputStream *)source coder:(id <AJRIncrementalCoder>)coder {
+    if ((self = [super init])) {
+        _source = source;
+        _coder = coder;
+        _pending = [NSMutableData dataWithCapacity:AJRCodingStreamChunkSize * 2];
+    }
+    return self;
+}
+
+#pragma mark - NSStream
+
+- (void)open {
+    [_source open];
+}
+
+- (void)close {
+    _closed = YES;
+    [_source close];
+}
+
+- (NSStreamStatus)streamStatus {
+    if (_error) {
+        return NSStreamStatusError;
+    }
+    if (_closed) {
+        return NSStreamStatusClosed;
+    }
+    if (_atEnd && _pendingOffset == _pending.length) {
+        return NSStreamStatusAtEnd;
+    }
+    return [_source streamStatus];
+}
+
+- (NSError *)streamError {
+    return _error;
+}
+
+#pragma mark - NSInputStream
+
+// Reads and codes another chunk of the source. Returns NO on error, having set _error.
+- (BOOL)_fillPending {
+    NSError *localError = nil;
+    NSInteger bytesRead = [_source read:_chunk maxLength:AJRCodingStreamChunkSize];
+
+    [_pending setLength:0];
+    _pendingOffset = 0;
+
+    if (bytesRead > 0) {
+        if (![_coder codeBytes:_chunk length:bytesRead intoData:_pending error:&localError]) {
+            _error = localError;
+        }
+    } else if (bytesRead == 0) {
+        _atEnd = YES;
+        if (![_coder finishIntoData:_pending error:&localError]) {
+            _error = localError;
+        }
+    } else {
+        _error = [_source streamError] ?: [NSError errorWithDomain:AJRStreamErrorDomain message:@"Failed to read from the source stream."];
+    }
+
+    return _error == nil;
+}
+
+- (NSInteger)read:(uint8_t *)buffer maxLength:(NSUInteger)length {
+    // A chunk of input may not complete any output, so keep going until it does, or we run out.
+    while (_error == nil && !_atEnd && _pendingOffset == _pending.length) {
+        [self _fillPending];
+    }
+    if (_error) {
+        return -1;
+    }
+
+    NSUInteger available = MIN(length, _pending.length - _pendingOffset);
+    memcpy(buffer, (const uint8_t *)_pending.bytes + _pendingOffset, available);
+    _pendingOffset += available;
+
+    return available;
+}
+
+- (BOOL)getBuffer:(uint8_t **)buffer length:(NSUInteger *)length {
+    return NO;
+}
+
+- (BOOL)hasBytesAvailable {
+    return _error == nil && (!_atEnd || _pendingOffset < _pending.length);
+}
+
+@end
+
+@implementation AJRCodingOutputStream {
+    NSError *_error;
+    NSMutableData *_pending;
+    BOOL _closed;
+}
+
++ (instancetype)outputStreamWithOutputStream:(NSOutputStream *)destination coder:(id <AJRIncrementalCoder>)coder {
+    return [[self alloc] initWithOutputStream:destination coder:coder];
+}
+
+- (instancetype)initWithOutputStream:(NSOutputStream *)destination coder:(id <AJRIncrementalCoder>)coder {
+    if ((self = [super init])) {
+        _destination = destination;
+        _coder = coder;
+        _pending = [NSMutableData dataWithCapacity:AJRCodingStreamChunkSize * 2];
+    }
+    return self;
+}
+
+#pragma mark - NSStream
+
+- (void)open {
+    [_destination open];
+}
+
+- (void)close {
+    if (!_closed) {
+        _closed = YES;
+        if (_error == nil) {
+            NSError *localError = nil;
+            [_pending setLength:0];
+            if ([_coder finishIntoData:_pending error:&localError]) {
+                [self _writePending];
+            } else {
+                _error = localError;
+            }
+        }
+        [_destination close];
+    }
+}
+
+- (NSStreamStatus)streamStatus {
+    if (_error) {
+        return NSStreamStatusError;
+    }
+    if (_closed) {
+        return NSStreamStatusClosed;
+    }
+    return [_destination streamStatus];
+}
+
+- (NSError *)streamError {
+    return _error;
+}
+
+#pragma mark - NSOutputStream
+
+// Writes all of _pending to the destination, which may take more than one write. Returns NO on error, having set _error.
+- (BOOL)_writePending {
+    const uint8_t *bytes = _pending.bytes;
+    NSUInteger remaining = _pending.length;
+
+    while (remaining > 0) {
+        NSInteger bytesWritten = [_destination write:bytes maxLength:remaining];
+        if (bytesWritten <= 0) {
+            _error = [_destination streamError] ?: [NSError errorWithDomain:AJRStreamErrorDomain message:@"Failed to write to the destination stream."];
+            return NO;
+        }
+        bytes += bytesWritten;
+        remaining -= bytesWritten;
+    }
+
+    return YES;
+}
+
+- (NSInteger)write:(const uint8_t *)buffer maxLength:(NSUInteger)length {
+    NSError *localError = nil;
+
+    if (_error == nil && _closed) {
+        _error = [NSError errorWithDomain:AJRStreamErrorDomain message:@"Attempted to write to a closed stream."];
+    }
+    if (_error) {
+        return -1;
+    }
+
+    [_pending setLength:0];
+    if (![_coder codeBytes:buffer length:length intoData:_pending error:&localError]) {
+        _error = localError;
+        return -1;
+    }
+
+    return [self _writePending] ? (NSInteger)length : -1;
+}
+
+- (BOOL)hasSpaceAvailable {
+    return _error == nil && !_closed;
+}
+
+@end
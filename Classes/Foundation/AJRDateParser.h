@@ -0,0 +1,74 @@
+/*
+ AJRDateParser.h
+ AJRFoundation
+
+ Copyright © 2023, AJ Raftis and AJRFoundation authors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of AJRFoundation nor the names of its contributors may be
+   used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL AJ RAFTIS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*!
+ Parses dates the way AJRDateFromStringAndFormat() does, but with the format, calendar, and time zone worked out once, up front, so that it can parse large numbers of dates, such as the date columns of an imported file, quickly.
+
+ Input that's entirely ASCII, which is to say nearly all of it, is scanned in place, and the result computed arithmetically. Anything else goes through the same code as AJRDateFromStringAndFormat(), so the results are always the same as that function's. The one difference is that the parser's idea of "today", used to fill in missing fields, is fixed by referenceDate, rather than checked on every call.
+
+ A parser keeps a small cache of time zone offsets, so it shouldn't be used by more than one thread at a time.
+ */
+@interface AJRDateParser : NSObject
+
+/*!
+ Creates a parser for format, which is the same as the format passed to AJRDateFromStringAndFormat(). Only the month (%m, %B, %b), day (%d, %e), and year (%Y, %y) specifiers matter, and only in the order they appear.
+
+ @param format The format, or nil to guess the order as month, day, year.
+ @param calendar The calendar to use, or nil for the current calendar.
+ */
+- (instancetype)initWithFormat:(nullable NSString *)format calendar:(nullable NSCalendar *)calendar NS_DESIGNATED_INITIALIZER;
+- (instancetype)initWithFormat:(nullable NSString *)format;
+- (instancetype)init NS_UNAVAILABLE;
+
+@property (nonatomic,nullable,readonly,strong) NSString *format;
+@property (nonatomic,readonly,strong) NSCalendar *calendar;
+/*! The date whose month, day, and year fill in for any missing from the input. This defaults to when the parser was created. */
+@property (nonatomic,strong) NSDate *referenceDate;
+
+- (nullable NSDate *)dateFromString:(NSString *)string error:(NSError * _Nullable * _Nullable)error;
+- (nullable NSDate *)dateFromUTF8Bytes:(const char *)bytes length:(NSUInteger)length error:(NSError * _Nullable * _Nullable)error;
+- (nullable NSDate *)dateFromCharacters:(const unichar *)characters length:(NSUInteger)length error:(NSError * _Nullable * _Nullable)error;
+
+/*! Parses string without creating an NSDate. Returns NAN if string can't be parsed. */
+- (NSTimeInterval)timeIntervalSinceReferenceDateFromString:(NSString *)string error:(NSError * _Nullable * _Nullable)error;
+
+/*! Parses each string in strings. Strings that can't be parsed produce NSNull in the returned array. */
+- (NSArray *)datesFromStrings:(NSArray<NSString *> *)strings;
+/*! Parses each string in strings into intervals, which must have room for all of them. Strings that can't be parsed produce NAN. */
+- (void)getTimeIntervals:(NSTimeInterval *)intervals fromStrings:(NSArray<NSString *> *)strings;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,483 @@
+/*
+ AJRDateParser.m
+ AJRFoundation
+
+ Copyright © 2023, AJ Raftis and AJRFoundation authors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of AJRFoundation nor the names of its contributors may be
+   used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL AJ RAFTIS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import "AJRDateParser.h"
+
+#import "AJRFunctionsP.h"
+#import "AJRLogging.h"
+#import "NSError+Extensions.h"
+#import "NSScanner+Extensions.h"
+
+typedef NS_ENUM(uint8_t, AJRDateField) {
+    AJRDateFieldMonth = 1,
+    AJRDateFieldDay,
+    AJRDateFieldYear,
+};
+
+typedef struct _ajrDateParserOffset {
+    NSInteger day;
+    NSTimeInterval offset;
+} AJRDateParserOffset;
+
+// Strings that aren't stored as ASCII are copied to a buffer of this size to be parsed. Anything longer goes to AJRDateFromStringAndFormatWithDefaults().
+#define AJRDateParserBufferLength 128
+// The number of days for which we remember the time zone's offset. This must be a power of two.
+#define AJRDateParserOffsetCacheSize 1024
+// NSCalendar's Gregorian calendar uses Julian dates before the 1582 reform, so we leave those to it. We also leave it the absurdly distant future.
+#define AJRDateParserFirstArithmeticYear 1583
+#define AJRDateParserLastArithmeticYear 100000
+
+// The number of seconds from 1970 to 2001.
+static const NSTimeInterval AJRDateParserReferenceDateOffset = 978307200.0;
+
+static inline BOOL AJRDateParserIsDigit(uint8_t character) {
+    return character >= '0' && character <= '9';
+}
+
+static inline BOOL AJRDateParserIsLetter(uint8_t character) {
+    return (character | 0x20) >= 'a' && (character | 0x20) <= 'z';
+}
+
+// The ASCII characters in NSCharacterSet's whitespaceAndNewlineCharacterSet, which is what NSScanner skips by default.
+static inline BOOL AJRDateParserIsWhitespace(uint8_t character) {
+    return character == ' ' || (character >= '\t' && character <= '\r');
+}
+
+static BOOL AJRDateParserIsASCII(const uint8_t *bytes, NSUInteger length) {
+    for (NSUInteger x = 0; x < length; x++) {
+        if (bytes[x] >= 0x80) {
+            return NO;
+        }
+    }
+    return YES;
+}
+
+static NSInteger AJRDateParserDaysInMonth(NSInteger month, NSInteger year) {
+    static const NSInteger daysInMonth[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+
+    if (month < 1 || month > 12) {
+        // The month will be rejected, so this doesn't matter.
+        return 31;
+    }
+    if (month == 2 && ((year % 4 == 0 && year % 100 != 0) || year % 400 == 0)) {
+        return 29;
+    }
+    return daysInMonth[month - 1];
+}
+
+// Days since 1970-01-01 in the proleptic Gregorian calendar.
+static NSInteger AJRDateParserDaysFromCivil(NSInteger year, NSInteger month, NSInteger day) {
+    year -= month <= 2;
+    NSInteger era = (year >= 0 ? year : year - 399) / 400;
+    NSInteger yearOfEra = year - era * 400;
+    NSInteger dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    NSInteger dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
+
+/*!
+ The equivalent of -[NSScanner scanDateSegment:segmentType:] for ASCII. Returns NO at the end of the input, in which case number is NSNotFound.
+ */
+static BOOL AJRDateParserScanSegment(const uint8_t *bytes, NSUInteger length, NSUInteger *position, NSInteger *number, AJRDateSegmentStringType *type) {
+    NSUInteger index = *position;
+
+    *type = AJRDateSegmentStringTypeNumeric;
+    *number = NSNotFound;
+
+    while (index < length && !AJRDateParserIsLetter(bytes[index]) && !AJRDateParserIsDigit(bytes[index])) {
+        index++;
+    }
+    if (index >= length) {
+        *position = index;
+        return NO;
+    }
+
+    if (AJRDateParserIsLetter(bytes[index])) {
+        char word[3];
+        NSUInteger wordLength = 0;
+        while (index < length && (AJRDateParserIsLetter(bytes[index]) || AJRDateParserIsDigit(bytes[index]))) {
+            if (wordLength < sizeof(word)) {
+                word[wordLength++] = AJRDateParserIsLetter(bytes[index]) ? (bytes[index] | 0x20) : bytes[index];
+            }
+            index++;
+        }
+        *type = AJRDateSegmentTypeForWord(word, wordLength, number);
+    } else {
+        NSInteger value = 0;
+        while (index < length && AJRDateParserIsDigit(bytes[index])) {
+            // Like NSScanner, clamp rather than overflow.
+            value = value > (NSIntegerMax - 9) / 10 ? NSIntegerMax : value * 10 + (bytes[index] - '0');
+            index++;
+        }
+        *number = value;
+    }
+    *position = index;
+
+    return YES;
+}
+
+@implementation AJRDateParser {
+    NSData *_fields;
+    BOOL _hasDay;
+    BOOL _isGregorian;
+    BOOL _hasFixedOffset;
+    NSTimeInterval _fixedOffset;
+    NSInteger _defaultMonth;
+    NSInteger _defaultDay;
+    NSInteger _defaultYear;
+    NSDateComponents *_defaultComponents;
+    AJRDateParserOffset *_offsets;
+}
+
+- (instancetype)initWithFormat:(NSString *)format {
+    return [self initWithFormat:format calendar:nil];
+}
+
+- (instancetype)initWithFormat:(NSString *)format calendar:(NSCalendar *)calendar {
+    if ((self = [super init])) {
+        _format = [format copy];
+        _calendar = calendar ?: [NSCalendar currentCalendar];
+        _isGregorian = [_calendar.calendarIdentifier isEqualToString:NSCalendarIdentifierGregorian];
+
+        // A zone that's never had a transition is always the same distance from GMT, so we needn't ask it about each day.
+        NSTimeZone *timeZone = _calendar.timeZone;
+        if ([timeZone nextDaylightSavingTimeTransitionAfterDate:[NSDate distantPast]] == nil) {
+            _hasFixedOffset = YES;
+            _fixedOffset = timeZone.secondsFromGMT;
+        } else {
+            _offsets = malloc(sizeof(AJRDateParserOffset) * AJRDateParserOffsetCacheSize);
+            for (NSInteger x = 0; x < AJRDateParserOffsetCacheSize; x++) {
+                _offsets[x].day = NSIntegerMin;
+            }
+        }
+
+        // Work out the order of the fields, which AJRDateFromStringAndFormat() does on each call.
+        if (_format != nil) {
+            NSMutableData *fields = [NSMutableData data];
+            for (NSString *component in [_format componentsSeparatedByString:@"%"]) {
+                AJRDateField field = 0;
+                switch (component.length ? [component characterAtIndex:0] : 0) {
+                    case 'm':
+                    case 'B':
+                    case 'b':
+                        field = AJRDateFieldMonth;
+                        break;
+                    case 'd':
+                    case 'e':
+                        field = AJRDateFieldDay;
+                        _hasDay = YES;
+                        break;
+                    case 'Y':
+                    case 'y':
+                        field = AJRDateFieldYear;
+                        break;
+                }
+                if (field) {
+                    [fields appendBytes:&field length:sizeof(field)];
+                }
+            }
+            _fields = fields;
+        }
+
+        self.referenceDate = [NSDate date];
+    }
+    return self;
+}
+
+- (void)dealloc {
+    free(_offsets);
+}
+
+- (void)setReferenceDate:(NSDate *)referenceDate {
+    _referenceDate = referenceDate;
+    NSDateComponents *components = [[NSCalendar currentCalendar] components:NSCalendarUnitYear | NSCalendarUnitMonth | NSCalendarUnitDay fromDate:referenceDate];
+    _defaultMonth = components.month;
+    _defaultDay = components.day;
+    _defaultYear = components.year;
+    _defaultComponents = components;
+}
+
+#pragma mark - Dates
+
+- (NSInteger)_daysInMonth:(NSInteger)month year:(NSInteger)year {
+    if (_isGregorian && year >= AJRDateParserFirstArithmeticYear && year <= AJRDateParserLastArithmeticYear) {
+        return AJRDateParserDaysInMonth(month, year);
+    }
+    return [_calendar rangeOfUnit:NSCalendarUnitDay inUnit:NSCalendarUnitMonth forDate:AJRDateFromMonthDayAndYear(_calendar, month, 1, year)].length;
+}
+
+- (NSTimeInterval)_timeIntervalForMonth:(NSInteger)month day:(NSInteger)day year:(NSInteger)year error:(NSError **)error {
+    NSInteger daysInMonth = [self _daysInMonth:month year:year];
+
+    if ((month < 1) || (month > 12)) {
+        AJRSetOutParameter(error, [NSError errorWithDomain:AJRDateErrorDomain code:AJRDateErrorCodeMonthOutOfRange format:@"The entered month must be within January (1) through December (12)."]);
+        return NAN;
+    }
+    if (day < 1) {
+        AJRSetOutParameter(error, [NSError errorWithDomain:AJRDateErrorDomain code:AJRDateErrorCodeDayOutOfRange message:@"Day must be at least 1."]);
+        return NAN;
+    }
+    if (day > daysInMonth) {
+        AJRSetOutParameter(error, [NSError errorWithDomain:AJRDateErrorDomain code:AJRDateErrorCodeDayOutOfRange format:@"There are only %ld days in the month of %@ in the year %ld.", (long)daysInMonth, [[[[NSDateFormatter alloc] init] monthSymbols] objectAtIndex:month - 1], (long)year]);
+        return NAN;
+    }
+
+    if (!_isGregorian || year < AJRDateParserFirstArithmeticYear || year > AJRDateParserLastArithmeticYear) {
+        return [AJRDateFromMonthDayAndYear(_calendar, month, day, year) timeIntervalSinceReferenceDate];
+    }
+
+    NSInteger days = AJRDateParserDaysFromCivil(year, month, day);
+    // Midnight as though we were at GMT.
+    NSTimeInterval midnight = days * 86400.0 - AJRDateParserReferenceDateOffset;
+
+    if (_hasFixedOffset) {
+        return midnight - _fixedOffset;
+    }
+
+    // Otherwise, ask the calendar once per day, which also gets us its answer for days where midnight falls in a daylight saving time transition.
+    AJRDateParserOffset *entry = _offsets + (days & (AJRDateParserOffsetCacheSize - 1));
+    if (entry->day != days) {
+        entry->day = days;
+        entry->offset = midnight - [AJRDateFromMonthDayAndYear(_calendar, month, day, year) timeIntervalSinceReferenceDate];
+    }
+    return midnight - entry->offset;
+}
+
+#pragma mark - Parsing
+
+// This follows AJRDateFromStringAndFormat() step for step, so that the two always agree.
+- (NSTimeInterval)_timeIntervalFromASCII:(const uint8_t *)bytes length:(NSUInteger)length error:(NSError **)error {
+    NSInteger m = _defaultMonth, d = _defaultDay, y = _defaultYear, currentYear = _defaultYear;
+    BOOL usedMonth = NO, usedDay = NO, usedYear = NO;
+    NSUInteger position = 0;
+    NSInteger w;
+    AJRDateSegmentStringType type;
+
+    // A string of only digits, surrounded by optional white space, is parsed as mm, mmyy, mmddyy, or mmddyyyy.
+    while (position < length && AJRDateParserIsWhitespace(bytes[position])) position++;
+    while (position < length && AJRDateParserIsDigit(bytes[position])) position++;
+    while (position < length && AJRDateParserIsWhitespace(bytes[position])) position++;
+    if (position == length) {
+        if ((length == 1) || (length == 3) || (length == 5) || (length == 7) || (length > 8)) {
+            AJRSetOutParameter(error, [NSError errorWithDomain:AJRDateErrorDomain code:AJRDateErrorCodeInvalidFormat message:@"When entering a date with out separators, you must enter mm, mmyy, mmddyy, or mmddyyyy"]);
+            return NAN;
+        }
+        if (length >= 2) {
+            usedMonth = YES;
+            m = (bytes[0] - '0') * 10 + (bytes[1] - '0');
+        }
+        if (length >= 4) {
+            usedDay = YES;
+            d = (bytes[2] - '0') * 10 + (bytes[3] - '0');
+        }
+        if (length >= 8) {
+            y = (bytes[4] - '0') * 1000 + (bytes[5] - '0') * 100 + (bytes[6] - '0') * 10 + (bytes[7] - '0');
+            usedYear = YES;
+        } else if (length >= 6) {
+            y = (bytes[4] - '0') * 10 + (bytes[5] - '0');
+            usedYear = YES;
+        }
+        if (!usedMonth && !usedDay && !usedYear) {
+            AJRSetOutParameter(error, [NSError errorWithDomain:AJRDateErrorDomain code:AJRDateErrorCodeNoValidDate format:@"Could not find a valid date in “%@”.", [[NSString alloc] initWithBytes:bytes length:length encoding:NSASCIIStringEncoding]]);
+            return NAN;
+        }
+        if (usedDay && !usedYear) {
+            // mmyy
+            y = AJRYearDerivedFromYearWithoutCentury(d, currentYear);
+            d = [self _daysInMonth:m year:y];
+        } else if (usedYear) {
+            y = AJRYearDerivedFromYearWithoutCentury(y, currentYear);
+        }
+        return [self _timeIntervalForMonth:m day:d year:y error:error];
+    }
+    position = 0;
+
+    if (_format != nil) {
+        const AJRDateField *fields = _fields.bytes;
+        NSUInteger fieldCount = _fields.length;
+        NSUInteger x = 0;
+
+        while (AJRDateParserScanSegment(bytes, length, &position, &w, &type)) {
+            if (type == AJRDateSegmentStringTypeDayOfWeek) {
+                AJRLog(nil, AJRLogLevelWarning, @"We don't handle days of week yet in date parsing, so ignoring.");
+                continue;
+            }
+            if (type == AJRDateSegmentStringTypeInvalid) {
+                AJRSetOutParameter(error, [NSError errorWithDomain:AJRDateErrorDomain code:AJRDateErrorCodeInvalidFormat format:@"An invalid substring was encountered while interpreting the date \"%@\".", [[NSString alloc] initWithBytes:bytes length:length encoding:NSASCIIStringEncoding]]);
+                return NAN;
+            }
+            switch (x < fieldCount ? fields[x] : 0) {
+                case AJRDateFieldMonth:
+                    m = w;
+                    break;
+                case AJRDateFieldDay:
+                    usedDay = YES;
+                    d = w;
+                    break;
+                case AJRDateFieldYear:
+                    usedYear = YES;
+                    y = w;
+                    break;
+            }
+            x++;
+        }
+
+        y = AJRYearDerivedFromYearWithoutCentury(y, currentYear);
+        // Without a day, use the last day of the month.
+        if (!_hasDay || !usedDay) {
+            d = [self _daysInMonth:m year:y];
+        }
+    } else {
+        // Without a format, it's month, day, year.
+        for (NSInteger field = 0; field < 3; field++) {
+            do {
+                AJRDateParserScanSegment(bytes, length, &position, &w, &type);
+                if (type == AJRDateSegmentStringTypeDayOfWeek) {
+                    AJRLog(nil, AJRLogLevelWarning, @"We don't handle days yet in date parsing, so ignoring.");
+                }
+            } while (type == AJRDateSegmentStringTypeDayOfWeek);
+
+            if (field == 0) {
+                if (w == NSNotFound) {
+                    AJRSetOutParameter(error, [NSError errorWithDomain:AJRDateErrorDomain code:AJRDateErrorCodeInvalidFormat format:@"No valid date was found in the string \"%@\".", [[NSString alloc] initWithBytes:bytes length:length encoding:NSASCIIStringEncoding]]);
+                    return NAN;
+                }
+                m = w;
+            } else if (w != NSNotFound) {
+                if (field == 1) {
+                    usedDay = YES;
+                    d = w;
+                } else {
+                    usedYear = YES;
+                    y = w;
+                }
+            }
+        }
+
+        if (usedDay && !usedYear) {
+            y = AJRYearDerivedFromYearWithoutCentury(d, currentYear);
+            d = [self _daysInMonth:m year:y];
+        } else {
+            y = AJRYearDerivedFromYearWithoutCentury(y, currentYear);
+        }
+    }
+
+    return [self _timeIntervalForMonth:m day:d year:y error:error];
+}
+
+- (NSTimeInterval)_timeIntervalFromNonASCIIString:(NSString *)string error:(NSError **)error {
+    // Missing fields come from referenceDate, just as they do on the ASCII path.
+    NSDate *date = AJRDateFromStringAndFormatWithDefaults(string, _format, _calendar, _defaultComponents, error);
+    return date ? [date timeIntervalSinceReferenceDate] : NAN;
+}
+
+- (NSTimeInterval)timeIntervalSinceReferenceDateFromString:(NSString *)string error:(NSError **)error {
+    CFStringRef cfString = (__bridge CFStringRef)string;
+    CFIndex length = CFStringGetLength(cfString);
+    const uint8_t *ascii = (const uint8_t *)CFStringGetCStringPtr(cfString, kCFStringEncodingASCII);
+
+    if (ascii && AJRDateParserIsASCII(ascii, length)) {
+        return [self _timeIntervalFromASCII:ascii length:length error:error];
+    }
+    if (length <= AJRDateParserBufferLength) {
+        uint8_t buffer[AJRDateParserBufferLength];
+        CFIndex used = 0;
+        if (CFStringGetBytes(cfString, CFRangeMake(0, length), kCFStringEncodingASCII, 0, false, buffer, sizeof(buffer), &used) == length) {
+            return [self _timeIntervalFromASCII:buffer length:used error:error];
+        }
+    }
+    return [self _timeIntervalFromNonASCIIString:string error:error];
+}
+
+- (NSTimeInterval)_timeIntervalFromUTF8Bytes:(const char *)bytes length:(NSUInteger)length error:(NSError **)error {
+    if (AJRDateParserIsASCII((const uint8_t *)bytes, length)) {
+        return [self _timeIntervalFromASCII:(const uint8_t *)bytes length:length error:error];
+    }
+    NSString *string = [[NSString alloc] initWithBytes:bytes length:length encoding:NSUTF8StringEncoding];
+    if (string == nil) {
+        AJRSetOutParameter(error, [NSError errorWithDomain:AJRDateErrorDomain code:AJRDateErrorCodeInvalidFormat message:@"The date isn't valid UTF-8."]);
+        return NAN;
+    }
+    return [self _timeIntervalFromNonASCIIString:string error:error];
+}
+
+- (NSTimeInterval)_timeIntervalFromCharacters:(const unichar *)characters length:(NSUInteger)length error:(NSError **)error {
+    if (length <= AJRDateParserBufferLength) {
+        uint8_t buffer[AJRDateParserBufferLength];
+        NSUInteger x;
+        for (x = 0; x < length && characters[x] < 0x80; x++) {
+            buffer[x] = characters[x];
+        }
+        if (x == length) {
+            return [self _timeIntervalFromASCII:buffer length:length error:error];
+        }
+    }
+    return [self _timeIntervalFromNonASCIIString:[[NSString alloc] initWithCharacters:characters length:length] error:error];
+}
+
+- (NSDate *)dateFromString:(NSString *)string error:(NSError **)error {
+    NSTimeInterval interval = [self timeIntervalSinceReferenceDateFromString:string error:error];
+    return isnan(interval) ? nil : [NSDate dateWithTimeIntervalSinceReferenceDate:interval];
+}
+
+- (NSDate *)dateFromUTF8Bytes:(const char *)bytes length:(NSUInteger)length error:(NSError **)error {
+    NSTimeInterval interval = [self _timeIntervalFromUTF8Bytes:bytes length:length error:error];
+    return isnan(interval) ? nil : [NSDate dateWithTimeIntervalSinceReferenceDate:interval];
+}
+
+- (NSDate *)dateFromCharacters:(const unichar *)characters length:(NSUInteger)length error:(NSError **)error {
+    NSTimeInterval interval = [self _timeIntervalFromCharacters:characters length:length error:error];
+    return isnan(interval) ? nil : [NSDate dateWithTimeIntervalSinceReferenceDate:interval];
+}
+
+#pragma mark - Batches
+
+- (NSArray *)datesFromStrings:(NSArray<NSString *> *)strings {
+    NSMutableArray *dates = [NSMutableArray arrayWithCapacity:strings.count];
+    NSNull *null = [NSNull null];
+
+    for (NSString *string in strings) {
+        NSTimeInterval interval = [self timeIntervalSinceReferenceDateFromString:string error:NULL];
+        [dates addObject:isnan(interval) ? null : [NSDate dateWithTimeIntervalSinceReferenceDate:interval]];
+    }
+
+    return dates;
+}
+
+- (void)getTimeIntervals:(NSTimeInterval *)intervals fromStrings:(NSArray<NSString *> *)strings {
+    NSUInteger index = 0;
+
+    for (NSString *string in strings) {
+        intervals[index++] = [self timeIntervalSinceReferenceDateFromString:string error:NULL];
+    }
+}
+
+@end
@@ -35,6 +35,20 @@ NS_ASSUME_NONNULL_BEGIN
 
 extern NSString * const AJRStreamErrorDomain;
 
+typedef NS_ENUM(NSInteger, AJRFileOutputStreamBuffering) {
+    /// Every write goes straight to write(2). This is the default.
+    AJRFileOutputStreamBufferingNone,
+    /// Writes are buffered, and the buffer is flushed whenever a newline is written.
+    AJRFileOutputStreamBufferingLine,
+    /// Writes are buffered, and the buffer is only flushed when full, on close, or on an explicit flush.
+    AJRFileOutputStreamBufferingFull,
+    /// Line buffering if the file descriptor is a TTY, otherwise full buffering.
+    AJRFileOutputStreamBufferingAutomatic,
+};
+
+/// The buffer size used by setBuffering:size: when passed a size of 0.
+extern const NSUInteger AJRFileOutputStreamDefaultBufferSize;
+
 @interface AJRFileOutputStream : NSOutputStream
 
 + (instancetype)outputStreamWithFileDescriptor:(int)fileHandle;
@@ -44,6 +58,30 @@ extern NSString * const AJRStreamErrorDomain;
 
 @property (nonatomic,assign) BOOL closeOnDeallocate;
 
+/*!
+ Changes how the stream buffers writes. Any data already buffered is flushed first. When buffering, a write that doesn't fit in the buffer is gathered with the buffered data into a single writev(2), rather than being copied.
+
+ Note that when buffering, write errors may not be reported until the buffer is flushed. Buffered data is flushed on close, and when the stream is deallocated.
+
+ @param buffering The buffering policy. AJRFileOutputStreamBufferingAutomatic is resolved when called, so the buffering property will reflect the policy actually chosen.
+ @param size The size of the buffer, or 0 for AJRFileOutputStreamDefaultBufferSize. Ignored when buffering is AJRFileOutputStreamBufferingNone.
+ */
+- (void)setBuffering:(AJRFileOutputStreamBuffering)buffering size:(NSUInteger)size;
+
+@property (nonatomic,readonly) AJRFileOutputStreamBuffering buffering;
+@property (nonatomic,readonly) NSUInteger bufferSize;
+/*! The number of bytes written to the stream, but not yet written to the file descriptor. */
+@property (nonatomic,readonly) NSUInteger bufferedLength;
+/*! The number of write(2) and writev(2) calls made by the stream. This is mostly useful for tuning the buffer size. */
+@property (nonatomic,readonly) NSUInteger writeCallCount;
+
+/*!
+ Writes any buffered data to the file descriptor. If the stream isn't buffering, this does nothing.
+
+ @returns YES on success, or NO if the write fails, in which case the stream also enters the error state.
+ */
+- (BOOL)flushWithError:(out NSError * _Nullable * _Nullable)error;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -31,14 +31,20 @@
 
 #import "AJRFileOutputStream.h"
 
+#import "AJRFunctions.h"
 #import "NSError+Extensions.h"
 
+#import <sys/uio.h>
+
 NSString * const AJRStreamErrorDomain = @"AJRStreamErrorDomain";
 
+const NSUInteger AJRFileOutputStreamDefaultBufferSize = 16384;
+
 @implementation AJRFileOutputStream {
     int _fileDescriptor;
     FILE *_file;
     NSError *_error;
+    uint8_t *_buffer;
 }
 
 + (instancetype)outputStreamWithFileDescriptor:(int)fileDescriptor {
@@ -75,7 +81,10 @@ NSString * const AJRStreamErrorDomain = @"AJRStreamErrorDomain";
 - (void)dealloc {
     if (_closeOnDeallocate) {
         [self close];
+    } else {
+        [self flushWithError:NULL];
     }
+    free(_buffer);
 }
 
 - (BOOL)hasSpaceAvailable {
@@ -83,6 +92,7 @@ NSString * const AJRStreamErrorDomain = @"AJRStreamErrorDomain";
 }
 
 - (void)close {
+    [self flushWithError:NULL];
     if (_file) {
         fclose(_file);
         _file = NULL;
@@ -101,17 +111,132 @@ NSString * const AJRStreamErrorDomain = @"AJRStreamErrorDomain";
     }
 }
 
+#pragma mark - Buffering
+
+- (void)setBuffering:(AJRFileOutputStreamBuffering)buffering size:(NSUInteger)size {
+    @synchronized (self) {
+        [self _flushBuffer];
+        if (buffering == AJRFileOutputStreamBufferingAutomatic) {
+            buffering = _fileDescriptor >= 0 && isatty(_fileDescriptor) ? AJRFileOutputStreamBufferingLine : AJRFileOutputStreamBufferingFull;
+        }
+        _buffering = buffering;
+        if (buffering == AJRFileOutputStreamBufferingNone) {
+            free(_buffer);
+            _buffer = NULL;
+            _bufferSize = 0;
+        } else {
+            _bufferSize = size == 0 ? AJRFileOutputStreamDefaultBufferSize : size;
+            _buffer = realloc(_buffer, _bufferSize);
+        }
+    }
+}
+
+- (NSUInteger)bufferedLength {
+    @synchronized (self) {
+        return _bufferedLength;
+    }
+}
+
+/*!
+ Writes all of vectors, coping with partial writes and interrupts. Returns NO, having set _error, if the write fails.
+ */
+- (BOOL)_writeVectors:(struct iovec *)vectors count:(int)count {
+    while (count > 0) {
+        ssize_t bytesWritten;
+        
+        _writeCallCount++;
+        if (count == 1) {
+            bytesWritten = write(_fileDescriptor, vectors[0].iov_base, vectors[0].iov_len);
+        } else {
+            bytesWritten = writev(_fileDescriptor, vectors, count);
+        }
+        if (bytesWritten < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            _error = [NSError errorWithDomain:AJRStreamErrorDomain errorNumber:errno];
+            return NO;
+        }
+        
+        // Skip over whatever made it out, which may end part way through a vector.
+        while (count > 0 && (size_t)bytesWritten >= vectors[0].iov_len) {
+            bytesWritten -= vectors[0].iov_len;
+            vectors++;
+            count--;
+        }
+        if (count > 0) {
+            vectors[0].iov_base = (uint8_t *)vectors[0].iov_base + bytesWritten;
+            vectors[0].iov_len -= bytesWritten;
+        }
+    }
+    return YES;
+}
+
+// Must be called while synchronized on self.
+- (BOOL)_flushBuffer {
+    if (_bufferedLength == 0) {
+        return YES;
+    }
+    if (_error != nil || _fileDescriptor < 0) {
+        // Nowhere for the data to go, so drop it. The error will have been reported when the stream closed or failed.
+        _bufferedLength = 0;
+        return NO;
+    }
+    struct iovec vector = { _buffer, _bufferedLength };
+    _bufferedLength = 0;
+    return [self _writeVectors:&vector count:1];
+}
+
+- (BOOL)flushWithError:(out NSError **)error {
+    NSError *localError = nil;
+    
+    @synchronized (self) {
+        if (![self _flushBuffer]) {
+            localError = _error ?: [NSError errorWithDomain:AJRStreamErrorDomain message:@"Attempted to flush a closed file."];
+        }
+    }
+    
+    return AJRAssertOrPropagateError(localError == nil, error, localError);
+}
+
+- (BOOL)_bufferBytes:(const uint8_t *)bytes length:(NSUInteger)length {
+    if (_bufferedLength + length < _bufferSize) {
+        memcpy(_buffer + _bufferedLength, bytes, length);
+        _bufferedLength += length;
+        if (_buffering == AJRFileOutputStreamBufferingLine && memchr(bytes, '\n', length) != NULL) {
+            return [self _flushBuffer];
+        }
+        return YES;
+    }
+    
+    // The write doesn't fit, so hand the buffered data and the new data to the kernel together, rather than copying the new data through the buffer.
+    struct iovec vectors[2] = {
+        { _buffer, _bufferedLength },
+        { (void *)bytes, length },
+    };
+    BOOL hasBufferedData = _bufferedLength > 0;
+    _bufferedLength = 0;
+    return [self _writeVectors:hasBufferedData ? vectors : vectors + 1 count:hasBufferedData ? 2 : 1];
+}
+
+#pragma mark - NSOutputStream
+
 - (NSInteger)write:(const uint8_t *)buffer maxLength:(NSUInteger)length {
     ssize_t bytesWritten = -1;
     
-    if (_error == nil) {
-        if (_fileDescriptor >= 0) {
-            bytesWritten = write(_fileDescriptor, buffer, length);
-            if (bytesWritten < 0) {
-                _error = [NSError errorWithDomain:AJRStreamErrorDomain errorNumber:errno];
+    @synchronized (self) {
+        if (_error == nil) {
+            if (_fileDescriptor < 0) {
+                _error = [NSError errorWithDomain:AJRStreamErrorDomain message:@"Attempted to write to a closed file."];
+            } else if (_buffering != AJRFileOutputStreamBufferingNone) {
+                bytesWritten = [self _bufferBytes:buffer length:length] ? (ssize_t)length : -1;
+            } else {
+                _writeCallCount++;
+                bytesWritten = write(_fileDescriptor, buffer, length);
+                if (bytesWritten < 0) {
+                    _error = [NSError errorWithDomain:AJRStreamErrorDomain errorNumber:errno];
+                }
             }
-        } else {
-            _error = [NSError errorWithDomain:AJRStreamErrorDomain message:@"Attempted to write to a closed file."];
         }
     }
     
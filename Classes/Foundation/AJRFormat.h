@@ -201,10 +201,97 @@ extern "C" {
      @result A formatted NSString. The value will be autoreleased.
      */
     extern NSString *AJRFormat(NSString *format, ...);
-    
+
+    /*!
+     @function AJRFormatToBufferv
+
+     @discussion Formats like AJRFormatv, but writes the result as UTF-8 into buffer, which may be on the stack or carved out of an arena, rather than allocating a string. Like snprintf, at most size - 1 bytes are written, followed by a NUL, and output that doesn't fit is dropped without splitting a UTF-8 sequence.
+
+     @param buffer The buffer to receive the output.
+     @param size The size of buffer, including room for the terminating NUL.
+     @param format The format specifier string.
+     @param ap The variable argument list.
+
+     @result The length in bytes of the complete output, not counting the NUL. If this is size or more, the output was truncated, and a buffer of the returned length plus one would have been large enough.
+     */
+    extern NSUInteger AJRFormatToBufferv(char *buffer, size_t size, NSString *format, va_list ap);
+    extern NSUInteger AJRFormatToBuffer(char *buffer, size_t size, NSString *format, ...);
+
+    /*!
+     @function AJRFormatToGrowableBufferv
+
+     @discussion Formats like AJRFormatToBufferv, but never truncates. The output goes into buffer while it fits, and is moved to memory allocated with malloc() when it doesn't, so the format is only ever rendered once.
+
+     @param buffer The buffer to try first.
+     @param size The size of buffer, including room for the terminating NUL.
+     @param result Set to the NUL terminated output. If this isn't buffer, the caller must free() it.
+     @param format The format specifier string.
+     @param ap The variable argument list.
+
+     @result The length in bytes of the output, not counting the NUL.
+     */
+    extern NSUInteger AJRFormatToGrowableBufferv(char *buffer, size_t size, char * _Nullable * _Nonnull result, NSString *format, va_list ap);
+    extern NSUInteger AJRFormatToGrowableBuffer(char *buffer, size_t size, char * _Nullable * _Nonnull result, NSString *format, ...);
+
+    /*!
+     @function AJRFormatAppendv
+
+     @discussion Formats like AJRFormatv, and appends the result to string, without creating an intermediate string.
+     */
+    extern void AJRFormatAppendv(NSMutableString *string, NSString *format, va_list ap);
+    extern void AJRFormatAppend(NSMutableString *string, NSString *format, ...);
+
+    /*!
+     @function AJRFormatToOutputStreamv
+
+     @discussion Formats like AJRFormatv, and writes the result to stream as UTF-8, a small buffer at a time, without creating an intermediate string. The stream's encoding isn't consulted.
+
+     @result The number of bytes written, or -1 if the stream failed to accept some of the output.
+     */
+    extern NSInteger AJRFormatToOutputStreamv(NSOutputStream *stream, NSString *format, va_list ap);
+    extern NSInteger AJRFormatToOutputStream(NSOutputStream *stream, NSString *format, ...);
+
+    /*!
+     @function AJRFormatToFileDescriptorv
+
+     @discussion Formats like AJRFormatv, and writes the result to fileDescriptor as UTF-8, a small buffer at a time, without creating an intermediate string.
+
+     @result The number of bytes written, or -1 if a write failed, in which case errno describes the failure.
+     */
+    extern NSInteger AJRFormatToFileDescriptorv(int fileDescriptor, NSString *format, va_list ap);
+    extern NSInteger AJRFormatToFileDescriptor(int fileDescriptor, NSString *format, ...);
+
 #ifdef __cplusplus
 }
 #endif
 
+/*!
+ @class AJRFormatSpecification
+
+ @discussion A format string that's been parsed, once, into its literal text and its conversions, so that it can be rendered any number of times without being parsed again. AJRFormat and AJRFormatv use this class, and, when the format is a constant string, they'll reuse a cached specification, so you'll generally only need to use this directly when you'd like to hold on to a specification for a format that isn't a constant, or when you want the output as UTF-8 or UTF-16 bytes, rather than as a string.
+
+ Specifications are immutable, and may be used from any number of threads at once.
+ */
+@interface AJRFormatSpecification : NSObject
+
+/*!
+ Returns a specification for format. When format is a constant string, the specification is cached, and the same instance will be returned on later calls.
+ */
++ (instancetype)specificationWithFormat:(NSString *)format;
+
+- (instancetype)initWithFormat:(NSString *)format NS_DESIGNATED_INITIALIZER;
+- (instancetype)init NS_UNAVAILABLE;
+
+@property (nonatomic,readonly,strong) NSString *format;
+
+/*! Renders the receiver with the arguments in ap. This is what AJRFormatv does. */
+- (NSString *)stringWithArguments:(va_list)ap;
+/*! Renders the receiver directly to UTF-8, without first producing a string. */
+- (NSData *)UTF8DataWithArguments:(va_list)ap;
+/*! Renders the receiver directly to UTF-16, in host byte order and without a byte order mark. */
+- (NSData *)UTF16DataWithArguments:(va_list)ap;
+
+@end
+
 NS_ASSUME_NONNULL_END
 
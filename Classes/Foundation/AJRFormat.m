@@ -34,31 +34,7 @@
 #import "AJRLogging.h"
 #import "AJRFoundationOS.h"
 
-typedef NS_ENUM(uint8_t, AJRFormatStage) {
-    AJRFormatStageAPriori,
-    AJRFormatStageParameter,
-    AJRFormatStageFlags,
-    AJRFormatStageWidth,
-    AJRFormatStagePrecision,
-    AJRFormatStageType
-};
-
-#define _AJRExpandBufferIfNeeded(length) { \
-while (outputBufferPosition + length >= outputBufferMaxLength) { \
-outputBufferMaxLength += 1024; \
-outputBuffer = (wchar_t *)NSZoneRealloc(NULL, outputBuffer, sizeof(wchar_t) * outputBufferMaxLength); \
-} \
-}
-
-#define _AJRPad(count) { \
-wchar_t pad = (flags & AJRZeroPadding) ? '0' : ' '; \
-NSInteger rCount = (count); \
-while (rCount) { \
-outputBuffer[outputBufferPosition] = pad; \
-outputBufferPosition++; \
-rCount--; \
-} \
-}
+#import <unistd.h>
 
 #if defined(AJRFoundation_iOS)
 static NSString *NSStringFromPoint(CGPoint point) {
@@ -114,764 +90,1270 @@ char *_ajrIntegerToString(unsigned long long value, NSInteger base, char *digits
     return buffer + x + 1;
 }
 
-NSString *AJRFormatv(NSString *format, va_list ap) {
-    char integerBuffer[_integerBufferSize];
-    wchar_t character;
-    NSInteger position, x;
-    NSUInteger length;
-    wchar_t *outputBuffer;
-    NSInteger outputBufferPosition = 0;
-    NSInteger outputBufferMaxLength = 1024;
-    NSRange range;
-    AJRFormatStage stage = AJRFormatStageAPriori;
-    NSUInteger flags = 0;
-    NSUInteger width = NSNotFound, precision = NSNotFound;
-    NSCharacterSet *digits = [NSCharacterSet decimalDigitCharacterSet];
-    char *stringValue = NULL;
-    unichar *unicharStringValue = NULL;
-    id objectValue = nil;
-    NSDate *dateValue = nil;
-    NSInteger numericBase = 0;
-    char *prefix = NULL;
-    BOOL isSigned = NO;
-    char *displayDigits = _ajrDecimalDigits;
-    BOOL doingFloat = NO;
-    double floatValue = 0.0;
-    long double longDoubleValue = 0.0;
-    BOOL doingTimeInterval = NO;
-    OSType osType = '    ';
-    BOOL doingOSType = NO;
-    BOOL booleanValue = NO;
-    BOOL doingBooleanType = NO;
-    BOOL useCapitals = NO;
-    NSTimeZone *timeZoneForFormat = nil;
-    NSTimeInterval timeIntervalValue = 0.0;
-    NSRange parameterRange;
-    wchar_t *inputBuffer;
-
-    // format.length should always be sufficient, since we're converting to UTF-32, which, if anything will convert two character input characters to single characters.
-    inputBuffer = (wchar_t *)NSZoneMalloc(NULL, sizeof(wchar_t) * format.length);
-    [format getBytes:inputBuffer maxLength:sizeof(wchar_t) * format.length usedLength:&length encoding:NSUTF32LittleEndianStringEncoding options:0 range:(NSRange){0, [format length]} remainingRange:NULL];
-    length /= sizeof(wchar_t); // Because the above returns the length in bytes, but wchar_t, which is what we really want.
-    
-    outputBuffer = (wchar_t *)NSZoneMalloc(NULL, sizeof(wchar_t) * outputBufferMaxLength);
-    
-    range.location = 0;
-    range.length = 0;
-    for (position = 0; position < length; position++) {
-        character = CFSwapInt32LittleToHost(inputBuffer[position]);
-        if (stage == AJRFormatStageAPriori) {
-            if (character == '%') {
-                range.length = position - range.location;
-                _AJRExpandBufferIfNeeded(range.length);
-                for (NSInteger x = 0; x <  range.length; x++) {
-                    outputBuffer[outputBufferPosition + x] = inputBuffer[range.location + x];
-                }
-                range.location = position + 1;
-                outputBufferPosition += range.length;
-                stage = AJRFormatStageFlags;
-                flags = 0;
-                width = NSNotFound;
-                precision = NSNotFound;
-                stringValue = NULL;
-                unicharStringValue = NULL;
-                objectValue = nil;
-                dateValue = nil;
-                numericBase = 0;
-                prefix = NULL;
-                doingFloat = NO;
-                parameterRange = (NSRange){NSNotFound, 0};
+
+#pragma mark - Output
+
+typedef NS_ENUM(uint8_t, AJRFormatEncoding) {
+    AJRFormatEncodingUTF8,
+    AJRFormatEncodingUTF16,
+};
+
+typedef struct _ajrFormatOutput AJRFormatOutput;
+
+/*!
+ Called when an append of needed bytes won't fit in the output's buffer. The function should make room, either by growing the buffer or by flushing it somewhere, and return YES. A flushing function needn't make room for all of needed, as the append will be handed over a buffer full at a time. If it returns NO, the append is truncated to what fits, and the rest, along with anything appended later, is counted in truncatedLength.
+ */
+typedef BOOL (*AJRFormatOutputMakeRoom)(AJRFormatOutput *output, size_t needed);
+
+struct _ajrFormatOutput {
+    AJRFormatEncoding encoding;
+    uint8_t *bytes;
+    size_t length;
+    size_t capacity;
+    // YES once bytes has been allocated by AJRFormatOutputGrow(), rather than provided by the caller.
+    BOOL ownsBytes;
+    size_t truncatedLength;
+    // The number of characters written, for %n. This is only kept when countsCharacters is set, since it costs a scan of every string appended.
+    BOOL countsCharacters;
+    NSInteger characters;
+    AJRFormatOutputMakeRoom makeRoom;
+    void *context;
+};
+
+static BOOL AJRFormatOutputGrow(AJRFormatOutput *output, size_t needed) {
+    size_t capacity = MAX(output->capacity * 2, output->length + needed + 256);
+
+    if (output->ownsBytes) {
+        output->bytes = reallocf(output->bytes, capacity);
+    } else {
+        uint8_t *bytes = malloc(capacity);
+        if (bytes && output->length) {
+            memcpy(bytes, output->bytes, output->length);
+        }
+        output->bytes = bytes;
+        output->ownsBytes = YES;
+    }
+    if (output->bytes == NULL) {
+        output->length = 0;
+        output->capacity = 0;
+        return NO;
+    }
+    output->capacity = capacity;
+
+    return YES;
+}
+
+static inline AJRFormatOutput AJRFormatOutputMake(AJRFormatEncoding encoding, void *bytes, size_t capacity, AJRFormatOutputMakeRoom makeRoom) {
+    AJRFormatOutput output = { 0 };
+    output.encoding = encoding;
+    output.bytes = bytes;
+    output.capacity = capacity;
+    output.makeRoom = makeRoom;
+    return output;
+}
+
+static void AJRFormatOutputAppendBytes(AJRFormatOutput *output, const void *bytes, size_t length) {
+    const uint8_t *input = bytes;
+
+    // Once we've truncated, everything else is just counted, otherwise the output would have holes in it.
+    if (output->truncatedLength > 0) {
+        output->truncatedLength += length;
+        return;
+    }
+
+    while (output->capacity - output->length < length) {
+        if (output->makeRoom && output->makeRoom(output, length)) {
+            size_t room = output->capacity - output->length;
+            if (room >= length) {
+                break;
             }
+            if (room > 0) {
+                // A sink that flushes can only make as much room as its buffer, so hand it what fits and go around again.
+                memcpy(output->bytes + output->length, input, room);
+                output->length += room;
+                input += room;
+                length -= room;
+                continue;
+            }
+        }
+
+        size_t available = output->capacity - output->length;
+        if (output->encoding == AJRFormatEncodingUTF16) {
+            available &= ~(size_t)1;
         } else {
-            if (stage == AJRFormatStageFlags) {
-                switch (character) {
-                    case '%':
-                        stage = AJRFormatStageAPriori;
-                        continue;
-                    case '#':
-                        flags |= AJRAlternateForm;
-                        range.location++;
-                        break;
-                    case '0':
-                        flags |= AJRZeroPadding;
-                        range.location++;
-                        break;
-                    case '-':
-                        flags |= AJRLeftJustified;
-                        range.location++;
-                        break;
-                    case ' ':
-                        flags |= AJRSpaceForPlus;
-                        range.location++;
-                        break;
-                    case '+':
-                        flags |= AJRShowPlus;
-                        range.location++;
-                        break;
-                    case '!':
-                        timeZoneForFormat = va_arg(ap, NSTimeZone *);
-                        if (![timeZoneForFormat isKindOfClass:[NSTimeZone class]]) {
-                            AJRLog(nil, AJRLogLevelWarning, @"Flag parameter to %s wasn't an NSTimeZone object.", __FUNCTION__);
-                            timeZoneForFormat = nil;
-                        }
-                        range.location++;
-                        break;
-                        //                    case ',':
-                        //                        flags |= AJRGroupThousands;
-                        //                        range.location++;
-                        //                        break;
-                    case '(':
-                        stage = AJRFormatStageParameter;
-                        parameterRange.location = position;
-                        parameterRange.length = 0;
-                        break;
-                    default:
-                        stage = AJRFormatStageWidth;
-                        break;
-                }
+            // Don't leave half of a UTF-8 sequence at the end of the output.
+            while (available > 0 && (input[available] & 0xC0) == 0x80) {
+                available--;
+            }
+        }
+        memcpy(output->bytes + output->length, input, available);
+        output->length += available;
+        output->truncatedLength = length - available;
+        return;
+    }
+    memcpy(output->bytes + output->length, input, length);
+    output->length += length;
+}
+
+// Appends bytes as ISO Latin 1, which, for characters below 128, is also ASCII.
+static void AJRFormatOutputAppendLatin1(AJRFormatOutput *output, const char *characters, size_t length) {
+    const uint8_t *input = (const uint8_t *)characters;
+
+    if (output->countsCharacters) {
+        output->characters += length;
+    }
+
+    if (output->encoding == AJRFormatEncodingUTF16) {
+        unichar buffer[128];
+        while (length > 0) {
+            size_t count = MIN(length, 128);
+            for (size_t x = 0; x < count; x++) {
+                buffer[x] = input[x];
+            }
+            AJRFormatOutputAppendBytes(output, buffer, count * sizeof(unichar));
+            input += count;
+            length -= count;
+        }
+    } else {
+        while (length > 0) {
+            size_t run = 0;
+            while (run < length && input[run] < 0x80) {
+                run++;
+            }
+            AJRFormatOutputAppendBytes(output, input, run);
+            input += run;
+            length -= run;
+            if (length > 0) {
+                uint8_t encoded[2] = { 0xC0 | (input[0] >> 6), 0x80 | (input[0] & 0x3F) };
+                AJRFormatOutputAppendBytes(output, encoded, 2);
+                input++;
+                length--;
+            }
+        }
+    }
+}
+
+static void AJRFormatOutputAppendRepeated(AJRFormatOutput *output, char character, size_t count) {
+    char buffer[64];
+    memset(buffer, character, MIN(count, sizeof(buffer)));
+    while (count > 0) {
+        size_t chunk = MIN(count, sizeof(buffer));
+        AJRFormatOutputAppendLatin1(output, buffer, chunk);
+        count -= chunk;
+    }
+}
+
+static void AJRFormatOutputAppendCodePoint(AJRFormatOutput *output, uint32_t character) {
+    if (character > 0x10FFFF || (character >= 0xD800 && character <= 0xDFFF)) {
+        character = 0xFFFD;
+    }
+    if (output->countsCharacters) {
+        output->characters++;
+    }
+    if (output->encoding == AJRFormatEncodingUTF16) {
+        if (character > 0xFFFF) {
+            unichar pair[2] = { 0xD800 + ((character - 0x10000) >> 10), 0xDC00 + ((character - 0x10000) & 0x3FF) };
+            AJRFormatOutputAppendBytes(output, pair, sizeof(pair));
+        } else {
+            unichar single = character;
+            AJRFormatOutputAppendBytes(output, &single, sizeof(single));
+        }
+    } else {
+        uint8_t encoded[4];
+        size_t length;
+        if (character < 0x80) {
+            encoded[0] = character;
+            length = 1;
+        } else if (character < 0x800) {
+            encoded[0] = 0xC0 | (character >> 6);
+            encoded[1] = 0x80 | (character & 0x3F);
+            length = 2;
+        } else if (character < 0x10000) {
+            encoded[0] = 0xE0 | (character >> 12);
+            encoded[1] = 0x80 | ((character >> 6) & 0x3F);
+            encoded[2] = 0x80 | (character & 0x3F);
+            length = 3;
+        } else {
+            encoded[0] = 0xF0 | (character >> 18);
+            encoded[1] = 0x80 | ((character >> 12) & 0x3F);
+            encoded[2] = 0x80 | ((character >> 6) & 0x3F);
+            encoded[3] = 0x80 | (character & 0x3F);
+            length = 4;
+        }
+        AJRFormatOutputAppendBytes(output, encoded, length);
+    }
+}
+
+static void AJRFormatOutputAppendCharacters(AJRFormatOutput *output, const unichar *characters, size_t length) {
+    if (output->countsCharacters) {
+        NSInteger count = length;
+        for (size_t x = 0; x < length; x++) {
+            if (CFStringIsSurrogateLowCharacter(characters[x])) {
+                count--;
+            }
+        }
+        output->characters += count;
+    }
+
+    if (output->encoding == AJRFormatEncodingUTF16) {
+        AJRFormatOutputAppendBytes(output, characters, length * sizeof(unichar));
+        return;
+    }
+
+    uint8_t buffer[256];
+    size_t used = 0;
+    for (size_t x = 0; x < length; x++) {
+        // Leave room for the longest sequence we can write.
+        if (used > sizeof(buffer) - 4) {
+            AJRFormatOutputAppendBytes(output, buffer, used);
+            used = 0;
+        }
+        uint32_t character = characters[x];
+        if (character < 0x80) {
+            buffer[used++] = character;
+            continue;
+        }
+        if (CFStringIsSurrogateHighCharacter(character) && x + 1 < length && CFStringIsSurrogateLowCharacter(characters[x + 1])) {
+            character = CFStringGetLongCharacterForSurrogatePair(character, characters[++x]);
+        } else if (character >= 0xD800 && character <= 0xDFFF) {
+            character = 0xFFFD;
+        }
+        if (character < 0x800) {
+            buffer[used++] = 0xC0 | (character >> 6);
+            buffer[used++] = 0x80 | (character & 0x3F);
+        } else if (character < 0x10000) {
+            buffer[used++] = 0xE0 | (character >> 12);
+            buffer[used++] = 0x80 | ((character >> 6) & 0x3F);
+            buffer[used++] = 0x80 | (character & 0x3F);
+        } else {
+            buffer[used++] = 0xF0 | (character >> 18);
+            buffer[used++] = 0x80 | ((character >> 12) & 0x3F);
+            buffer[used++] = 0x80 | ((character >> 6) & 0x3F);
+            buffer[used++] = 0x80 | (character & 0x3F);
+        }
+    }
+    AJRFormatOutputAppendBytes(output, buffer, used);
+}
+
+static void AJRFormatOutputAppendString(AJRFormatOutput *output, CFStringRef string, CFRange range) {
+    const unichar *characters = CFStringGetCharactersPtr(string);
+    if (characters) {
+        AJRFormatOutputAppendCharacters(output, characters + range.location, range.length);
+        return;
+    }
+
+    // Most strings are stored as ASCII, which is also UTF-8, and saves us looking at each character.
+    if (output->encoding == AJRFormatEncodingUTF8) {
+        const char *bytes = CFStringGetCStringPtr(string, kCFStringEncodingASCII);
+        if (bytes) {
+            AJRFormatOutputAppendLatin1(output, bytes + range.location, range.length);
+            return;
+        }
+    }
+
+    unichar buffer[256];
+    while (range.length > 0) {
+        CFIndex count = MIN(range.length, 256);
+        CFStringGetCharacters(string, CFRangeMake(range.location, count), buffer);
+        // Don't split a surrogate pair between chunks.
+        if (count < range.length && count > 1 && CFStringIsSurrogateHighCharacter(buffer[count - 1])) {
+            count--;
+        }
+        AJRFormatOutputAppendCharacters(output, buffer, count);
+        range.location += count;
+        range.length -= count;
+    }
+}
+
+#pragma mark - Specifications
+
+typedef struct _ajrFormatSegment {
+    // The conversion character, or 0 for literal text.
+    uint32_t conversion;
+    uint16_t flags;
+    // The number of '!' flags, each of which takes a time zone argument.
+    uint8_t timeZoneArguments;
+    // The number of '*'s in the width and precision, each of which takes an int argument. Only the last one counts.
+    uint8_t widthArguments;
+    uint8_t precisionArguments;
+    // The digits of the width and precision, or NSNotFound. When there's an argument, these are digits that followed it, and they're appended to the argument's value, shifted over by the scale.
+    NSUInteger width;
+    NSUInteger widthScale;
+    NSUInteger precision;
+    NSUInteger precisionScale;
+    // Literal text, as offsets into the specification's UTF-8 and UTF-16 copies.
+    NSUInteger utf8Offset;
+    NSUInteger utf8Length;
+    NSUInteger utf16Offset;
+    NSUInteger utf16Length;
+    NSUInteger characterCount;
+    // The contents of a "(...)" parameter, which is used as the date format by %D.
+    CFStringRef parameter;
+    // The printf format for floating point conversions, with '*'s for the width and precision, if they're present.
+    char floatFormat[16];
+} AJRFormatSegment;
+
+typedef struct _ajrFormatRenderState {
+    // These two carry from one conversion to the next, as they always have.
+    BOOL useCapitals;
+    __unsafe_unretained NSTimeZone *timeZone;
+} AJRFormatRenderState;
+
+// How many constant format strings we'll remember.
+static const NSUInteger AJRFormatCacheLimit = 4096;
+
+@interface AJRFormatSpecification ()
+
+- (void)_renderToOutput:(AJRFormatOutput *)output arguments:(va_list)ap;
+
+@end
+
+@implementation AJRFormatSpecification {
+    AJRFormatSegment *_segments;
+    NSUInteger _segmentCount;
+    NSData *_utf8Literals;
+    NSData *_utf16Literals;
+    BOOL _countsCharacters;
+}
+
++ (instancetype)specificationWithFormat:(NSString *)format {
+    static NSMapTable *cache = nil;
+    static NSLock *cacheLock = nil;
+    static Class constantStringClass = Nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        // Constant strings live for the life of the process, so we can key on their addresses.
+        cache = [NSMapTable mapTableWithKeyOptions:NSPointerFunctionsOpaqueMemory | NSPointerFunctionsOpaquePersonality valueOptions:NSPointerFunctionsStrongMemory];
+        cacheLock = [[NSLock alloc] init];
+        constantStringClass = [@"" class];
+    });
+
+    if ([format class] != constantStringClass) {
+        return [[self alloc] initWithFormat:format];
+    }
+
+    [cacheLock lock];
+    AJRFormatSpecification *specification = [cache objectForKey:format];
+    [cacheLock unlock];
+
+    if (specification == nil) {
+        specification = [[self alloc] initWithFormat:format];
+        [cacheLock lock];
+        if (cache.count < AJRFormatCacheLimit) {
+            [cache setObject:specification forKey:format];
+        }
+        [cacheLock unlock];
+    }
+
+    return specification;
+}
+
+- (instancetype)initWithFormat:(NSString *)format {
+    if ((self = [super init])) {
+        _format = [format copy];
+        [self _compile];
+    }
+    return self;
+}
+
+- (void)dealloc {
+    for (NSUInteger x = 0; x < _segmentCount; x++) {
+        if (_segments[x].parameter) {
+            CFRelease(_segments[x].parameter);
+        }
+    }
+    free(_segments);
+}
+
+#pragma mark - Compiling
+
+- (AJRFormatSegment *)_addSegment:(NSUInteger *)capacity {
+    if (_segmentCount == *capacity) {
+        *capacity = MAX(8, *capacity * 2);
+        _segments = reallocf(_segments, sizeof(AJRFormatSegment) * *capacity);
+    }
+    AJRFormatSegment *segment = _segments + _segmentCount++;
+    memset(segment, 0, sizeof(AJRFormatSegment));
+    return segment;
+}
+
+- (void)_compile {
+    CFStringRef format = (__bridge CFStringRef)_format;
+    CFIndex length = format ? CFStringGetLength(format) : 0;
+    CFStringInlineBuffer buffer;
+    NSMutableData *utf16Literals = [NSMutableData data];
+    __block AJRFormatOutput utf8Literals = AJRFormatOutputMake(AJRFormatEncodingUTF8, NULL, 0, AJRFormatOutputGrow);
+    __block NSUInteger capacity = 0;
+    __block CFIndex literalStart = 0;
+    CFIndex position = 0;
+
+    CFStringInitInlineBuffer(format, &buffer, CFRangeMake(0, length));
+
+    // Appends the literal text that's accumulated in utf16Literals since literalStart.
+    void (^finishLiteral)(void) = ^{
+        NSUInteger literalLength = utf16Literals.length / sizeof(unichar) - literalStart;
+        if (literalLength > 0) {
+            const unichar *characters = (const unichar *)utf16Literals.bytes + literalStart;
+            AJRFormatSegment *segment = [self _addSegment:&capacity];
+            segment->utf16Offset = literalStart;
+            segment->utf16Length = literalLength;
+            segment->utf8Offset = utf8Literals.length;
+            utf8Literals.countsCharacters = YES;
+            utf8Literals.characters = 0;
+            AJRFormatOutputAppendCharacters(&utf8Literals, characters, literalLength);
+            segment->utf8Length = utf8Literals.length - segment->utf8Offset;
+            segment->characterCount = utf8Literals.characters;
+        }
+        literalStart = utf16Literals.length / sizeof(unichar);
+    };
+
+    while (position < length) {
+        unichar character = CFStringGetCharacterFromInlineBuffer(&buffer, position++);
+        if (character != '%') {
+            [utf16Literals appendBytes:&character length:sizeof(character)];
+            continue;
+        }
+
+        AJRFormatSegment spec = { 0 };
+        NSUInteger parameterStart = NSNotFound, parameterLength = 0;
+        BOOL complete = NO;
+
+        spec.width = NSNotFound;
+        spec.precision = NSNotFound;
+        spec.widthScale = 1;
+        spec.precisionScale = 1;
+
+        // Flags, which may be interleaved with "(...)" parameters.
+        while (position < length) {
+            character = CFStringGetCharacterFromInlineBuffer(&buffer, position);
+            if (character == '#') {
+                spec.flags |= AJRAlternateForm;
+            } else if (character == '0') {
+                spec.flags |= AJRZeroPadding;
+            } else if (character == '-') {
+                spec.flags |= AJRLeftJustified;
+            } else if (character == ' ') {
+                spec.flags |= AJRSpaceForPlus;
+            } else if (character == '+') {
+                spec.flags |= AJRShowPlus;
+            } else if (character == '!') {
+                spec.timeZoneArguments++;
+            } else if (character == '(') {
+                parameterStart = position;
+                while (++position < length && CFStringGetCharacterFromInlineBuffer(&buffer, position) != ')') { }
+                parameterLength = position - parameterStart + 1;
+            } else {
+                break;
             }
-            if (stage == AJRFormatStageParameter) {
-                if (character == ')') {
-                    stage = AJRFormatStageFlags;
-                    parameterRange.length = position - parameterRange.location + 1;
+            position++;
+        }
+        if (position < length && character == '%' && spec.flags == 0 && spec.timeZoneArguments == 0 && parameterStart == NSNotFound) {
+            // A literal '%'.
+            [utf16Literals appendBytes:&character length:sizeof(character)];
+            position++;
+            continue;
+        }
+
+        // Width
+        while (position < length) {
+            character = CFStringGetCharacterFromInlineBuffer(&buffer, position);
+            if (character == '*') {
+                spec.widthArguments++;
+                spec.width = NSNotFound;
+                spec.widthScale = 1;
+            } else if (character >= '0' && character <= '9') {
+                spec.width = spec.width == NSNotFound ? character - '0' : spec.width * 10 + (character - '0');
+                if (spec.widthArguments) {
+                    spec.widthScale *= 10;
                 }
-                range.location++;
+            } else {
+                break;
             }
-            if (stage == AJRFormatStageWidth) {
+            position++;
+        }
+
+        // Precision
+        if (position < length && character == '.') {
+            position++;
+            while (position < length) {
+                character = CFStringGetCharacterFromInlineBuffer(&buffer, position);
                 if (character == '*') {
-                    width = va_arg(ap, int);
-                    range.location++;
-                } else if ([digits characterIsMember:character]) {
-                    if (width == NSNotFound) {
-                        width = character - '0';
-                    } else {
-                        width = (width * 10) + (character - '0');
+                    spec.precisionArguments++;
+                    spec.precision = NSNotFound;
+                    spec.precisionScale = 1;
+                } else if (character >= '0' && character <= '9') {
+                    spec.precision = spec.precision == NSNotFound ? character - '0' : spec.precision * 10 + (character - '0');
+                    if (spec.precisionArguments) {
+                        spec.precisionScale *= 10;
                     }
-                    range.location++;
-                } else if (character == '.') {
-                    stage = AJRFormatStagePrecision;
-                    continue; // We don't want fall through in this case.
                 } else {
-                    stage = AJRFormatStageType;
+                    break;
                 }
+                position++;
             }
-            if (stage == AJRFormatStagePrecision) {
-                if (character == '*') {
-                    precision = va_arg(ap, int);
-                    range.location++;
-                } else if ([digits characterIsMember:character]) {
-                    if (precision == NSNotFound) {
-                        precision = character - '0';
-                    } else {
-                        precision = (precision * 10) + (character - '0');
-                    }
-                    range.location++;
+        }
+
+        // Length modifiers, and finally the conversion.
+        while (position < length) {
+            character = CFStringGetCharacterFromInlineBuffer(&buffer, position++);
+            if (character == 'h') {
+                spec.flags |= AJRShortType;
+            } else if (character == 'l') {
+                if (spec.flags & AJRLongType) {
+                    spec.flags &= ~AJRLongType;
+                    spec.flags |= AJRLongLongType;
                 } else {
-                    stage = AJRFormatStageType;
-                    range.location++;
+                    spec.flags |= AJRLongType;
                 }
-            }
-            if (stage == AJRFormatStageType) {
-                switch (character) {
-                    case 'h':
-                        flags |= AJRShortType;
-                        range.location++;
-                        break;
-                    case 'l':
-                        if (flags & AJRLongType) {
-                            flags &= (~AJRLongType);
-                            flags |= AJRLongLongType;
-                        } else {
-                            flags |= AJRLongType;
-                        }
-                        range.location++;
-                        break;
-                    case 'L':
-                        flags &= (~AJRLongType);
-                        flags |= AJRLongLongType;
-                        range.location++;
-                        break;
-                    case 'q':
-                        flags |= AJRLongLongType;
-                        range.location++;
-                        break;
-                    case 'z':
-                        flags |= AJRSizeTType;
-                        range.location++;
-                        break;
-                    case 'd':
-                    case 'i':
-                        numericBase = 10;
-                        isSigned = YES;
-                        displayDigits = _ajrDecimalDigits;
-                        break;
-                    case 'b':
-                        numericBase = 2;
-                        prefix = NULL;
-                        isSigned = NO;
-                        displayDigits = _ajrDecimalDigits;
-                        break;
-                    case 'o':
-                        numericBase = 8;
-                        prefix = flags & AJRAlternateForm ? "0" : NULL;
-                        isSigned = YES;
-                        displayDigits = _ajrOctalDigits;
-                        break;
-                    case 'u':
-                        numericBase = 10;
-                        prefix = NULL;
-                        isSigned = NO;
-                        displayDigits = _ajrDecimalDigits;
-                        break;
-                    case 'x':
-                        numericBase = 16;
-                        prefix = flags & AJRAlternateForm ? "0x" : NULL;
-                        isSigned = NO;
-                        displayDigits = useCapitals ? _ajrHEXIDECIMALDigits : _ajrHexidecimalDigits;
-                        break;
-                    case 'X':
-                        numericBase = 16;
-                        prefix = flags & AJRAlternateForm ? "0X" : NULL;
-                        isSigned = NO;
-                        displayDigits = _ajrHEXIDECIMALDigits;
-                        break;
-                    case 'A':
-                    case 'E':
-                    case 'F':
-                    case 'G':
-                        useCapitals = YES;
-                    case 'a':
-                    case 'e':
-                    case 'f':
-                    case 'g':
-                        doingFloat = YES;
-                        if ((flags & AJRLongType) || (flags & AJRLongLongType)) {
-                            longDoubleValue = va_arg(ap, long double);
-                        } else {
-                            floatValue = va_arg(ap, double);
-                        }
-                        break;
-                    case 'c':
-                        _AJRExpandBufferIfNeeded(1);
-                        if (flags & AJRLongType) {
-                            outputBuffer[outputBufferPosition++] = va_arg(ap, unsigned int) & 0xFFFFFFFF;
-                        } else {
-                            outputBuffer[outputBufferPosition++] = va_arg(ap, unsigned int) & 0xFF;
-                        }
-                        stage = AJRFormatStageAPriori;
-                        range.location++;
-                        break;
-                    case 's':
-                        if (flags & AJRLongType) {
-                            unicharStringValue = va_arg(ap, unichar *);
-                            if (unicharStringValue == NULL) {
-                                objectValue = @"(null)";
-                            }
-                        } else {
-                            stringValue = va_arg(ap, char *);
-                            if (stringValue == NULL) {
-                                objectValue = @"(null)";
-                            }
-                        }
-                        break;
-                    case 'p':
-                        numericBase = 16;
-                        prefix = "0x";
-                        isSigned = NO;
-                        displayDigits = _ajrHexidecimalDigits;
-                        if (sizeof(void *) == 8) {
-                            flags |= AJRLongLongType;
-                        }
-                        break;
-                    case 'n':
-                    {
-                        if (flags & AJRLongType) {
-                            NSInteger *location = va_arg(ap, NSInteger *);
-                            *location = outputBufferPosition;
-                        } else if (flags & AJRLongLongType) {
-                            long long *location = va_arg(ap, long long *);
-                            *location = outputBufferPosition;
-                        } else {
-                            int *location = va_arg(ap, int *);
-                            *location = (int)outputBufferPosition;
-                        }
-                        stage = AJRFormatStageAPriori;
-                        range.location++;
-                    }
-                        break;
-                    case '@':
-                        objectValue = va_arg(ap, id);
-                        if (!objectValue) {
-                            objectValue = @"(null)";
-                        }
-                        break;
-                        /* These are special, extended formats not normally supported by printf */
-                    case 'S':
-                        objectValue = NSStringFromSelector(va_arg(ap, SEL));
-                        break;
-                    case 'C': {
-                        id object = va_arg(ap, id);
-                        objectValue = object ? NSStringFromClass([object class]) : @"(Nil)";
-                        break;
+            } else if (character == 'L') {
+                spec.flags &= ~AJRLongType;
+                spec.flags |= AJRLongLongType;
+            } else if (character == 'q') {
+                spec.flags |= AJRLongLongType;
+            } else if (character == 'z') {
+                spec.flags |= AJRSizeTType;
+            } else {
+                spec.conversion = character;
+                if (CFStringIsSurrogateHighCharacter(character) && position < length) {
+                    unichar low = CFStringGetCharacterFromInlineBuffer(&buffer, position);
+                    if (CFStringIsSurrogateLowCharacter(low)) {
+                        spec.conversion = (uint32_t)CFStringGetLongCharacterForSurrogatePair(character, low);
+                        position++;
                     }
-                    case 'R':
-                        objectValue = NSStringFromRect(va_arg(ap, CGRect));
-                        break;
-                    case 'r':
-                        objectValue = NSStringFromRange(va_arg(ap, NSRange));
-                        break;
-                    case 'Z':
-                        objectValue = NSStringFromSize(va_arg(ap, CGSize));
-                        break;
-                    case 'P':
-                        objectValue = NSStringFromPoint(va_arg(ap, CGPoint));
-                        break;
-                    case 'm':
-                        objectValue = [NSByteCountFormatter stringFromByteCount:va_arg(ap, NSUInteger) countStyle:NSByteCountFormatterCountStyleMemory];
-                        break;
-                    case 'T':
-                        doingTimeInterval = YES;
-                        timeIntervalValue = va_arg(ap, NSTimeInterval);
-                        break;
-                    case 'O':
-                        doingOSType = YES;
-                        osType = va_arg(ap, OSType);
-                        break;
-                    case 'B':
-                        doingBooleanType = YES;
-                        booleanValue = va_arg(ap, int);
-                        break;
-                    case 'D':
-                        dateValue = va_arg(ap, NSDate *);
-                        if (![dateValue isKindOfClass:[NSDate class]]) {
-                            AJRLog(nil, AJRLogLevelWarning, @"Parameter to %s wasn't an NSDate object.", __FUNCTION__);
-                        }
-                        break;
-                    default:
-                        _AJRExpandBufferIfNeeded(1);
-                        outputBuffer[outputBufferPosition++] = character;
-                        stage = AJRFormatStageAPriori;
-                        range.location++;
-                        break;
                 }
-                if (stringValue) {
-                    NSInteger length = strlen(stringValue);
-                    NSInteger vPos;
-                    
-                    if ((precision != NSNotFound) && (length > precision)) {
-                        length = precision;
-                    }
-                    if (!(flags & AJRLeftJustified) && (width != NSNotFound) && (length < width)) {
-                        _AJRExpandBufferIfNeeded(width - length);
-                        _AJRPad(width - length);
-                    }
-                    for (vPos = 0; vPos < length; vPos++) {
-                        _AJRExpandBufferIfNeeded(1);
-                        outputBuffer[outputBufferPosition] = *(stringValue + vPos);
-                        outputBufferPosition++;
-                    }
-                    if ((flags & AJRLeftJustified) && (width != NSNotFound) && (length < width)) {
-                        _AJRExpandBufferIfNeeded(width - length);
-                        _AJRPad(width - length);
-                    }
-                    stage = AJRFormatStageAPriori;
-                    range.location++;
-                    
-                    stringValue = NULL;
-                } else if (unicharStringValue) {
-                    NSInteger length = ustrlen(unicharStringValue);
-                    NSInteger vPos;
-                    BOOL isLittleEndian = NO;
-                    
-                    if (length >= 1) {
-                        if ((((unsigned char *)unicharStringValue)[0] == 0xFE) && (((unsigned char *)unicharStringValue)[1] == 0xFF)) {
-                            isLittleEndian = YES;
-                            length--;
-                            unicharStringValue++;
-                        } else if ((((unsigned char *)unicharStringValue)[0] == 0xFF) && (((unsigned char *)unicharStringValue)[1] == 0xFE)) {
-                            isLittleEndian = NO;
-                            length--;
-                            unicharStringValue++;
-                        }
-                    }
-                    
-                    if ((precision != NSNotFound) && (length > precision)) {
-                        length = precision;
-                    }
-                    if (!(flags & AJRLeftJustified) && (width != NSNotFound) && (length < width)) {
-                        _AJRExpandBufferIfNeeded(width - length);
-                        _AJRPad(width - length);
-                    }
-                    for (vPos = 0; vPos < length; vPos += 1) {
-                        _AJRExpandBufferIfNeeded(1);
-                        if (isLittleEndian) {
-                            outputBuffer[outputBufferPosition] = NSSwapBigShortToHost(*(unicharStringValue + vPos));
-                            outputBufferPosition++;
-                        } else {
-                            outputBuffer[outputBufferPosition] = NSSwapLittleShortToHost(*(unicharStringValue + vPos));
-                            outputBufferPosition++;
-                        }
-                    }
-                    if ((flags & AJRLeftJustified) && (width != NSNotFound) && (length < width)) {
-                        _AJRExpandBufferIfNeeded(width - length);
-                        _AJRPad(width - length);
-                    }
-                    stage = AJRFormatStageAPriori;
-                    range.location++;
-                    
-                    unicharStringValue = NULL;
-                } else if (objectValue || dateValue) {
-                    NSString *value = nil;
-                    
-                    if (dateValue) {
-                        NSString *formatString = @"yyyy/MM/dd HH:mm";
-                        if (parameterRange.length > 2) {
-                            parameterRange.location += 1;
-                            parameterRange.length -= 2;
-                            formatString = [format substringWithRange:parameterRange];
-                        }
-                        NSDateFormatter *formatter = [[NSDateFormatter alloc] init];
-                        [formatter setDateFormat:formatString];
-                        if (timeZoneForFormat != nil) {
-                            [formatter setTimeZone:timeZoneForFormat];
-                        }
-                        value = [formatter stringFromDate:dateValue];
-                    } else {
-                        value = [objectValue description];
-                    }
-                    // This may seem a little cumbersome, but if you ask for a string's length, and that string contains Unicode values greater than 0xFFFF, NSString will return 2 for each character. So, if instead, we ask for the length in bytes for our encoding, and divide by 4 (since we're looking at 32 bit values), then we'll get the actual length we want.
-                    NSInteger length = [value lengthOfBytesUsingEncoding:NSUTF32LittleEndianStringEncoding] / sizeof(wchar_t);
+                complete = YES;
+                break;
+            }
+        }
 
-                    if ((precision != NSNotFound) && (length > precision)) {
-                        length = precision;
-                    }
-                    if (!(flags & AJRLeftJustified) && (width != NSNotFound) && (length < width)) {
-                        _AJRExpandBufferIfNeeded(width - length);
-                        _AJRPad(width - length);
-                    }
-                    _AJRExpandBufferIfNeeded(length);
-                    [value getBytes:outputBuffer + outputBufferPosition maxLength:outputBufferMaxLength * sizeof(wchar_t) usedLength:NULL encoding:NSUTF32LittleEndianStringEncoding options:0 range:(NSRange){0, value.length} remainingRange:NULL];
-                    outputBufferPosition += length;
-                    if ((flags & AJRLeftJustified) && (width != NSNotFound) && (length < width)) {
-                        _AJRExpandBufferIfNeeded(width - length);
-                        _AJRPad(width - length);
-                    }
-                    stage = AJRFormatStageAPriori;
-                    range.location++;
-                    
-                    objectValue = nil;
-                } else if (numericBase) {
-                    unichar signChar = 0;
-                    long long tValue;
-                    unsigned long long    value;
-                    NSInteger length, trueLength;
-                    
-                    if (flags & AJRShortType) {
-                        if (isSigned) {
-                            tValue = va_arg(ap, int /* short */);
-                            if (tValue < 0) signChar = '-';
-                            value = llabs(tValue);
-                        } else {
-                            value = va_arg(ap, unsigned int /*unsigned short*/);
-                        }
-                    } else if (flags & AJRLongType) {
-                        if (isSigned) {
-                            tValue = va_arg(ap, long);
-                            if (tValue < 0) signChar = '-';
-                            value = llabs(tValue);
-                        } else {
-                            value = va_arg(ap, unsigned long);
-                        }
-                    } else if (flags & AJRLongLongType) {
-                        if (isSigned) {
-                            tValue = va_arg(ap, long long);
-                            if (tValue < 0) signChar = '-';
-                            value = llabs(tValue);
-                        } else {
-                            value = va_arg(ap, unsigned long long);
-                        }
-                    } else {
-                        if (isSigned) {
-                            tValue = va_arg(ap, int);
-                            if (tValue < 0) signChar = '-';
-                            value = llabs(tValue);
-                        } else {
-                            value = va_arg(ap, unsigned int);
-                        }
-                    }
-                    
-                    if (signChar == 0) {
-                        if (flags & AJRSpaceForPlus) {
-                            signChar = ' ';
-                        } else if (flags & AJRShowPlus) {
-                            signChar = '+';
-                        }
-                    }
-                    
-                    stringValue = _ajrIntegerToString(value, numericBase, displayDigits, integerBuffer);
-                    length = trueLength = strlen(stringValue);
-                    if (signChar != 0) length++;
-                    if (prefix) length += strlen(prefix);
-                    
-                    if (precision != NSNotFound) {
-                        width = precision;
-                        flags |= AJRZeroPadding;
-                    }
-                    
-                    if ((width != NSNotFound) && (length < width) && (!(flags & AJRLeftJustified) || (flags & AJRZeroPadding))) {
-                        if (flags & AJRZeroPadding) {
-                            if (signChar != 0) {
-                                _AJRExpandBufferIfNeeded(1);
-                                outputBuffer[outputBufferPosition++] = signChar;
-                            }
-                            if (prefix) {
-                                for (x = 0; prefix[x]; x++) {
-                                    _AJRExpandBufferIfNeeded(1);
-                                    outputBuffer[outputBufferPosition++] = prefix[x];
-                                }
-                            }
-                            for (x = 0; x < width - length; x++) {
-                                _AJRExpandBufferIfNeeded(1);
-                                outputBuffer[outputBufferPosition++] = '0';
-                            }
-                        } else {
-                            for (x = 0; x < width - length; x++) {
-                                _AJRExpandBufferIfNeeded(1);
-                                outputBuffer[outputBufferPosition++] = ' ';
-                            }
-                            if (signChar != 0) {
-                                _AJRExpandBufferIfNeeded(1);
-                                outputBuffer[outputBufferPosition++] = signChar;
-                            }
-                            if (prefix) {
-                                for (x = 0; prefix[x]; x++) {
-                                    _AJRExpandBufferIfNeeded(1);
-                                    outputBuffer[outputBufferPosition++] = prefix[x];
-                                }
-                            }
-                        }
-                    } else if (signChar != 0) {
-                        _AJRExpandBufferIfNeeded(1);
-                        outputBuffer[outputBufferPosition++] = signChar;
-                        if (prefix) {
-                            for (x = 0; prefix[x]; x++) {
-                                _AJRExpandBufferIfNeeded(1);
-                                outputBuffer[outputBufferPosition++] = prefix[x];
-                            }
-                        }
-                    } else if (prefix) {
-                        if (prefix) {
-                            for (x = 0; prefix[x]; x++) {
-                                _AJRExpandBufferIfNeeded(1);
-                                outputBuffer[outputBufferPosition++] = prefix[x];
-                            }
-                        }
-                    }
-                    
-                    for (x = 0; x < trueLength; x++) {
-                        _AJRExpandBufferIfNeeded(1);
-                        outputBuffer[outputBufferPosition++] = stringValue[x];
-                    }
-                    
-                    if ((width != NSNotFound) && (length < width) && (flags & AJRLeftJustified) && !(flags & AJRZeroPadding)) {
-                        for (x = 0; x < width - length; x++) {
-                            _AJRExpandBufferIfNeeded(1);
-                            outputBuffer[outputBufferPosition++] = ' ';
-                        }
-                    }
-                    
-                    stage = AJRFormatStageAPriori;
-                    range.location++;
-                    
-                    stringValue = NULL;
-                    numericBase = 0;
-                } else if (doingFloat) {
-                    char cFormat[20];
-                    char cType[3] = { character, '\0', '\0' };
-                    char tempBuffer[80];
-                    
-                    if ((flags & AJRLongType) || (flags & AJRLongLongType)) {
-                        cType[1] = cType[0];
-                        cType[0] = 'L';
-                    }
-                    
-                    strcpy(cFormat, "%");
-                    if (flags & AJRAlternateForm) strcat(cFormat, "#");
-                    if (flags & AJRZeroPadding) strcat(cFormat, "0");
-                    if (flags & AJRLeftJustified) strcat(cFormat, "-");
-                    if (flags & AJRSpaceForPlus) strcat(cFormat, " ");
-                    if (flags & AJRShowPlus) strcat(cFormat, "+");
-                    //                    if (flags & AJRGroupThousands) strcat(cFormat, ",");
-                    if ((width == NSNotFound) && (precision == NSNotFound)) {
-                        strcat(cFormat, cType);
-                        if ((flags & AJRLongType) || (flags & AJRLongLongType)) {
-                            snprintf(tempBuffer, 80, cFormat, longDoubleValue);
-                        } else {
-                            snprintf(tempBuffer, 80, cFormat, floatValue);
-                        }
-                    } else if ((width != NSNotFound) && (precision == NSNotFound)) {
-                        strcat(cFormat, "*");
-                        strcat(cFormat, cType);
-                        if ((flags & AJRLongType) || (flags & AJRLongLongType)) {
-                            snprintf(tempBuffer, 80, cFormat, width, longDoubleValue);
-                        } else {
-                            snprintf(tempBuffer, 80, cFormat, width, floatValue);
-                        }
-                    } else if ((width == NSNotFound) && (precision != NSNotFound)) {
-                        strcat(cFormat, ".*");
-                        strcat(cFormat, cType);
-                        if ((flags & AJRLongType) || (flags & AJRLongLongType)) {
-                            snprintf(tempBuffer, 80, cFormat, precision, longDoubleValue);
-                        } else {
-                            snprintf(tempBuffer, 80, cFormat, precision, floatValue);
-                        }
-                    } else if ((width != NSNotFound) && (precision != NSNotFound)) {
-                        strcat(cFormat, "*.*");
-                        strcat(cFormat, cType);
-                        if ((flags & AJRLongType) || (flags & AJRLongLongType)) {
-                            snprintf(tempBuffer, 80, cFormat, width, precision, longDoubleValue);
-                        } else {
-                            snprintf(tempBuffer, 80, cFormat, width, precision, floatValue);
-                        }
-                    }
-                    
-                    _AJRExpandBufferIfNeeded(strlen(tempBuffer));
-                    for (x = 0; tempBuffer[x]; x++) {
-                        outputBuffer[outputBufferPosition++] = tempBuffer[x];
-                    }
-                    
-                    stage = AJRFormatStageAPriori;
-                    range.location++;
-                    
-                    floatValue = 0.0;
-                    doingFloat = NO;
-                } else if (doingTimeInterval) {
-                    NSInteger hours, minutes, seconds;
-                    NSInteger hourLength = 0;
-                    NSInteger fraction = 0;
-                    BOOL isNegative = timeIntervalValue < 0.0;
-                    char *number;
-                    NSInteger x;
-                    NSInteger neededLength;
-                    
-                    timeIntervalValue = fabs(timeIntervalValue);
-                    
-                    hours = (int)floor(timeIntervalValue / (60.0 * 60.0));
-                    minutes = ((int)floor(timeIntervalValue) / 60) % 60;
-                    seconds = (int)floor(timeIntervalValue) % 60;
-                    if (precision != NSNotFound) {
-                        fraction = (int)rint((timeIntervalValue - floor(timeIntervalValue)) * pow(10.0, precision));
-                    }
-                    hourLength = hours == 0 ? 1 : ceil(log10(hours + 1));
-                    
-                    neededLength = hourLength < 2 ? 2 : hourLength;
-                    neededLength += 6;
-                    if (isNegative) neededLength++;
-                    if (precision != NSNotFound) neededLength += precision + 1;
-                    _AJRExpandBufferIfNeeded(neededLength);
-                    //fprintf(stderr, "%d\n", neededLength);
-                    
-                    if (isNegative) {
-                        outputBuffer[outputBufferPosition++] = '-';
-                    }
-                    number = _ajrIntegerToString(hours, 10, _ajrDecimalDigits, integerBuffer);
-                    if (hourLength < 2) {
-                        outputBuffer[outputBufferPosition++] = '0';
-                    }
-                    for (x = 0; x < strlen(number); x++) {
-                        outputBuffer[outputBufferPosition++] = number[x];
-                    }
-                    outputBuffer[outputBufferPosition++] = ':';
-                    if (minutes < 10) {
-                        outputBuffer[outputBufferPosition++] = '0';
-                    } else {
-                        outputBuffer[outputBufferPosition++] = (wchar_t)('0' + (minutes / 10));
-                    }
-                    outputBuffer[outputBufferPosition++] = '0' + (minutes % 10);
-                    outputBuffer[outputBufferPosition++] = ':';
-                    if (seconds < 10) {
-                        outputBuffer[outputBufferPosition++] = '0';
-                    } else {
-                        outputBuffer[outputBufferPosition++] = (wchar_t)('0' + (seconds / 10));
-                    }
-                    outputBuffer[outputBufferPosition++] = '0' + (seconds % 10);
-                    if (precision != NSNotFound) {
-                        NSInteger length;
-                        
-                        number = _ajrIntegerToString(fraction, 10, _ajrDecimalDigits, integerBuffer);
-                        length = strlen(number);
-                        //fprintf(stderr, "%d, %d, %s\n", precision, length, number);
-                        outputBuffer[outputBufferPosition++] = '.';
-                        if (length <= precision) {
-                            for (x = 0; x < precision - length; x++) {
-                                outputBuffer[outputBufferPosition++] = _ajrDecimalDigits[0];
-                            }
-                        }
-                        for (x = length > precision ? 1 : 0; x < length; x++) {
-                            outputBuffer[outputBufferPosition++] = number[x];
-                        }
-                    }
-                    
-                    stage = AJRFormatStageAPriori;
-                    range.location++;
-                    
-                    timeIntervalValue = 0.0;
-                    doingTimeInterval = NO;
-                } else if (doingOSType) {
-                    stage = AJRFormatStageAPriori;
-                    range.location++;
-                    
-                    _AJRExpandBufferIfNeeded(4);
-                    outputBuffer[outputBufferPosition++] = (osType >> 24) & 0x000000FF;
-                    outputBuffer[outputBufferPosition++] = (osType >> 16) & 0x000000FF;
-                    outputBuffer[outputBufferPosition++] = (osType >>  8) & 0x000000FF;
-                    outputBuffer[outputBufferPosition++] = (osType >>  0) & 0x000000FF;
-                    
-                    osType = 0;
-                    doingOSType = NO;
-                } else if (doingBooleanType) {
-                    stage = AJRFormatStageAPriori;
-                    range.location++;
-                    
-                    if (booleanValue) {
-                        _AJRExpandBufferIfNeeded(3);
-                        outputBuffer[outputBufferPosition++] = 'Y';
-                        outputBuffer[outputBufferPosition++] = 'E';
-                        outputBuffer[outputBufferPosition++] = 'S';
-                    } else {
-                        _AJRExpandBufferIfNeeded(2);
-                        outputBuffer[outputBufferPosition++] = 'N';
-                        outputBuffer[outputBufferPosition++] = 'O';
-                    }
-                    
-                    booleanValue = NO;
-                    doingBooleanType = NO;
+        // A conversion cut off by the end of the format produces nothing.
+        if (!complete) {
+            break;
+        }
+
+        if (parameterStart != NSNotFound && parameterLength > 2) {
+            spec.parameter = CFStringCreateWithSubstring(NULL, format, CFRangeMake(parameterStart + 1, parameterLength - 2));
+        }
+        if (strchr("aefgAEFG", (int)(spec.conversion < 0x80 ? spec.conversion : 0)) && spec.conversion != 0) {
+            char *floatFormat = spec.floatFormat;
+            *floatFormat++ = '%';
+            if (spec.flags & AJRAlternateForm) *floatFormat++ = '#';
+            if (spec.flags & AJRZeroPadding) *floatFormat++ = '0';
+            if (spec.flags & AJRLeftJustified) *floatFormat++ = '-';
+            if (spec.flags & AJRSpaceForPlus) *floatFormat++ = ' ';
+            if (spec.flags & AJRShowPlus) *floatFormat++ = '+';
+            if (spec.widthArguments || spec.width != NSNotFound) *floatFormat++ = '*';
+            if (spec.precisionArguments || spec.precision != NSNotFound) {
+                *floatFormat++ = '.';
+                *floatFormat++ = '*';
+            }
+            if (spec.flags & (AJRLongType | AJRLongLongType)) *floatFormat++ = 'L';
+            *floatFormat++ = (char)spec.conversion;
+            *floatFormat = '\0';
+        }
+        if (spec.conversion == 'n') {
+            _countsCharacters = YES;
+        }
+
+        finishLiteral();
+        *[self _addSegment:&capacity] = spec;
+    }
+    finishLiteral();
+
+    _utf16Literals = utf16Literals;
+    _utf8Literals = utf8Literals.bytes ? [NSData dataWithBytesNoCopy:utf8Literals.bytes length:utf8Literals.length freeWhenDone:YES] : [NSData data];
+}
+
+#pragma mark - Rendering
+
+static void AJRFormatRenderInteger(AJRFormatOutput *output, unsigned long long value, char signCharacter, NSInteger base, char *digits, const char *prefix, NSUInteger flags, NSUInteger width, NSUInteger precision) {
+    char integerBuffer[_integerBufferSize];
+    const char *number = _ajrIntegerToString(value, base, digits, integerBuffer);
+    size_t numberLength = strlen(number);
+    size_t prefixLength = prefix ? strlen(prefix) : 0;
+
+    if (signCharacter == 0) {
+        if (flags & AJRSpaceForPlus) {
+            signCharacter = ' ';
+        } else if (flags & AJRShowPlus) {
+            signCharacter = '+';
+        }
+    }
+
+    NSUInteger length = numberLength + prefixLength + (signCharacter ? 1 : 0);
+
+    // A precision on an integer is the minimum number of digits, which is just zero padding by another name.
+    if (precision != NSNotFound) {
+        width = precision;
+        flags |= AJRZeroPadding;
+    }
+
+    BOOL needsPadding = width != NSNotFound && length < width;
+    if (needsPadding && !(flags & AJRZeroPadding) && !(flags & AJRLeftJustified)) {
+        AJRFormatOutputAppendRepeated(output, ' ', width - length);
+    }
+    if (signCharacter) {
+        AJRFormatOutputAppendLatin1(output, &signCharacter, 1);
+    }
+    if (prefix) {
+        AJRFormatOutputAppendLatin1(output, prefix, prefixLength);
+    }
+    if (needsPadding && (flags & AJRZeroPadding)) {
+        AJRFormatOutputAppendRepeated(output, '0', width - length);
+    }
+    AJRFormatOutputAppendLatin1(output, number, numberLength);
+    if (needsPadding && (flags & AJRLeftJustified) && !(flags & AJRZeroPadding)) {
+        AJRFormatOutputAppendRepeated(output, ' ', width - length);
+    }
+}
+
+static int AJRFormatFloat(char *buffer, size_t size, const AJRFormatSegment *segment, NSUInteger flags, NSUInteger width, NSUInteger precision, BOOL isLong, double value, long double longValue) {
+    // A negative width argument asks for left justification, which the compiled format doesn't know about, so hand it back to snprintf as a negative width.
+    if ((flags & AJRLeftJustified) && !(segment->flags & AJRLeftJustified)) {
+        width = -width;
+    }
+
+    BOOL hasWidth = segment->widthArguments || segment->width != NSNotFound;
+    BOOL hasPrecision = segment->precisionArguments || segment->precision != NSNotFound;
+
+    if (hasWidth && hasPrecision) {
+        return isLong ? snprintf(buffer, size, segment->floatFormat, (int)width, (int)precision, longValue) : snprintf(buffer, size, segment->floatFormat, (int)width, (int)precision, value);
+    } else if (hasWidth) {
+        return isLong ? snprintf(buffer, size, segment->floatFormat, (int)width, longValue) : snprintf(buffer, size, segment->floatFormat, (int)width, value);
+    } else if (hasPrecision) {
+        return isLong ? snprintf(buffer, size, segment->floatFormat, (int)precision, longValue) : snprintf(buffer, size, segment->floatFormat, (int)precision, value);
+    }
+    return isLong ? snprintf(buffer, size, segment->floatFormat, longValue) : snprintf(buffer, size, segment->floatFormat, value);
+}
+
+static void AJRFormatRenderTimeInterval(AJRFormatOutput *output, NSTimeInterval value, NSUInteger precision) {
+    char integerBuffer[_integerBufferSize];
+    char buffer[_integerBufferSize + 16];
+    size_t length = 0;
+    BOOL isNegative = value < 0.0;
+
+    value = fabs(value);
+
+    NSInteger hours = (int)floor(value / (60.0 * 60.0));
+    NSInteger minutes = ((int)floor(value) / 60) % 60;
+    NSInteger seconds = (int)floor(value) % 60;
+    NSInteger hourLength = hours == 0 ? 1 : ceil(log10(hours + 1));
+
+    if (isNegative) {
+        buffer[length++] = '-';
+    }
+    if (hourLength < 2) {
+        buffer[length++] = '0';
+    }
+    const char *number = _ajrIntegerToString(hours, 10, _ajrDecimalDigits, integerBuffer);
+    size_t numberLength = strlen(number);
+    memcpy(buffer + length, number, numberLength);
+    length += numberLength;
+    buffer[length++] = ':';
+    buffer[length++] = '0' + (minutes / 10);
+    buffer[length++] = '0' + (minutes % 10);
+    buffer[length++] = ':';
+    buffer[length++] = '0' + (seconds / 10);
+    buffer[length++] = '0' + (seconds % 10);
+
+    if (precision != NSNotFound) {
+        NSInteger fraction = (int)rint((value - floor(value)) * pow(10.0, precision));
+        buffer[length++] = '.';
+        AJRFormatOutputAppendLatin1(output, buffer, length);
+
+        number = _ajrIntegerToString(fraction, 10, _ajrDecimalDigits, integerBuffer);
+        numberLength = strlen(number);
+        if (numberLength <= precision) {
+            AJRFormatOutputAppendRepeated(output, '0', precision - numberLength);
+            AJRFormatOutputAppendLatin1(output, number, numberLength);
+        } else {
+            // Rounding carried into the seconds, which we've already written, so drop the carry.
+            AJRFormatOutputAppendLatin1(output, number + 1, numberLength - 1);
+        }
+    } else {
+        AJRFormatOutputAppendLatin1(output, buffer, length);
+    }
+}
+
+// Appends value, padded to width and truncated to precision, both of which count characters, not UTF-16 units.
+static void AJRFormatRenderString(AJRFormatOutput *output, NSString *value, NSUInteger flags, NSUInteger width, NSUInteger precision) {
+    CFStringRef string = (__bridge CFStringRef)value;
+    CFIndex length = string ? CFStringGetLength(string) : 0;
+    CFRange range = CFRangeMake(0, length);
+    NSUInteger characterCount = 0;
+
+    if (width != NSNotFound || precision != NSNotFound) {
+        CFStringInlineBuffer buffer;
+        CFIndex position = 0;
+
+        CFStringInitInlineBuffer(string, &buffer, range);
+        while (position < length && characterCount < precision) {
+            unichar character = CFStringGetCharacterFromInlineBuffer(&buffer, position++);
+            if (CFStringIsSurrogateHighCharacter(character) && position < length && CFStringIsSurrogateLowCharacter(CFStringGetCharacterFromInlineBuffer(&buffer, position))) {
+                position++;
+            }
+            characterCount++;
+        }
+        range.length = position;
+    }
+
+    BOOL needsPadding = width != NSNotFound && characterCount < width;
+    char pad = (flags & AJRZeroPadding) ? '0' : ' ';
+
+    if (needsPadding && !(flags & AJRLeftJustified)) {
+        AJRFormatOutputAppendRepeated(output, pad, width - characterCount);
+    }
+    if (range.length > 0) {
+        AJRFormatOutputAppendString(output, string, range);
+    }
+    if (needsPadding && (flags & AJRLeftJustified)) {
+        AJRFormatOutputAppendRepeated(output, pad, width - characterCount);
+    }
+}
+
+static void AJRFormatRenderBytes(AJRFormatOutput *output, const char *value, NSUInteger flags, NSUInteger width, NSUInteger precision) {
+    size_t length = precision == NSNotFound ? strlen(value) : strnlen(value, precision);
+    BOOL needsPadding = width != NSNotFound && length < width;
+    char pad = (flags & AJRZeroPadding) ? '0' : ' ';
+
+    if (needsPadding && !(flags & AJRLeftJustified)) {
+        AJRFormatOutputAppendRepeated(output, pad, width - length);
+    }
+    AJRFormatOutputAppendLatin1(output, value, length);
+    if (needsPadding && (flags & AJRLeftJustified)) {
+        AJRFormatOutputAppendRepeated(output, pad, width - length);
+    }
+}
+
+static void AJRFormatRenderUnichars(AJRFormatOutput *output, const unichar *value, NSUInteger flags, NSUInteger width, NSUInteger precision) {
+    size_t length = ustrlen(value);
+    BOOL isBigEndian = NO;
+
+    // Skip a byte order mark, if there is one.
+    if (length >= 1) {
+        if ((((unsigned char *)value)[0] == 0xFE) && (((unsigned char *)value)[1] == 0xFF)) {
+            isBigEndian = YES;
+            length--;
+            value++;
+        } else if ((((unsigned char *)value)[0] == 0xFF) && (((unsigned char *)value)[1] == 0xFE)) {
+            length--;
+            value++;
+        }
+    }
+    if (precision != NSNotFound && length > precision) {
+        length = precision;
+    }
+
+    BOOL needsPadding = width != NSNotFound && length < width;
+    char pad = (flags & AJRZeroPadding) ? '0' : ' ';
+
+    if (needsPadding && !(flags & AJRLeftJustified)) {
+        AJRFormatOutputAppendRepeated(output, pad, width - length);
+    }
+    unichar buffer[128];
+    for (size_t x = 0; x < length; ) {
+        size_t count = MIN(length - x, 128);
+        for (size_t y = 0; y < count; y++) {
+            buffer[y] = isBigEndian ? NSSwapBigShortToHost(value[x + y]) : NSSwapLittleShortToHost(value[x + y]);
+        }
+        AJRFormatOutputAppendCharacters(output, buffer, count);
+        x += count;
+    }
+    if (needsPadding && (flags & AJRLeftJustified)) {
+        AJRFormatOutputAppendRepeated(output, pad, width - length);
+    }
+}
+
+// Reads the arguments for a '*' width or precision. A negative width means left justified, and a negative precision means no precision at all, as with printf.
+static inline NSUInteger AJRFormatResolveLength(NSUInteger digits, NSUInteger scale, NSInteger argument, BOOL isWidth, NSUInteger *flags) {
+    if (argument < 0) {
+        if (!isWidth) {
+            return NSNotFound;
+        }
+        *flags |= AJRLeftJustified;
+        argument = -argument;
+    }
+    return digits == NSNotFound ? (NSUInteger)argument : (NSUInteger)argument * scale + digits;
+}
+
+static void AJRFormatRenderSegment(const AJRFormatSegment *segment, AJRFormatOutput *output, AJRFormatRenderState *state, va_list *ap) {
+    NSUInteger flags = segment->flags;
+    NSUInteger width = segment->width;
+    NSUInteger precision = segment->precision;
+    __unsafe_unretained id objectValue = nil;
+    NSString *stringValue = nil;
+
+    for (NSUInteger x = 0; x < segment->timeZoneArguments; x++) {
+        state->timeZone = va_arg(*ap, NSTimeZone *);
+        if (![state->timeZone isKindOfClass:[NSTimeZone class]]) {
+            AJRLog(nil, AJRLogLevelWarning, @"Flag parameter to %s wasn't an NSTimeZone object.", "AJRFormatv");
+            state->timeZone = nil;
+        }
+    }
+    if (segment->widthArguments) {
+        NSInteger argument = 0;
+        for (NSUInteger x = 0; x < segment->widthArguments; x++) {
+            argument = va_arg(*ap, int);
+        }
+        width = AJRFormatResolveLength(segment->width, segment->widthScale, argument, YES, &flags);
+    }
+    if (segment->precisionArguments) {
+        NSInteger argument = 0;
+        for (NSUInteger x = 0; x < segment->precisionArguments; x++) {
+            argument = va_arg(*ap, int);
+        }
+        precision = AJRFormatResolveLength(segment->precision, segment->precisionScale, argument, NO, &flags);
+    }
+
+    switch (segment->conversion) {
+        case 'd':
+        case 'i':
+        case 'o': {
+            long long value;
+            if (flags & AJRShortType) {
+                value = va_arg(*ap, int /* short */);
+            } else if (flags & AJRLongType) {
+                value = va_arg(*ap, long);
+            } else if (flags & AJRLongLongType) {
+                value = va_arg(*ap, long long);
+            } else {
+                value = va_arg(*ap, int);
+            }
+            if (segment->conversion == 'o') {
+                AJRFormatRenderInteger(output, llabs(value), value < 0 ? '-' : 0, 8, _ajrOctalDigits, flags & AJRAlternateForm ? "0" : NULL, flags, width, precision);
+            } else {
+                AJRFormatRenderInteger(output, llabs(value), value < 0 ? '-' : 0, 10, _ajrDecimalDigits, NULL, flags, width, precision);
+            }
+            break;
+        }
+        case 'p':
+            if (sizeof(void *) == 8) {
+                flags |= AJRLongLongType;
+            }
+            // Fall through
+        case 'b':
+        case 'u':
+        case 'x':
+        case 'X': {
+            unsigned long long value;
+            if (flags & AJRShortType) {
+                value = va_arg(*ap, unsigned int /* unsigned short */);
+            } else if (flags & AJRLongType) {
+                value = va_arg(*ap, unsigned long);
+            } else if (flags & AJRLongLongType) {
+                value = va_arg(*ap, unsigned long long);
+            } else {
+                value = va_arg(*ap, unsigned int);
+            }
+            switch (segment->conversion) {
+                case 'b':
+                    AJRFormatRenderInteger(output, value, 0, 2, _ajrDecimalDigits, NULL, flags, width, precision);
+                    break;
+                case 'u':
+                    AJRFormatRenderInteger(output, value, 0, 10, _ajrDecimalDigits, NULL, flags, width, precision);
+                    break;
+                case 'x':
+                    AJRFormatRenderInteger(output, value, 0, 16, state->useCapitals ? _ajrHEXIDECIMALDigits : _ajrHexidecimalDigits, flags & AJRAlternateForm ? "0x" : NULL, flags, width, precision);
+                    break;
+                case 'X':
+                    AJRFormatRenderInteger(output, value, 0, 16, _ajrHEXIDECIMALDigits, flags & AJRAlternateForm ? "0X" : NULL, flags, width, precision);
+                    break;
+                case 'p':
+                    AJRFormatRenderInteger(output, value, 0, 16, _ajrHexidecimalDigits, "0x", flags, width, precision);
+                    break;
+            }
+            break;
+        }
+        case 'A':
+        case 'E':
+        case 'F':
+        case 'G':
+            state->useCapitals = YES;
+            // Fall through
+        case 'a':
+        case 'e':
+        case 'f':
+        case 'g': {
+            BOOL isLong = (flags & AJRLongType) || (flags & AJRLongLongType);
+            double value = 0.0;
+            long double longValue = 0.0;
+            char buffer[80];
+
+            if (isLong) {
+                longValue = va_arg(*ap, long double);
+            } else {
+                value = va_arg(*ap, double);
+            }
+            int length = AJRFormatFloat(buffer, sizeof(buffer), segment, flags, width, precision, isLong, value, longValue);
+            if (length >= (int)sizeof(buffer)) {
+                char *large = malloc(length + 1);
+                AJRFormatFloat(large, length + 1, segment, flags, width, precision, isLong, value, longValue);
+                AJRFormatOutputAppendLatin1(output, large, length);
+                free(large);
+            } else if (length > 0) {
+                AJRFormatOutputAppendLatin1(output, buffer, length);
+            }
+            break;
+        }
+        case 'c':
+            if (flags & AJRLongType) {
+                AJRFormatOutputAppendCodePoint(output, va_arg(*ap, unsigned int));
+            } else {
+                AJRFormatOutputAppendCodePoint(output, va_arg(*ap, unsigned int) & 0xFF);
+            }
+            break;
+        case 's':
+            if (flags & AJRLongType) {
+                const unichar *value = va_arg(*ap, unichar *);
+                if (value) {
+                    AJRFormatRenderUnichars(output, value, flags, width, precision);
+                } else {
+                    AJRFormatRenderString(output, @"(null)", flags, width, precision);
+                }
+            } else {
+                const char *value = va_arg(*ap, char *);
+                if (value) {
+                    AJRFormatRenderBytes(output, value, flags, width, precision);
+                } else {
+                    AJRFormatRenderString(output, @"(null)", flags, width, precision);
+                }
+            }
+            break;
+        case 'n':
+            if (flags & AJRLongType) {
+                *va_arg(*ap, NSInteger *) = output->characters;
+            } else if (flags & AJRLongLongType) {
+                *va_arg(*ap, long long *) = output->characters;
+            } else {
+                *va_arg(*ap, int *) = (int)output->characters;
+            }
+            break;
+        case '@':
+            objectValue = va_arg(*ap, id);
+            stringValue = objectValue ? [objectValue description] : @"(null)";
+            break;
+        // These are special, extended formats not normally supported by printf
+        case 'S':
+            stringValue = NSStringFromSelector(va_arg(*ap, SEL));
+            break;
+        case 'C':
+            objectValue = va_arg(*ap, id);
+            stringValue = objectValue ? NSStringFromClass([objectValue class]) : @"(Nil)";
+            break;
+        case 'R':
+            stringValue = NSStringFromRect(va_arg(*ap, CGRect));
+            break;
+        case 'r':
+            stringValue = NSStringFromRange(va_arg(*ap, NSRange));
+            break;
+        case 'Z':
+            stringValue = NSStringFromSize(va_arg(*ap, CGSize));
+            break;
+        case 'P':
+            stringValue = NSStringFromPoint(va_arg(*ap, CGPoint));
+            break;
+        case 'm':
+            stringValue = [NSByteCountFormatter stringFromByteCount:va_arg(*ap, NSUInteger) countStyle:NSByteCountFormatterCountStyleMemory];
+            break;
+        case 'T':
+            AJRFormatRenderTimeInterval(output, va_arg(*ap, NSTimeInterval), precision);
+            break;
+        case 'O': {
+            OSType value = va_arg(*ap, OSType);
+            char characters[4] = { (value >> 24) & 0xFF, (value >> 16) & 0xFF, (value >> 8) & 0xFF, value & 0xFF };
+            AJRFormatOutputAppendLatin1(output, characters, 4);
+            break;
+        }
+        case 'B':
+            if (va_arg(*ap, int)) {
+                AJRFormatOutputAppendLatin1(output, "YES", 3);
+            } else {
+                AJRFormatOutputAppendLatin1(output, "NO", 2);
+            }
+            break;
+        case 'D': {
+            NSDate *date = va_arg(*ap, NSDate *);
+            if (![date isKindOfClass:[NSDate class]]) {
+                AJRLog(nil, AJRLogLevelWarning, @"Parameter to %s wasn't an NSDate object.", "AJRFormatv");
+            } else {
+                NSDateFormatter *formatter = [[NSDateFormatter alloc] init];
+                [formatter setDateFormat:segment->parameter ? (__bridge NSString *)segment->parameter : @"yyyy/MM/dd HH:mm"];
+                if (state->timeZone != nil) {
+                    [formatter setTimeZone:state->timeZone];
                 }
+                stringValue = [formatter stringFromDate:date] ?: @"";
             }
+            break;
         }
+        default:
+            AJRFormatOutputAppendCodePoint(output, segment->conversion);
+            break;
     }
-    
-    if ((range.length = position - range.location) > 0) {
-        while (outputBufferPosition + range.length >= outputBufferMaxLength) {
-            outputBufferMaxLength += 1024;
-            outputBuffer = (wchar_t *)NSZoneRealloc(NULL, outputBuffer, sizeof(wchar_t) * outputBufferMaxLength);
+
+    if (stringValue) {
+        AJRFormatRenderString(output, stringValue, flags, width, precision);
+    }
+}
+
+- (void)_renderToOutput:(AJRFormatOutput *)output arguments:(va_list)ap {
+    AJRFormatRenderState state = { NO, nil };
+    const uint8_t *utf8Literals = _utf8Literals.bytes;
+    const unichar *utf16Literals = _utf16Literals.bytes;
+    va_list arguments;
+
+    output->countsCharacters = _countsCharacters;
+    va_copy(arguments, ap);
+    for (NSUInteger x = 0; x < _segmentCount; x++) {
+        const AJRFormatSegment *segment = _segments + x;
+        if (segment->conversion == 0) {
+            if (output->encoding == AJRFormatEncodingUTF8) {
+                AJRFormatOutputAppendBytes(output, utf8Literals + segment->utf8Offset, segment->utf8Length);
+            } else {
+                AJRFormatOutputAppendBytes(output, utf16Literals + segment->utf16Offset, segment->utf16Length * sizeof(unichar));
+            }
+            output->characters += segment->characterCount;
+        } else {
+            AJRFormatRenderSegment(segment, output, &state, &arguments);
         }
-        for (NSInteger x = 0; x < range.length; x++) {
-            outputBuffer[outputBufferPosition + x] = inputBuffer[range.location + x];
+    }
+    va_end(arguments);
+}
+
+- (NSString *)stringWithArguments:(va_list)ap {
+    unichar buffer[256];
+    AJRFormatOutput output = AJRFormatOutputMake(AJRFormatEncodingUTF16, buffer, sizeof(buffer), AJRFormatOutputGrow);
+
+    [self _renderToOutput:&output arguments:ap];
+
+    if (output.ownsBytes) {
+        return [[NSString alloc] initWithCharactersNoCopy:(unichar *)output.bytes length:output.length / sizeof(unichar) freeWhenDone:YES];
+    }
+    return [[NSString alloc] initWithCharacters:buffer length:output.length / sizeof(unichar)];
+}
+
+- (NSData *)_dataWithEncoding:(AJRFormatEncoding)encoding arguments:(va_list)ap {
+    uint8_t buffer[512];
+    AJRFormatOutput output = AJRFormatOutputMake(encoding, buffer, sizeof(buffer), AJRFormatOutputGrow);
+
+    [self _renderToOutput:&output arguments:ap];
+
+    if (output.ownsBytes) {
+        return [NSData dataWithBytesNoCopy:output.bytes length:output.length freeWhenDone:YES];
+    }
+    return [NSData dataWithBytes:buffer length:output.length];
+}
+
+- (NSData *)UTF8DataWithArguments:(va_list)ap {
+    return [self _dataWithEncoding:AJRFormatEncodingUTF8 arguments:ap];
+}
+
+- (NSData *)UTF16DataWithArguments:(va_list)ap {
+    return [self _dataWithEncoding:AJRFormatEncodingUTF16 arguments:ap];
+}
+
+- (NSString *)description {
+    return [NSString stringWithFormat:@"<%@: %p: \"%@\", %lu segments>", NSStringFromClass([self class]), self, _format, (unsigned long)_segmentCount];
+}
+
+@end
+
+#pragma mark - Sinks
+
+typedef struct _ajrFormatSink {
+    __unsafe_unretained id destination;
+    int fileDescriptor;
+    NSInteger written;
+    BOOL failed;
+} AJRFormatSink;
+
+// The size of the buffer we render into before handing the output to a string, stream, or file.
+#define AJRFormatSinkBufferSize 512
+
+static BOOL AJRFormatFlushToString(AJRFormatOutput *output, size_t needed) {
+    AJRFormatSink *sink = output->context;
+    CFStringAppendCharacters((__bridge CFMutableStringRef)sink->destination, (const unichar *)output->bytes, output->length / sizeof(unichar));
+    output->length = 0;
+    return YES;
+}
+
+static BOOL AJRFormatFlushToStream(AJRFormatOutput *output, size_t needed) {
+    AJRFormatSink *sink = output->context;
+    NSOutputStream *stream = sink->destination;
+    size_t offset = 0;
+
+    while (offset < output->length) {
+        NSInteger written = [stream write:output->bytes + offset maxLength:output->length - offset];
+        if (written <= 0) {
+            sink->failed = YES;
+            return NO;
         }
-        outputBufferPosition += range.length;
+        offset += written;
     }
-    
-    return [[NSString alloc] initWithBytesNoCopy:outputBuffer length:outputBufferPosition * sizeof(wchar_t) encoding:NSUTF32LittleEndianStringEncoding freeWhenDone:YES];
+    sink->written += offset;
+    output->length = 0;
+
+    return YES;
+}
+
+static BOOL AJRFormatFlushToFileDescriptor(AJRFormatOutput *output, size_t needed) {
+    AJRFormatSink *sink = output->context;
+    size_t offset = 0;
+
+    while (offset < output->length) {
+        ssize_t written = write(sink->fileDescriptor, output->bytes + offset, output->length - offset);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            sink->failed = YES;
+            return NO;
+        }
+        offset += written;
+    }
+    sink->written += offset;
+    output->length = 0;
+
+    return YES;
+}
+
+NSUInteger AJRFormatToBufferv(char *buffer, size_t size, NSString *format, va_list ap) {
+    char scratch[1];
+    // Leave room for the terminating NUL.
+    AJRFormatOutput output = AJRFormatOutputMake(AJRFormatEncodingUTF8, size > 0 ? buffer : scratch, size > 0 ? size - 1 : 0, NULL);
+
+    [[AJRFormatSpecification specificationWithFormat:format] _renderToOutput:&output arguments:ap];
+    if (size > 0) {
+        buffer[output.length] = '\0';
+    }
+
+    return output.length + output.truncatedLength;
+}
+
+NSUInteger AJRFormatToBuffer(char *buffer, size_t size, NSString *format, ...) {
+    va_list ap;
+    NSUInteger returnValue;
+
+    va_start(ap, format);
+    returnValue = AJRFormatToBufferv(buffer, size, format, ap);
+    va_end(ap);
+
+    return returnValue;
+}
+
+NSUInteger AJRFormatToGrowableBufferv(char *buffer, size_t size, char **result, NSString *format, va_list ap) {
+    // Leave room for the terminating NUL.
+    AJRFormatOutput output = AJRFormatOutputMake(AJRFormatEncodingUTF8, buffer, size > 0 ? size - 1 : 0, AJRFormatOutputGrow);
+
+    [[AJRFormatSpecification specificationWithFormat:format] _renderToOutput:&output arguments:ap];
+    if (output.ownsBytes && output.length == output.capacity) {
+        (void)AJRFormatOutputGrow(&output, 1);
+    }
+    if (output.bytes == NULL || (!output.ownsBytes && size == 0)) {
+        // We ran out of memory, or were given nowhere to put even the NUL.
+        *result = size > 0 ? buffer : NULL;
+        if (size > 0) {
+            buffer[0] = '\0';
+        }
+        return 0;
+    }
+    output.bytes[output.length] = '\0';
+    *result = (char *)output.bytes;
+
+    return output.length;
+}
+
+NSUInteger AJRFormatToGrowableBuffer(char *buffer, size_t size, char **result, NSString *format, ...) {
+    va_list ap;
+    NSUInteger returnValue;
+
+    va_start(ap, format);
+    returnValue = AJRFormatToGrowableBufferv(buffer, size, result, format, ap);
+    va_end(ap);
+
+    return returnValue;
+}
+
+void AJRFormatAppendv(NSMutableString *string, NSString *format, va_list ap) {
+    unichar buffer[AJRFormatSinkBufferSize / sizeof(unichar)];
+    AJRFormatSink sink = { string, -1, 0, NO };
+    AJRFormatOutput output = AJRFormatOutputMake(AJRFormatEncodingUTF16, buffer, sizeof(buffer), AJRFormatFlushToString);
+
+    output.context = &sink;
+    [[AJRFormatSpecification specificationWithFormat:format] _renderToOutput:&output arguments:ap];
+    AJRFormatFlushToString(&output, 0);
+}
+
+void AJRFormatAppend(NSMutableString *string, NSString *format, ...) {
+    va_list ap;
+
+    va_start(ap, format);
+    AJRFormatAppendv(string, format, ap);
+    va_end(ap);
+}
+
+NSInteger AJRFormatToOutputStreamv(NSOutputStream *stream, NSString *format, va_list ap) {
+    uint8_t buffer[AJRFormatSinkBufferSize];
+    AJRFormatSink sink = { stream, -1, 0, NO };
+    AJRFormatOutput output = AJRFormatOutputMake(AJRFormatEncodingUTF8, buffer, sizeof(buffer), AJRFormatFlushToStream);
+
+    output.context = &sink;
+    [[AJRFormatSpecification specificationWithFormat:format] _renderToOutput:&output arguments:ap];
+    if (!sink.failed) {
+        AJRFormatFlushToStream(&output, 0);
+    }
+
+    return sink.failed ? -1 : sink.written;
+}
+
+NSInteger AJRFormatToOutputStream(NSOutputStream *stream, NSString *format, ...) {
+    va_list ap;
+    NSInteger returnValue;
+
+    va_start(ap, format);
+    returnValue = AJRFormatToOutputStreamv(stream, format, ap);
+    va_end(ap);
+
+    return returnValue;
+}
+
+NSInteger AJRFormatToFileDescriptorv(int fileDescriptor, NSString *format, va_list ap) {
+    uint8_t buffer[AJRFormatSinkBufferSize];
+    AJRFormatSink sink = { nil, fileDescriptor, 0, NO };
+    AJRFormatOutput output = AJRFormatOutputMake(AJRFormatEncodingUTF8, buffer, sizeof(buffer), AJRFormatFlushToFileDescriptor);
+
+    output.context = &sink;
+    [[AJRFormatSpecification specificationWithFormat:format] _renderToOutput:&output arguments:ap];
+    if (!sink.failed) {
+        AJRFormatFlushToFileDescriptor(&output, 0);
+    }
+
+    return sink.failed ? -1 : sink.written;
+}
+
+NSInteger AJRFormatToFileDescriptor(int fileDescriptor, NSString *format, ...) {
+    va_list ap;
+    NSInteger returnValue;
+
+    va_start(ap, format);
+    returnValue = AJRFormatToFileDescriptorv(fileDescriptor, format, ap);
+    va_end(ap);
+
+    return returnValue;
+}
+
+#pragma mark - Strings
+
+NSString *AJRFormatv(NSString *format, va_list ap) {
+    return [[AJRFormatSpecification specificationWithFormat:format] stringWithArguments:ap];
 }
 
 NSString *AJRFormat(NSString *format, ...) {
     va_list ap;
     NSString *returnValue;
-    
+
     va_start(ap, format);
     returnValue = AJRFormatv(format, ap);
     va_end(ap);
-    
+
     return returnValue;
 }
@@ -229,6 +229,71 @@ extern uint32_t AJRHash32(uint32_t input);
  */
 extern uint64_t AJRHash64(uint64_t input);
 
+/*!
+ Returns a 64 bit hash of a run of bytes. This is wyhash, which is very fast, especially on short keys, and distributes well enough to build open addressing tables on, but it is not cryptographic. The hash is the same on every platform and in every process, so it may be stored, but if you're hashing input an attacker controls, use AJRHashBytesWithSeed() with a secret seed.
+
+ @param bytes The bytes to hash.
+ @param length The number of bytes.
+
+ @return The hash of bytes.
+ */
+extern uint64_t AJRHashBytes(const void *bytes, size_t length);
+
+/*!
+ Returns a 64 bit hash of a run of bytes. Different seeds give unrelated hashes of the same bytes.
+
+ @param bytes The bytes to hash.
+ @param length The number of bytes.
+ @param seed The seed. AJRHashBytes() uses 0.
+
+ @return The hash of bytes.
+ */
+extern uint64_t AJRHashBytesWithSeed(const void *bytes, size_t length, uint64_t seed);
+
+/*!
+ Returns the hash of bytes with A-Z folded to a-z, which is the same as the hash from AJRHashBytesWithSeed() of the lowercased bytes. All other bytes, including any that are part of a UTF-8 sequence, are hashed unchanged.
+ */
+extern uint64_t AJRHashBytesFoldingASCII(const void *bytes, size_t length, uint64_t seed);
+
+/*!
+ Returns the hash of UTF-8 text with case folded the way a case insensitive compare folds it, so any two strings that are equal ignoring case hash alike. ASCII text is hashed exactly as AJRHashBytesFoldingASCII() would hash it, and text that isn't valid UTF-8 has only its ASCII folded.
+ */
+extern uint64_t AJRHashUTF8FoldingCase(const void *bytes, size_t length, uint64_t seed);
+
+/*!
+ Returns the hash of the UTF-8 form of string, which is the same as AJRHashBytesWithSeed() of the string's UTF-8 bytes. This doesn't change between runs, unlike -[NSString hash], which also only looks at part of long strings.
+ */
+extern uint64_t AJRHashString(NSString *string, uint64_t seed);
+
+/*!
+ Returns the case folded hash of string, which is the same as AJRHashUTF8FoldingCase() of the string's UTF-8 bytes. Strings that compare equal with -caseInsensitiveCompare: hash alike.
+ */
+extern uint64_t AJRHashStringFoldingCase(NSString *string, uint64_t seed);
+
+/*!
+ Holds a hash in progress, so that input can be hashed as it arrives. Hashing input in pieces gives the same hash as hashing all of it at once with AJRHashBytesWithSeed(), however the input is split. The state is a plain struct, so it can live on the stack, and it's safe to copy.
+ */
+typedef struct _ajrHashState {
+    uint64_t seed;
+    uint64_t see1;
+    uint64_t see2;
+    uint64_t length;
+    size_t pending;
+    BOOL striped;
+    uint8_t buffer[64];
+} AJRHashState;
+
+/*! Starts a new hash with seed. */
+extern void AJRHashStateInitialize(AJRHashState *state, uint64_t seed);
+/*! Adds length bytes to the hash. */
+extern void AJRHashStateUpdate(AJRHashState *state, const void *bytes, size_t length);
+/*! Adds length bytes to the hash, with A-Z folded to a-z. */
+extern void AJRHashStateUpdateFoldingASCII(AJRHashState *state, const void *bytes, size_t length);
+/*! Adds the UTF-8 form of string to the hash. */
+extern void AJRHashStateUpdateWithString(AJRHashState *state, NSString *string);
+/*! Returns the hash of everything added so far. The state isn't changed, so you may keep adding to it. */
+extern uint64_t AJRHashStateFinalize(const AJRHashState *state);
+
 /*!
  Compares to doubles and checks that they're equal to the number of places requested. This is often useful when comparing floating point values, especially after values may have passed through a textual representation, as that can often lead to rounding errors due to the problematic nature of encoding floating point values.
 
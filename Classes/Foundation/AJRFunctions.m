@@ -29,7 +29,7 @@
  ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#import "AJRFunctions.h"
+#import "AJRFunctionsP.h"
 
 #import "AJRFileFinder.h"
 #import "AJRFormat.h"
@@ -72,8 +72,7 @@ const struct _AJROpaqueAssertStruct self = {};
 static NSString *tempDirectoryPath = nil;
 
 void AJRVFPrintf(NSFileHandle *fileHandle, NSString *format, va_list ap) {
-    NSString *output = AJRFormatv(format, ap);
-    [fileHandle writeData:[output dataUsingEncoding:NSUTF8StringEncoding allowLossyConversion:YES]];
+    [fileHandle writeData:[[AJRFormatSpecification specificationWithFormat:format] UTF8DataWithArguments:ap]];
 }
 
 void AJRVPrintf(NSString *format, va_list ap) {
@@ -366,13 +365,20 @@ NSDate *AJRDateFromString(NSString *string, NSCalendar *calendar, NSError **erro
 }
 
 NSDate *AJRDateFromStringAndFormat(NSString *string, NSString * _Nullable format, NSCalendar * _Nullable calendar, NSError * _Nullable * _Nullable error) {
+    /*
+     * Get the current time. This will fill in for any unsupplied values.
+     */
+    NSDateComponents *today = [[NSCalendar currentCalendar] components:NSCalendarUnitYear | NSCalendarUnitMonth |  NSCalendarUnitDay fromDate:[NSDate date]];
+    return AJRDateFromStringAndFormatWithDefaults(string, format, calendar, today, error);
+}
+
+NSDate *AJRDateFromStringAndFormatWithDefaults(NSString *string, NSString * _Nullable format, NSCalendar * _Nullable calendar, NSDateComponents *defaults, NSError * _Nullable * _Nullable error) {
     NSInteger m, d, y, currentYear, w, x;
     NSScanner *scanner = [NSScanner scannerWithString:string];
     NSMutableArray *formats = nil;
     NSArray *work;
     BOOL usedMonth = NO, usedDay = NO, usedYear = NO;
     BOOL /*hasMonth = NO,*/ hasDay = NO/*, hasYear = NO*/;
-    NSDateComponents *today;
     NSString *formatSubstring;
     AJRDateSegmentStringType type;
     
@@ -382,13 +388,9 @@ NSDate *AJRDateFromStringAndFormat(NSString *string, NSString * _Nullable format
         calendar = [NSCalendar currentCalendar];
     }
     
-    /*
-     * Get the current time. This will fill in for any unsupplied values.
-     */
-    today = [[NSCalendar currentCalendar] components:NSCalendarUnitYear | NSCalendarUnitMonth |  NSCalendarUnitDay fromDate:[NSDate date]];
-    m = [today month];
-    d = [today day];
-    y = currentYear = [today year];
+    m = [defaults month];
+    d = [defaults day];
+    y = currentYear = [defaults year];
     
     [scanner scanCharactersFromSet:[NSCharacterSet decimalDigitCharacterSet] intoString:NULL];
     // 6/24/97 AJR (1319)
@@ -850,6 +852,285 @@ uint64_t AJRHash64(uint64_t input) {
     return input;
 }
 
+#pragma mark - Byte Hashing
+
+// This is wyhash (final version 4), by Wang Yi, which is in the public domain. It's among the fastest 64 bit hashes that pass SMHasher, particularly on the short keys that make up most of what we hash.
+
+static const uint64_t AJRHashSecret[4] = { UINT64_C(0x2d358dccaa6c78a5), UINT64_C(0x8bb84b93962eacc9), UINT64_C(0x4b33a62ed433d4a3), UINT64_C(0x4d5a2da51de1aa47) };
+
+static inline void AJRHashMultiply(uint64_t *a, uint64_t *b) {
+    __uint128_t product = (__uint128_t)*a * *b;
+    *a = (uint64_t)product;
+    *b = (uint64_t)(product >> 64);
+}
+
+static inline uint64_t AJRHashMix(uint64_t a, uint64_t b) {
+    AJRHashMultiply(&a, &b);
+    return a ^ b;
+}
+
+static inline uint64_t AJRHashRead8(const uint8_t *p) {
+    uint64_t value;
+    memcpy(&value, p, sizeof(value));
+    return CFSwapInt64LittleToHost(value);
+}
+
+static inline uint64_t AJRHashRead4(const uint8_t *p) {
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return CFSwapInt32LittleToHost(value);
+}
+
+static inline uint64_t AJRHashRead3(const uint8_t *p, size_t length) {
+    return ((uint64_t)p[0] << 16) | ((uint64_t)p[length >> 1] << 8) | p[length - 1];
+}
+
+static inline uint64_t AJRHashStripe(const uint8_t *p, uint64_t seed, uint64_t *see1, uint64_t *see2) {
+    *see1 = AJRHashMix(AJRHashRead8(p + 16) ^ AJRHashSecret[2], AJRHashRead8(p + 24) ^ *see1);
+    *see2 = AJRHashMix(AJRHashRead8(p + 32) ^ AJRHashSecret[3], AJRHashRead8(p + 40) ^ *see2);
+    return AJRHashMix(AJRHashRead8(p) ^ AJRHashSecret[1], AJRHashRead8(p + 8) ^ seed);
+}
+
+// Finishes the last 1 to 48 bytes of an input longer than 16 bytes. The final read backs up to cover 16 bytes, so at least 16 bytes before end must be readable.
+static inline uint64_t AJRHashFinishLong(const uint8_t *p, size_t remaining, uint64_t seed, uint64_t length) {
+    while (remaining > 16) {
+        seed = AJRHashMix(AJRHashRead8(p) ^ AJRHashSecret[1], AJRHashRead8(p + 8) ^ seed);
+        p += 16;
+        remaining -= 16;
+    }
+    uint64_t a = AJRHashRead8(p + remaining - 16) ^ AJRHashSecret[1];
+    uint64_t b = AJRHashRead8(p + remaining - 8) ^ seed;
+    AJRHashMultiply(&a, &b);
+    return AJRHashMix(a ^ AJRHashSecret[0] ^ length, b ^ AJRHashSecret[1]);
+}
+
+static inline uint64_t AJRHashFinishShort(const uint8_t *p, size_t length, uint64_t seed) {
+    uint64_t a = 0, b = 0;
+    if (length >= 4) {
+        a = (AJRHashRead4(p) << 32) | AJRHashRead4(p + ((length >> 3) << 2));
+        b = (AJRHashRead4(p + length - 4) << 32) | AJRHashRead4(p + length - 4 - ((length >> 3) << 2));
+    } else if (length > 0) {
+        a = AJRHashRead3(p, length);
+    }
+    a ^= AJRHashSecret[1];
+    b ^= seed;
+    AJRHashMultiply(&a, &b);
+    return AJRHashMix(a ^ AJRHashSecret[0] ^ length, b ^ AJRHashSecret[1]);
+}
+
+uint64_t AJRHashBytesWithSeed(const void *bytes, size_t length, uint64_t seed) {
+    const uint8_t *p = (const uint8_t *)bytes;
+
+    seed ^= AJRHashMix(seed ^ AJRHashSecret[0], AJRHashSecret[1]);
+    if (length <= 16) {
+        return AJRHashFinishShort(p, length, seed);
+    }
+
+    size_t remaining = length;
+    if (remaining > 48) {
+        uint64_t see1 = seed, see2 = seed;
+        do {
+            seed = AJRHashStripe(p, seed, &see1, &see2);
+            p += 48;
+            remaining -= 48;
+        } while (remaining > 48);
+        seed ^= see1 ^ see2;
+    }
+    return AJRHashFinishLong(p, remaining, seed, length);
+}
+
+uint64_t AJRHashBytes(const void *bytes, size_t length) {
+    return AJRHashBytesWithSeed(bytes, length, 0);
+}
+
+void AJRHashStateInitialize(AJRHashState *state, uint64_t seed) {
+    seed ^= AJRHashMix(seed ^ AJRHashSecret[0], AJRHashSecret[1]);
+    state->seed = seed;
+    state->see1 = seed;
+    state->see2 = seed;
+    state->length = 0;
+    state->pending = 0;
+    state->striped = NO;
+}
+
+// The state's buffer keeps the last 16 bytes of the previous stripe, followed by up to one stripe of pending input. We can only hash a pending stripe once we know more input follows it, since the last 1 to 48 bytes are always finished differently.
+#define AJRHashContextLength 16
+#define AJRHashStripeLength 48
+
+void AJRHashStateUpdate(AJRHashState *state, const void *bytes, size_t length) {
+    const uint8_t *p = (const uint8_t *)bytes;
+
+    state->length += length;
+    while (length > 0) {
+        if (state->pending == AJRHashStripeLength) {
+            uint8_t *stripe = state->buffer + AJRHashContextLength;
+            state->seed = AJRHashStripe(stripe, state->seed, &state->see1, &state->see2);
+            memcpy(state->buffer, stripe + AJRHashStripeLength - AJRHashContextLength, AJRHashContextLength);
+            state->pending = 0;
+            state->striped = YES;
+        }
+        if (state->pending == 0 && length > AJRHashStripeLength) {
+            // Hash straight from the caller's bytes, leaving at least one byte behind.
+            do {
+                state->seed = AJRHashStripe(p, state->seed, &state->see1, &state->see2);
+                p += AJRHashStripeLength;
+                length -= AJRHashStripeLength;
+            } while (length > AJRHashStripeLength);
+            memcpy(state->buffer, p - AJRHashContextLength, AJRHashContextLength);
+            state->striped = YES;
+        }
+        size_t count = MIN(length, (size_t)(AJRHashStripeLength - state->pending));
+        memcpy(state->buffer + AJRHashContextLength + state->pending, p, count);
+        state->pending += count;
+        p += count;
+        length -= count;
+    }
+}
+
+uint64_t AJRHashStateFinalize(const AJRHashState *state) {
+    const uint8_t *p = state->buffer + AJRHashContextLength;
+
+    if (state->length <= 16) {
+        return AJRHashFinishShort(p, (size_t)state->length, state->seed);
+    }
+    uint64_t seed = state->seed;
+    if (state->striped) {
+        seed ^= state->see1 ^ state->see2;
+    }
+    return AJRHashFinishLong(p, state->pending, seed, state->length);
+}
+
+#pragma mark - Case Folding Hashes
+
+static inline uint8_t AJRHashFoldASCII(uint8_t character) {
+    return character + ((uint8_t)(character - 'A') < 26 ? 0x20 : 0);
+}
+
+void AJRHashStateUpdateFoldingASCII(AJRHashState *state, const void *bytes, size_t length) {
+    const uint8_t *p = (const uint8_t *)bytes;
+    uint8_t folded[256];
+
+    while (length > 0) {
+        size_t count = MIN(length, sizeof(folded));
+        // Simple enough that the compiler vectorizes it.
+        for (size_t x = 0; x < count; x++) {
+            folded[x] = AJRHashFoldASCII(p[x]);
+        }
+        AJRHashStateUpdate(state, folded, count);
+        p += count;
+        length -= count;
+    }
+}
+
+uint64_t AJRHashBytesFoldingASCII(const void *bytes, size_t length, uint64_t seed) {
+    if (length <= 256) {
+        // Short keys are most of what we see, so skip the state.
+        const uint8_t *p = (const uint8_t *)bytes;
+        uint8_t folded[256];
+        for (size_t x = 0; x < length; x++) {
+            folded[x] = AJRHashFoldASCII(p[x]);
+        }
+        return AJRHashBytesWithSeed(folded, length, seed);
+    }
+    AJRHashState state;
+    AJRHashStateInitialize(&state, seed);
+    AJRHashStateUpdateFoldingASCII(&state, bytes, length);
+    return AJRHashStateFinalize(&state);
+}
+
+#pragma mark - String Hashing
+
+uint64_t AJRHashString(NSString *string, uint64_t seed) {
+    CFStringRef cfString = (__bridge CFStringRef)string;
+    // ASCII is also UTF-8, so when the string is stored that way, we can hash it in place.
+    const char *characters = CFStringGetCStringPtr(cfString, kCFStringEncodingASCII);
+
+    if (characters != NULL) {
+        return AJRHashBytesWithSeed(characters, CFStringGetLength(cfString), seed);
+    }
+
+    AJRHashState state;
+    AJRHashStateInitialize(&state, seed);
+    AJRHashStateUpdateWithString(&state, string);
+    return AJRHashStateFinalize(&state);
+}
+
+void AJRHashStateUpdateWithString(AJRHashState *state, NSString *string) {
+    CFStringRef cfString = (__bridge CFStringRef)string;
+    CFIndex length = CFStringGetLength(cfString);
+    CFIndex location = 0;
+    UInt8 buffer[1024];
+
+    while (location < length) {
+        CFIndex used = 0;
+        // Conversion never splits a character, and an unpaired surrogate becomes a '?'.
+        CFIndex converted = CFStringGetBytes(cfString, CFRangeMake(location, length - location), kCFStringEncodingUTF8, '?', false, buffer, sizeof(buffer), &used);
+        if (converted == 0) {
+            break;
+        }
+        AJRHashStateUpdate(state, buffer, used);
+        location += converted;
+    }
+}
+
+uint64_t AJRHashStringFoldingCase(NSString *string, uint64_t seed) {
+    CFStringRef cfString = (__bridge CFStringRef)string;
+    const char *characters = CFStringGetCStringPtr(cfString, kCFStringEncodingASCII);
+
+    if (characters != NULL) {
+        return AJRHashBytesFoldingASCII(characters, CFStringGetLength(cfString), seed);
+    }
+
+    // Most strings are still ASCII, so fold them a block at a time for as long as they are.
+    CFIndex length = CFStringGetLength(cfString);
+    CFIndex location = 0;
+    UInt8 buffer[1024];
+    AJRHashState state;
+
+    AJRHashStateInitialize(&state, seed);
+    while (location < length) {
+        CFIndex converted = CFStringGetBytes(cfString, CFRangeMake(location, MIN(length - location, (CFIndex)sizeof(buffer))), kCFStringEncodingASCII, 0, false, buffer, sizeof(buffer), NULL);
+        AJRHashStateUpdateFoldingASCII(&state, buffer, converted);
+        location += converted;
+        if (location < length && converted < (CFIndex)sizeof(buffer)) {
+            break;
+        }
+    }
+    if (location == length) {
+        return AJRHashStateFinalize(&state);
+    }
+
+    // We found something other than ASCII, so fold the whole string the way a case insensitive compare would, and hash that instead.
+    CFMutableStringRef folded = CFStringCreateMutableCopy(NULL, 0, cfString);
+    CFStringFold(folded, kCFCompareCaseInsensitive, NULL);
+    uint64_t hash = AJRHashString((__bridge NSString *)folded, seed);
+    CFRelease(folded);
+    return hash;
+}
+
+uint64_t AJRHashUTF8FoldingCase(const void *bytes, size_t length, uint64_t seed) {
+    const uint8_t *p = (const uint8_t *)bytes;
+    size_t ascii = 0;
+
+    while (ascii < length && p[ascii] < 0x80) {
+        ascii++;
+    }
+    if (ascii == length) {
+        return AJRHashBytesFoldingASCII(bytes, length, seed);
+    }
+
+    CFStringRef string = CFStringCreateWithBytesNoCopy(NULL, p, length, kCFStringEncodingUTF8, false, kCFAllocatorNull);
+    if (string == NULL) {
+        // Not valid UTF-8, so all we can do is fold the ASCII.
+        return AJRHashBytesFoldingASCII(bytes, length, seed);
+    }
+    uint64_t hash = AJRHashStringFoldingCase((__bridge NSString *)string, seed);
+    CFRelease(string);
+    return hash;
+}
+
+#pragma mark - Math
+
 double AJRRoundToPlaces(double input, int places) {
     double multiplier = pow(10.0, (double)places);
     return round(input * multiplier) / multiplier;
@@ -33,6 +33,13 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
+typedef NS_ENUM(uint8_t, AJRMemoryHandleMapping) {
+    /// The file is mapped read only, and the handle cannot be written.
+    AJRMemoryHandleMappingReadOnly,
+    /// The file is mapped privately. Writes within the file's length modify the mapped pages, but are never written back to the file.
+    AJRMemoryHandleMappingCopyOnWrite,
+};
+
 @interface AJRMemoryHandle : NSFileHandle
 
 + (instancetype)memoryHandleForReadingData:(NSData *)data;
@@ -41,6 +48,7 @@ NS_ASSUME_NONNULL_BEGIN
 + (instancetype)memoryHandleForWriting;
 + (instancetype)memoryHandleWithContentsOfFile:(NSString *)path options:(NSDataReadingOptions)options error:(NSError * _Nullable * _Nullable)error;
 + (instancetype)memoryHandleWithContentsOfURL:(NSURL *)url options:(NSDataReadingOptions)options error:(NSError * _Nullable * _Nullable)error;
++ (nullable instancetype)memoryHandleByMappingFileAtURL:(NSURL *)url mapping:(AJRMemoryHandleMapping)mapping error:(NSError * _Nullable * _Nullable)error;
 
 /*!
  Create a memory handle suitable for writing. The mutable data written to is created and can be accessed via the data or mutableData properties.
@@ -102,6 +110,21 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (instancetype)initWithContentsOfURL:(NSURL *)url options:(NSDataReadingOptions)options error:(NSError * _Nullable * _Nullable)error;
 
+/*!
+ Creates a memory handle backed by a mmap(2) of the file at url, so that large files can be handed to code expecting an NSFileHandle without reading them into memory. Pages are only read as they're touched.
+
+ When mapping is AJRMemoryHandleMappingCopyOnWrite, writes that fall within the file's current length go directly to the privately mapped pages. A write that would extend or truncate the data first copies the data into memory, as if by convertToWritable. Either way, the file itself is never modified.
+
+ If the file changes size while mapped, accessing pages past its new end will fault, so only map files you don't expect to be truncated.
+
+ @param url A file URL.
+ @param mapping Whether the mapping is read only or copy-on-write.
+ @param error Initialized if the file can't be opened or mapped.
+
+ @returns A newly created memory handle, or nil if the file cannot be mapped.
+ */
+- (nullable instancetype)initByMappingFileAtURL:(NSURL *)url mapping:(AJRMemoryHandleMapping)mapping error:(NSError * _Nullable * _Nullable)error;
+
 /*!
  If the handle is not already writable, the handles data is converted to mutable, making the handle writable. The conversion to writable does not change the position within the data.
  */
@@ -129,11 +152,19 @@ NS_ASSUME_NONNULL_BEGIN
 /*! Returns the file's mutable data, if the data is writable, otherwise returns nil. */
 @property (nonatomic,readonly,nullable) NSMutableData *mutableData;
 @property (nonatomic,readonly) BOOL canWrite;
+/*! YES if the handle is backed by a mapped file, and hasn't since been converted to writable. */
+@property (nonatomic,readonly,getter=isMapped) BOOL mapped;
 
 - (NSData *)readDataToEndOfFile;
 - (NSData *)readDataToEndOfFileWithError:(NSError * _Nullable * _Nullable)error;
 - (NSData *)readDataOfLength:(NSUInteger)length;
 - (NSData *)readDataOfLength:(NSUInteger)length error:(NSError * _Nullable * _Nullable)error;
+/*!
+ Reads up to length bytes starting at offset, like pread(2). This neither uses nor changes the handle's offset, so it's safe to call from multiple threads at once, and if the handle isn't writable, it doesn't take the handle's lock at all. For read only handles, the returned data references the handle's bytes rather than copying them.
+
+ @returns The data read, which will be shorter than length, possibly empty, if offset + length extends past the end of the data. Returns nil if the handle has been closed.
+ */
+- (nullable NSData *)readDataOfLength:(NSUInteger)length atOffset:(unsigned long long)offset error:(NSError * _Nullable * _Nullable)error;
 
 - (void)writeData:(NSData *)data;
 
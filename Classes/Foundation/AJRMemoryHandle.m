@@ -35,10 +35,16 @@
 #import "NSError+Extensions.h"
 #import "NSFileHandle+Extensions.h"
 
+#import <fcntl.h>
+#import <sys/mman.h>
+#import <sys/stat.h>
+
 @interface AJRMemoryHandle ()
 
 @property (nonatomic,strong) NSData *data;
 @property (nonatomic,assign) NSUInteger position;
+// Set when our data can never change underneath us, which lets positional reads skip the access lock. This is atomic, because it's cleared if we're converted to writable.
+@property (atomic,strong,nullable) NSData *readOnlyData;
 
 @end
 
@@ -46,6 +52,10 @@
 	// Technically, we don't "close" per se, but track that the user closed us, so that we respond in an expected fashion to various API calls.
 	BOOL _closed;
 	NSRecursiveLock *_accessLock;
+	// Only set while we're backed by a mapped file.
+	void *_mappedBytes;
+	size_t _mappedLength;
+	AJRMemoryHandleMapping _mapping;
 }
 
 #pragma mark - Creation
@@ -75,8 +85,17 @@
 	return [[self alloc] initWithContentsOfURL:url options:options error:error];
 }
 
++ (instancetype)memoryHandleByMappingFileAtURL:(NSURL *)url mapping:(AJRMemoryHandleMapping)mapping error:(NSError * _Nullable * _Nullable)error {
+	return [[self alloc] initByMappingFileAtURL:url mapping:mapping error:error];
+}
+
 - (void)_commonInternalInit {
 	_accessLock = [[NSRecursiveLock alloc] init];
+	if (![_data isKindOfClass:[NSMutableData class]] && !(_mappedBytes != NULL && _mapping == AJRMemoryHandleMappingCopyOnWrite)) {
+		// Touch the bytes now, so that any flattening of the data happens here, rather than racing in readDataOfLength:atOffset:error:.
+		[_data bytes];
+		self.readOnlyData = _data;
+	}
 }
 
 - (instancetype)init {
@@ -142,16 +161,76 @@
     return self;
 }
 
+- (instancetype)initByMappingFileAtURL:(NSURL *)url mapping:(AJRMemoryHandleMapping)mapping error:(NSError **)error {
+	NSError *localError = nil;
+	NSData *data = nil;
+	void *bytes = NULL;
+	size_t length = 0;
+	int fileDescriptor = open(url.fileSystemRepresentation, O_RDONLY | O_CLOEXEC);
+	
+	if (fileDescriptor < 0) {
+		localError = [NSError errorWithDomain:NSPOSIXErrorDomain errorNumber:errno];
+	} else {
+		struct stat info;
+		if (fstat(fileDescriptor, &info) < 0) {
+			localError = [NSError errorWithDomain:NSPOSIXErrorDomain errorNumber:errno];
+		} else if (!S_ISREG(info.st_mode)) {
+			localError = [NSError errorWithDomain:NSPOSIXErrorDomain format:@"Cannot map %@, because it's not a regular file.", url.path];
+		} else if (info.st_size == 0) {
+			// mmap() refuses empty mappings, but there's nothing to map anyways. A copy-on-write handle still has to accept writes, which for an empty file always grow it.
+			data = mapping == AJRMemoryHandleMappingCopyOnWrite ? [NSMutableData data] : [NSData data];
+		} else {
+			length = (size_t)info.st_size;
+			bytes = mmap(NULL, length, mapping == AJRMemoryHandleMappingCopyOnWrite ? PROT_READ | PROT_WRITE : PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+			if (bytes == MAP_FAILED) {
+				bytes = NULL;
+				length = 0;
+				localError = [NSError errorWithDomain:NSPOSIXErrorDomain errorNumber:errno];
+			} else {
+				data = [[NSData alloc] initWithBytesNoCopy:bytes length:length deallocator:^(void *bytes, NSUInteger length) {
+					munmap(bytes, length);
+				}];
+			}
+		}
+		// The mapping stays valid after the file is closed.
+		close(fileDescriptor);
+	}
+	
+	if (data != nil) {
+		if ((self = [super init])) {
+			_data = data;
+			_mappedBytes = bytes;
+			_mappedLength = length;
+			_mapping = mapping;
+			[self _commonInternalInit];
+		}
+	} else {
+		self = nil;
+	}
+	
+	return AJRAssertOrPropagateError(self, error, localError);
+}
+
 #pragma mark - Utilities
 
 - (void)convertToWritable {
 	[self _lockedAccess:^{
-		if (![self canWrite]) {
+		if (![self->_data isKindOfClass:[NSMutableData class]]) {
 			self->_data = [self->_data mutableCopy];
+			self->_mappedBytes = NULL;
+			self->_mappedLength = 0;
+			self.readOnlyData = nil;
 		}
 	}];
 }
 
+/*! Copy-on-write mappings can't change length, so anything that needs a real NSMutableData converts them first. Must be called while holding the access lock. */
+- (void)_convertCopyOnWriteMappingToWritable {
+	if (_mappedBytes != NULL && _mapping == AJRMemoryHandleMappingCopyOnWrite) {
+		[self convertToWritable];
+	}
+}
+
 - (void)accessData:(void (^)(NSData *data, NSUInteger *position))block {
 	[self _lockedAccess:^{
 		NSUInteger localPosition = self->_position;
@@ -163,6 +242,7 @@
 - (BOOL)accessMutableData:(void (^)(NSMutableData *data, NSUInteger *position))block {
 	__block BOOL wasWritable = NO;
 	[self _lockedAccess:^{
+		[self _convertCopyOnWriteMappingToWritable];
 		if (self.canWrite) {
 			NSUInteger localPosition = self->_position;
 			wasWritable = YES;
@@ -180,6 +260,7 @@
 	__block NSMutableData *data = nil;
 	
 	[self _lockedAccess:^{
+		[self _convertCopyOnWriteMappingToWritable];
 		if (self.canWrite) {
 			data = (NSMutableData *)self->_data;
 		}
@@ -189,7 +270,11 @@
 }
 
 - (BOOL)canWrite {
-    return [_data isKindOfClass:[NSMutableData class]];
+    return [_data isKindOfClass:[NSMutableData class]] || (_mappedBytes != NULL && _mapping == AJRMemoryHandleMappingCopyOnWrite);
+}
+
+- (BOOL)isMapped {
+	return _mappedBytes != NULL;
 }
 
 #pragma mark - Thread Safety
@@ -301,6 +386,37 @@
 	return AJRAssertOrPropagateError(subdata, error, localError);
 }
 
+- (NSData *)readDataOfLength:(NSUInteger)length atOffset:(unsigned long long)offset error:(NSError **)error {
+	__block NSData *subdata = nil;
+	NSError *localError = nil;
+	NSData *readOnlyData = self.readOnlyData;
+	
+	if (_closed) {
+		localError = [NSError errorWithDomain:NSPOSIXErrorDomain format:@"Unable to read from memory handle: %@", @"Tried to read from a closed memory handle."];
+	} else if (readOnlyData != nil) {
+		// The data can't change, so there's no need for the lock, and the result can simply reference our bytes. The deallocator keeps readOnlyData alive for as long as the result is.
+		NSUInteger dataLength = readOnlyData.length;
+		if (offset >= dataLength) {
+			subdata = [NSData data];
+		} else {
+			subdata = [[NSData alloc] initWithBytesNoCopy:(uint8_t *)readOnlyData.bytes + offset length:MIN(length, dataLength - (NSUInteger)offset) deallocator:^(void *bytes, NSUInteger length) {
+				(void)readOnlyData;
+			}];
+		}
+	} else {
+		[self _lockedAccess:^{
+			NSUInteger dataLength = self->_data.length;
+			if (offset >= dataLength) {
+				subdata = [NSData data];
+			} else {
+				subdata = [self->_data subdataWithRange:(NSRange){(NSUInteger)offset, MIN(length, dataLength - (NSUInteger)offset)}];
+			}
+		}];
+	}
+	
+	return AJRAssertOrPropagateError(subdata, error, localError);
+}
+
 - (void)readInBackgroundAndNotify {
 	[self readToEndOfFileInBackgroundAndNotify];
 }
@@ -323,6 +439,7 @@
 /*! Called by internal methods to write to our data. This method throws an exception if the data is not writable. */
 - (void)writeIfPossible:(void (^)(NSMutableData *data))writeBlock {
 	[self _lockedAccess:^{
+		[self _convertCopyOnWriteMappingToWritable];
 		if (![self canWrite]) {
 			[NSException raise:NSInternalInconsistencyException format:@"Cannot write to locked memory."];
 		}
@@ -339,10 +456,12 @@
 	size_t bytesWritten = 0;
 	
 	@try {
-		[self writeIfPossible:^(NSMutableData *data) {
-			[data replaceBytesInRange:(NSRange){self->_position, length} withBytes:bytes];
-			self->_position += length;
-		}];
+		if (![self _writeBytesToMapping:bytes length:length]) {
+			[self writeIfPossible:^(NSMutableData *data) {
+				[data replaceBytesInRange:(NSRange){self->_position, length} withBytes:bytes];
+				self->_position += length;
+			}];
+		}
 		bytesWritten = length;
 	} @catch (NSException *localException) {
 		errno = EBADF;
@@ -356,6 +475,22 @@
 	return AJRAssertOrPropagateError(bytesWritten != AJR_WRITE_ERROR, error, localError);
 }
 
+/*! Writes directly into a copy-on-write mapping when the write doesn't change the data's length. Returns NO if the write needs to go through writeIfPossible: instead. */
+- (BOOL)_writeBytesToMapping:(const void *)bytes length:(size_t)length {
+	if (_mapping != AJRMemoryHandleMappingCopyOnWrite) {
+		return NO;
+	}
+	__block BOOL wrote = NO;
+	[self _lockedAccess:^{
+		if (self->_mappedBytes != NULL && !self->_closed && self->_position + length <= self->_mappedLength) {
+			memcpy((uint8_t *)self->_mappedBytes + self->_position, bytes, length);
+			self->_position += length;
+			wrote = YES;
+		}
+	}];
+	return wrote;
+}
+
 #pragma mark - Writing
 
 - (NSInteger)writeBytes:(const void *)buffer length:(unsigned long)length {
@@ -40,6 +40,42 @@ typedef NS_ENUM (uint8_t, AJREndianness) {
 
 extern AJREndianness AJRGetCurrentArchitectureEndianness(void);
 
+/*!
+ Decodes and encodes fixed size values stored with `endianness` at a possibly unaligned address. These are shared by the stream functions below and by AJRBinaryReader and AJRBinaryWriter, so the byte layout is defined in exactly one place.
+ */
+static inline uint16_t AJRDecodeUInt16(const void *bytes, AJREndianness endianness) {
+    uint16_t value;
+    memcpy(&value, bytes, sizeof(value));
+    return endianness == AJREndiannessBig ? CFSwapInt16BigToHost(value) : CFSwapInt16LittleToHost(value);
+}
+
+static inline uint32_t AJRDecodeUInt32(const void *bytes, AJREndianness endianness) {
+    uint32_t value;
+    memcpy(&value, bytes, sizeof(value));
+    return endianness == AJREndiannessBig ? CFSwapInt32BigToHost(value) : CFSwapInt32LittleToHost(value);
+}
+
+static inline uint64_t AJRDecodeUInt64(const void *bytes, AJREndianness endianness) {
+    uint64_t value;
+    memcpy(&value, bytes, sizeof(value));
+    return endianness == AJREndiannessBig ? CFSwapInt64BigToHost(value) : CFSwapInt64LittleToHost(value);
+}
+
+static inline void AJREncodeUInt16(void *bytes, uint16_t value, AJREndianness endianness) {
+    value = endianness == AJREndiannessBig ? CFSwapInt16HostToBig(value) : CFSwapInt16HostToLittle(value);
+    memcpy(bytes, &value, sizeof(value));
+}
+
+static inline void AJREncodeUInt32(void *bytes, uint32_t value, AJREndianness endianness) {
+    value = endianness == AJREndiannessBig ? CFSwapInt32HostToBig(value) : CFSwapInt32HostToLittle(value);
+    memcpy(bytes, &value, sizeof(value));
+}
+
+static inline void AJREncodeUInt64(void *bytes, uint64_t value, AJREndianness endianness) {
+    value = endianness == AJREndiannessBig ? CFSwapInt64HostToBig(value) : CFSwapInt64HostToLittle(value);
+    memcpy(bytes, &value, sizeof(value));
+}
+
 @protocol AJRByteStreamMethods <NSObject>
 
 @property (nonatomic,assign) AJREndianness endianness;
@@ -31,6 +31,7 @@
 
 #import "AJRStreamUtilities.h"
 
+#import "AJRBufferedReaderP.h"
 #import "AJRFormat.h"
 #import "AJRFunctions.h"
 #import "AJRLogging.h"
@@ -46,10 +47,7 @@ AJREndianness AJRGetCurrentArchitectureEndianness(void) {
     return AJR_IS_BIG_ENDIAN ? AJREndiannessBig : AJREndiannessLittle;
 }
 
-#define BUFFERSIZE    16384
-#define BUFFERSIZE32  (BUFFERSIZE / sizeof(uint32_t))
 #define AJR_ICONV_ERROR ((iconv_t)(-1))
-#define AJR_READ_ERROR ((NSInteger)(-1))
 
 @interface AJRStreamLoader : NSObject
 @end
@@ -184,207 +182,19 @@ void AJRAddReaderConveniencesToReader(Class class) {
 #pragma mark - Read Function Primitives
 
 BOOL AJRReadCharacter(id <AJRByteReader> reader, uint32_t *characterOut, size_t *bytesRead, NSError **error) {
-    NSError *localError = nil;
-    BOOL success = YES;
-    uint32_t character = 0;
-    const char *encodingNameString = [reader.encodingName ?: @"UTF-8" UTF8String];
-    iconv_t cd = iconv_open("UTF-32LE", encodingNameString);
-    
-    AJRAssert(cd != AJR_ICONV_ERROR, @"Failed to open iconv_open. This should never fail.");
-    
-    size_t position = 0;
-    
-    // We're going to assume that we'll have a valid character after reading 16 bytes, or else we're in trouble.
-    uint8_t inputBuffer[16];
-    char *inputPointer = (char *)inputBuffer;
-    uint8_t outputBuffer[16];
-    char *outputPointer = (char *)outputBuffer;
-    
-    for (position = 0; position < 16; position++) {
-        size_t readLength;
-        success = [reader readBytes:&(inputBuffer[position]) length:1 bytesRead:&readLength error:&localError];
-        if (!success) {
-            // We've got an error.
-            character = 0;
-            position = AJR_READ_ERROR;
-            break;
-        } else if (readLength == 0) {
-            // We hit end-of-file, so just return 0
-            character = 0;
-            break;
-        } else {
-            // We're good, see if we can convert to our character encoding.
-            size_t bytesWritten = 16;
-            size_t length = position + 1;
-            size_t result = iconv(cd, &inputPointer, &length, &outputPointer, &bytesWritten);
-            if (result == AJR_READ_ERROR) {
-                // We don't care about 0 or nothing read, because as far as we're concerned, this just means we haven't read a valid character yet.
-            } else {
-                // Because we're decoding to UTF-32, we always expect bytes written to be 4.
-                AJRAssert(16 - bytesWritten == 4, @"We always expect 1 and exactly one UTF-32 character, but we consumed %d bytes, not 4 as expected by UTF-32.", (int)(16 - bytesWritten));
-                character = ((outputBuffer[0] <<  0) |
-                             (outputBuffer[1] <<  8) |
-                             (outputBuffer[2] << 16) |
-                             (outputBuffer[3] << 24));
-                position++; // Increment, because we consumed a character.
-                break;
-            }
-        }
+    if ([reader isKindOfClass:[AJRBufferedReader class]]) {
+        return [(AJRBufferedReader *)reader readCharacter:characterOut bytesRead:bytesRead error:error];
     }
-    
-    if (position == 16) {
-        // We read 16 bytes and couldn't produce a valid unicode character, so produce an error instead
-        character = 0;
-        position = 0;
-        localError = [NSError errorWithDomain:NSPOSIXErrorDomain errorNumber:EILSEQ];
-        success = NO;
-    }
-    
-    iconv_close(cd);
-
-    if (success) {
-        AJRSetOutParameter(characterOut, character);
-        AJRSetOutParameter(bytesRead, position);
-    }
-
-    return AJRAssertOrPropagateError(success, error, localError);
-}
-
-static NSInteger AJRCharacterKey = 0;
-static void AJRPushCharacter(id object, uint32_t character) {
-    objc_setAssociatedObject(object, &AJRCharacterKey, @(character), OBJC_ASSOCIATION_RETAIN);
-}
-
-static BOOL AJRPopCharacter(id object, uint32_t *character) {
-    NSNumber *value = objc_getAssociatedObject(object, &AJRCharacterKey);
-    if (value) {
-        objc_setAssociatedObject(object, &AJRCharacterKey, nil, OBJC_ASSOCIATION_RETAIN);
-        AJRSetOutParameter(character, (uint32_t)value.unsignedIntegerValue);
-        return YES;
-    }
-    return NO;
+    // The attached reader never reads past the end of the character, so the reader is left positioned exactly after it.
+    return [AJRBufferedReaderAttachedToReader(reader) readCharacter:characterOut bytesRead:bytesRead error:error];
 }
 
 NSString *AJRReadLine(NSObject<AJRByteReader> *reader, NSError **error) {
-    if (AJREncodingIs8Bit(reader.encoding)) {
-        NSError *localError = nil;
-        char buffer[BUFFERSIZE];
-        NSInteger pos;
-        BOOL lastWasCR = NO;
-        BOOL hitEOF = NO;
-        
-        // Mont - 9/21/99
-        // Clear out the buffer.
-        memset(buffer, 0, BUFFERSIZE);
-        
-        uint32_t lastCharacter;
-        if (AJRPopCharacter(reader, &lastCharacter)) {
-            buffer[0] = (char)lastCharacter;
-            pos = 1;
-        } else {
-            pos = 0;
-        }
-        
-        for (; pos < BUFFERSIZE; pos++) {
-            size_t bytesRead = 0;
-            BOOL success = [reader readBytes:&(buffer[pos]) length:1 bytesRead:&bytesRead error:&localError];
-            if (!success) {
-                // We hit an error, so we're going to return it.
-                localError = [NSError errorWithDomain:NSPOSIXErrorDomain errorNumber:errno];
-                break;
-            }
-            if (bytesRead == 0) {
-                // Hit EOF, so bail.
-                hitEOF = YES;
-                break;
-            }
-            
-            // Mont - 9/21/99
-            // Since pos can go to -1 only check for '\n' if '\r' was false.
-            if (buffer[pos] == '\r') {
-                pos--;
-                lastWasCR = YES;
-            } else if (buffer[pos] == '\n') {
-                buffer[pos] = '\0';
-                break;
-            } else if (lastWasCR) {
-                // This is necessary, because we need to distinguish between cr/nl endings and just cr endings, and the only way to determine that is to read one character past the \r. To do this, we "push" the character into private storage, and then we'll use it when called again. This is a little hacky, but generally when calling readLine, you'll do it over and over, not intersperced with other calls.
-                AJRPushCharacter(reader, buffer[pos]);
-                break;
-            }
-        }
-        
-        if (localError != nil) {
-            AJRSetOutParameter(error, localError);
-            return nil;
-        }
-        
-        if (hitEOF && pos == 0) {
-            return nil;
-        }
-        
-        if (reader.encoding == NSASCIIStringEncoding) {
-            // Treat this encoding as completely "raw", meaning all characters above 127 will just be passed through, as is, with no interpretation of the encoding.
-            return [NSString stringWithRawBytes:(unsigned char *)buffer length:pos];
-        }
-        
-        return [[NSString alloc] initWithBytes:buffer length:pos encoding:reader.encoding];
-    } else {
-        NSError *localError = nil;
-        uint32_t buffer[BUFFERSIZE32];
-        NSInteger pos;
-        BOOL lastWasCR = NO;
-        BOOL hitEOF = NO;
-        
-        // Mont - 9/21/99
-        // Clear out the buffer.
-        memset(buffer, 0, BUFFERSIZE32);
-        
-        if (AJRPopCharacter(reader, &buffer[0])) {
-            pos = 1;
-        } else {
-            pos = 0;
-        }
-        
-        for (; pos < BUFFERSIZE32; pos++) {
-            size_t bytesRead = 0;
-            BOOL success = AJRReadCharacter(reader, &(buffer[pos]), &bytesRead, &localError);
-            
-            if (!success) {
-                // We hit an error, so we're going to return it.
-                break;
-            }
-            if (bytesRead == 0) {
-                // We hit EOF, so stop reading.
-                hitEOF = YES;
-                break;
-            }
-            // Otherwise we're good, so soldier on.
-            
-            // Mont - 9/21/99
-            // Since pos can go to -1 only check for '\n' if '\r' was false.
-            if (buffer[pos] == '\r') {
-                pos--;
-                lastWasCR = YES;
-            } else if (buffer[pos] == '\n') {
-                buffer[pos] = '\0';
-                break;
-            } else if (lastWasCR) {
-                // This is necessary, because we need to distinguish between cr/nl endings and just cr endings, and the only way to determine that is to read one character past the \r. To do this, we "push" the character into private storage, and then we'll use it when called again. This is a little hacky, but generally when calling readLine, you'll do it over and over, not intersperced with other calls.
-                AJRPushCharacter(reader, buffer[pos]);
-                break;
-            }
-        }
-        
-        if (localError != nil) {
-            AJRSetOutParameter(error, localError);
-            return nil;
-        }
-        
-        // On EOF, if we've not read anything yet, we return nil, because that makes for a nice loop structure, even though it's not strictly conformant to how NSError's generally work.
-        // NOTE: We can't quite get 100% code coverage here, becuase we can only test for one arch type, either little or big endian, but not both.
-        return (hitEOF && pos == 0) ? nil : [[NSString alloc] initWithBytes:buffer length:pos * sizeof(uint32_t) encoding:AJR_IS_BIG_ENDIAN ? NSUTF32BigEndianStringEncoding : NSUTF32LittleEndianStringEncoding];
+    if ([reader isKindOfClass:[AJRBufferedReader class]]) {
+        return [(AJRBufferedReader *)reader readLineWithError:error];
     }
+    // When reader can seek, the attached reader reads ahead and seeks back to the end of the line when done. Otherwise it reads only what it needs, which, for cr only line endings, means one character past the '\r'. That character is held by the attached reader and returned by the next call to AJRReadLine() or AJRReadCharacter(). This is a little hacky, but generally when calling readLine, you'll do it over and over, not intersperced with other calls. If you're reading a lot of lines, use an AJRBufferedReader directly.
+    return [AJRBufferedReaderAttachedToReader(reader) readLineWithError:error];
 }
 
 BOOL AJRReadInt8(id <AJRByteReader> reader, int8_t *value, NSError **error) {
@@ -396,60 +206,54 @@ BOOL AJRReadUInt8(id <AJRByteReader> reader, uint8_t *value, NSError **error) {
 }
 
 BOOL AJRReadInt16(id <AJRByteReader> reader, int16_t *value, AJREndianness endianness, NSError **error) {
-    int16_t work = 0;
-    if ([reader readBytes:&work length:sizeof(work) bytesRead:NULL error:error]) {
-        work = endianness == AJREndiannessBig ? CFSwapInt16BigToHost(work) : CFSwapInt16LittleToHost(work);
-        AJRSetOutParameter(value, work);
+    uint8_t bytes[sizeof(int16_t)] = { 0 };
+    if ([reader readBytes:bytes length:sizeof(bytes) bytesRead:NULL error:error]) {
+        AJRSetOutParameter(value, (int16_t)AJRDecodeUInt16(bytes, endianness));
         return YES;
     }
     return NO;
 }
 
 BOOL AJRReadUInt16(id <AJRByteReader> reader, uint16_t *value, AJREndianness endianness, NSError **error) {
-    int16_t work = 0;
-    if ([reader readBytes:&work length:sizeof(work) bytesRead:NULL error:error]) {
-        work = endianness == AJREndiannessBig ? CFSwapInt16BigToHost(work) : CFSwapInt16LittleToHost(work);
-        AJRSetOutParameter(value, work);
+    uint8_t bytes[sizeof(uint16_t)] = { 0 };
+    if ([reader readBytes:bytes length:sizeof(bytes) bytesRead:NULL error:error]) {
+        AJRSetOutParameter(value, (uint16_t)AJRDecodeUInt16(bytes, endianness));
         return YES;
     }
     return NO;
 }
 
 BOOL AJRReadInt32(id <AJRByteReader> reader, int32_t *value, AJREndianness endianness, NSError **error) {
-    int32_t work = 0;
-    if ([reader readBytes:&work length:sizeof(work) bytesRead:NULL error:error]) {
-        work = endianness == AJREndiannessBig ? CFSwapInt32BigToHost(work) : CFSwapInt32LittleToHost(work);
-        AJRSetOutParameter(value, work);
+    uint8_t bytes[sizeof(int32_t)] = { 0 };
+    if ([reader readBytes:bytes length:sizeof(bytes) bytesRead:NULL error:error]) {
+        AJRSetOutParameter(value, (int32_t)AJRDecodeUInt32(bytes, endianness));
         return YES;
     }
     return NO;
 }
 
 BOOL AJRReadUInt32(id <AJRByteReader> reader, uint32_t *value, AJREndianness endianness, NSError **error) {
-    int32_t work = 0;
-    if ([reader readBytes:&work length:sizeof(work) bytesRead:NULL error:error]) {
-        work = endianness == AJREndiannessBig ? CFSwapInt32BigToHost(work) : CFSwapInt32LittleToHost(work);
-        AJRSetOutParameter(value, work);
+    uint8_t bytes[sizeof(uint32_t)] = { 0 };
+    if ([reader readBytes:bytes length:sizeof(bytes) bytesRead:NULL error:error]) {
+        AJRSetOutParameter(value, (uint32_t)AJRDecodeUInt32(bytes, endianness));
         return YES;
     }
     return NO;
 }
 
 BOOL AJRReadInt64(id <AJRByteReader> reader, int64_t *value, AJREndianness endianness, NSError **error) {
-    int64_t work = 0;
-    if ([reader readBytes:&work length:sizeof(work) bytesRead:NULL error:error]) {
-        work = endianness == AJREndiannessBig ? CFSwapInt64BigToHost(work) : CFSwapInt64LittleToHost(work);
-        AJRSetOutParameter(value, work);
+    uint8_t bytes[sizeof(int64_t)] = { 0 };
+    if ([reader readBytes:bytes length:sizeof(bytes) bytesRead:NULL error:error]) {
+        AJRSetOutParameter(value, (int64_t)AJRDecodeUInt64(bytes, endianness));
         return YES;
     }
     return NO;
 }
 
 BOOL AJRReadUInt64(id <AJRByteReader> reader, uint64_t *value, AJREndianness endianness, NSError **error) {
-    int64_t work = 0;
-    if ([reader readBytes:&work length:sizeof(work) bytesRead:NULL error:error]) {
-        work = endianness == AJREndiannessBig ? CFSwapInt64BigToHost(work) : CFSwapInt64LittleToHost(work);
-        AJRSetOutParameter(value, work);
+    uint8_t bytes[sizeof(uint64_t)] = { 0 };
+    if ([reader readBytes:bytes length:sizeof(bytes) bytesRead:NULL error:error]) {
+        AJRSetOutParameter(value, (uint64_t)AJRDecodeUInt64(bytes, endianness));
         return YES;
     }
     return NO;
@@ -659,33 +463,39 @@ BOOL AJRWriteUInt8(id <AJRByteWriter> writer, uint8_t value, NSError **error) {
 }
 
 BOOL AJRWriteInt16(id <AJRByteWriter> writer, int16_t value, AJREndianness endianness, NSError **error) {
-    int16_t swapped = endianness == AJREndiannessBig ? CFSwapInt16HostToBig(value) : CFSwapInt16HostToLittle(value);
-    return [writer writeBytes:&swapped length:sizeof(swapped) bytesWritten:NULL error:error];
+    uint8_t bytes[sizeof(int16_t)];
+    AJREncodeUInt16(bytes, (uint16_t)value, endianness);
+    return [writer writeBytes:bytes length:sizeof(bytes) bytesWritten:NULL error:error];
 }
 
 BOOL AJRWriteUInt16(id <AJRByteWriter> writer, uint16_t value, AJREndianness endianness, NSError **error) {
-    uint16_t swapped = endianness == AJREndiannessBig ? CFSwapInt16HostToBig(value) : CFSwapInt16HostToLittle(value);
-    return [writer writeBytes:&swapped length:sizeof(swapped) bytesWritten:NULL error:error];
+    uint8_t bytes[sizeof(uint16_t)];
+    AJREncodeUInt16(bytes, (uint16_t)value, endianness);
+    return [writer writeBytes:bytes length:sizeof(bytes) bytesWritten:NULL error:error];
 }
 
 BOOL AJRWriteInt32(id <AJRByteWriter> writer, int32_t value, AJREndianness endianness, NSError **error) {
-    int32_t swapped = endianness == AJREndiannessBig ? CFSwapInt32HostToBig(value) : CFSwapInt32HostToLittle(value);
-    return [writer writeBytes:&swapped length:sizeof(swapped) bytesWritten:NULL error:error];
+    uint8_t bytes[sizeof(int32_t)];
+    AJREncodeUInt32(bytes, (uint32_t)value, endianness);
+    return [writer writeBytes:bytes length:sizeof(bytes) bytesWritten:NULL error:error];
 }
 
 BOOL AJRWriteUInt32(id <AJRByteWriter> writer, uint32_t value, AJREndianness endianness, NSError **error) {
-    uint32_t swapped = endianness == AJREndiannessBig ? CFSwapInt32HostToBig(value) : CFSwapInt32HostToLittle(value);
-    return [writer writeBytes:&swapped length:sizeof(swapped) bytesWritten:NULL error:error];
+    uint8_t bytes[sizeof(uint32_t)];
+    AJREncodeUInt32(bytes, (uint32_t)value, endianness);
+    return [writer writeBytes:bytes length:sizeof(bytes) bytesWritten:NULL error:error];
 }
 
 BOOL AJRWriteInt64(id <AJRByteWriter> writer, int64_t value, AJREndianness endianness, NSError **error) {
-    int64_t swapped = endianness == AJREndiannessBig ? CFSwapInt64HostToBig(value) : CFSwapInt64HostToLittle(value);
-    return [writer writeBytes:&swapped length:sizeof(swapped) bytesWritten:NULL error:error];
+    uint8_t bytes[sizeof(int64_t)];
+    AJREncodeUInt64(bytes, (uint64_t)value, endianness);
+    return [writer writeBytes:bytes length:sizeof(bytes) bytesWritten:NULL error:error];
 }
 
 BOOL AJRWriteUInt64(id <AJRByteWriter> writer, uint64_t value, AJREndianness endianness, NSError **error) {
-    uint64_t swapped = endianness == AJREndiannessBig ? CFSwapInt64HostToBig(value) : CFSwapInt64HostToLittle(value);
-    return [writer writeBytes:&swapped length:sizeof(swapped) bytesWritten:NULL error:error];
+    uint8_t bytes[sizeof(uint64_t)];
+    AJREncodeUInt64(bytes, (uint64_t)value, endianness);
+    return [writer writeBytes:bytes length:sizeof(bytes) bytesWritten:NULL error:error];
 }
 
 BOOL AJRWriteFloat(id <AJRByteWriter> writer, float value, NSError **error) {
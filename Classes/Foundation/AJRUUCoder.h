@@ -0,0 +1,67 @@
+/*
+ AJRUUCoder.h
+ AJRFoundation
+
+ Copyright © 2023, AJ Raftis and AJRFoundation authors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of AJRFoundation nor the names of its contributors may be
+   used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL AJ RAFTIS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import <AJRFoundation/AJRCodingStreams.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*!
+ Encodes uuencode incrementally, including the begin and end lines. The output is exactly what -[NSData ajr_uuEncodedStringWithFilename:andPosixFilePermissions:] would produce for all of the input at once. Since each line starts with its length, the encoder holds up to one line (45 bytes) of input between calls.
+ */
+@interface AJRUUEncoder : NSObject <AJRIncrementalCoder>
+
+/*! Writes a bare "begin" line, with no filename or permissions. */
+- (instancetype)init;
+- (instancetype)initWithFilename:(nullable NSString *)filename posixFilePermissions:(NSInteger)permissions;
+
+@property (nullable,nonatomic,readonly) NSString *filename;
+@property (nonatomic,readonly) NSInteger permissions;
+
+@end
+
+/*!
+ Decodes uuencode incrementally. Input is ignored until the begin line, and after the end line. Lines can be split across calls in any way.
+ */
+@interface AJRUUDecoder : NSObject <AJRIncrementalCoder>
+
+/*! The filename from the begin line, once it's been decoded. */
+@property (nullable,nonatomic,readonly) NSString *filename;
+/*! The permissions from the begin line, once it's been decoded. */
+@property (nonatomic,readonly) NSUInteger permissions;
+
+@end
+
+/*!
+ Decodes a single line of uuencoded data, less its newline, into decoded, which must have room for at least three quarters of the line's length. Returns the number of bytes decoded, or -1 if the line is malformed.
+ */
+extern NSInteger AJRDecodeUUECString(const char *characters, char *decoded, NSError * _Nullable * _Nullable error);
+
+NS_ASSUME_NONNULL_END
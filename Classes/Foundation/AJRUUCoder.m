@@ -0,0 +1,289 @@
+/*
+ AJRUUCoder.m
+ AJRFoundation
+
+ Copyright © 2023, AJ Raftis and AJRFoundation authors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of AJRFoundation nor the names of its contributors may be
+   used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL AJ RAFTIS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import "AJRUUCoder.h"
+
+#import "AJRFormat.h"
+#import "AJRFunctions.h"
+#import "NSData+Base64.h"
+#import "NSError+Extensions.h"
+
+#ifdef WIN32
+#define strcasecmp stricmp
+#define strncasecmp strnicmp
+#endif
+
+// The number of bytes encoded on each line.
+#define AJRUULineLength 45
+// The longest line the decoder will look at. Anything beyond this is dropped.
+#define AJRUUMaximumLineLength 1024
+
+//                             0000000000111111111122222222223333333333444444444455555555556666
+//                             0123456789012345678901234567890123456789012345678901234567890123
+//                             ----------------------------------------------------------------
+//                             0000000000000000111111111111111122222222222222223333333333333333
+//                             0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef
+const static char *alphabet = "`!\"#$%&'()*+,-./0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_ ";
+const static char decodeAlphabet[] = {
+    0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+    0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+    0x00,0x01,0x02,0x03,0x04,0x05,0x06,0x07,0x08,0x09,0x0A,0x0B,0x0C,0x0D,0x0E,0x0F,
+    0x10,0x11,0x12,0x13,0x14,0x15,0x16,0x17,0x18,0x19,0x1A,0x1B,0x1C,0x1D,0x1E,0x1F,
+    0x20,0x21,0x22,0x23,0x24,0x25,0x26,0x27,0x28,0x29,0x2A,0x2B,0x2C,0x2D,0x2E,0x2F,
+    0x30,0x31,0x32,0x33,0x34,0x35,0x36,0x37,0x38,0x39,0x3A,0x3B,0x3C,0x3D,0x3E,0x3F,
+    0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+    0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00
+};
+
+@implementation AJRUUEncoder {
+    BOOL _hasWrittenHeader;
+    uint8_t _line[AJRUULineLength];
+    size_t _lineLength;
+}
+
+- (instancetype)init {
+    return [self initWithFilename:nil posixFilePermissions:0644];
+}
+
+- (instancetype)initWithFilename:(NSString *)filename posixFilePermissions:(NSInteger)permissions {
+    if ((self = [super init])) {
+        _filename = [filename copy];
+        _permissions = permissions;
+    }
+    return self;
+}
+
+- (void)_appendHeaderIfNeededToData:(NSMutableData *)output {
+    if (!_hasWrittenHeader) {
+        NSString *header = _filename ? AJRFormat(@"begin %o %@", (int)_permissions, _filename) : @"begin";
+        [output appendData:[header dataUsingEncoding:NSUTF8StringEncoding]];
+        _hasWrittenHeader = YES;
+    }
+}
+
+// Each line starts with a newline, rather than ending with one, because that's how the trailer works out.
+- (void)_appendLine:(const uint8_t *)bytes length:(size_t)length toData:(NSMutableData *)output {
+    NSUInteger start = output.length;
+    size_t groups = (length + 2) / 3;
+
+    [output setLength:start + 2 + groups * 4];
+    uint8_t *coded = (uint8_t *)output.mutableBytes + start;
+
+    *coded++ = '\n';
+    *coded++ = alphabet[length];
+    for (size_t x = 0; x < length; x += 3) {
+        unsigned char c1 = bytes[x];
+        unsigned char c2 = x + 1 < length ? bytes[x + 1] : 0;
+        unsigned char c3 = x + 2 < length ? bytes[x + 2] : 0;
+
+        *coded++ = alphabet[c1 >> 2];
+        *coded++ = alphabet[((c1 << 4) & 060) | ((c2 >> 4) & 017)];
+        *coded++ = alphabet[((c2 << 2) & 074) | ((c3 >> 6) & 03)];
+        *coded++ = alphabet[(c3 & 077)];
+    }
+}
+
+- (BOOL)codeBytes:(const void *)bytes length:(size_t)length intoData:(NSMutableData *)output error:(NSError **)error {
+    const uint8_t *input = bytes;
+
+    [self _appendHeaderIfNeededToData:output];
+
+    if (_lineLength > 0) {
+        size_t count = MIN(AJRUULineLength - _lineLength, length);
+        memcpy(_line + _lineLength, input, count);
+        _lineLength += count;
+        input += count;
+        length -= count;
+        if (_lineLength < AJRUULineLength) {
+            return YES;
+        }
+        [self _appendLine:_line length:AJRUULineLength toData:output];
+        _lineLength = 0;
+    }
+
+    // Whole lines can be encoded straight from the input.
+    while (length >= AJRUULineLength) {
+        [self _appendLine:input length:AJRUULineLength toData:output];
+        input += AJRUULineLength;
+        length -= AJRUULineLength;
+    }
+
+    memcpy(_line, input, length);
+    _lineLength = length;
+
+    return YES;
+}
+
+- (BOOL)finishIntoData:(NSMutableData *)output error:(NSError **)error {
+    const char *footer = "\n`\nend\n";
+
+    [self _appendHeaderIfNeededToData:output];
+    if (_lineLength > 0) {
+        [self _appendLine:_line length:_lineLength toData:output];
+    }
+    [output appendBytes:footer length:strlen(footer)];
+
+    _hasWrittenHeader = NO;
+    _lineLength = 0;
+
+    return YES;
+}
+
+@end
+
+@implementation AJRUUDecoder {
+    char _line[AJRUUMaximumLineLength + 1];
+    size_t _lineLength;
+    BOOL _hasBegun;
+    BOOL _hasEnded;
+}
+
+// Returns NO if the line is malformed.
+- (BOOL)_decodeLineIntoData:(NSMutableData *)output error:(NSError **)error {
+    NSError *localError = nil;
+
+    _line[_lineLength] = '\0';
+    if (strncasecmp(_line, "begin ", 6) == NSOrderedSame) {
+        char filenameC[AJRUUMaximumLineLength + 1];
+        char scratch[AJRUUMaximumLineLength + 1];
+        unsigned int permissions = 0;
+
+        strcpy(filenameC, "");
+        sscanf(_line, "begin%[ \t]%o%[ \t]%[^\n]", scratch, &permissions, scratch, filenameC);
+
+        _filename = [[[NSString stringWithCString:filenameC encoding:NSUTF8StringEncoding] stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceAndNewlineCharacterSet]] lastPathComponent];
+        _permissions = permissions;
+        _hasBegun = YES;
+    } else if (strcasecmp(_line, "end") == NSOrderedSame) {
+        _hasEnded = YES;
+    } else if (_hasBegun) {
+        char decoded[AJRUUMaximumLineLength];
+        NSInteger length = AJRDecodeUUECString(_line, decoded, &localError);
+        if (length >= 0) {
+            [output appendBytes:decoded length:length];
+        }
+    }
+    _lineLength = 0;
+
+    return AJRAssertOrPropagateError(localError == nil, error, localError);
+}
+
+- (BOOL)codeBytes:(const void *)bytes length:(size_t)length intoData:(NSMutableData *)output error:(NSError **)error {
+    const char *characters = bytes;
+
+    for (size_t x = 0; x < length && !_hasEnded; x++) {
+        if (characters[x] == '\n') {
+            if (![self _decodeLineIntoData:output error:error]) {
+                return NO;
+            }
+        } else if (characters[x] != '\r' && _lineLength < AJRUUMaximumLineLength) {
+            _line[_lineLength++] = characters[x];
+        }
+    }
+
+    return YES;
+}
+
+- (BOOL)finishIntoData:(NSMutableData *)output error:(NSError **)error {
+    // A last line without a newline has never been decoded, so we don't either.
+    _lineLength = 0;
+    _hasBegun = NO;
+    _hasEnded = NO;
+    return YES;
+}
+
+@end
+
+NSInteger AJRDecodeUUECString(const char *characters, char *decoded, NSError **error) {
+    NSInteger x, y;
+    NSInteger length = strlen(characters);
+    char c1, c2, c3, c4;
+    NSError *localError = nil;
+    
+    errno = 0;
+    
+    static NSCharacterSet *alphabetSet = nil;
+    static BOOL (*isMemberFunction)(id, SEL, unichar);
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        alphabetSet = [NSCharacterSet characterSetWithCharactersInString:[NSString stringWithCString:alphabet encoding:NSASCIIStringEncoding]];
+        isMemberFunction = (BOOL (*)(id, SEL, unichar))[alphabetSet methodForSelector:@selector(characterIsMember:)];
+    });
+    
+    if (characters[0] == '`') return 0;
+    
+    for (y = 0, x = 1; x < length; ) {
+        c1 = characters[x++];
+        
+        c2 = -1;
+        if ((x < length) && isMemberFunction(alphabetSet, @selector(characterIsMember:), characters[x])) {
+            c2 = characters[x];
+            x++;
+        }
+        
+        c3 = -1;
+        if ((x < length) && isMemberFunction(alphabetSet, @selector(characterIsMember:), characters[x])) {
+            c3 = characters[x];
+            x++;
+        }
+        
+        c4 = -1;
+        if ((x < length) && isMemberFunction(alphabetSet, @selector(characterIsMember:), characters[x])) {
+            c4 = characters[x];
+            x++;
+        }
+        
+        if ((c1 != -1) && (c2 != -1)) {
+            decoded[y++] = (decodeAlphabet[(NSInteger)c1] << 2) | (decodeAlphabet[(NSInteger)c2] >> 4);
+        } else {
+            localError = [NSError errorWithDomain:AJRDataErrorDomain message:@"UUEncoded data was truncated."];
+        }
+        if (c2 != -1 && c3 != -1) {
+            decoded[y++] = (((NSInteger)decodeAlphabet[c2]) << 4) | ((NSInteger)decodeAlphabet[c3] >> 2);
+        }
+        if (c3 != -1 && c4 != -1) {
+            decoded[y++] = (((NSInteger)decodeAlphabet[c3]) << 6) | (NSInteger)decodeAlphabet[c4];
+        }
+    }
+    
+    NSInteger expectedLength = decodeAlphabet[(NSInteger)(characters[0])];
+    if (y != ceil(expectedLength / 3.0) * 3.0) {
+        localError = [NSError errorWithDomain:AJRDataErrorDomain format:@"UUEncoded data was truncated: %s", characters];
+    }
+    
+    if (localError) {
+        if (error) {
+            *error = localError;
+        }
+        return -1;
+    }
+    return expectedLength;
+}
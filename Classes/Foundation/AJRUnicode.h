@@ -77,3 +77,84 @@ extern NSInteger ustrncmp(const unichar *s1, const unichar *s2, size_t length);
 extern unichar utoupper(unichar character);
 extern unichar utolower(unichar character);
 
+NS_ASSUME_NONNULL_BEGIN
+
+#pragma mark - Transcoding
+
+/*!
+ How a transcoding or folding function finished.
+
+ @const AJRUnicodeConversionSuccess All of the input was converted.
+ @const AJRUnicodeConversionInvalidInput The input isn't well formed. Consumed is left at the start of the bad sequence, so everything before it was converted.
+ @const AJRUnicodeConversionIncompleteInput The input ends part way through a character. Everything before that character was converted, so call again with the rest of the character prepended to more input.
+ @const AJRUnicodeConversionOutputFull The output buffer filled up. The output always ends on a whole character, so call again with the rest of the input and a new buffer.
+ */
+typedef NS_ENUM(NSInteger, AJRUnicodeConversionResult) {
+    AJRUnicodeConversionSuccess,
+    AJRUnicodeConversionInvalidInput,
+    AJRUnicodeConversionIncompleteInput,
+    AJRUnicodeConversionOutputFull,
+};
+
+/*!
+ Returns the number of UTF-16 code units that length bytes of UTF-8 will convert to. This is exact for well formed input, and never less than what AJRUTF8ToUTF16() will write, so it's safe for sizing a buffer. Nothing is validated and nothing is allocated.
+ */
+extern size_t AJRUTF16LengthOfUTF8(const char *bytes, size_t length);
+
+/*!
+ Returns the number of UTF-8 bytes that length UTF-16 code units will convert to. This is exact for well formed input, and never less than what AJRUTF16ToUTF8() will write.
+ */
+extern size_t AJRUTF8LengthOfUTF16(const unichar *characters, size_t length);
+
+/*!
+ Converts UTF-8 to UTF-16 in the caller's buffer, validating as it goes. Overlong forms, encoded surrogates, and values past U+10FFFF are all rejected. Runs of ASCII are converted 16 bytes at a time with the CPU's vector unit.
+
+ @param bytes The UTF-8 to convert.
+ @param length The number of bytes.
+ @param output Where to write the UTF-16.
+ @param capacity The number of code units output has room for. AJRUTF16LengthOfUTF8() tells you how many you need.
+ @param consumed If not NULL, set to the number of bytes converted.
+ @param written If not NULL, set to the number of code units written.
+
+ @return AJRUnicodeConversionSuccess if all of the input was converted, otherwise why it stopped.
+ */
+extern AJRUnicodeConversionResult AJRUTF8ToUTF16(const char *bytes, size_t length, unichar *output, size_t capacity, size_t * _Nullable consumed, size_t * _Nullable written);
+
+/*!
+ Converts UTF-16 to UTF-8 in the caller's buffer, validating as it goes, so an unpaired surrogate is rejected. Runs of ASCII are converted with the CPU's vector unit.
+
+ @param characters The UTF-16 to convert.
+ @param length The number of code units.
+ @param output Where to write the UTF-8. No terminator is written.
+ @param capacity The number of bytes output has room for. AJRUTF8LengthOfUTF16() tells you how many you need.
+ @param consumed If not NULL, set to the number of code units converted.
+ @param written If not NULL, set to the number of bytes written.
+
+ @return AJRUnicodeConversionSuccess if all of the input was converted, otherwise why it stopped.
+ */
+extern AJRUnicodeConversionResult AJRUTF16ToUTF8(const unichar *characters, size_t length, char *output, size_t capacity, size_t * _Nullable consumed, size_t * _Nullable written);
+
+/*!
+ Returns YES if length bytes are well formed UTF-8. If not, and offset isn't NULL, it's set to the start of the first bad sequence, which may be a sequence cut off by the end of the input.
+ */
+extern BOOL AJRUTF8Validate(const char *bytes, size_t length, size_t * _Nullable offset);
+
+#pragma mark - Case Folding
+
+/*!
+ Returns the simple case folding of character, as defined by the Unicode CaseFolding.txt file (the C and S mappings). Folding is what you want when comparing or hashing without regard to case: it maps every case variant of a character to the same character, and it never changes the length of a string in UTF-16. The lookup is two table reads for characters in the BMP.
+ */
+extern UTF32Char AJRUnicodeFoldCase(UTF32Char character);
+
+/*!
+ Case folds length code units of UTF-16 into output, which may be the same buffer as characters. Simple folding never changes the number of code units, so output needs room for length. Surrogate pairs are folded as a pair, and unpaired surrogates are copied unchanged.
+ */
+extern void AJRUTF16FoldCase(const unichar *characters, size_t length, unichar *output);
+
+/*!
+ Case folds UTF-8 into the caller's buffer. Folding can change the number of bytes a character needs, though never by more than half again, so output needs room for length + length / 2 bytes to be sure to hold it all. Arguments and results are as for AJRUTF8ToUTF16().
+ */
+extern AJRUnicodeConversionResult AJRUTF8FoldCase(const char *bytes, size_t length, char *output, size_t capacity, size_t * _Nullable consumed, size_t * _Nullable written);
+
+NS_ASSUME_NONNULL_END
+
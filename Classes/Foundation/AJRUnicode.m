@@ -32,6 +32,7 @@
 #import "AJRUnicode.h"
 
 #import "AJRAutoreleasedMemory.h"
+#import "AJRFunctions.h"
 
 unichar *str2ustr(const char *string)
 {
@@ -111,9 +112,9 @@ extern UniChar toutitle(UniChar);
 
 extern unichar utoupper(unichar character) {
    if (character < 128) {
-      return (character >= 'a' && character <= 'a') ? character -= 32 : character;
+      return (character >= 'a' && character <= 'z') ? character -= 32 : character;
    }
-   return [[[NSString stringWithCharacters:&character length:1] lowercaseString] characterAtIndex:0];
+   return [[[NSString stringWithCharacters:&character length:1] uppercaseString] characterAtIndex:0];
 }
 
 extern unichar utolower(unichar character) {
@@ -122,3 +123,471 @@ extern unichar utolower(unichar character) {
    }
    return [[[NSString stringWithCharacters:&character length:1] lowercaseString] characterAtIndex:0];
 }
+
+#pragma mark - Vector Support
+
+#if defined(__x86_64__)
+#import <emmintrin.h>
+#elif defined(__aarch64__)
+#import <arm_neon.h>
+#endif
+
+// Widens as many leading ASCII bytes as it can, 16 at a time, returning how many it converted.
+static inline size_t AJRWidenASCII(const uint8_t *input, size_t length, unichar *output, size_t capacity) {
+    size_t done = 0;
+    size_t limit = MIN(length, capacity);
+#if defined(__x86_64__)
+    const __m128i zero = _mm_setzero_si128();
+    while (limit - done >= 16) {
+        __m128i bytes = _mm_loadu_si128((const __m128i *)(input + done));
+        if (_mm_movemask_epi8(bytes) != 0) {
+            break;
+        }
+        _mm_storeu_si128((__m128i *)(output + done), _mm_unpacklo_epi8(bytes, zero));
+        _mm_storeu_si128((__m128i *)(output + done + 8), _mm_unpackhi_epi8(bytes, zero));
+        done += 16;
+    }
+#elif defined(__aarch64__)
+    while (limit - done >= 16) {
+        uint8x16_t bytes = vld1q_u8(input + done);
+        if (vmaxvq_u8(bytes) >= 0x80) {
+            break;
+        }
+        vst1q_u16(output + done, vmovl_u8(vget_low_u8(bytes)));
+        vst1q_u16(output + done + 8, vmovl_high_u8(bytes));
+        done += 16;
+    }
+#endif
+    return done;
+}
+
+// Narrows as many leading ASCII code units as it can, 16 at a time, returning how many it converted.
+static inline size_t AJRNarrowASCII(const unichar *input, size_t length, uint8_t *output, size_t capacity) {
+    size_t done = 0;
+    size_t limit = MIN(length, capacity);
+#if defined(__x86_64__)
+    const __m128i mask = _mm_set1_epi16((short)0xFF80);
+    while (limit - done >= 16) {
+        __m128i low = _mm_loadu_si128((const __m128i *)(input + done));
+        __m128i high = _mm_loadu_si128((const __m128i *)(input + done + 8));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(_mm_or_si128(low, high), mask), _mm_setzero_si128())) != 0xFFFF) {
+            break;
+        }
+        _mm_storeu_si128((__m128i *)(output + done), _mm_packus_epi16(low, high));
+        done += 16;
+    }
+#elif defined(__aarch64__)
+    while (limit - done >= 16) {
+        uint16x8_t low = vld1q_u16(input + done);
+        uint16x8_t high = vld1q_u16(input + done + 8);
+        if (vmaxvq_u16(vorrq_u16(low, high)) >= 0x80) {
+            break;
+        }
+        vst1q_u8(output + done, vcombine_u8(vmovn_u16(low), vmovn_u16(high)));
+        done += 16;
+    }
+#endif
+    return done;
+}
+
+#pragma mark - Transcoding
+
+size_t AJRUTF16LengthOfUTF8(const char *bytes, size_t length) {
+    const uint8_t *input = (const uint8_t *)bytes;
+    size_t count = 0;
+    // Every byte but a continuation byte starts a character, and four byte characters need a surrogate pair. Written without branches, so the compiler vectorizes it.
+    for (size_t x = 0; x < length; x++) {
+        count += ((input[x] & 0xC0) != 0x80) + (input[x] >= 0xF0);
+    }
+    return count;
+}
+
+size_t AJRUTF8LengthOfUTF16(const unichar *characters, size_t length) {
+    size_t count = 0;
+    // Each half of a surrogate pair counts two, for four bytes a pair.
+    for (size_t x = 0; x < length; x++) {
+        unichar c = characters[x];
+        count += 1 + ((c & 0xFF80) != 0) + ((c & 0xF800) != 0) - ((c & 0xF800) == 0xD800);
+    }
+    return count;
+}
+
+// Decodes one character that doesn't start with an ASCII byte. Returns the number of bytes it used, 0 if the sequence is bad, or -1 if the input ends in the middle of an otherwise good sequence.
+static inline NSInteger AJRUTF8DecodeSequence(const uint8_t *input, size_t available, UTF32Char *character) {
+    uint8_t lead = input[0];
+    uint8_t low = 0x80, high = 0xBF;
+    NSInteger count;
+    UTF32Char value;
+
+    if (lead >= 0xC2 && lead <= 0xDF) {
+        count = 2;
+        value = lead & 0x1F;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+        count = 3;
+        value = lead & 0x0F;
+        // These rule out overlong forms and surrogates.
+        if (lead == 0xE0) {
+            low = 0xA0;
+        } else if (lead == 0xED) {
+            high = 0x9F;
+        }
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+        count = 4;
+        value = lead & 0x07;
+        // And these rule out overlong forms and values past U+10FFFF.
+        if (lead == 0xF0) {
+            low = 0x90;
+        } else if (lead == 0xF4) {
+            high = 0x8F;
+        }
+    } else {
+        return 0;
+    }
+
+    for (NSInteger x = 1; x < count; x++) {
+        if ((size_t)x >= available) {
+            return -1;
+        }
+        uint8_t next = input[x];
+        if (next < low || next > high) {
+            return 0;
+        }
+        value = (value << 6) | (next & 0x3F);
+        low = 0x80;
+        high = 0xBF;
+    }
+    *character = value;
+    return count;
+}
+
+static inline NSInteger AJRUTF8EncodeCharacter(UTF32Char character, uint8_t *output) {
+    if (character < 0x80) {
+        output[0] = (uint8_t)character;
+        return 1;
+    } else if (character < 0x800) {
+        output[0] = (uint8_t)(0xC0 | (character >> 6));
+        output[1] = (uint8_t)(0x80 | (character & 0x3F));
+        return 2;
+    } else if (character < 0x10000) {
+        output[0] = (uint8_t)(0xE0 | (character >> 12));
+        output[1] = (uint8_t)(0x80 | ((character >> 6) & 0x3F));
+        output[2] = (uint8_t)(0x80 | (character & 0x3F));
+        return 3;
+    }
+    output[0] = (uint8_t)(0xF0 | (character >> 18));
+    output[1] = (uint8_t)(0x80 | ((character >> 12) & 0x3F));
+    output[2] = (uint8_t)(0x80 | ((character >> 6) & 0x3F));
+    output[3] = (uint8_t)(0x80 | (character & 0x3F));
+    return 4;
+}
+
+static inline NSInteger AJRUTF8LengthOfCharacter(UTF32Char character) {
+    return character < 0x80 ? 1 : (character < 0x800 ? 2 : (character < 0x10000 ? 3 : 4));
+}
+
+AJRUnicodeConversionResult AJRUTF8ToUTF16(const char *bytes, size_t length, unichar *output, size_t capacity, size_t *consumed, size_t *written) {
+    const uint8_t *input = (const uint8_t *)bytes;
+    AJRUnicodeConversionResult result = AJRUnicodeConversionSuccess;
+    size_t read = 0;
+    size_t wrote = 0;
+
+    while (read < length) {
+        if (input[read] < 0x80) {
+            size_t count = AJRWidenASCII(input + read, length - read, output + wrote, capacity - wrote);
+            read += count;
+            wrote += count;
+            // Finish any short run of ASCII a byte at a time.
+            while (read < length && input[read] < 0x80 && wrote < capacity) {
+                output[wrote++] = input[read++];
+            }
+            if (read < length && input[read] < 0x80) {
+                result = AJRUnicodeConversionOutputFull;
+                break;
+            }
+            continue;
+        }
+
+        UTF32Char character = 0;
+        NSInteger count = AJRUTF8DecodeSequence(input + read, length - read, &character);
+        if (count <= 0) {
+            result = count == 0 ? AJRUnicodeConversionInvalidInput : AJRUnicodeConversionIncompleteInput;
+            break;
+        }
+        if (character >= 0x10000) {
+            if (capacity - wrote < 2) {
+                result = AJRUnicodeConversionOutputFull;
+                break;
+            }
+            character -= 0x10000;
+            output[wrote++] = (unichar)(0xD800 + (character >> 10));
+            output[wrote++] = (unichar)(0xDC00 + (character & 0x3FF));
+        } else {
+            if (wrote == capacity) {
+                result = AJRUnicodeConversionOutputFull;
+                break;
+            }
+            output[wrote++] = (unichar)character;
+        }
+        read += count;
+    }
+
+    AJRSetOutParameter(consumed, read);
+    AJRSetOutParameter(written, wrote);
+    return result;
+}
+
+AJRUnicodeConversionResult AJRUTF16ToUTF8(const unichar *characters, size_t length, char *bytes, size_t capacity, size_t *consumed, size_t *written) {
+    uint8_t *output = (uint8_t *)bytes;
+    AJRUnicodeConversionResult result = AJRUnicodeConversionSuccess;
+    size_t read = 0;
+    size_t wrote = 0;
+
+    while (read < length) {
+        unichar c = characters[read];
+        if (c < 0x80) {
+            size_t count = AJRNarrowASCII(characters + read, length - read, output + wrote, capacity - wrote);
+            read += count;
+            wrote += count;
+            while (read < length && characters[read] < 0x80 && wrote < capacity) {
+                output[wrote++] = (uint8_t)characters[read++];
+            }
+            if (read < length && characters[read] < 0x80) {
+                result = AJRUnicodeConversionOutputFull;
+                break;
+            }
+            continue;
+        }
+
+        UTF32Char character = c;
+        size_t units = 1;
+        if (CFStringIsSurrogateHighCharacter(c)) {
+            if (read + 1 == length) {
+                result = AJRUnicodeConversionIncompleteInput;
+                break;
+            }
+            if (!CFStringIsSurrogateLowCharacter(characters[read + 1])) {
+                result = AJRUnicodeConversionInvalidInput;
+                break;
+            }
+            character = CFStringGetLongCharacterForSurrogatePair(c, characters[read + 1]);
+            units = 2;
+        } else if (CFStringIsSurrogateLowCharacter(c)) {
+            result = AJRUnicodeConversionInvalidInput;
+            break;
+        }
+        if (capacity - wrote < (size_t)AJRUTF8LengthOfCharacter(character)) {
+            result = AJRUnicodeConversionOutputFull;
+            break;
+        }
+        wrote += AJRUTF8EncodeCharacter(character, output + wrote);
+        read += units;
+    }
+
+    AJRSetOutParameter(consumed, read);
+    AJRSetOutParameter(written, wrote);
+    return result;
+}
+
+BOOL AJRUTF8Validate(const char *bytes, size_t length, size_t *offset) {
+    const uint8_t *input = (const uint8_t *)bytes;
+    size_t read = 0;
+
+    while (read < length) {
+        // Skip ASCII eight bytes at a time.
+        while (length - read >= 8) {
+            uint64_t block;
+            memcpy(&block, input + read, sizeof(block));
+            if (block & UINT64_C(0x8080808080808080)) {
+                break;
+            }
+            read += 8;
+        }
+        if (read == length) {
+            break;
+        }
+        if (input[read] < 0x80) {
+            read++;
+            continue;
+        }
+        UTF32Char character;
+        NSInteger count = AJRUTF8DecodeSequence(input + read, length - read, &character);
+        if (count <= 0) {
+            AJRSetOutParameter(offset, read);
+            return NO;
+        }
+        read += count;
+    }
+
+    return YES;
+}
+
+#pragma mark - Case Folding
+
+// The simple case foldings from CaseFolding.txt (Unicode 14), as runs of characters that fold by the same delta. A stride of 2 means only every other character in the run folds, which is how the upper and lowercase pairs of many scripts alternate.
+typedef struct _ajrFoldingRange {
+    UTF32Char first;
+    UTF32Char last;
+    int32_t delta;
+    uint8_t stride;
+} AJRFoldingRange;
+
+static const AJRFoldingRange AJRFoldingRanges[] = {
+    { 0x0041, 0x005A, 32, 1 }, { 0x00B5, 0x00B5, 775, 1 }, { 0x00C0, 0x00D6, 32, 1 }, { 0x00D8, 0x00DE, 32, 1 },
+    { 0x0100, 0x012E, 1, 2 }, { 0x0132, 0x0136, 1, 2 }, { 0x0139, 0x0147, 1, 2 }, { 0x014A, 0x0176, 1, 2 },
+    { 0x0178, 0x0178, -121, 1 }, { 0x0179, 0x017D, 1, 2 }, { 0x017F, 0x017F, -268, 1 }, { 0x0181, 0x0181, 210, 1 },
+    { 0x0182, 0x0184, 1, 2 }, { 0x0186, 0x0186, 206, 1 }, { 0x0187, 0x0187, 1, 1 }, { 0x0189, 0x018A, 205, 1 },
+    { 0x018B, 0x018B, 1, 1 }, { 0x018E, 0x018E, 79, 1 }, { 0x018F, 0x018F, 202, 1 }, { 0x0190, 0x0190, 203, 1 },
+    { 0x0191, 0x0191, 1, 1 }, { 0x0193, 0x0193, 205, 1 }, { 0x0194, 0x0194, 207, 1 }, { 0x0196, 0x0196, 211, 1 },
+    { 0x0197, 0x0197, 209, 1 }, { 0x0198, 0x0198, 1, 1 }, { 0x019C, 0x019C, 211, 1 }, { 0x019D, 0x019D, 213, 1 },
+    { 0x019F, 0x019F, 214, 1 }, { 0x01A0, 0x01A4, 1, 2 }, { 0x01A6, 0x01A6, 218, 1 }, { 0x01A7, 0x01A7, 1, 1 },
+    { 0x01A9, 0x01A9, 218, 1 }, { 0x01AC, 0x01AC, 1, 1 }, { 0x01AE, 0x01AE, 218, 1 }, { 0x01AF, 0x01AF, 1, 1 },
+    { 0x01B1, 0x01B2, 217, 1 }, { 0x01B3, 0x01B5, 1, 2 }, { 0x01B7, 0x01B7, 219, 1 }, { 0x01B8, 0x01B8, 1, 1 },
+    { 0x01BC, 0x01BC, 1, 1 }, { 0x01C4, 0x01C4, 2, 1 }, { 0x01C5, 0x01C5, 1, 1 }, { 0x01C7, 0x01C7, 2, 1 },
+    { 0x01C8, 0x01C8, 1, 1 }, { 0x01CA, 0x01CA, 2, 1 }, { 0x01CB, 0x01DB, 1, 2 }, { 0x01DE, 0x01EE, 1, 2 },
+    { 0x01F1, 0x01F1, 2, 1 }, { 0x01F2, 0x01F4, 1, 2 }, { 0x01F6, 0x01F6, -97, 1 }, { 0x01F7, 0x01F7, -56, 1 },
+    { 0x01F8, 0x021E, 1, 2 }, { 0x0220, 0x0220, -130, 1 }, { 0x0222, 0x0232, 1, 2 }, { 0x023A, 0x023A, 10795, 1 },
+    { 0x023B, 0x023B, 1, 1 }, { 0x023D, 0x023D, -163, 1 }, { 0x023E, 0x023E, 10792, 1 }, { 0x0241, 0x0241, 1, 1 },
+    { 0x0243, 0x0243, -195, 1 }, { 0x0244, 0x0244, 69, 1 }, { 0x0245, 0x0245, 71, 1 }, { 0x0246, 0x024E, 1, 2 },
+    { 0x0345, 0x0345, 116, 1 }, { 0x0370, 0x0372, 1, 2 }, { 0x0376, 0x0376, 1, 1 }, { 0x037F, 0x037F, 116, 1 },
+    { 0x0386, 0x0386, 38, 1 }, { 0x0388, 0x038A, 37, 1 }, { 0x038C, 0x038C, 64, 1 }, { 0x038E, 0x038F, 63, 1 },
+    { 0x0391, 0x03A1, 32, 1 }, { 0x03A3, 0x03AB, 32, 1 }, { 0x03C2, 0x03C2, 1, 1 }, { 0x03CF, 0x03CF, 8, 1 },
+    { 0x03D0, 0x03D0, -30, 1 }, { 0x03D1, 0x03D1, -25, 1 }, { 0x03D5, 0x03D5, -15, 1 }, { 0x03D6, 0x03D6, -22, 1 },
+    { 0x03D8, 0x03EE, 1, 2 }, { 0x03F0, 0x03F0, -54, 1 }, { 0x03F1, 0x03F1, -48, 1 }, { 0x03F4, 0x03F4, -60, 1 },
+    { 0x03F5, 0x03F5, -64, 1 }, { 0x03F7, 0x03F7, 1, 1 }, { 0x03F9, 0x03F9, -7, 1 }, { 0x03FA, 0x03FA, 1, 1 },
+    { 0x03FD, 0x03FF, -130, 1 }, { 0x0400, 0x040F, 80, 1 }, { 0x0410, 0x042F, 32, 1 }, { 0x0460, 0x0480, 1, 2 },
+    { 0x048A, 0x04BE, 1, 2 }, { 0x04C0, 0x04C0, 15, 1 }, { 0x04C1, 0x04CD, 1, 2 }, { 0x04D0, 0x052E, 1, 2 },
+    { 0x0531, 0x0556, 48, 1 }, { 0x10A0, 0x10C5, 7264, 1 }, { 0x10C7, 0x10C7, 7264, 1 }, { 0x10CD, 0x10CD, 7264, 1 },
+    { 0x13F8, 0x13FD, -8, 1 }, { 0x1C80, 0x1C80, -6222, 1 }, { 0x1C81, 0x1C81, -6221, 1 }, { 0x1C82, 0x1C82, -6212, 1 },
+    { 0x1C83, 0x1C84, -6210, 1 }, { 0x1C85, 0x1C85, -6211, 1 }, { 0x1C86, 0x1C86, -6204, 1 }, { 0x1C87, 0x1C87, -6180, 1 },
+    { 0x1C88, 0x1C88, 35267, 1 }, { 0x1C90, 0x1CBA, -3008, 1 }, { 0x1CBD, 0x1CBF, -3008, 1 }, { 0x1E00, 0x1E94, 1, 2 },
+    { 0x1E9B, 0x1E9B, -58, 1 }, { 0x1E9E, 0x1E9E, -7615, 1 }, { 0x1EA0, 0x1EFE, 1, 2 }, { 0x1F08, 0x1F0F, -8, 1 },
+    { 0x1F18, 0x1F1D, -8, 1 }, { 0x1F28, 0x1F2F, -8, 1 }, { 0x1F38, 0x1F3F, -8, 1 }, { 0x1F48, 0x1F4D, -8, 1 },
+    { 0x1F59, 0x1F5F, -8, 2 }, { 0x1F68, 0x1F6F, -8, 1 }, { 0x1F88, 0x1F8F, -8, 1 }, { 0x1F98, 0x1F9F, -8, 1 },
+    { 0x1FA8, 0x1FAF, -8, 1 }, { 0x1FB8, 0x1FB9, -8, 1 }, { 0x1FBA, 0x1FBB, -74, 1 }, { 0x1FBC, 0x1FBC, -9, 1 },
+    { 0x1FBE, 0x1FBE, -7173, 1 }, { 0x1FC8, 0x1FCB, -86, 1 }, { 0x1FCC, 0x1FCC, -9, 1 }, { 0x1FD8, 0x1FD9, -8, 1 },
+    { 0x1FDA, 0x1FDB, -100, 1 }, { 0x1FE8, 0x1FE9, -8, 1 }, { 0x1FEA, 0x1FEB, -112, 1 }, { 0x1FEC, 0x1FEC, -7, 1 },
+    { 0x1FF8, 0x1FF9, -128, 1 }, { 0x1FFA, 0x1FFB, -126, 1 }, { 0x1FFC, 0x1FFC, -9, 1 }, { 0x2126, 0x2126, -7517, 1 },
+    { 0x212A, 0x212A, -8383, 1 }, { 0x212B, 0x212B, -8262, 1 }, { 0x2132, 0x2132, 28, 1 }, { 0x2160, 0x216F, 16, 1 },
+    { 0x2183, 0x2183, 1, 1 }, { 0x24B6, 0x24CF, 26, 1 }, { 0x2C00, 0x2C2F, 48, 1 }, { 0x2C60, 0x2C60, 1, 1 },
+    { 0x2C62, 0x2C62, -10743, 1 }, { 0x2C63, 0x2C63, -3814, 1 }, { 0x2C64, 0x2C64, -10727, 1 }, { 0x2C67, 0x2C6B, 1, 2 },
+    { 0x2C6D, 0x2C6D, -10780, 1 }, { 0x2C6E, 0x2C6E, -10749, 1 }, { 0x2C6F, 0x2C6F, -10783, 1 }, { 0x2C70, 0x2C70, -10782, 1 },
+    { 0x2C72, 0x2C72, 1, 1 }, { 0x2C75, 0x2C75, 1, 1 }, { 0x2C7E, 0x2C7F, -10815, 1 }, { 0x2C80, 0x2CE2, 1, 2 },
+    { 0x2CEB, 0x2CED, 1, 2 }, { 0x2CF2, 0x2CF2, 1, 1 }, { 0xA640, 0xA66C, 1, 2 }, { 0xA680, 0xA69A, 1, 2 },
+    { 0xA722, 0xA72E, 1, 2 }, { 0xA732, 0xA76E, 1, 2 }, { 0xA779, 0xA77B, 1, 2 }, { 0xA77D, 0xA77D, -35332, 1 },
+    { 0xA77E, 0xA786, 1, 2 }, { 0xA78B, 0xA78B, 1, 1 }, { 0xA78D, 0xA78D, -42280, 1 }, { 0xA790, 0xA792, 1, 2 },
+    { 0xA796, 0xA7A8, 1, 2 }, { 0xA7AA, 0xA7AA, -42308, 1 }, { 0xA7AB, 0xA7AB, -42319, 1 }, { 0xA7AC, 0xA7AC, -42315, 1 },
+    { 0xA7AD, 0xA7AD, -42305, 1 }, { 0xA7AE, 0xA7AE, -42308, 1 }, { 0xA7B0, 0xA7B0, -42258, 1 }, { 0xA7B1, 0xA7B1, -42282, 1 },
+    { 0xA7B2, 0xA7B2, -42261, 1 }, { 0xA7B3, 0xA7B3, 928, 1 }, { 0xA7B4, 0xA7C2, 1, 2 }, { 0xA7C4, 0xA7C4, -48, 1 },
+    { 0xA7C5, 0xA7C5, -42307, 1 }, { 0xA7C6, 0xA7C6, -35384, 1 }, { 0xA7C7, 0xA7C9, 1, 2 }, { 0xA7D0, 0xA7D0, 1, 1 },
+    { 0xA7D6, 0xA7D8, 1, 2 }, { 0xA7F5, 0xA7F5, 1, 1 }, { 0xAB70, 0xABBF, -38864, 1 }, { 0xFF21, 0xFF3A, 32, 1 },
+    { 0x10400, 0x10427, 40, 1 }, { 0x104B0, 0x104D3, 40, 1 }, { 0x10570, 0x1057A, 39, 1 }, { 0x1057C, 0x1058A, 39, 1 },
+    { 0x1058C, 0x10592, 39, 1 }, { 0x10594, 0x10595, 39, 1 }, { 0x10C80, 0x10CB2, 64, 1 }, { 0x118A0, 0x118BF, 32, 1 },
+    { 0x16E40, 0x16E5F, 32, 1 }, { 0x1E900, 0x1E921, 34, 1 },
+};
+
+// For the BMP, the ranges are expanded into a two level table of deltas. Most blocks of 256 characters don't fold at all and share block 0, which is all zeros.
+static uint8_t AJRFoldingBlockIndexes[256];
+static uint16_t (*AJRFoldingBlocks)[256];
+static NSInteger AJRFoldingSupplementaryStart;
+
+static void AJRFoldingInitialize(void) {
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        NSInteger blockCount = 1;
+        for (NSInteger x = 0; x < AJRCountOf(AJRFoldingRanges) && AJRFoldingRanges[x].first < 0x10000; x++) {
+            for (NSInteger block = AJRFoldingRanges[x].first >> 8; block <= AJRFoldingRanges[x].last >> 8; block++) {
+                if (AJRFoldingBlockIndexes[block] == 0) {
+                    AJRFoldingBlockIndexes[block] = blockCount++;
+                }
+            }
+            AJRFoldingSupplementaryStart = x + 1;
+        }
+        AJRFoldingBlocks = calloc(blockCount, sizeof(*AJRFoldingBlocks));
+        for (NSInteger x = 0; x < AJRFoldingSupplementaryStart; x++) {
+            const AJRFoldingRange *range = &AJRFoldingRanges[x];
+            for (UTF32Char character = range->first; character <= range->last; character += range->stride) {
+                AJRFoldingBlocks[AJRFoldingBlockIndexes[character >> 8]][character & 0xFF] = (uint16_t)range->delta;
+            }
+        }
+    });
+}
+
+static inline unichar AJRFoldBMPCharacter(unichar character) {
+    // The deltas wrap modulo 65536, which lets a 16 bit table hold negative deltas, and every BMP character folds to another BMP character.
+    return (unichar)(character + AJRFoldingBlocks[AJRFoldingBlockIndexes[character >> 8]][character & 0xFF]);
+}
+
+UTF32Char AJRUnicodeFoldCase(UTF32Char character) {
+    AJRFoldingInitialize();
+
+    if (character < 0x10000) {
+        return AJRFoldBMPCharacter((unichar)character);
+    }
+    for (NSInteger x = AJRFoldingSupplementaryStart; x < AJRCountOf(AJRFoldingRanges); x++) {
+        const AJRFoldingRange *range = &AJRFoldingRanges[x];
+        if (character >= range->first && character <= range->last) {
+            return (character - range->first) % range->stride == 0 ? character + range->delta : character;
+        }
+    }
+    return character;
+}
+
+void AJRUTF16FoldCase(const unichar *characters, size_t length, unichar *output) {
+    AJRFoldingInitialize();
+
+    for (size_t x = 0; x < length; x++) {
+        unichar c = characters[x];
+        if (c < 0x80) {
+            output[x] = c + ((unichar)(c - 'A') < 26 ? 0x20 : 0);
+        } else if (CFStringIsSurrogateHighCharacter(c) && x + 1 < length && CFStringIsSurrogateLowCharacter(characters[x + 1])) {
+            UTF32Char folded = AJRUnicodeFoldCase(CFStringGetLongCharacterForSurrogatePair(c, characters[x + 1]));
+            UTF16Char surrogates[2];
+            CFStringGetSurrogatePairForLongCharacter(folded, surrogates);
+            output[x] = surrogates[0];
+            output[x + 1] = surrogates[1];
+            x++;
+        } else {
+            output[x] = AJRFoldBMPCharacter(c);
+        }
+    }
+}
+
+AJRUnicodeConversionResult AJRUTF8FoldCase(const char *bytes, size_t length, char *outputBytes, size_t capacity, size_t *consumed, size_t *written) {
+    const uint8_t *input = (const uint8_t *)bytes;
+    uint8_t *output = (uint8_t *)outputBytes;
+    AJRUnicodeConversionResult result = AJRUnicodeConversionSuccess;
+    size_t read = 0;
+    size_t wrote = 0;
+
+    AJRFoldingInitialize();
+    while (read < length) {
+        uint8_t c = input[read];
+        if (c < 0x80) {
+            if (wrote == capacity) {
+                result = AJRUnicodeConversionOutputFull;
+                break;
+            }
+            output[wrote++] = c + ((uint8_t)(c - 'A') < 26 ? 0x20 : 0);
+            read++;
+            continue;
+        }
+
+        UTF32Char character = 0;
+        NSInteger count = AJRUTF8DecodeSequence(input + read, length - read, &character);
+        if (count <= 0) {
+            result = count == 0 ? AJRUnicodeConversionInvalidInput : AJRUnicodeConversionIncompleteInput;
+            break;
+        }
+        character = AJRUnicodeFoldCase(character);
+        if (capacity - wrote < (size_t)AJRUTF8LengthOfCharacter(character)) {
+            result = AJRUnicodeConversionOutputFull;
+            break;
+        }
+        wrote += AJRUTF8EncodeCharacter(character, output + wrote);
+        read += count;
+    }
+
+    AJRSetOutParameter(consumed, read);
+    AJRSetOutParameter(written, wrote);
+    return result;
+}
@@ -102,65 +102,55 @@ public extension Data {
         return string
     }
 
-    @inlinable
-    internal static func hexNibbleToInt(_ nibble: UInt8) -> UInt8? {
-        if nibble >= 65 && nibble <= 70 {
-            return nibble - 55
-        }
-        if nibble >= 97 && nibble <= 102 {
-            return nibble - 87
-        }
-        if nibble >= 48 && nibble <= 57 {
-            return nibble - 48
-        }
-        return nil
-    }
-
     init?(hexString hex: String) {
-        if let ascii = hex.data(using: .ascii) {
-            let length = ascii.count
-            if length % 2 != 0 {
-                // We have to have two digits per
+        var hex = hex
+        let decoded : Data? = hex.withUTF8 { characters in
+            if characters.count % 2 != 0 {
+                // We have to have two digits per byte.
                 return nil
             }
-            var buffer = [UInt8](repeating: 0, count: length / 2)
-
-            for index in stride(from: 0, to: length, by: 2) {
-                if let hiNibble = Data.hexNibbleToInt(ascii[index]),
-                   let loNibble = Data.hexNibbleToInt(ascii[index + 1]) {
-                    buffer[index / 2] = hiNibble * 16 + loNibble
-                } else {
-                    return nil
-                }
+            guard let base = characters.baseAddress else {
+                return Data()
             }
-            self.init(buffer)
+            var data = Data(count: characters.count / 2)
+            var consumed = 0
+            data.withUnsafeMutableBytes { output in
+                _ = AJRHexDecodeCharacters(UnsafeRawPointer(base).assumingMemoryBound(to: CChar.self), characters.count, output.baseAddress!.assumingMemoryBound(to: UInt8.self), &consumed)
+            }
+            return consumed == characters.count ? data : nil
+        }
+        if let decoded = decoded {
+            self = decoded
         } else {
             return nil
         }
     }
 
-    static internal func nibble<T:BinaryInteger>(_ nibble: T) -> T? {
-        if nibble < 10 {
-            return nibble + 48
-        }
-        if nibble < 16 {
-            return nibble + 55
-        }
-        return nil
+    /**
+     A string representing the Data as hex numbers, using uppercase digits.
+
+     This has always been uppercase, so it stays that way, even though `-[NSData ajr_hexEncodedString]` defaults to lowercase. Use `hexString(uppercase:)` when the case matters.
+     */
+    var hexString : String {
+        return hexString(uppercase: true)
     }
 
     /**
      A string representing the Data as hex numbers.
-     */
-    var hexString : String {
-        var raw = Data(repeating: 0, count: count * 2)
 
-        for (index, byte) in self.enumerated() {
-            raw[index * 2 + 0] = Data.nibble((byte & 0xF0) >> 4)!
-            raw[index * 2 + 1] = Data.nibble((byte & 0x0F) >> 0)!
-        }
+     - parameter uppercase: If `true`, use A-F, otherwise use a-f.
 
-        return String(data: raw, encoding: .ascii)!
+     - returns: The bytes of the data as pairs of hex digits.
+     */
+    func hexString(uppercase: Bool) -> String {
+        return withUnsafeBytes { bytes in
+            guard let base = bytes.baseAddress else {
+                return ""
+            }
+            return String(unsafeUninitializedCapacity: bytes.count * 2) { characters in
+                return AJRHexEncodeBytes(base.assumingMemoryBound(to: UInt8.self), bytes.count, uppercase, UnsafeMutableRawPointer(characters.baseAddress!).assumingMemoryBound(to: CChar.self))
+            }
+        }
     }
 
     /**
@@ -51,4 +51,24 @@ extern const NSInteger AJRBase64NoLineBreak;
 extern NSString *AJRBase64EncodedString(const uint8_t *bytes, NSInteger length, NSRange subrange, NSInteger lineBreakPosition);
 extern NSError * _Nullable AJRBase64DecodedBytes(NSString * _Nonnull string, uint8_t * _Nonnull * _Nullable bytesOut, NSInteger * _Nonnull lengthOut);
 
+/// Returns the number of characters AJRBase64EncodeBytes() will write for length bytes, including any line breaks.
+extern size_t AJRBase64EncodedLength(size_t length, NSInteger lineBreakPosition);
+/// Encodes length bytes into output, which must have room for AJRBase64EncodedLength() characters. A line break is written after every lineBreakPosition quanta, or never if lineBreakPosition is AJRBase64NoLineBreak. Returns the number of characters written. Uses the CPU's vector unit when one is available.
+extern size_t AJRBase64EncodeBytes(const uint8_t *bytes, size_t length, NSInteger lineBreakPosition, char *output);
+/// Returns the largest number of bytes AJRBase64DecodeCharacters() can write for length characters.
+extern size_t AJRBase64MaximumDecodedLength(size_t length);
+/// Decodes length characters into output, which must have room for AJRBase64MaximumDecodedLength() bytes. Characters outside of the alphabet, including whitespace and padding, are skipped. Returns NO if the input ends one character into a quantum, which can't produce a byte.
+extern BOOL AJRBase64DecodeCharacters(const char *characters, size_t length, uint8_t *output, size_t * _Nullable outputLength);
+
+/// The part of a quantum that AJRBase64DecodeCharactersWithState() couldn't finish, carried over to the next call.
+typedef struct _ajrBase64DecodeState {
+    uint32_t accumulator;
+    NSInteger pending;
+} AJRBase64DecodeState;
+
+/// Decodes length characters, starting from and updating state, so that input can be decoded in arbitrary pieces. Only whole quanta are written, so output must have room for AJRBase64MaximumDecodedLength(length + 3) bytes. Returns the number of bytes written.
+extern size_t AJRBase64DecodeCharactersWithState(const char *characters, size_t length, uint8_t *output, AJRBase64DecodeState *state);
+/// Writes the last, partial quantum left in state, which is at most two bytes, and resets state. Returns NO if the quantum was truncated.
+extern BOOL AJRBase64FinishDecoding(AJRBase64DecodeState *state, uint8_t *output, size_t * _Nullable outputLength);
+
 NS_ASSUME_NONNULL_END
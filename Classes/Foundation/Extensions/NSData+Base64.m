@@ -35,29 +35,16 @@
 #import "NSError+Extensions.h"
 #import "NSNumber+Extensions.h"
 
-//static NSArray        *magic = nil;
+#if defined(__x86_64__)
+#import <immintrin.h>
+#elif defined(__aarch64__)
+#import <arm_neon.h>
+#endif
 
 NSString * const AJRDataErrorDomain = @"AJRDataErrorDomain";
 
 @implementation NSData (Base64)
 
-//                             0000000000111111111122222222223333333333444444444455555555556666
-//                             0123456789012345678901234567890123456789012345678901234567890123
-//                             ----------------------------------------------------------------
-//                             0000000000000000111111111111111122222222222222223333333333333333
-//                             0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef
-const static char *alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
-const static char decodeAlphabet[] = {
-    0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
-    0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
-    0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x3e,0x00,0x00,0x00,0x3f,
-    0x34,0x35,0x36,0x37,0x38,0x39,0x3a,0x3b,0x3c,0x3d,0x00,0x00,0x00,0x00,0x00,0x00,
-    0x00,0x00,0x01,0x02,0x03,0x04,0x05,0x06,0x07,0x08,0x09,0x0a,0x0b,0x0c,0x0d,0x0e,
-    0x0f,0x10,0x11,0x12,0x13,0x14,0x15,0x16,0x17,0x18,0x19,0x00,0x00,0x00,0x00,0x00,
-    0x00,0x1a,0x1b,0x1c,0x1d,0x1e,0x1f,0x20,0x21,0x22,0x23,0x24,0x25,0x26,0x27,0x28,
-    0x29,0x2a,0x2b,0x2c,0x2d,0x2e,0x2f,0x30,0x31,0x32,0x33,0x00,0x00,0x00,0x00,0x00
-};
-
 - (NSString *)ajr_base64EncodedString {
 	return [self ajr_base64EncodedStringInRange:(NSRange){0, [self length]}];
 }
@@ -95,114 +82,461 @@ const static char decodeAlphabet[] = {
 
 const NSInteger AJRBase64NoLineBreak = 0;
 
-NSString *AJRBase64EncodedString(const uint8_t *bytes, NSInteger length, NSRange subrange, NSInteger lineBreakPosition) {
-    NSInteger x, y;
-    unsigned char *coded;
-    NSInteger count = 0;
-    
-    coded = (unsigned char *)NSZoneCalloc(NSDefaultMallocZone(), length * 2, sizeof(char));
-    
-    for (x = subrange.location, y = 0; x < NSMaxRange(subrange) && x < length; x += 3) {
-        coded[y++] = alphabet[bytes[x] >> 2];
-        if (x + 1 < length) {
-            coded[y++] = alphabet[((bytes[x] & 0x03) << 4) | (bytes[x + 1] >> 4)];
-            if (x + 2 < length) {
-                // 12-15-98 AJR (none) This had an additional if that prevented the last byte from being encoded when the length of the original bytes was a multiple of 3.
-                coded[y++] = alphabet[((bytes[x + 1] & 0x0F) << 2) | (bytes[x + 2] >> 6)];
-                coded[y++] = alphabet[(bytes[x + 2] & 0x3F)];
-            } else {
-                coded[y++] = alphabet[(bytes[x + 1] & 0x0F) << 2];
-                coded[y++] = '=';
-            }
-        } else {
-            coded[y++] = alphabet[(bytes[x] & 0x03) << 4];
-            coded[y++] = '=';
-        }
-        if (lineBreakPosition != AJRBase64NoLineBreak) {
-            count = (count + 1) % lineBreakPosition;
-            if (count == 0) {
-                coded[y++] = '\n';
-            }
+#pragma mark - Tables
+
+//                                      0000000000111111111122222222223333333333444444444455555555556666
+//                                      0123456789012345678901234567890123456789012345678901234567890123
+//                                      ----------------------------------------------------------------
+//                                      0000000000000000111111111111111122222222222222223333333333333333
+//                                      0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef
+static const char AJRBase64Alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+#define AJRBase64Invalid 0xFF
+
+// Maps every byte to its value in the alphabet, or to AJRBase64Invalid. The decoder skips invalid characters, so this one table also serves as the whitespace filter. Note that '=' is invalid as well, which is how padding gets skipped.
+static const uint8_t AJRBase64DecodeTable[256] = {
+    0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,
+    0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,
+    0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0x3e,0xff,0xff,0xff,0x3f,
+    0x34,0x35,0x36,0x37,0x38,0x39,0x3a,0x3b,0x3c,0x3d,0xff,0xff,0xff,0xff,0xff,0xff,
+    0xff,0x00,0x01,0x02,0x03,0x04,0x05,0x06,0x07,0x08,0x09,0x0a,0x0b,0x0c,0x0d,0x0e,
+    0x0f,0x10,0x11,0x12,0x13,0x14,0x15,0x16,0x17,0x18,0x19,0xff,0xff,0xff,0xff,0xff,
+    0xff,0x1a,0x1b,0x1c,0x1d,0x1e,0x1f,0x20,0x21,0x22,0x23,0x24,0x25,0x26,0x27,0x28,
+    0x29,0x2a,0x2b,0x2c,0x2d,0x2e,0x2f,0x30,0x31,0x32,0x33,0xff,0xff,0xff,0xff,0xff,
+    0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,
+    0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,
+    0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,
+    0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,
+    0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,
+    0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,
+    0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,
+    0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff
+};
+
+// The two characters for every 12 bit value, so the scalar encoder does two lookups per three bytes rather than four.
+static char AJRBase64EncodePairs[4096][2];
+
+#pragma mark - Vector Implementations
+
+// Encodes as many whole groups of three bytes as it can, returning the number of groups encoded. The caller finishes the rest.
+typedef size_t (*AJRBase64EncodeGroupsFunction)(const uint8_t *input, size_t groups, char *output);
+// Decodes blocks of characters for as long as every character in a block is in the alphabet. Returns the number of bytes written, and sets consumed to the number of characters read.
+typedef size_t (*AJRBase64DecodeBlocksFunction)(const uint8_t *input, size_t length, uint8_t *output, size_t *consumed);
+
+static AJRBase64EncodeGroupsFunction AJRBase64EncodeVector = NULL;
+static AJRBase64DecodeBlocksFunction AJRBase64DecodeVector = NULL;
+
+#if defined(__x86_64__)
+
+// These follow Wojciech Muła's and Daniel Lemire's SIMD base64 algorithms. Each lane of 12 bytes is spread over 16 bytes, split into sextets with two multiplies, and then the sextets are mapped onto the alphabet with a 16 entry table indexed by range.
+
+__attribute__((target("ssse3")))
+static inline __m128i AJRBase64EncodeSSSE3Lane(__m128i input) {
+    input = _mm_shuffle_epi8(input, _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+    __m128i t0 = _mm_and_si128(input, _mm_set1_epi32(0x0fc0fc00));
+    __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+    __m128i t2 = _mm_and_si128(input, _mm_set1_epi32(0x003f03f0));
+    __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+    __m128i indices = _mm_or_si128(t1, t3);
+
+    __m128i offsets = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+    __m128i isUppercase = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+    offsets = _mm_or_si128(offsets, _mm_and_si128(isUppercase, _mm_set1_epi8(13)));
+    __m128i shifts = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+    return _mm_add_epi8(_mm_shuffle_epi8(shifts, offsets), indices);
+}
+
+__attribute__((target("ssse3")))
+static size_t AJRBase64EncodeGroupsSSSE3(const uint8_t *input, size_t groups, char *output) {
+    size_t done = 0;
+    // Each step reads 16 bytes, but only uses 12 of them.
+    while (groups - done >= 6) {
+        __m128i characters = AJRBase64EncodeSSSE3Lane(_mm_loadu_si128((const __m128i *)(input + done * 3)));
+        _mm_storeu_si128((__m128i *)(output + done * 4), characters);
+        done += 4;
+    }
+    return done;
+}
+
+__attribute__((target("avx2")))
+static size_t AJRBase64EncodeGroupsAVX2(const uint8_t *input, size_t groups, char *output) {
+    const __m256i spread = _mm256_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10, 1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+    const __m256i shifts = _mm256_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0,
+                                            'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+    size_t done = 0;
+    // Each step reads 28 bytes, but only uses 24 of them.
+    while (groups - done >= 10) {
+        const uint8_t *bytes = input + done * 3;
+        __m256i lanes = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)bytes)), _mm_loadu_si128((const __m128i *)(bytes + 12)), 1);
+        lanes = _mm256_shuffle_epi8(lanes, spread);
+        __m256i t0 = _mm256_and_si256(lanes, _mm256_set1_epi32(0x0fc0fc00));
+        __m256i t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+        __m256i t2 = _mm256_and_si256(lanes, _mm256_set1_epi32(0x003f03f0));
+        __m256i t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+        __m256i indices = _mm256_or_si256(t1, t3);
+
+        __m256i offsets = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+        __m256i isUppercase = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+        offsets = _mm256_or_si256(offsets, _mm256_and_si256(isUppercase, _mm256_set1_epi8(13)));
+        _mm256_storeu_si256((__m256i *)(output + done * 4), _mm256_add_epi8(_mm256_shuffle_epi8(shifts, offsets), indices));
+        done += 8;
+    }
+    return done;
+}
+
+// Maps 16 characters onto their sextets. Returns NO if any character isn't in the alphabet.
+__attribute__((target("ssse3")))
+static inline BOOL AJRBase64DecodeSSSE3Lane(__m128i characters, __m128i *sextets) {
+    const __m128i lowTable = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m128i highTable = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m128i rollTable = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i mask = _mm_set1_epi8(0x2F);
+
+    __m128i highNibbles = _mm_and_si128(_mm_srli_epi32(characters, 4), mask);
+    __m128i lowNibbles = _mm_and_si128(characters, mask);
+    __m128i low = _mm_shuffle_epi8(lowTable, lowNibbles);
+    __m128i high = _mm_shuffle_epi8(highTable, highNibbles);
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(low, high), _mm_setzero_si128())) != 0xFFFF) {
+        return NO;
+    }
+    __m128i isSlash = _mm_cmpeq_epi8(characters, mask);
+    *sextets = _mm_add_epi8(characters, _mm_shuffle_epi8(rollTable, _mm_add_epi8(isSlash, highNibbles)));
+    return YES;
+}
+
+// Packs 16 sextets into 12 bytes, in the low 12 bytes of the result.
+__attribute__((target("ssse3")))
+static inline __m128i AJRBase64PackSSSE3Lane(__m128i sextets) {
+    __m128i pairs = _mm_maddubs_epi16(sextets, _mm_set1_epi32(0x01400140));
+    __m128i quads = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+    return _mm_shuffle_epi8(quads, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+}
+
+__attribute__((target("ssse3")))
+static size_t AJRBase64DecodeBlocksSSSE3(const uint8_t *input, size_t length, uint8_t *output, size_t *consumed) {
+    size_t read = 0;
+    size_t written = 0;
+    while (length - read >= 16) {
+        __m128i sextets;
+        if (!AJRBase64DecodeSSSE3Lane(_mm_loadu_si128((const __m128i *)(input + read)), &sextets)) {
+            break;
         }
+        __m128i bytes = AJRBase64PackSSSE3Lane(sextets);
+        // Store exactly 12 bytes, so the caller doesn't need to leave any slack in the output.
+        _mm_storel_epi64((__m128i *)(output + written), bytes);
+        uint32_t last = (uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(bytes, 8));
+        memcpy(output + written + 8, &last, sizeof(last));
+        read += 16;
+        written += 12;
     }
-    
-    return [[NSString alloc] initWithBytesNoCopy:(char *)coded length:y encoding:NSASCIIStringEncoding freeWhenDone:YES];
+    *consumed = read;
+    return written;
 }
 
-NSError *AJRBase64DecodedBytes(NSString *string, uint8_t **bytesOut, NSInteger *lengthOut) {
-    const char *characters = [string UTF8String];
-    NSInteger x, y;
-    uint8_t *decoded;
-    NSInteger length = strlen(characters);
-    char c1, c2, c3, c4;
-    NSError *localError = nil;
-    
-    static NSCharacterSet *alphabetSet = nil;
-    static BOOL (*isMemberFunction)(id, SEL, unichar);
-    static dispatch_once_t onceToken;
-    dispatch_once(&onceToken, ^{
-        alphabetSet = [NSCharacterSet characterSetWithCharactersInString:[NSString stringWithCString:alphabet encoding:NSASCIIStringEncoding]];
-        isMemberFunction = (BOOL (*)(id, SEL, unichar))[alphabetSet methodForSelector:@selector(characterIsMember:)];
-    });
+__attribute__((target("avx2")))
+static size_t AJRBase64DecodeBlocksAVX2(const uint8_t *input, size_t length, uint8_t *output, size_t *consumed) {
+    const __m256i lowTable = _mm256_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+                                              0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m256i highTable = _mm256_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+                                               0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m256i rollTable = _mm256_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+                                               0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i pack = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+                                          2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+    const __m256i mask = _mm256_set1_epi8(0x2F);
+    size_t read = 0;
+    size_t written = 0;
 
-    decoded = (uint8_t *)NSZoneCalloc(nil, length, sizeof(char));
-    for (x = 0, y = 0; x < length; ) {
-        while ((x < length) && !isMemberFunction(alphabetSet, @selector(characterIsMember:), characters[x])) {
-            x++;
+    while (length - read >= 32) {
+        __m256i characters = _mm256_loadu_si256((const __m256i *)(input + read));
+        __m256i highNibbles = _mm256_and_si256(_mm256_srli_epi32(characters, 4), mask);
+        __m256i lowNibbles = _mm256_and_si256(characters, mask);
+        __m256i low = _mm256_shuffle_epi8(lowTable, lowNibbles);
+        __m256i high = _mm256_shuffle_epi8(highTable, highNibbles);
+        if (!_mm256_testz_si256(low, high)) {
+            break;
         }
-        if (x != length) {
-            c1 = characters[x++];
-        } else {
-            c1 = -1;
+        __m256i isSlash = _mm256_cmpeq_epi8(characters, mask);
+        __m256i sextets = _mm256_add_epi8(characters, _mm256_shuffle_epi8(rollTable, _mm256_add_epi8(isSlash, highNibbles)));
+        __m256i pairs = _mm256_maddubs_epi16(sextets, _mm256_set1_epi32(0x01400140));
+        __m256i quads = _mm256_madd_epi16(pairs, _mm256_set1_epi32(0x00011000));
+        __m256i bytes = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(quads, pack), _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+        // As above, exactly 24 bytes.
+        _mm_storeu_si128((__m128i *)(output + written), _mm256_castsi256_si128(bytes));
+        _mm_storel_epi64((__m128i *)(output + written + 16), _mm256_extracti128_si256(bytes, 1));
+        read += 32;
+        written += 24;
+    }
+    *consumed = read;
+    return written;
+}
+
+#elif defined(__aarch64__)
+
+static size_t AJRBase64EncodeGroupsNEON(const uint8_t *input, size_t groups, char *output) {
+    const uint8x16x4_t alphabet = vld1q_u8_x4((const uint8_t *)AJRBase64Alphabet);
+    const uint8x16_t mask = vdupq_n_u8(0x3F);
+    size_t done = 0;
+    while (groups - done >= 16) {
+        // vld3 splits 48 bytes into the first, second, and third byte of each group.
+        uint8x16x3_t bytes = vld3q_u8(input + done * 3);
+        uint8x16x4_t indices;
+        indices.val[0] = vshrq_n_u8(bytes.val[0], 2);
+        indices.val[1] = vandq_u8(vorrq_u8(vshlq_n_u8(bytes.val[0], 4), vshrq_n_u8(bytes.val[1], 4)), mask);
+        indices.val[2] = vandq_u8(vorrq_u8(vshlq_n_u8(bytes.val[1], 2), vshrq_n_u8(bytes.val[2], 6)), mask);
+        indices.val[3] = vandq_u8(bytes.val[2], mask);
+        uint8x16x4_t characters;
+        characters.val[0] = vqtbl4q_u8(alphabet, indices.val[0]);
+        characters.val[1] = vqtbl4q_u8(alphabet, indices.val[1]);
+        characters.val[2] = vqtbl4q_u8(alphabet, indices.val[2]);
+        characters.val[3] = vqtbl4q_u8(alphabet, indices.val[3]);
+        vst4q_u8((uint8_t *)output + done * 4, characters);
+        done += 16;
+    }
+    return done;
+}
+
+static inline uint8x16_t AJRBase64DecodeNEONLane(uint8x16_t characters, uint8x16x4_t lowTable, uint8x16x4_t highTable) {
+    // Characters below 64 come from the first table, 64 through 127 from the second. Anything above 127 is forced to invalid.
+    uint8x16_t sextets = vqtbl4q_u8(lowTable, characters);
+    sextets = vqtbx4q_u8(sextets, highTable, vsubq_u8(characters, vdupq_n_u8(64)));
+    return vorrq_u8(sextets, vcgeq_u8(characters, vdupq_n_u8(128)));
+}
+
+static size_t AJRBase64DecodeBlocksNEON(const uint8_t *input, size_t length, uint8_t *output, size_t *consumed) {
+    const uint8x16x4_t lowTable = vld1q_u8_x4(AJRBase64DecodeTable);
+    const uint8x16x4_t highTable = vld1q_u8_x4(AJRBase64DecodeTable + 64);
+    size_t read = 0;
+    size_t written = 0;
+    while (length - read >= 64) {
+        // vld4 splits 64 characters into the first, second, third, and fourth character of each quantum.
+        uint8x16x4_t characters = vld4q_u8(input + read);
+        uint8x16_t a = AJRBase64DecodeNEONLane(characters.val[0], lowTable, highTable);
+        uint8x16_t b = AJRBase64DecodeNEONLane(characters.val[1], lowTable, highTable);
+        uint8x16_t c = AJRBase64DecodeNEONLane(characters.val[2], lowTable, highTable);
+        uint8x16_t d = AJRBase64DecodeNEONLane(characters.val[3], lowTable, highTable);
+        if (vmaxvq_u8(vorrq_u8(vorrq_u8(a, b), vorrq_u8(c, d))) >= 64) {
+            break;
         }
-        
-        while ((x < length) && !isMemberFunction(alphabetSet, @selector(characterIsMember:), characters[x])) {
-            x++;
+        uint8x16x3_t bytes;
+        bytes.val[0] = vorrq_u8(vshlq_n_u8(a, 2), vshrq_n_u8(b, 4));
+        bytes.val[1] = vorrq_u8(vshlq_n_u8(b, 4), vshrq_n_u8(c, 2));
+        bytes.val[2] = vorrq_u8(vshlq_n_u8(c, 6), d);
+        vst3q_u8(output + written, bytes);
+        read += 64;
+        written += 48;
+    }
+    *consumed = read;
+    return written;
+}
+
+#endif
+
+static void AJRBase64Initialize(void) {
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        for (NSInteger x = 0; x < 4096; x++) {
+            AJRBase64EncodePairs[x][0] = AJRBase64Alphabet[x >> 6];
+            AJRBase64EncodePairs[x][1] = AJRBase64Alphabet[x & 0x3F];
         }
-        if (x != length) {
-            c2 = characters[x++];
-        } else {
-            c2 = -1;
+#if defined(__x86_64__)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            AJRBase64EncodeVector = AJRBase64EncodeGroupsAVX2;
+            AJRBase64DecodeVector = AJRBase64DecodeBlocksAVX2;
+        } else if (__builtin_cpu_supports("ssse3")) {
+            AJRBase64EncodeVector = AJRBase64EncodeGroupsSSSE3;
+            AJRBase64DecodeVector = AJRBase64DecodeBlocksSSSE3;
         }
-        
-        while ((x < length) && !isMemberFunction(alphabetSet, @selector(characterIsMember:), characters[x])) {
-            x++;
+#elif defined(__aarch64__)
+        AJRBase64EncodeVector = AJRBase64EncodeGroupsNEON;
+        AJRBase64DecodeVector = AJRBase64DecodeBlocksNEON;
+#endif
+    });
+}
+
+#pragma mark - Encoding
+
+static size_t AJRBase64EncodeGroups(const uint8_t *input, size_t groups, char *output) {
+    size_t done = AJRBase64EncodeVector ? AJRBase64EncodeVector(input, groups, output) : 0;
+    for (; done < groups; done++) {
+        const uint8_t *bytes = input + done * 3;
+        uint32_t value = ((uint32_t)bytes[0] << 16) | ((uint32_t)bytes[1] << 8) | bytes[2];
+        memcpy(output + done * 4, AJRBase64EncodePairs[value >> 12], 2);
+        memcpy(output + done * 4 + 2, AJRBase64EncodePairs[value & 0xFFF], 2);
+    }
+    return groups * 4;
+}
+
+size_t AJRBase64EncodedLength(size_t length, NSInteger lineBreakPosition) {
+    size_t quanta = (length + 2) / 3;
+    // A trailing single byte is only followed by one pad character.
+    size_t characters = quanta * 4 - (length % 3 == 1 ? 1 : 0);
+    if (lineBreakPosition != AJRBase64NoLineBreak) {
+        characters += quanta / (size_t)ABS(lineBreakPosition);
+    }
+    return characters;
+}
+
+size_t AJRBase64EncodeBytes(const uint8_t *bytes, size_t length, NSInteger lineBreakPosition, char *output) {
+    AJRBase64Initialize();
+
+    size_t groups = length / 3;
+    size_t remainder = length % 3;
+    char *start = output;
+
+    if (lineBreakPosition == AJRBase64NoLineBreak) {
+        output += AJRBase64EncodeGroups(bytes, groups, output);
+    } else {
+        size_t lineLength = (size_t)ABS(lineBreakPosition);
+        for (size_t done = 0; done < groups; ) {
+            size_t count = MIN(lineLength, groups - done);
+            output += AJRBase64EncodeGroups(bytes + done * 3, count, output);
+            done += count;
+            if (count == lineLength) {
+                *output++ = '\n';
+            }
         }
-        if (x != length) {
-            c3 = characters[x++];
+    }
+
+    if (remainder) {
+        const uint8_t *tail = bytes + groups * 3;
+        *output++ = AJRBase64Alphabet[tail[0] >> 2];
+        if (remainder == 2) {
+            *output++ = AJRBase64Alphabet[((tail[0] & 0x03) << 4) | (tail[1] >> 4)];
+            *output++ = AJRBase64Alphabet[(tail[1] & 0x0F) << 2];
         } else {
-            c3 = -1;
+            *output++ = AJRBase64Alphabet[(tail[0] & 0x03) << 4];
         }
-        
-        while ((x < length) && !isMemberFunction(alphabetSet, @selector(characterIsMember:), characters[x])) {
-            x++;
-        }
-        if (x != length) {
-            c4 = characters[x++];
-        } else {
-            c4 = -1;
+        *output++ = '=';
+        if (lineBreakPosition != AJRBase64NoLineBreak && (groups + 1) % (size_t)ABS(lineBreakPosition) == 0) {
+            *output++ = '\n';
         }
-        
-        if ((c1 != -1) && (c2 != -1)) {
-            decoded[y++] = (decodeAlphabet[(NSInteger)c1] << 2) | (decodeAlphabet[(NSInteger)c2] >> 4);
-        } else {
-            if (!(c1 == -1 && c2 == -1 && c3 == -1 && c4 == -1)) {
-                localError = [NSError errorWithDomain:AJRDataErrorDomain message:@"Warning: B64 data stream is truncated."];
+    }
+
+    return output - start;
+}
+
+NSString *AJRBase64EncodedString(const uint8_t *bytes, NSInteger length, NSRange subrange, NSInteger lineBreakPosition) {
+    // Like it always has, a range that doesn't end on a whole quantum is extended to the next one, as long as there are bytes to extend into.
+    NSInteger start = MIN((NSInteger)subrange.location, length);
+    NSInteger end = MIN(start + (NSInteger)(((subrange.length + 2) / 3) * 3), length);
+    size_t encodedLength = AJRBase64EncodedLength(end - start, lineBreakPosition);
+    char *encoded = (char *)malloc(MAX(encodedLength, 1));
+
+    AJRBase64EncodeBytes(bytes + start, end - start, lineBreakPosition, encoded);
+
+    return [[NSString alloc] initWithBytesNoCopy:encoded length:encodedLength encoding:NSASCIIStringEncoding freeWhenDone:YES];
+}
+
+#pragma mark - Decoding
+
+size_t AJRBase64MaximumDecodedLength(size_t length) {
+    return (length / 4) * 3 + 2;
+}
+
+size_t AJRBase64DecodeCharactersWithState(const char *characters, size_t length, uint8_t *output, AJRBase64DecodeState *state) {
+    AJRBase64Initialize();
+
+    const uint8_t *input = (const uint8_t *)characters;
+    size_t read = 0;
+    size_t written = 0;
+    uint32_t accumulator = state->accumulator;
+    NSInteger pending = state->pending;
+
+    while (read < length) {
+        if (pending == 0) {
+            // On a quantum boundary, so take the fast paths for as long as the input is clean.
+            if (AJRBase64DecodeVector) {
+                size_t consumed = 0;
+                written += AJRBase64DecodeVector(input + read, length - read, output + written, &consumed);
+                read += consumed;
+            }
+            while (length - read >= 4) {
+                uint32_t a = AJRBase64DecodeTable[input[read]];
+                uint32_t b = AJRBase64DecodeTable[input[read + 1]];
+                uint32_t c = AJRBase64DecodeTable[input[read + 2]];
+                uint32_t d = AJRBase64DecodeTable[input[read + 3]];
+                if ((a | b | c | d) & 0x80) {
+                    break;
+                }
+                uint32_t value = (a << 18) | (b << 12) | (c << 6) | d;
+                output[written] = (uint8_t)(value >> 16);
+                output[written + 1] = (uint8_t)(value >> 8);
+                output[written + 2] = (uint8_t)value;
+                read += 4;
+                written += 3;
+            }
+            if (read == length) {
+                break;
             }
         }
-        if (c2 != -1 && c3 != -1) {
-            decoded[y++] = (((NSInteger)decodeAlphabet[c2]) << 4) | ((NSInteger)decodeAlphabet[c3] >> 2);
-        }
-        if (c3 != -1 && c4 != -1) {
-            decoded[y++] = (((NSInteger)decodeAlphabet[c3]) << 6) | (NSInteger)decodeAlphabet[c4];
+
+        // Whitespace, padding, or the quantum was split by something we skip, so go a character at a time until we're back on a boundary.
+        uint8_t value = AJRBase64DecodeTable[input[read++]];
+        if (value != AJRBase64Invalid) {
+            accumulator = (accumulator << 6) | value;
+            if (++pending == 4) {
+                output[written++] = (uint8_t)(accumulator >> 16);
+                output[written++] = (uint8_t)(accumulator >> 8);
+                output[written++] = (uint8_t)accumulator;
+                accumulator = 0;
+                pending = 0;
+            }
         }
     }
-    
-    if (!localError) {
-		AJRSetOutParameter(bytesOut, decoded);
-		AJRSetOutParameter(lengthOut, y);
+
+    state->accumulator = accumulator;
+    state->pending = pending;
+
+    return written;
+}
+
+BOOL AJRBase64FinishDecoding(AJRBase64DecodeState *state, uint8_t *output, size_t *outputLength) {
+    size_t written = 0;
+    BOOL success = state->pending != 1;
+
+    // Finally, a partial quantum. Two characters give us one byte, and three give us two, but one character can't produce anything at all.
+    if (state->pending == 2) {
+        output[written++] = (uint8_t)(state->accumulator >> 4);
+    } else if (state->pending == 3) {
+        output[written++] = (uint8_t)(state->accumulator >> 10);
+        output[written++] = (uint8_t)(state->accumulator >> 2);
     }
-    
-    return localError;
+    state->accumulator = 0;
+    state->pending = 0;
+
+    AJRSetOutParameter(outputLength, written);
+    return success;
 }
 
+BOOL AJRBase64DecodeCharacters(const char *characters, size_t length, uint8_t *output, size_t *outputLength) {
+    AJRBase64DecodeState state = { 0, 0 };
+    size_t written = AJRBase64DecodeCharactersWithState(characters, length, output, &state);
+    size_t finalLength = 0;
+    BOOL success = AJRBase64FinishDecoding(&state, output + written, &finalLength);
+
+    AJRSetOutParameter(outputLength, written + finalLength);
+    return success;
+}
+
+NSError *AJRBase64DecodedBytes(NSString *string, uint8_t **bytesOut, NSInteger *lengthOut) {
+    NSError *localError = nil;
+    // Base64 is ASCII, so when the string is stored that way, we can read it in place.
+    const char *characters = CFStringGetCStringPtr((__bridge CFStringRef)string, kCFStringEncodingASCII) ?: [string UTF8String];
+    size_t length = strlen(characters);
+    uint8_t *decoded = (uint8_t *)malloc(AJRBase64MaximumDecodedLength(length));
+    size_t decodedLength = 0;
+
+    if (AJRBase64DecodeCharacters(characters, length, decoded, &decodedLength)) {
+        // Whitespace may have left us with more room than we needed.
+        decoded = (uint8_t *)reallocf(decoded, MAX(decodedLength, 1));
+        AJRSetOutParameter(bytesOut, decoded);
+        AJRSetOutParameter(lengthOut, (NSInteger)decodedLength);
+    } else {
+        free(decoded);
+        localError = [NSError errorWithDomain:AJRDataErrorDomain message:@"Warning: B64 data stream is truncated."];
+    }
+
+    return localError;
+}
@@ -0,0 +1,50 @@
+/*
+ NSData+Hex.h
+ AJRFoundation
+
+ Copyright © 2023, AJ Raftis and AJRFoundation authors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of AJRFoundation nor the names of its contributors may be
+   used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL AJ RAFTIS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface NSData (Hex)
+
+/*! Returns the receiver as pairs of lowercase hex digits, such as "a800f1". Note that Swift's Data.hexString is uppercase. */
+- (NSString *)ajr_hexEncodedString;
+/*! Returns the receiver as pairs of hex digits, using A-F rather than a-f when uppercase is YES. */
+- (NSString *)ajr_hexEncodedStringUsingUppercase:(BOOL)uppercase;
+
+@end
+
+/// Encodes length bytes as hex digits into output, which must have room for length * 2 characters. No terminator is written. Returns the number of characters written. Uses the CPU's vector unit when one is available.
+extern size_t AJRHexEncodeBytes(const uint8_t *bytes, size_t length, BOOL uppercase, char *output);
+/// Decodes pairs of hex digits, in either case, into output, which must have room for length / 2 bytes. Decoding stops at the first character that isn't a hex digit, or at a trailing unpaired digit. If consumed isn't NULL, it's set to the number of characters decoded, so the input was entirely hex when consumed equals length. Returns the number of bytes written.
+extern size_t AJRHexDecodeCharacters(const char *characters, size_t length, uint8_t *output, size_t * _Nullable consumed);
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,238 @@
+/*
+ NSData+Hex.m
+ AJRFoundation
+
+ Copyright © 2023, AJ Raftis and AJRFoundation authors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of AJRFoundation nor the names of its contributors may be
+   used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL AJ RAFTIS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import <AJRFoundation/NSData+Hex.h>
+
+#import "AJRFunctions.h"
+
+#if defined(__x86_64__)
+#import <immintrin.h>
+#elif defined(__aarch64__)
+#import <arm_neon.h>
+#endif
+
+@implementation NSData (Hex)
+
+- (NSString *)ajr_hexEncodedString {
+    return [self ajr_hexEncodedStringUsingUppercase:NO];
+}
+
+- (NSString *)ajr_hexEncodedStringUsingUppercase:(BOOL)uppercase {
+    size_t length = self.length;
+    char *encoded = (char *)malloc(MAX(length * 2, 1));
+
+    AJRHexEncodeBytes(self.bytes, length, uppercase, encoded);
+
+    return [[NSString alloc] initWithBytesNoCopy:encoded length:length * 2 encoding:NSASCIIStringEncoding freeWhenDone:YES];
+}
+
+@end
+
+#pragma mark - Tables
+
+static const char AJRHexLowercaseDigits[] = "0123456789abcdef";
+static const char AJRHexUppercaseDigits[] = "0123456789ABCDEF";
+
+// Both digits of every byte, so the scalar encoder does one lookup per byte.
+static char AJRHexLowercasePairs[256][2];
+static char AJRHexUppercasePairs[256][2];
+
+#define AJRHexInvalid 0xFF
+
+static uint8_t AJRHexDecodeTable[256];
+
+#pragma mark - Vector Implementations
+
+// Encodes as many whole blocks as it can, returning the number of bytes encoded. The caller finishes the rest.
+typedef size_t (*AJRHexEncodeBlocksFunction)(const uint8_t *input, size_t length, const char *digits, char *output);
+// Decodes blocks of characters for as long as every character in a block is a hex digit. Returns the number of bytes written, which is always half the number of characters consumed.
+typedef size_t (*AJRHexDecodeBlocksFunction)(const uint8_t *input, size_t length, uint8_t *output);
+
+static AJRHexEncodeBlocksFunction AJRHexEncodeVector = NULL;
+static AJRHexDecodeBlocksFunction AJRHexDecodeVector = NULL;
+
+#if defined(__x86_64__)
+
+// Each nibble indexes a 16 entry table of digits with pshufb, and then the high and low digits are interleaved.
+__attribute__((target("ssse3")))
+static size_t AJRHexEncodeBlocksSSSE3(const uint8_t *input, size_t length, const char *digits, char *output) {
+    const __m128i table = _mm_loadu_si128((const __m128i *)digits);
+    const __m128i mask = _mm_set1_epi8(0x0F);
+    size_t done = 0;
+    while (length - done >= 16) {
+        __m128i bytes = _mm_loadu_si128((const __m128i *)(input + done));
+        __m128i high = _mm_shuffle_epi8(table, _mm_and_si128(_mm_srli_epi16(bytes, 4), mask));
+        __m128i low = _mm_shuffle_epi8(table, _mm_and_si128(bytes, mask));
+        _mm_storeu_si128((__m128i *)(output + done * 2), _mm_unpacklo_epi8(high, low));
+        _mm_storeu_si128((__m128i *)(output + done * 2 + 16), _mm_unpackhi_epi8(high, low));
+        done += 16;
+    }
+    return done;
+}
+
+// Returns the value of each digit in characters, and sets valid to all ones for each character that is a digit. Letters are folded to lowercase by setting 0x20, which can't turn anything else into a letter.
+__attribute__((target("ssse3")))
+static inline __m128i AJRHexDecodeSSSE3Lane(__m128i characters, __m128i *valid) {
+    __m128i digits = _mm_sub_epi8(characters, _mm_set1_epi8('0'));
+    __m128i isDigit = _mm_cmpeq_epi8(_mm_min_epu8(digits, _mm_set1_epi8(9)), digits);
+    __m128i letters = _mm_sub_epi8(_mm_or_si128(characters, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+    __m128i isLetter = _mm_cmpeq_epi8(_mm_min_epu8(letters, _mm_set1_epi8(5)), letters);
+    *valid = _mm_or_si128(isDigit, isLetter);
+    return _mm_or_si128(_mm_and_si128(isDigit, digits), _mm_and_si128(isLetter, _mm_add_epi8(letters, _mm_set1_epi8(10))));
+}
+
+__attribute__((target("ssse3")))
+static size_t AJRHexDecodeBlocksSSSE3(const uint8_t *input, size_t length, uint8_t *output) {
+    // Multiplies each high nibble by 16 and adds its low nibble, giving one byte per 16 bit lane.
+    const __m128i weights = _mm_set1_epi16(0x0110);
+    size_t written = 0;
+    while (length - written * 2 >= 32) {
+        __m128i firstValid, secondValid;
+        __m128i first = AJRHexDecodeSSSE3Lane(_mm_loadu_si128((const __m128i *)(input + written * 2)), &firstValid);
+        __m128i second = AJRHexDecodeSSSE3Lane(_mm_loadu_si128((const __m128i *)(input + written * 2 + 16)), &secondValid);
+        if (_mm_movemask_epi8(_mm_and_si128(firstValid, secondValid)) != 0xFFFF) {
+            break;
+        }
+        __m128i bytes = _mm_packus_epi16(_mm_maddubs_epi16(first, weights), _mm_maddubs_epi16(second, weights));
+        _mm_storeu_si128((__m128i *)(output + written), bytes);
+        written += 16;
+    }
+    return written;
+}
+
+#elif defined(__aarch64__)
+
+static size_t AJRHexEncodeBlocksNEON(const uint8_t *input, size_t length, const char *digits, char *output) {
+    const uint8x16_t table = vld1q_u8((const uint8_t *)digits);
+    size_t done = 0;
+    while (length - done >= 16) {
+        uint8x16_t bytes = vld1q_u8(input + done);
+        uint8x16x2_t characters;
+        characters.val[0] = vqtbl1q_u8(table, vshrq_n_u8(bytes, 4));
+        characters.val[1] = vqtbl1q_u8(table, vandq_u8(bytes, vdupq_n_u8(0x0F)));
+        // vst2 interleaves the high and low digits for us.
+        vst2q_u8((uint8_t *)output + done * 2, characters);
+        done += 16;
+    }
+    return done;
+}
+
+static inline uint8x16_t AJRHexDecodeNEONLane(uint8x16_t characters, uint8x16_t *valid) {
+    uint8x16_t digits = vsubq_u8(characters, vdupq_n_u8('0'));
+    uint8x16_t isDigit = vcltq_u8(digits, vdupq_n_u8(10));
+    uint8x16_t letters = vsubq_u8(vorrq_u8(characters, vdupq_n_u8(0x20)), vdupq_n_u8('a'));
+    uint8x16_t isLetter = vcltq_u8(letters, vdupq_n_u8(6));
+    *valid = vorrq_u8(isDigit, isLetter);
+    return vbslq_u8(isDigit, digits, vaddq_u8(letters, vdupq_n_u8(10)));
+}
+
+static size_t AJRHexDecodeBlocksNEON(const uint8_t *input, size_t length, uint8_t *output) {
+    size_t written = 0;
+    while (length - written * 2 >= 32) {
+        // vld2 splits the high digits from the low ones.
+        uint8x16x2_t characters = vld2q_u8(input + written * 2);
+        uint8x16_t highValid, lowValid;
+        uint8x16_t high = AJRHexDecodeNEONLane(characters.val[0], &highValid);
+        uint8x16_t low = AJRHexDecodeNEONLane(characters.val[1], &lowValid);
+        if (vminvq_u8(vandq_u8(highValid, lowValid)) != 0xFF) {
+            break;
+        }
+        vst1q_u8(output + written, vorrq_u8(vshlq_n_u8(high, 4), low));
+        written += 16;
+    }
+    return written;
+}
+
+#endif
+
+static void AJRHexInitialize(void) {
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        for (NSInteger x = 0; x < 256; x++) {
+            AJRHexLowercasePairs[x][0] = AJRHexLowercaseDigits[x >> 4];
+            AJRHexLowercasePairs[x][1] = AJRHexLowercaseDigits[x & 0x0F];
+            AJRHexUppercasePairs[x][0] = AJRHexUppercaseDigits[x >> 4];
+            AJRHexUppercasePairs[x][1] = AJRHexUppercaseDigits[x & 0x0F];
+        }
+        memset(AJRHexDecodeTable, AJRHexInvalid, sizeof(AJRHexDecodeTable));
+        for (NSInteger x = 0; x < 16; x++) {
+            AJRHexDecodeTable[(uint8_t)AJRHexLowercaseDigits[x]] = (uint8_t)x;
+            AJRHexDecodeTable[(uint8_t)AJRHexUppercaseDigits[x]] = (uint8_t)x;
+        }
+#if defined(__x86_64__)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("ssse3")) {
+            AJRHexEncodeVector = AJRHexEncodeBlocksSSSE3;
+            AJRHexDecodeVector = AJRHexDecodeBlocksSSSE3;
+        }
+#elif defined(__aarch64__)
+        AJRHexEncodeVector = AJRHexEncodeBlocksNEON;
+        AJRHexDecodeVector = AJRHexDecodeBlocksNEON;
+#endif
+    });
+}
+
+#pragma mark - Encoding
+
+size_t AJRHexEncodeBytes(const uint8_t *bytes, size_t length, BOOL uppercase, char *output) {
+    AJRHexInitialize();
+
+    char (*pairs)[2] = uppercase ? AJRHexUppercasePairs : AJRHexLowercasePairs;
+    size_t done = AJRHexEncodeVector ? AJRHexEncodeVector(bytes, length, uppercase ? AJRHexUppercaseDigits : AJRHexLowercaseDigits, output) : 0;
+
+    for (; done < length; done++) {
+        memcpy(output + done * 2, pairs[bytes[done]], 2);
+    }
+
+    return length * 2;
+}
+
+#pragma mark - Decoding
+
+size_t AJRHexDecodeCharacters(const char *characters, size_t length, uint8_t *output, size_t *consumed) {
+    AJRHexInitialize();
+
+    const uint8_t *input = (const uint8_t *)characters;
+    size_t written = AJRHexDecodeVector ? AJRHexDecodeVector(input, length, output) : 0;
+
+    // Either the input is too short for a block, or a block had something other than a digit, in which case we find exactly where here.
+    while (length - written * 2 >= 2) {
+        uint8_t high = AJRHexDecodeTable[input[written * 2]];
+        uint8_t low = AJRHexDecodeTable[input[written * 2 + 1]];
+        if ((high | low) & 0xF0) {
+            break;
+        }
+        output[written++] = (uint8_t)((high << 4) | low);
+    }
+
+    AJRSetOutParameter(consumed, written * 2);
+    return written;
+}
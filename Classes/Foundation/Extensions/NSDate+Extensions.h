@@ -88,3 +88,34 @@ extern const long long AJRMillisPer365DayYear;
 + (NSTimeInterval)timeIntervalForTimePeriodString:(NSString *)value defaultValue:(NSTimeInterval)defaultValue;
 
 @end
+
+#pragma mark - Time Periods
+
+/*!
+ The result of parsing a textual duration, such as "1h 15m 10s 15ms", "90 seconds", or "01:12:01.234". Each term is an optional number followed by an optional unit, where the unit is any word starting with ms, milli, mo, m, s, h, d, w, or y. A term without a unit uses a default unit, which is milliseconds for milliseconds and seconds for the intervals.
+
+ The struct is filled in with every reading of the string at once, so callers can take whichever they need.
+ */
+typedef struct _ajrTimePeriod {
+    /*! The sum of the terms, in milliseconds, with each term truncated to a whole millisecond. This is what +[NSDate millisecondsForTimePeriodString:defaultValue:] returns, unless it's 0. */
+    long long milliseconds;
+    /*! The sum of the terms, in seconds. This is what +[NSDate timeIntervalForTimePeriodString:defaultValue:] returns when termCount isn't 0. */
+    NSTimeInterval periodInterval;
+    /*! The interval -[NSString timeIntervalValue] returns. This is the clock time when isClockTime is YES, otherwise it's periodInterval. */
+    NSTimeInterval timeInterval;
+    /*! The number of terms parsed. */
+    NSUInteger termCount;
+    /*! YES when the string contains a colon, and so is read as "[[[days:]hours:]minutes:]seconds". */
+    BOOL isClockTime;
+} AJRTimePeriod;
+
+/*!
+ Parses string into period in a single pass, without allocating. A nil or empty string parses as no terms.
+ */
+extern void AJRParseTimePeriod(NSString *string, AJRTimePeriod *period);
+
+/*!
+ Like AJRParseTimePeriod(), but remembers the results for strings it has seen, which makes sense for values that are parsed over and over, like those read from configuration. The cache is bounded, and strings that arrive once it's full are simply parsed.
+ */
+extern void AJRParseTimePeriodUsingCache(NSString *string, AJRTimePeriod *period);
+
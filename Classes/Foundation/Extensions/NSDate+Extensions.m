@@ -33,6 +33,8 @@
 
 #import "AJRFunctions.h"
 
+#import <xlocale.h>
+
 const long long AJRMillisPerSecond = 1000LL;
 const long long AJRSecondsPerMinute = 60LL;
 const long long AJRMinutesPerHour = 60LL;
@@ -211,121 +213,312 @@ NSString *AJRISO8601DateTimeFormat = @"%Y-%m-%dT%H:%M:%S%z";
 
 #pragma mark Milliseconds
 
-static NSArray<NSString *> *_ajrUnitMultiplierKeys = nil;
-static NSArray<NSNumber *> *_ajrUnitMultiplierValues = nil;
++ (long long)millisecondsForTimePeriodString:(NSString *)value defaultValue:(long long)defaultValue {
+    AJRTimePeriod period;
+    AJRParseTimePeriod(value, &period);
+    return period.milliseconds != 0LL ? period.milliseconds : defaultValue;
+}
+
++ (NSTimeInterval)timeIntervalForTimePeriodString:(NSString *)value defaultValue:(NSTimeInterval)defaultValue {
+    AJRTimePeriod period;
+    AJRParseTimePeriod(value, &period);
+    return period.termCount ? period.periodInterval : defaultValue;
+}
+
+@end
+
+#pragma mark - Time Periods
+
+/*
+ The scanner below reproduces what we used to get from NSScanner: each term is an optional number, followed by an optional run of letters, with whitespace and newlines skipped before each. Numbers follow strtod()'s decimal grammar, and the letters name a unit if, lowercased, they begin with one of ms, milli, mo, m, s, h, d, w, or y, checked in that order. A term with a number but no recognized unit uses the caller's base unit, and scanning stops at the first term with neither. Clock syntax, "[[[d:]h:]m:]s.fff", is recognized when the string contains a colon anywhere, and is evaluated the same way -[NSString doubleValue] and -[NSString longLongValue] would evaluate each field.
+ */
+
+static const NSUInteger AJRTimePeriodCacheLimit = 1024;
+
+static inline BOOL AJRTimePeriodIsWhitespace(UniChar character) {
+    if (character < 0x80) {
+        return character == ' ' || (character >= '\t' && character <= '\r');
+    }
+    return CFCharacterSetIsCharacterMember(CFCharacterSetGetPredefined(kCFCharacterSetWhitespaceAndNewline), character);
+}
 
-+ (void)_faultUnits {
-	static dispatch_once_t onceToken;
-	dispatch_once(&onceToken, ^{
-        _ajrUnitMultiplierKeys = @[@"ms", @"milli", @"mo", @"m", @"s", @"h", @"d", @"w", @"y"];
-        _ajrUnitMultiplierValues = @[
-			@(1LL),
-			@(1LL),
-			@(AJRMillisPer30DayMonth),
-			@(AJRMillisPerMinute),
-			@(AJRMillisPerSecond),
-			@(AJRMillisPerHour),
-			@(AJRMillisPerDay),
-			@(AJRMillisPerWeek),
-			@(AJRMillisPer365DayYear)];
-	});
+static inline BOOL AJRTimePeriodIsLetter(UniChar character) {
+    if (character < 0x80) {
+        return (character >= 'a' && character <= 'z') || (character >= 'A' && character <= 'Z');
+    }
+    return CFCharacterSetIsCharacterMember(CFCharacterSetGetPredefined(kCFCharacterSetLetter), character);
 }
 
-+ (NSArray<NSString *> *)_unitMultiplierKeys {
-    [self _faultUnits];
-    return _ajrUnitMultiplierKeys;
+static inline BOOL AJRTimePeriodIsDigit(UniChar character) {
+    return character >= '0' && character <= '9';
 }
 
-+ (NSArray<NSNumber *> *)_unitMultiplierValues {
-    [self _faultUnits];
-    return _ajrUnitMultiplierValues;
+static inline UniChar AJRTimePeriodCharacterAt(CFStringInlineBuffer *buffer, CFIndex index, CFIndex length) {
+    return index < length ? CFStringGetCharacterFromInlineBuffer(buffer, index) : 0;
 }
 
-static BOOL _ajrScanQuantityAndMultiplier(NSScanner *scanner, double *value, double baseMultiplier) {
-    __block double baseQuantity;
-    __block BOOL didSetValue = NO;
-    BOOL scannedQuantity = NO;
-    
-    if (![scanner scanDouble:&baseQuantity]) {
-        baseQuantity = 1.0;
+static CFIndex AJRTimePeriodSkipWhitespace(CFStringInlineBuffer *buffer, CFIndex index, CFIndex length) {
+    while (index < length && AJRTimePeriodIsWhitespace(CFStringGetCharacterFromInlineBuffer(buffer, index))) {
+        index++;
+    }
+    return index;
+}
+
+/*!
+ Scans a decimal floating point number at index, which must already be past any whitespace. Returns the index just past the number, or index itself if there isn't a number there. Short numbers are converted exactly with a power of ten; anything else is handed to strtod_l() so we round the same way -[NSScanner scanDouble:] does.
+ */
+static CFIndex AJRTimePeriodScanDouble(CFStringInlineBuffer *buffer, CFIndex index, CFIndex length, double *value) {
+    static const double powersOfTen[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+    CFIndex start = index;
+    BOOL negative = NO;
+    uint64_t mantissa = 0;
+    NSInteger significantDigits = 0;
+    NSInteger exponent = 0;
+    BOOL sawDigit = NO;
+    UniChar character = AJRTimePeriodCharacterAt(buffer, index, length);
+
+    if (character == '+' || character == '-') {
+        negative = character == '-';
+        character = AJRTimePeriodCharacterAt(buffer, ++index, length);
+    }
+    while (AJRTimePeriodIsDigit(character)) {
+        if (mantissa != 0 || character != '0') {
+            if (significantDigits < 19) {
+                mantissa = mantissa * 10 + (character - '0');
+            } else {
+                exponent++;
+            }
+            significantDigits++;
+        }
+        sawDigit = YES;
+        character = AJRTimePeriodCharacterAt(buffer, ++index, length);
+    }
+    if (character == '.') {
+        character = AJRTimePeriodCharacterAt(buffer, ++index, length);
+        while (AJRTimePeriodIsDigit(character)) {
+            if (mantissa != 0 || character != '0') {
+                if (significantDigits < 19) {
+                    mantissa = mantissa * 10 + (character - '0');
+                    exponent--;
+                }
+                significantDigits++;
+            } else {
+                exponent--;
+            }
+            sawDigit = YES;
+            character = AJRTimePeriodCharacterAt(buffer, ++index, length);
+        }
+    }
+    if (!sawDigit) {
+        return start;
+    }
+    if (character == 'e' || character == 'E') {
+        CFIndex exponentIndex = index + 1;
+        BOOL negativeExponent = NO;
+        NSInteger explicitExponent = 0;
+        character = AJRTimePeriodCharacterAt(buffer, exponentIndex, length);
+        if (character == '+' || character == '-') {
+            negativeExponent = character == '-';
+            character = AJRTimePeriodCharacterAt(buffer, ++exponentIndex, length);
+        }
+        if (AJRTimePeriodIsDigit(character)) {
+            while (AJRTimePeriodIsDigit(character)) {
+                if (explicitExponent < 100000) {
+                    explicitExponent = explicitExponent * 10 + (character - '0');
+                }
+                character = AJRTimePeriodCharacterAt(buffer, ++exponentIndex, length);
+            }
+            exponent += negativeExponent ? -explicitExponent : explicitExponent;
+            index = exponentIndex;
+        }
+    }
+
+    double result;
+    if (mantissa == 0) {
+        result = 0.0;
+    } else if (significantDigits <= 15 && exponent >= -22 && exponent <= 22) {
+        // Both operands are exact, so a single multiply or divide rounds correctly.
+        result = exponent < 0 ? (double)mantissa / powersOfTen[-exponent] : (double)mantissa * powersOfTen[exponent];
     } else {
-        scannedQuantity = YES;
+        char local[128];
+        CFIndex numberLength = index - start;
+        char *characters = numberLength < (CFIndex)sizeof(local) ? local : malloc(numberLength + 1);
+        for (CFIndex x = 0; x < numberLength; x++) {
+            characters[x] = (char)CFStringGetCharacterFromInlineBuffer(buffer, start + x);
+        }
+        characters[numberLength] = '\0';
+        result = fabs(strtod_l(characters, NULL, NULL));
+        if (characters != local) {
+            free(characters);
+        }
     }
-    
-    NSString *scannedString;
-    if ([scanner scanCharactersFromSet:[NSCharacterSet letterCharacterSet] intoString:&scannedString]) {
-        if ([scannedString length]) {
-            scannedString = [scannedString lowercaseString];
-            
-			[[NSDate _unitMultiplierKeys] enumerateObjectsUsingBlock:^(NSString *key, NSUInteger index, BOOL *stop) {
-				if ([scannedString hasPrefix:key]) {
-					*value = baseQuantity * [[NSDate _unitMultiplierValues][index] longLongValue];
-					didSetValue = YES;
-					*stop = YES;
-				}
-			}];
+    *value = negative ? -result : result;
+
+    return index;
+}
+
+/*!
+ Scans an optional sign and digits the way -[NSString longLongValue] does, saturating on overflow.
+ */
+static long long AJRTimePeriodScanLongLong(CFStringInlineBuffer *buffer, CFIndex index, CFIndex length) {
+    BOOL negative = NO;
+    unsigned long long magnitude = 0;
+    UniChar character = AJRTimePeriodCharacterAt(buffer, index, length);
+
+    if (character == '+' || character == '-') {
+        negative = character == '-';
+        character = AJRTimePeriodCharacterAt(buffer, ++index, length);
+    }
+    while (AJRTimePeriodIsDigit(character)) {
+        if (magnitude <= (unsigned long long)LLONG_MAX + 1) {
+            magnitude = magnitude * 10 + (character - '0');
         }
+        character = AJRTimePeriodCharacterAt(buffer, ++index, length);
     }
-    
-    // If we didn't scan a multiplier, but we did scan
-    // a quantity, the value is the quantity by itself
-    // i.e. an implicit multiplier of 1
-    if (!didSetValue && scannedQuantity) {
-        *value = baseQuantity * baseMultiplier;
-        didSetValue = YES;
+    if (negative) {
+        return magnitude > (unsigned long long)LLONG_MAX ? LLONG_MIN : -(long long)magnitude;
     }
-    
-    return didSetValue;
+    return magnitude > (unsigned long long)LLONG_MAX ? LLONG_MAX : (long long)magnitude;
 }
 
-static BOOL _ajrScanLongLongQuantityAndMultiplier(NSScanner *scanner, long long *value, double baseMultiplier) {
-	double intermediateValue;
-	BOOL result = _ajrScanQuantityAndMultiplier(scanner, &intermediateValue, baseMultiplier);
-	if (result) {
-		AJRSetOutParameter(value, (long long)intermediateValue);
-	}
-	return result;
+/*!
+ Matches a run of letters against our unit names, returning the number of milliseconds in the unit, or 0.0 when the letters don't name one.
+ */
+static double AJRTimePeriodUnitMultiplier(CFStringInlineBuffer *buffer, CFIndex start, CFIndex end) {
+    UniChar lowercased[5];
+    CFIndex count = MIN(end - start, (CFIndex)AJRCountOf(lowercased));
+    for (CFIndex x = 0; x < count; x++) {
+        UniChar character = CFStringGetCharacterFromInlineBuffer(buffer, start + x);
+        lowercased[x] = (character >= 'A' && character <= 'Z') ? character + ('a' - 'A') : character;
+    }
+
+    switch (lowercased[0]) {
+        case 'm':
+            if (count >= 2 && lowercased[1] == 's') return 1.0;
+            if (count >= 5 && lowercased[1] == 'i' && lowercased[2] == 'l' && lowercased[3] == 'l' && lowercased[4] == 'i') return 1.0;
+            if (count >= 2 && lowercased[1] == 'o') return AJRMillisPer30DayMonth;
+            return AJRMillisPerMinute;
+        case 's': return AJRMillisPerSecond;
+        case 'h': return AJRMillisPerHour;
+        case 'd': return AJRMillisPerDay;
+        case 'w': return AJRMillisPerWeek;
+        case 'y': return AJRMillisPer365DayYear;
+    }
+    return 0.0;
 }
 
-+ (long long)millisecondsForTimePeriodString:(NSString *)value defaultValue:(long long)defaultValue {
-    long long longLongValue = defaultValue;
-    
-    if ([value length]) {
-        NSScanner *scanner = [NSScanner scannerWithString:value];
-        long long scannedValue;
-        long long startingValue = 0;
-        
-        while (_ajrScanLongLongQuantityAndMultiplier(scanner, &scannedValue, 1.0)) {
-            startingValue += scannedValue;
-        }
-        
-        if (startingValue != 0LL) {
-            longLongValue = startingValue;
+static NSTimeInterval AJRTimePeriodClockInterval(CFStringInlineBuffer *buffer, CFIndex length, const CFIndex *fieldStarts, NSUInteger fieldCount) {
+    // fieldStarts holds the last (up to) four fields, with seconds last.
+    double fields[4] = { 0.0, 0.0, 0.0, 0.0 };
+    for (NSUInteger x = 0; x < fieldCount; x++) {
+        CFIndex index = AJRTimePeriodSkipWhitespace(buffer, fieldStarts[x], length);
+        if (x == fieldCount - 1) {
+            AJRTimePeriodScanDouble(buffer, index, length, &fields[4 - fieldCount + x]);
+        } else {
+            fields[4 - fieldCount + x] = (double)AJRTimePeriodScanLongLong(buffer, index, length);
         }
     }
-    
-    return longLongValue;
+    return fields[3] + fields[2] * AJRSecondsPerMinute + fields[1] * AJRSecondsPerHour + fields[0] * AJRSecondsPerDay;
 }
 
-+ (NSTimeInterval)timeIntervalForTimePeriodString:(NSString *)value defaultValue:(NSTimeInterval)defaultValue {
-    NSTimeInterval timeIntervalValue = defaultValue;
-    
-    if ([value length]) {
-        NSScanner *scanner = [NSScanner scannerWithString:value];
-        double scannedValue;
-		BOOL first = YES;
-        
-        while (_ajrScanQuantityAndMultiplier(scanner, &scannedValue, AJRMillisPerSecond)) {
-			if (first) {
-				timeIntervalValue = (double)scannedValue / 1000.0;
-				first = NO;
-			} else {
-				timeIntervalValue += (double)scannedValue / 1000.0;
-			}
-		}
+void AJRParseTimePeriod(NSString *string, AJRTimePeriod *period) {
+    CFIndex length = (CFIndex)[string length];
+    CFStringInlineBuffer buffer;
+    CFIndex index = 0;
+
+    period->milliseconds = 0LL;
+    period->periodInterval = 0.0;
+    period->timeInterval = 0.0;
+    period->termCount = 0;
+    period->isClockTime = NO;
+
+    if (length == 0) {
+        return;
+    }
+    CFStringInitInlineBuffer((__bridge CFStringRef)string, &buffer, CFRangeMake(0, length));
+
+    while (YES) {
+        double quantity = 1.0;
+        BOOL scannedQuantity = NO;
+        double multiplier = 0.0;
+
+        index = AJRTimePeriodSkipWhitespace(&buffer, index, length);
+        CFIndex end = AJRTimePeriodScanDouble(&buffer, index, length, &quantity);
+        if (end != index) {
+            scannedQuantity = YES;
+            index = end;
+        }
+
+        index = AJRTimePeriodSkipWhitespace(&buffer, index, length);
+        end = index;
+        while (end < length && AJRTimePeriodIsLetter(CFStringGetCharacterFromInlineBuffer(&buffer, end))) {
+            end++;
+        }
+        if (end != index) {
+            multiplier = AJRTimePeriodUnitMultiplier(&buffer, index, end);
+            index = end;
+        }
+
+        if (multiplier == 0.0 && !scannedQuantity) {
+            break;
+        }
+
+        // A bare number means milliseconds to one caller, and seconds to the other.
+        double milliseconds = quantity * (multiplier != 0.0 ? multiplier : 1.0);
+        double interval = (multiplier != 0.0 ? quantity * multiplier : quantity * AJRMillisPerSecond) / 1000.0;
+        period->milliseconds += (long long)milliseconds;
+        period->periodInterval = period->termCount == 0 ? interval : period->periodInterval + interval;
+        period->termCount++;
+    }
+
+    // Colons can't appear in a term, so the terms stop at or before the first colon. Clock fields
+    // are evaluated last to first, so we only need to remember where the last four begin.
+    CFIndex fieldStarts[4] = { 0, 0, 0, 0 };
+    NSUInteger fieldCount = 1;
+    for (; index < length; index++) {
+        if (CFStringGetCharacterFromInlineBuffer(&buffer, index) == ':') {
+            memmove(fieldStarts, fieldStarts + 1, sizeof(CFIndex) * 3);
+            fieldStarts[3] = index + 1;
+            fieldCount = MIN(fieldCount + 1, 4);
+            period->isClockTime = YES;
+        }
+    }
+
+    if (period->isClockTime) {
+        period->timeInterval = AJRTimePeriodClockInterval(&buffer, length, fieldStarts + (4 - fieldCount), fieldCount);
+    } else {
+        period->timeInterval = period->periodInterval;
     }
-    
-    return timeIntervalValue;
 }
 
-@end
+void AJRParseTimePeriodUsingCache(NSString *string, AJRTimePeriod *period) {
+    static NSMapTable<NSString *, NSValue *> *cache = nil;
+    static NSLock *cacheLock = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        // Copying the keys means a mutable string can't change a cached entry out from under us.
+        cache = [NSMapTable mapTableWithKeyOptions:NSPointerFunctionsStrongMemory | NSPointerFunctionsObjectPersonality | NSPointerFunctionsCopyIn valueOptions:NSPointerFunctionsStrongMemory];
+        cacheLock = [[NSLock alloc] init];
+    });
+
+    if (string == nil) {
+        AJRParseTimePeriod(string, period);
+        return;
+    }
+
+    [cacheLock lock];
+    NSValue *value = [cache objectForKey:string];
+    [cacheLock unlock];
+
+    if (value != nil) {
+        [value getValue:period size:sizeof(AJRTimePeriod)];
+    } else {
+        AJRParseTimePeriod(string, period);
+        value = [NSValue valueWithBytes:period objCType:@encode(AJRTimePeriod)];
+        [cacheLock lock];
+        if (cache.count < AJRTimePeriodCacheLimit) {
+            [cache setObject:value forKey:string];
+        }
+        [cacheLock unlock];
+    }
+}
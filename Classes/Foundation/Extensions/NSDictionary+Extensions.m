@@ -35,6 +35,7 @@
 #import "AJRFunctions.h"
 #import "AJRLogging.h"
 #import "NSArray+Extensions.h"
+#import "NSDate+Extensions.h"
 #import "NSMutableDictionary+Extensions.h"
 #import "NSObject+Extensions.h"
 #import "NSString+Extensions.h"
@@ -151,6 +152,29 @@ static void _AJRSetObjectNilObjectOrKey(id self, id object, id key) {
 @end
 
 
+/*!
+ Durations in dictionaries usually come from configuration, so the same handful of strings get parsed on every lookup. These go through the time period cache, so that each is only parsed once.
+ */
+static NSTimeInterval AJRTimeIntervalFromValue(id value, NSTimeInterval defaultValue) {
+    if (value == nil) return defaultValue;
+    if ([value isKindOfClass:[NSNumber class]]) {
+        return [value doubleValue];
+    }
+    AJRTimePeriod period;
+    AJRParseTimePeriodUsingCache([value isKindOfClass:[NSString class]] ? value : [value description], &period);
+    return period.timeInterval;
+}
+
+static long long AJRMillisecondsFromValue(id value, long long defaultValue) {
+    if (value == nil) return defaultValue;
+    if ([value isKindOfClass:[NSNumber class]]) {
+        return [value longLongValue];
+    }
+    AJRTimePeriod period;
+    AJRParseTimePeriodUsingCache([value isKindOfClass:[NSString class]] ? value : [value description], &period);
+    return period.milliseconds;
+}
+
 @implementation NSDictionary (Extensions)
 
 - (id)objectForKey:(NSString *)key defaultValue:(id)defaultValue {
@@ -268,33 +292,19 @@ static void _AJRSetObjectNilObjectOrKey(id self, id object, id key) {
 }
 
 - (NSTimeInterval)timeIntervalForKey:(NSString *)key defaultValue:(NSTimeInterval)defaultValue {
-    NSString *value = [self objectForKey:key];
-    if (!value) return defaultValue;
-    if ([value isKindOfClass:[NSNumber class]]) {
-        return value.doubleValue;
-    }
-    return [value description].timeIntervalValue;
+    return AJRTimeIntervalFromValue([self objectForKey:key], defaultValue);
 }
 
 - (NSTimeInterval)timeIntervalForKeyPath:(NSString *)key defaultValue:(NSTimeInterval)defaultValue {
-    NSString *value = [self valueForKeyPath:key];
-    if (!value) return defaultValue;
-    if ([value isKindOfClass:[NSNumber class]]) {
-        return value.doubleValue;
-    }
-    return [[value description] timeIntervalValue];
+    return AJRTimeIntervalFromValue([self valueForKeyPath:key], defaultValue);
 }
 
 - (long long)millisecondsForKey:(NSString *)key defaultValue:(long long)defaultValue {
-    NSString *value = [self objectForKey:key];
-    if (!value) return defaultValue;
-    return [value millisecondsValue];
+    return AJRMillisecondsFromValue([self objectForKey:key], defaultValue);
 }
 
 - (long long)millisecondsForKeyPath:(NSString *)key defaultValue:(long long)defaultValue {
-    NSString *value = [self valueForKeyPath:key];
-    if (!value) return defaultValue;
-    return [value millisecondsValue];
+    return AJRMillisecondsFromValue([self valueForKeyPath:key], defaultValue);
 }
 
 - (NSNumber *)numberForKey:(NSString *)key defaultValue:(NSNumber *)defaultValue {
@@ -41,6 +41,24 @@ NS_ASSUME_NONNULL_BEGIN
 
 extern mode_t AJRGetUMask(void);
 
+/*!
+ Describes how removeBytesInRange:strategy:error: and replaceDataInRange:withData:strategy:error: moved the contents of the file.
+ */
+typedef NS_ENUM(NSInteger, AJRFileEditStrategy) {
+    /// Nothing in the file needed to move.
+    AJRFileEditStrategyNone,
+    /// The range ran to the end of the file, so the file was just truncated.
+    AJRFileEditStrategyTruncate,
+    /// The file system collapsed or inserted blocks with fallocate(2), so no data was copied.
+    AJRFileEditStrategyFallocate,
+    /// The data was moved by the kernel with copy_file_range(2).
+    AJRFileEditStrategyCopyFileRange,
+    /// The data was moved with large pread(2) / pwrite(2) calls.
+    AJRFileEditStrategyReadWrite,
+    /// The handle has no file descriptor, such as an AJRMemoryHandle, so the data was moved by seeking, reading, and writing the handle.
+    AJRFileEditStrategyHandle,
+};
+
 /*!
  Declares that NSFileHandle will implement the various read convenience methods. This will be added to NSFileHandle via AJRAddReaderConveniencesToReader().
  */
@@ -81,7 +99,16 @@ extern mode_t AJRGetUMask(void);
  This method isn't currently correct. It basically assumes the file is ASCII (or ISO-Latin-1) encoded and can only terminate on character, if character is in the range of 0 to 255.
  */
 - (NSString *)readToCharacter:(uint32_t)character error:(out NSError * _Nullable * _Nullable)error;
-- (NSData *)readToByte:(uint8_t)aByte error:(out NSError * _Nullable * _Nullable)error;
+/*!
+ Reads up to, but not including, `aByte`, leaving `aByte` as the next byte to read. On a seekable file, the file is read in large chunks and searched with memchr(), so this is efficient even for very long records. A handle that can't seek, such as a pipe, is read a byte at a time, and since the delimiter can't be put back, it's consumed.
+
+ @returns The bytes read. If EOF is reached before `aByte`, returns the remaining bytes, or nil, without an error, if no bytes remain.
+ */
+- (nullable NSData *)readToByte:(uint8_t)aByte error:(out NSError * _Nullable * _Nullable)error;
+/*!
+ Like readToByte:error:, but for a delimiter longer than one byte, such as the CR/LF that terminates records in many network protocols. As with readToByte:error:, the delimiter is left as the next bytes to read, unless the handle can't seek.
+ */
+- (nullable NSData *)readToDelimiter:(NSData *)delimiter error:(out NSError * _Nullable * _Nullable)error;
 // Requires that the file can seek.
 - (NSString *)readCharactersInSet:(NSCharacterSet *)characters error:(out NSError **)error;
 - (NSString *)readToCharacterFromSet:(NSCharacterSet *)characters error:(out NSError * _Nullable * _Nullable)error;
@@ -104,6 +131,23 @@ extern mode_t AJRGetUMask(void);
 - (BOOL)removeBytesInRange:(NSRange)range error:(out NSError * _Nullable * _Nullable)error;
 - (BOOL)replaceDataInRange:(NSRange)range withData:(NSData *)data error:(out NSError * _Nullable * _Nullable)error;
 
+/*!
+ Removes range from the file, shifting everything after it down.
+
+ Where the platform and file system allow it, and the range is aligned to the file system's block size, the blocks are simply collapsed out of the file with fallocate(2). Otherwise the tail of the file is moved with copy_file_range(2), when available and the range is large, or with large pread(2) / pwrite(2) calls.
+
+ @param range The range to remove. Ranges starting past the end of the file do nothing, and ranges extending past the end are clipped.
+ @param strategy On success, initialized with how the file's contents were moved.
+ @param error On failure, initialized with the error that occurred.
+
+ @returns YES on success.
+ */
+- (BOOL)removeBytesInRange:(NSRange)range strategy:(out nullable AJRFileEditStrategy *)strategy error:(out NSError * _Nullable * _Nullable)error;
+/*!
+ Replaces range with data, growing or shrinking the file as needed. When the file grows, the new space is inserted with fallocate(2) where possible, otherwise the tail of the file is moved as described for removeBytesInRange:strategy:error:.
+ */
+- (BOOL)replaceDataInRange:(NSRange)range withData:(NSData *)data strategy:(out nullable AJRFileEditStrategy *)strategy error:(out NSError * _Nullable * _Nullable)error;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -29,8 +29,14 @@
  ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#if defined(__linux__)
+// For fallocate() and copy_file_range().
+#define _GNU_SOURCE
+#endif
+
 #import "NSFileHandle+Extensions.h"
 
+#import "AJRBufferedReaderP.h"
 #import "AJRFormat.h"
 #import "AJRFunctions.h"
 #import "AJRLogging.h"
@@ -39,10 +45,17 @@
 #import "NSObject+AJRUserInfo.h"
 
 #import <iconv.h>
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <linux/falloc.h>
+#endif
 
 #define BUFFERSIZE    16384
 #define BUFFERSIZE32  (BUFFERSIZE / sizeof(uint32_t))
+// Used when shifting the contents of a file. Large enough that each system call moves a useful amount of data.
+#define AJRFileLargeBufferSize  (4 * 1024 * 1024)
 
 typedef NS_ENUM(uint8_t, AJRUnicodeAction) {
 	AJRUnicodeActionContinue,
@@ -327,65 +340,15 @@ mode_t AJRGetUMask(void) {
 	} error:error];
 }
 
-- (BOOL)readToByte:(uint8_t)byte buffer:(out uint8_t **)outputBuffer length:(out size_t *)outputLength error:(out NSError **)error {
-	NSError *localError;
-	size_t bufferSize = BUFFERSIZE;
-	uint8_t *buffer = (uint8_t *)malloc(bufferSize);
-    NSInteger pos = 0;
-    AJRReadFunction reader = (AJRReadFunction)[self methodForSelector:@selector(readBytes:length:)];
-	BOOL done = NO;
-	BOOL hitEOF = NO;
-    
-    while (!done) {
-		if (pos == bufferSize / sizeof(uint8_t)) {
-			bufferSize += BUFFERSIZE;
-			buffer = (uint8_t *)realloc(buffer, bufferSize);
-		}
-		size_t bytesRead = reader(self, @selector(readBytes:length:), buffer + pos, 1);
-		if (bytesRead == 0) {
-			hitEOF = YES;
-			done = YES;
-		} else if (bytesRead == AJR_READ_ERROR) {
-			localError = [NSError errorWithDomain:NSPOSIXErrorDomain errorNumber:errno];
-			done = YES;
-		} else if (buffer[pos] == byte) {
-			[self ajr_seekToOffset:[self offsetInFile] - 1 error:&localError];
-			done = YES;
-		} else {
-			pos += 1;
-		}
-    }
-
-	if (localError == nil) {
-		if (pos == 0 && hitEOF) {
-			// We read no data, but had no error, so initialize the output parameters accordingly. Also free the buffer, since we're not going to return it.
-			AJRSetOutParameter(outputBuffer, NULL);
-			AJRSetOutParameter(outputLength, 0);
-			NSZoneFree(NULL, buffer);
-		} else {
-			// No errors, so initialize the output parameters.
-			AJRSetOutParameter(outputBuffer, buffer);
-			AJRSetOutParameter(outputLength, pos);
-		}
-	} else {
-		// We had an error, so we have to free our own buffer.
-		NSZoneFree(NULL, buffer);
-	}
-
-	return AJRAssertOrPropagateError(localError == nil, error, localError);
+- (NSData *)readToByte:(uint8_t)byte error:(out NSError **)error {
+	// Seekable files are scanned a chunk at a time, with whatever we read past the delimiter handed back to the file. Other files, like pipes, are read only as far as the delimiter, which can't be handed back, so it's consumed.
+	AJRBufferedReader *reader = AJRBufferedReaderAttachedToReader(self);
+	return [reader readDataToByte:byte consumeDelimiter:!AJRBufferedReaderReturnsUnconsumedBytes(reader) error:error];
 }
 
-- (NSData *)readToByte:(uint8_t)byte error:(out NSError **)error {
-	NSError *localError;
-	uint8_t *buffer;
-	size_t length;
-	NSData *data;
-	if ([self readToByte:byte buffer:&buffer length:&length error:&localError]) {
-		data = (length == 0 && buffer == NULL) ? nil : [[NSData alloc] initWithBytesNoCopy:buffer length:length freeWhenDone:YES];
-	} else {
-		AJRSetOutParameter(error, localError);
-	}
-	return data;
+- (NSData *)readToDelimiter:(NSData *)delimiter error:(out NSError **)error {
+	AJRBufferedReader *reader = AJRBufferedReaderAttachedToReader(self);
+	return [reader readDataToDelimiter:delimiter consumeDelimiter:!AJRBufferedReaderReturnsUnconsumedBytes(reader) error:error];
 }
 
 - (NSString *)readToCharacterFromSet:(NSCharacterSet *)characters error:(out NSError **)error {
@@ -478,96 +441,285 @@ mode_t AJRGetUMask(void) {
 
 #pragma mark - Changing File Length
 
-- (BOOL)removeBytesInRange:(NSRange)range error:(out NSError **)error {
-    unsigned char buffer[BUFFERSIZE];
-	NSUInteger readLength = 0;
-    NSUInteger position = range.location;
-    unsigned long long fileLength;
+- (BOOL)_ajr_fileDescriptor:(out int *)fileDescriptor length:(out off_t *)fileLength error:(out NSError **)error {
 	NSError *localError = nil;
-	BOOL success = NO;
-    
-	success = [self ajr_seekToEndReturningOffset:&fileLength error:&localError];
-    
-	if (success) {
-		if (range.location > fileLength) {
-			success = YES;
-		} else if (range.location + range.length == fileLength) {
-			success = [self ajr_truncateAtOffset:range.location error:error];
+	int descriptor = -1;
+	
+	@try {
+		// Throws on a closed handle.
+		descriptor = self.fileDescriptor;
+	} @catch (NSException *localException) {
+		localError = [NSError errorWithDomain:NSPOSIXErrorDomain code:EBADF message:[localException description]];
+	}
+	if (localError == nil) {
+		if (descriptor < 0) {
+			// Not backed by a file, for example, an AJRMemoryHandle, so fall back to seeking.
+			unsigned long long length;
+			if ([self ajr_seekToEndReturningOffset:&length error:&localError]) {
+				*fileLength = (off_t)length;
+			}
 		} else {
-			do {
-				success = [self ajr_seekToOffset:position + range.length error:&localError];
-				if (success) {
-					readLength = [self readBytes:buffer length:BUFFERSIZE];
-					if (readLength > 0) {
-						[self seekToFileOffset:position];
-						if (![self writeBytes:buffer length:BUFFERSIZE error:&localError]) {
-							success = NO;
-						}
+			struct stat info;
+			if (fstat(descriptor, &info) == 0) {
+				*fileLength = info.st_size;
+			} else {
+				localError = [NSError errorWithDomain:NSPOSIXErrorDomain errorNumber:errno];
+			}
+		}
+	}
+	*fileDescriptor = descriptor;
+	
+	return AJRAssertOrPropagateError(localError == nil, error, localError);
+}
+
+#if defined(__linux__)
+/*! Whether offset and length line up with the file system's blocks, which is what fallocate(2) requires to collapse or insert ranges. */
+static BOOL AJRFileRangeIsBlockAligned(int fileDescriptor, off_t offset, off_t length) {
+	struct stat info;
+	return (fstat(fileDescriptor, &info) == 0
+			&& info.st_blksize > 0
+			&& offset % info.st_blksize == 0
+			&& length % info.st_blksize == 0);
+}
+#endif
+
+/*! Writes all of bytes at offset, retrying short and interrupted writes. A write that makes no progress fails with EIO. */
+static BOOL AJRFileWriteAll(int fileDescriptor, const uint8_t *bytes, size_t length, off_t offset, NSError **error) {
+	size_t written = 0;
+	while (written < length) {
+		ssize_t result = pwrite(fileDescriptor, bytes + written, length - written, offset + written);
+		if (result < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			AJRSetOutParameter(error, [NSError errorWithDomain:NSPOSIXErrorDomain errorNumber:errno]);
+			return NO;
+		}
+		if (result == 0) {
+			// Shouldn't happen for a regular file, but don't spin forever if it does.
+			AJRSetOutParameter(error, [NSError errorWithDomain:NSPOSIXErrorDomain errorNumber:EIO]);
+			return NO;
+		}
+		written += result;
+	}
+	return YES;
+}
+
+/*!
+ Copies length bytes from source to destination within the same file. The ranges may overlap. Returns the strategy used, or AJRFileEditStrategyNone with error initialized on failure.
+ */
+static AJRFileEditStrategy AJRFileMoveRange(int fileDescriptor, off_t source, off_t destination, off_t length, NSError **error) {
+	off_t distance = source > destination ? source - destination : destination - source;
+	BOOL forward = destination < source;
+	
+#if defined(__linux__)
+	// copy_file_range() refuses overlapping ranges within a file, so each chunk can be at most the distance we're moving. When that's large, the kernel can do the copy without it ever passing through user space, or even share extents on file systems that support it.
+	if (distance >= AJRFileLargeBufferSize) {
+		off_t remaining = length;
+		BOOL supported = YES;
+		while (remaining > 0 && supported) {
+			size_t chunk = (size_t)MIN(remaining, distance);
+			off_t chunkStart = forward ? source + (length - remaining) : source + remaining - (off_t)chunk;
+			// A chunk never overlaps its destination, so it's safe to copy front to back. We have to finish it before moving on, though, because when moving backward the next chunk is below this one, and a short copy would otherwise leave this chunk's tail behind.
+			size_t copiedSoFar = 0;
+			while (copiedSoFar < chunk) {
+				off_t in = chunkStart + (off_t)copiedSoFar;
+				off_t out = in + (destination - source);
+				ssize_t copied = copy_file_range(fileDescriptor, &in, fileDescriptor, &out, chunk - copiedSoFar, 0);
+				if (copied < 0) {
+					if (errno == EINTR) {
+						continue;
 					}
-					position += readLength;
+					if ((errno == ENOSYS || errno == EXDEV || errno == EOPNOTSUPP || errno == EINVAL) && remaining == length && copiedSoFar == 0) {
+						supported = NO;
+						break;
+					}
+					AJRSetOutParameter(error, [NSError errorWithDomain:NSPOSIXErrorDomain errorNumber:errno]);
+					return AJRFileEditStrategyNone;
+				} else if (copied == 0) {
+					// The file got shorter underneath us.
+					AJRSetOutParameter(error, [NSError errorWithDomain:NSPOSIXErrorDomain errorNumber:EIO]);
+					return AJRFileEditStrategyNone;
 				}
-			} while (success && readLength == BUFFERSIZE);
-			
-			if (success) {
-				success = [self ajr_truncateAtOffset:fileLength - range.length error:error];
+				copiedSoFar += (size_t)copied;
+			}
+			if (supported) {
+				remaining -= (off_t)chunk;
+			}
+		}
+		if (supported) {
+			return AJRFileEditStrategyCopyFileRange;
+		}
+	}
+#endif
+	
+	// Because we read each chunk completely before writing it, the chunks can overlap, as long as we walk in the direction of the move.
+	size_t bufferSize = (size_t)MIN(length, (off_t)AJRFileLargeBufferSize);
+	uint8_t *buffer = malloc(MAX(bufferSize, (size_t)1));
+	off_t remaining = length;
+	NSError *localError = nil;
+	
+	while (remaining > 0 && localError == nil) {
+		size_t chunk = (size_t)MIN(remaining, (off_t)bufferSize);
+		off_t in = forward ? source + (length - remaining) : source + remaining - (off_t)chunk;
+		off_t out = in + (destination - source);
+		ssize_t bytesRead = pread(fileDescriptor, buffer, chunk, in);
+		if (bytesRead < 0 && errno == EINTR) {
+			continue;
+		}
+		if (bytesRead <= 0 || (size_t)bytesRead != chunk) {
+			localError = [NSError errorWithDomain:NSPOSIXErrorDomain errorNumber:bytesRead < 0 ? errno : EIO];
+			break;
+		}
+		if (!AJRFileWriteAll(fileDescriptor, buffer, chunk, out, &localError)) {
+			break;
+		}
+		remaining -= chunk;
+	}
+	free(buffer);
+	
+	if (localError != nil) {
+		AJRSetOutParameter(error, localError);
+		return AJRFileEditStrategyNone;
+	}
+	return AJRFileEditStrategyReadWrite;
+}
+
+/*! The fallback for handles without a file descriptor, which can only move bytes through the handle itself. */
+- (BOOL)_ajr_moveBytesFrom:(off_t)source to:(off_t)destination length:(off_t)length error:(out NSError **)error {
+	size_t bufferSize = (size_t)MIN(length, (off_t)AJRFileLargeBufferSize);
+	uint8_t *buffer = malloc(MAX(bufferSize, (size_t)1));
+	BOOL forward = destination < source;
+	off_t remaining = length;
+	NSError *localError = nil;
+	
+	while (remaining > 0 && localError == nil) {
+		size_t chunk = (size_t)MIN(remaining, (off_t)bufferSize);
+		off_t in = forward ? source + (length - remaining) : source + remaining - (off_t)chunk;
+		size_t bytesRead = 0;
+		if ([self ajr_seekToOffset:in error:&localError]
+			&& [self readBytes:buffer length:chunk bytesRead:&bytesRead error:&localError]
+			&& [self ajr_seekToOffset:in + (destination - source) error:&localError]) {
+			[self writeBytes:buffer length:bytesRead error:&localError];
+		}
+		remaining -= chunk;
+	}
+	free(buffer);
+	
+	return AJRAssertOrPropagateError(localError == nil, error, localError);
+}
+
+- (BOOL)removeBytesInRange:(NSRange)range error:(out NSError **)error {
+	return [self removeBytesInRange:range strategy:NULL error:error];
+}
+
+- (BOOL)removeBytesInRange:(NSRange)range strategy:(out AJRFileEditStrategy *)strategyOut error:(out NSError **)error {
+	NSError *localError = nil;
+	AJRFileEditStrategy strategy = AJRFileEditStrategyNone;
+	int fileDescriptor;
+	off_t fileLength;
+	BOOL success = [self _ajr_fileDescriptor:&fileDescriptor length:&fileLength error:&localError];
+	
+	if (success && (off_t)range.location < fileLength && range.length > 0) {
+		off_t location = (off_t)range.location;
+		off_t end = MIN((off_t)(range.location + range.length), fileLength);
+		off_t length = end - location;
+		
+		if (end == fileLength) {
+			// Nothing follows the range, so just truncate.
+			strategy = AJRFileEditStrategyTruncate;
+		} else if (fileDescriptor < 0) {
+			success = [self _ajr_moveBytesFrom:end to:location length:fileLength - end error:&localError];
+			strategy = AJRFileEditStrategyHandle;
+		} else {
+#if defined(__linux__) && defined(FALLOC_FL_COLLAPSE_RANGE)
+			if (AJRFileRangeIsBlockAligned(fileDescriptor, location, length)
+				&& fallocate(fileDescriptor, FALLOC_FL_COLLAPSE_RANGE, location, length) == 0) {
+				// The file system dropped the blocks, and the file is already the right length.
+				strategy = AJRFileEditStrategyFallocate;
+			}
+#endif
+			if (strategy == AJRFileEditStrategyNone) {
+				strategy = AJRFileMoveRange(fileDescriptor, end, location, fileLength - end, &localError);
+				success = strategy != AJRFileEditStrategyNone;
 			}
 		}
+		
+		if (success && strategy != AJRFileEditStrategyFallocate) {
+			success = [self ajr_truncateAtOffset:fileLength - length error:&localError];
+		}
+		if (success && fileDescriptor >= 0) {
+			// Leave the file positioned at the end, just as truncating does.
+			lseek(fileDescriptor, 0, SEEK_END);
+		}
 	}
 	
+	if (success) {
+		AJRSetOutParameter(strategyOut, strategy);
+	}
 	return AJRAssertOrPropagateError(success, error, localError);
 }
 
 - (BOOL)replaceDataInRange:(NSRange)range withData:(NSData *)data error:(out NSError **)error {
-	NSError *localError;
-    size_t dataLength = data.length;
-	BOOL success = NO;
-	unsigned long long fileLength;
-	success = [self ajr_seekToEndReturningOffset:&fileLength error:&localError];
+	return [self replaceDataInRange:range withData:data strategy:NULL error:error];
+}
+
+- (BOOL)replaceDataInRange:(NSRange)range withData:(NSData *)data strategy:(out AJRFileEditStrategy *)strategyOut error:(out NSError **)error {
+	NSError *localError = nil;
+	AJRFileEditStrategy strategy = AJRFileEditStrategyNone;
+	size_t dataLength = data.length;
+	int fileDescriptor;
+	off_t fileLength;
+	BOOL success = [self _ajr_fileDescriptor:&fileDescriptor length:&fileLength error:&localError];
 	
 	if (success) {
+		off_t end = (off_t)(range.location + range.length);
+		
 		if (dataLength == 0) {
 			// Super easy case, because we just call removeBytesInRange...
-			success = [self removeBytesInRange:range error:&localError];
-		} else if (range.location + range.length > fileLength) {
+			success = [self removeBytesInRange:range strategy:&strategy error:&localError];
+		} else if (end > fileLength) {
 			// Out of range.
 			success = NO;
-			localError = [NSError errorWithDomain:NSCocoaErrorDomain format:@"Range %r out of file's range of [0..%llu]", range, fileLength];
-		} else if (range.length == dataLength) {
-			// The easy case, in that the new data is the same length as the old data.
+			localError = [NSError errorWithDomain:NSCocoaErrorDomain format:@"Range %r out of file's range of [0..%llu]", range, (unsigned long long)fileLength];
+		} else if (dataLength <= range.length) {
+			// The easy cases, where the new data fits in the old range, and anything left over is removed.
 			success = ([self ajr_seekToOffset:range.location error:&localError]
-					   && [self writeBytes:[data bytes] length:dataLength error:error]);
-		} else if (dataLength < range.length) {
-			// The next easy case, where the new length is less than the old length.
-			success = ([self ajr_seekToOffset:range.location error:&localError]
-					   && [self writeBytes:[data bytes] length:dataLength error:error]
-					   && [self removeBytesInRange:(NSRange){ range.location + dataLength, range.length - dataLength } error:error]);
+					   && [self writeBytes:[data bytes] length:dataLength error:&localError]);
+			if (success && dataLength < range.length) {
+				success = [self removeBytesInRange:(NSRange){ range.location + dataLength, range.length - dataLength } strategy:&strategy error:&localError];
+			}
 		} else {
-			unsigned char buffer[BUFFERSIZE];
-			long long shift = dataLength - range.length;
-			long long position = fileLength - BUFFERSIZE;
-			size_t tempLength = 0;
-			size_t readLength = BUFFERSIZE;
-			do {
-				if (position < range.location + dataLength) {
-					readLength = (position + BUFFERSIZE) - (range.location + range.length);
-					position = range.location + range.length;
+			// The file has to grow, so move everything after the range up, then write the data.
+			off_t shift = (off_t)(dataLength - range.length);
+			
+			if (fileDescriptor < 0) {
+				success = [self _ajr_moveBytesFrom:end to:end + shift length:fileLength - end error:&localError];
+				strategy = AJRFileEditStrategyHandle;
+			} else {
+#if defined(__linux__) && defined(FALLOC_FL_INSERT_RANGE)
+				if (end < fileLength
+					&& AJRFileRangeIsBlockAligned(fileDescriptor, end, shift)
+					&& fallocate(fileDescriptor, FALLOC_FL_INSERT_RANGE, end, shift) == 0) {
+					strategy = AJRFileEditStrategyFallocate;
 				}
-				success = ([self ajr_seekToOffset:position error:&localError]
-						   && [self readBytes:buffer length:readLength bytesRead:&tempLength error:&localError]);
-				if (success && tempLength > 0) {
-					success = ([self ajr_seekToOffset:position + shift error:&localError]
-							   && [self writeBytes:buffer length:tempLength error:error]);
+#endif
+				if (strategy == AJRFileEditStrategyNone) {
+					strategy = AJRFileMoveRange(fileDescriptor, end, end + shift, fileLength - end, &localError);
+					success = strategy != AJRFileEditStrategyNone;
 				}
-				position -= BUFFERSIZE;
-			} while (success && tempLength == BUFFERSIZE);
+			}
 			
 			if (success) {
 				success = ([self ajr_seekToOffset:range.location error:&localError]
-						   && [self ajr_writeData:data error:error]);
+						   && [self ajr_writeData:data error:&localError]);
 			}
 		}
 	}
 	
+	if (success) {
+		AJRSetOutParameter(strategyOut, strategy);
+	}
 	return AJRAssertOrPropagateError(success, error, localError);
 }
 
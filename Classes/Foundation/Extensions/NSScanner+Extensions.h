@@ -117,4 +117,15 @@ typedef NS_ENUM(NSInteger, AJRTagType) {
 
 @end
 
+/*!
+ Matches word against the month and weekday spellings recognized by -scanDateSegment:segmentType:, for callers that scan dates without an NSScanner.
+
+ @param word The word, which must already be lower case. Only its first three characters are significant.
+ @param length The length of word.
+ @param index Set to the month (1-12) or weekday (1-7, Monday first), or NSNotFound if word isn't recognized.
+
+ @return The type of segment word represents, or AJRDateSegmentStringTypeInvalid.
+ */
+extern AJRDateSegmentStringType AJRDateSegmentTypeForWord(const char *word, NSUInteger length, NSInteger * _Nullable index);
+
 NS_ASSUME_NONNULL_END
@@ -65,6 +65,27 @@ static _ajrDateSpellings dateSpellings[] = {
     { @"sun", 7, AJRDateSegmentStringTypeDayOfWeek }, { @"su", 7, AJRDateSegmentStringTypeDayOfWeek }, { @"snu", 7, AJRDateSegmentStringTypeDayOfWeek }
 };
 
+AJRDateSegmentStringType AJRDateSegmentTypeForWord(const char *word, NSUInteger length, NSInteger *index) {
+    static const char *spellings[sizeof(dateSpellings) / sizeof(_ajrDateSpellings)];
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        for (NSInteger x = 0; x < sizeof(dateSpellings) / sizeof(_ajrDateSpellings); x++) {
+            spellings[x] = [dateSpellings[x].month UTF8String];
+        }
+    });
+
+    // This must match the same entries, in the same order, as -scanDateSegment:segmentType: does with -hasPrefix:.
+    for (NSInteger x = 0; x < sizeof(dateSpellings) / sizeof(_ajrDateSpellings); x++) {
+        size_t spellingLength = strlen(spellings[x]);
+        if (spellingLength <= length && strncmp(word, spellings[x], spellingLength) == 0) {
+            AJRSetOutParameter(index, dateSpellings[x].index);
+            return dateSpellings[x].type;
+        }
+    }
+    AJRSetOutParameter(index, NSNotFound);
+    return AJRDateSegmentStringTypeInvalid;
+}
+
 @implementation NSScanner (AJRExtensions)
 
 - (BOOL)scanTagInto:(NSString * _Nullable * _Nullable)string
@@ -41,6 +41,8 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
+@protocol AJRByteWriter;
+
 /*!
  @category NSString(AJRExtensions)
  @discussion This category provides a number of useful extensions on Apple's NSString implementation.
@@ -159,6 +161,23 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (NSString *)stringByWrappingToWidth:(NSInteger)width NS_SWIFT_NAME(byWrapping(to:));
 
+/*!
+ @abstract Wraps a string directly into a writer.
+
+ @discussion Produces exactly the same text as `stringByWrappingToWidth:firstLinePrefix:prefix:lineSeparator:splitURLs:`, but rather than building a string, the wrapped text is written to `writer` in the writer's encoding as it's produced. This only ever holds a small buffer of output, so it's the better choice when wrapping very long strings to a file or stream.
+
+ @param width The maximum width of a line of the string.
+ @param firstLinePrefix A string to prepend to the first line. If `nil`, then use `prefix`.
+ @param prefix A string to prepend to each line, including the first.
+ @param separator The string used to separate lines.
+ @param flag If YES, URL's may be split.
+ @param writer The writer that receives the wrapped text.
+ @param error Set if the writer fails.
+
+ @return YES if all of the wrapped text was written.
+ */
+- (BOOL)writeByWrappingToWidth:(NSInteger)width firstLinePrefix:(nullable NSString *)firstLinePrefix prefix:(nullable NSString *)prefix lineSeparator:(NSString *)separator splitURLs:(BOOL)flag to:(id <AJRByteWriter>)writer error:(out NSError * _Nullable * _Nullable)error NS_SWIFT_NAME(writeByWrapping(to:firstLinePrefix:prefix:lineSeparator:splitURLs:writer:));
+
 /*!
  @abstract Attempts to remove a prefix from a string.
  @discussion If the receiver begins with the string <EM>other</EM>, this returns a new string based on receiver with the prefix specified by <EM>other</EM> deleted.
@@ -395,7 +414,7 @@ NS_ASSUME_NONNULL_BEGIN
 
 /*!
  @abstract Returns an NSData by parsing hexidecimal string value.
- @discussion Returns an NSData from a string compose of hex bytes, ie, "a800f1...". Ignores all characters not 0-9, A-F, or a-f
+ @discussion Returns an NSData from a string compose of hex bytes, ie, "a800f1...". Decoding stops at the first character that isn't 0-9, A-F, or a-f, or at a trailing unpaired digit, and the bytes decoded up to that point are returned. See AJRHexDecodeCharacters() to decode into your own buffer.
  
  @return If the receiver is valid hexidecimal, then that data is returned as an NSData object, otherwise nil is returned.
  */
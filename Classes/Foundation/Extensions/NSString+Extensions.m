@@ -33,7 +33,9 @@
 
 #import "AJRAutoreleasedMemory.h"
 #import "AJRFunctions.h"
+#import "AJRStreamUtilities.h"
 #import "AJRUnicode.h"
+#import "NSData+Hex.h"
 #import "NSDate+Extensions.h"
 #import "NSMutableString+Extensions.h"
 #import "NSNumber+Extensions.h"
@@ -219,103 +221,265 @@
 
 #pragma mark - Word Wrapping
 
-- (NSInteger)splitPointForLine:(NSString *)line width:(NSInteger)width splitURLs:(BOOL)flag {
-    static NSCharacterSet *splitCharacterSet = nil;
-    static dispatch_once_t onceToken;
-    dispatch_once(&onceToken, ^{
-        // Should include '-', but I was having another issue that needed quick resolution.
-        splitCharacterSet = [NSCharacterSet characterSetWithCharactersInString:@" \t"];
-    });
-    NSRange subrange = NSMakeRange(0, width);
-    NSString *substring = [line substringWithRange:subrange];
-    
-    if (!flag && [line hasPrefix:@"http://"]) {
-        subrange = [line rangeOfCharacterFromSet:splitCharacterSet];
-        if (subrange.length) {
-            if (subrange.location + subrange.length > width) {
-                return subrange.location + subrange.length - 1;
-            }
-        } else {
-            return [line length];
+/*
+ The wrapping engine walks the receiver once, reading characters through a CFStringInlineBuffer and copying each emitted run straight into a single unichar buffer, so wrapping a string doesn't create a substring per line. When a writer is supplied, the buffer is flushed to the writer whenever it fills, rather than grown, which lets arbitrarily long strings be wrapped in constant memory.
+ */
+
+#define AJRWrapBufferSize 1024
+
+typedef struct _ajrWrapOutput {
+    unichar *characters;
+    NSUInteger length;
+    NSUInteger capacity;
+    BOOL ownsCharacters;
+    __unsafe_unretained id <AJRByteWriter> writer;
+    NSError *error;
+} AJRWrapOutput;
+
+static BOOL AJRWrapOutputFlush(AJRWrapOutput *output, BOOL final) {
+    if (output->error == nil && output->length > 0) {
+        NSUInteger length = output->length;
+        // Don't split a surrogate pair across two writes, since each half would be encoded as a lossy character.
+        if (!final && length > 1 && CFStringIsSurrogateHighCharacter(output->characters[length - 1])) {
+            length -= 1;
         }
-    }
-    
-    subrange = [substring rangeOfCharacterFromSet:splitCharacterSet options:NSBackwardsSearch];
-    if (subrange.location != NSNotFound) {
-        width = subrange.location + subrange.length;
-        
-        if (!flag) {
-            NSRange one = [substring rangeOfString:@"<" options:NSBackwardsSearch];
-            if (one.location != NSNotFound && one.location > width) {
-                NSRange two = [substring rangeOfString:@">" options:NSBackwardsSearch];
-                if (two.location == NSNotFound) {
-                    two = [line rangeOfString:@">" options:0 range:(NSRange){width, [line length] - width}];
-                    if (two.location != NSNotFound) {
-                        return two.location + two.length;
-                    }
-                }
-            }
+        NSString *string = [[NSString alloc] initWithCharactersNoCopy:output->characters length:length freeWhenDone:NO];
+        NSError *localError = nil;
+        if (!AJRWriteString(output->writer, string, NULL, &localError)) {
+            output->error = localError ?: [NSError errorWithDomain:NSPOSIXErrorDomain code:EIO message:@"Failed to write wrapped string."];
         }
-        
-        return width;
+        memmove(output->characters, output->characters + length, (output->length - length) * sizeof(unichar));
+        output->length -= length;
+    }
+    return output->error == nil;
+}
+
+static BOOL AJRWrapOutputMakeRoom(AJRWrapOutput *output, NSUInteger needed) {
+    if (output->writer != nil) {
+        return AJRWrapOutputFlush(output, NO);
+    }
+    NSUInteger capacity = output->capacity * 2;
+    while (capacity - output->length < needed) {
+        capacity *= 2;
+    }
+    if (output->ownsCharacters) {
+        output->characters = reallocf(output->characters, capacity * sizeof(unichar));
     } else {
-        return width;
+        unichar *characters = malloc(capacity * sizeof(unichar));
+        memcpy(characters, output->characters, output->length * sizeof(unichar));
+        output->characters = characters;
+        output->ownsCharacters = YES;
+    }
+    output->capacity = capacity;
+    if (output->characters == NULL) {
+        output->length = 0;
+        output->capacity = 0;
+        output->error = [NSError errorWithDomain:NSPOSIXErrorDomain code:ENOMEM message:@"Unable to allocate memory for wrapped string."];
     }
+    return output->error == nil;
 }
 
-- (NSString*)stringByWrappingToWidth:(NSInteger)width withLineSeparator:(NSString *)separator {
-    return [self stringByWrappingToWidth:width firstLinePrefix:nil prefix:@"" lineSeparator:separator splitURLs:YES];
+static void AJRWrapOutputAppendRange(AJRWrapOutput *output, CFStringRef string, CFRange range) {
+    while (range.length > 0 && output->error == nil) {
+        if (output->length == output->capacity && !AJRWrapOutputMakeRoom(output, range.length)) {
+            return;
+        }
+        CFIndex count = MIN(range.length, (CFIndex)(output->capacity - output->length));
+        CFStringGetCharacters(string, CFRangeMake(range.location, count), output->characters + output->length);
+        output->length += count;
+        range.location += count;
+        range.length -= count;
+    }
 }
 
-- (NSString*)stringByWrappingToWidth:(NSInteger)width withLineSeparator:(NSString *)separator splitURLs:(BOOL)flag {
-    return [self stringByWrappingToWidth:width firstLinePrefix:nil prefix:@"" lineSeparator:separator splitURLs:flag];
+static inline void AJRWrapOutputAppendString(AJRWrapOutput *output, CFStringRef string) {
+    AJRWrapOutputAppendRange(output, string, CFRangeMake(0, CFStringGetLength(string)));
 }
 
-- (NSString*)stringByWrappingToWidth:(NSInteger)width prefix:(NSString *)prefix lineSeparator:(NSString *)separator splitURLs:(BOOL)flag {
-    return [self stringByWrappingToWidth:width firstLinePrefix:nil prefix:prefix lineSeparator:separator splitURLs:flag];
+static inline BOOL AJRWrapIsWhitespace(UniChar character) {
+    if (character < 0x80) {
+        return character == ' ' || (character >= '\t' && character <= '\r');
+    }
+    return CFCharacterSetIsCharacterMember(CFCharacterSetGetPredefined(kCFCharacterSetWhitespaceAndNewline), character);
+}
+
+static inline BOOL AJRWrapIsBreak(UniChar character) {
+    // Should include '-', but I was having another issue that needed quick resolution.
+    return character == ' ' || character == '\t';
+}
+
+/*!
+ Returns the offset from `start` at which the line running from `start` to `end` should be split. The window of `width` characters is scanned once, noting the last break, the last '<' and whether any '>' was seen, which is everything the URL and tag heuristics need.
+ */
+static CFIndex AJRWrapSplitPoint(CFStringInlineBuffer *buffer, CFIndex start, CFIndex end, CFIndex width, BOOL splitURLs) {
+    static const UniChar http[] = { 'h', 't', 't', 'p', ':', '/', '/' };
+
+    if (!splitURLs && end - start >= (CFIndex)AJRCountOf(http)) {
+        BOOL isURL = YES;
+        for (CFIndex x = 0; isURL && x < (CFIndex)AJRCountOf(http); x++) {
+            isURL = CFStringGetCharacterFromInlineBuffer(buffer, start + x) == http[x];
+        }
+        if (isURL) {
+            CFIndex index = start;
+            while (index < end && !AJRWrapIsBreak(CFStringGetCharacterFromInlineBuffer(buffer, index))) {
+                index++;
+            }
+            if (index == end) {
+                return end - start;
+            }
+            if (index - start + 1 > width) {
+                return index - start;
+            }
+        }
+    }
+
+    CFIndex lastBreak = kCFNotFound;
+    CFIndex lastOpen = kCFNotFound;
+    BOOL hasClose = NO;
+    for (CFIndex index = start; index < start + width; index++) {
+        UniChar character = CFStringGetCharacterFromInlineBuffer(buffer, index);
+        if (AJRWrapIsBreak(character)) {
+            lastBreak = index;
+        } else if (character == '<') {
+            lastOpen = index;
+        } else if (character == '>') {
+            hasClose = YES;
+        }
+    }
+
+    if (lastBreak != kCFNotFound) {
+        CFIndex split = lastBreak - start + 1;
+        if (!splitURLs && lastOpen != kCFNotFound && lastOpen - start > split && !hasClose) {
+            // We're in the middle of a tag, so try to keep it on one line.
+            for (CFIndex index = start + split; index < end; index++) {
+                if (CFStringGetCharacterFromInlineBuffer(buffer, index) == '>') {
+                    return index - start + 1;
+                }
+            }
+        }
+        return split;
+    }
+
+    // No break, so we have to split the word, but avoid splitting a surrogate pair when we can.
+    if (width > 1
+        && start + width < end
+        && CFStringIsSurrogateHighCharacter(CFStringGetCharacterFromInlineBuffer(buffer, start + width - 1))
+        && CFStringIsSurrogateLowCharacter(CFStringGetCharacterFromInlineBuffer(buffer, start + width))) {
+        return width - 1;
+    }
+    return width;
 }
 
-- (NSString*)stringByWrappingToWidth:(NSInteger)width firstLinePrefix:(NSString *)firstLinePrefixIn prefix:(NSString *)prefix lineSeparator:(NSString *)separator splitURLs:(BOOL)flag {
-    NSMutableArray *lines = [[self componentsSeparatedByString:separator] mutableCopy];
-    NSMutableString *newString = [NSMutableString string];
-    NSInteger i;
-    NSInteger count = [lines count];
-    NSString *firstLinePrefix = firstLinePrefixIn == nil ? prefix : firstLinePrefixIn;
+static BOOL AJRWrapString(NSString *string, NSInteger width, NSString *firstLinePrefix, NSString *prefix, NSString *separator, BOOL splitURLs, AJRWrapOutput *output) {
+    CFStringRef source = (__bridge CFStringRef)string;
+    CFIndex length = CFStringGetLength(source);
+    CFStringInlineBuffer buffer;
+    CFIndex paragraphStart = 0;
+    BOOL last = NO;
 
-    for (i = 0; i < count; i++) {
-        NSString *line = [lines objectAtIndex:i];
+    // A width of less than one would never let a line get shorter.
+    width = MAX(width, 1);
+
+    CFStringInitInlineBuffer(source, &buffer, CFRangeMake(0, length));
+    while (!last && output->error == nil) {
+        NSRange separatorRange = separator.length ? [string rangeOfString:separator options:0 range:(NSRange){paragraphStart, length - paragraphStart}] : (NSRange){NSNotFound, 0};
+        CFIndex paragraphEnd;
         BOOL first = YES;
 
-        if ([line length] == 0 && i + 1 < count) {
-            [newString appendString:first ? firstLinePrefix : prefix];
+        if (separatorRange.location == NSNotFound) {
+            paragraphEnd = length;
+            last = YES;
+        } else {
+            paragraphEnd = separatorRange.location;
+        }
+
+        if (paragraphStart == paragraphEnd && !last) {
+            AJRWrapOutputAppendString(output, (__bridge CFStringRef)firstLinePrefix);
             first = NO;
-            [newString appendString:separator];
+            AJRWrapOutputAppendString(output, (__bridge CFStringRef)separator);
         }
-        while ([line length] > width) {
-            NSInteger splitPoint = [self splitPointForLine:line width:width splitURLs:flag];
 
-            [newString appendString:first ? firstLinePrefix : prefix];
+        CFIndex lineStart = paragraphStart;
+        while (paragraphEnd - lineStart > width) {
+            CFIndex split = AJRWrapSplitPoint(&buffer, lineStart, paragraphEnd, width, splitURLs);
+            CFIndex lineEnd = lineStart + split;
+
+            AJRWrapOutputAppendString(output, (__bridge CFStringRef)(first ? firstLinePrefix : prefix));
             first = NO;
-            [newString appendString:[[line substringToIndex:splitPoint] stringByDeletingTrailingCharactersInSet:[NSCharacterSet whitespaceAndNewlineCharacterSet]]];
-            line = [[line substringFromIndex:splitPoint] stringByDeletingLeadingCharactersInSet:[NSCharacterSet whitespaceAndNewlineCharacterSet]];
-            [newString appendString:separator];
+            while (lineEnd > lineStart && AJRWrapIsWhitespace(CFStringGetCharacterFromInlineBuffer(&buffer, lineEnd - 1))) {
+                lineEnd--;
+            }
+            AJRWrapOutputAppendRange(output, source, CFRangeMake(lineStart, lineEnd - lineStart));
+            lineStart += split;
+            while (lineStart < paragraphEnd && AJRWrapIsWhitespace(CFStringGetCharacterFromInlineBuffer(&buffer, lineStart))) {
+                lineStart++;
+            }
+            AJRWrapOutputAppendString(output, (__bridge CFStringRef)separator);
         }
-        if ([line length]) {
-            [newString appendString:first ? firstLinePrefix : prefix];
+        if (lineStart < paragraphEnd) {
+            AJRWrapOutputAppendString(output, (__bridge CFStringRef)(first ? firstLinePrefix : prefix));
             first = NO;
-            [newString appendString:line];
-            if (i + 1 < count) {
-                [newString appendString:separator];
+            AJRWrapOutputAppendRange(output, source, CFRangeMake(lineStart, paragraphEnd - lineStart));
+            if (!last) {
+                AJRWrapOutputAppendString(output, (__bridge CFStringRef)separator);
             }
         }
+
+        paragraphStart = paragraphEnd + separatorRange.length;
     }
-    return newString;
+
+    return output->error == nil;
+}
+
+- (NSString*)stringByWrappingToWidth:(NSInteger)width withLineSeparator:(NSString *)separator {
+    return [self stringByWrappingToWidth:width firstLinePrefix:nil prefix:@"" lineSeparator:separator splitURLs:YES];
+}
+
+- (NSString*)stringByWrappingToWidth:(NSInteger)width withLineSeparator:(NSString *)separator splitURLs:(BOOL)flag {
+    return [self stringByWrappingToWidth:width firstLinePrefix:nil prefix:@"" lineSeparator:separator splitURLs:flag];
+}
+
+- (NSString*)stringByWrappingToWidth:(NSInteger)width prefix:(NSString *)prefix lineSeparator:(NSString *)separator splitURLs:(BOOL)flag {
+    return [self stringByWrappingToWidth:width firstLinePrefix:nil prefix:prefix lineSeparator:separator splitURLs:flag];
+}
+
+- (NSString*)stringByWrappingToWidth:(NSInteger)width firstLinePrefix:(NSString *)firstLinePrefix prefix:(NSString *)prefix lineSeparator:(NSString *)separator splitURLs:(BOOL)flag {
+    unichar characters[AJRWrapBufferSize];
+    AJRWrapOutput output = { .characters = characters, .capacity = AJRCountOf(characters) };
+    NSString *result = nil;
+
+    prefix = prefix ?: @"";
+    if (AJRWrapString(self, width, firstLinePrefix ?: prefix, prefix, separator, flag, &output)) {
+        if (output.ownsCharacters) {
+            result = [[NSString alloc] initWithCharactersNoCopy:output.characters length:output.length freeWhenDone:YES];
+            output.ownsCharacters = NO;
+        } else {
+            result = [[NSString alloc] initWithCharacters:output.characters length:output.length];
+        }
+    }
+    if (output.ownsCharacters) {
+        free(output.characters);
+    }
+
+    return result ?: @"";
 }
 
 - (NSString*)stringByWrappingToWidth:(NSInteger)width {
     return [self stringByWrappingToWidth:width withLineSeparator:@"\n"];
 }
 
+- (BOOL)writeByWrappingToWidth:(NSInteger)width firstLinePrefix:(NSString *)firstLinePrefix prefix:(NSString *)prefix lineSeparator:(NSString *)separator splitURLs:(BOOL)flag to:(id <AJRByteWriter>)writer error:(NSError **)error {
+    unichar characters[AJRWrapBufferSize];
+    AJRWrapOutput output = { .characters = characters, .capacity = AJRCountOf(characters), .writer = writer };
+
+    prefix = prefix ?: @"";
+    if (AJRWrapString(self, width, firstLinePrefix ?: prefix, prefix, separator, flag, &output)) {
+        AJRWrapOutputFlush(&output, YES);
+    }
+
+    return AJRAssertOrPropagateError(output.error == nil, error, output.error);
+}
+
 #pragma mark - Words
 
 - (NSString *)wordAtIndex:(NSUInteger)index {
@@ -717,47 +881,36 @@ static unichar _AJRRandomCharacterForType(AJRCharacterType type) {
 
 #pragma mark - Hex Encoding
 
-static inline NSInteger _AJRHexValueFromCharacter(unichar character) {
-    NSInteger nibble = 0;
-
-    if (character >= '0' && character <= '9') {
-        nibble = character - '0';
-    } else if (character >= 'A' && character <= 'F') {
-        nibble = (character - 'A') + 10;
-    } else if (character >= 'a' && character <= 'f') {
-        nibble = (character - 'a') + 10;
-    }
-
-    return nibble;
-}
-
-static inline BOOL _AJRIsHexStringCharacter(unichar character) {
-    return ((character >= '0' && character <= '9') ||
-            (character >= 'A' && character <= 'F') ||
-            (character >= 'a' && character <= 'f'));
-}
-
 - (NSData *)dataFromHexEncodedString {
-    NSMutableData *returnValue = nil;
-    NSInteger x, length = [self length];
-
-    for (x = 0; x < length; x += 2) {
-        unichar value1 = 0;
-        unichar value2 = 0;
-
-        if (x < length && _AJRIsHexStringCharacter(value1 = [self characterAtIndex:x])
-            && x + 1 < length && _AJRIsHexStringCharacter(value2 = [self characterAtIndex:x + 1])) {
-            uint8_t byte = _AJRHexValueFromCharacter(value1) << 4 | _AJRHexValueFromCharacter(value2);
-            if (returnValue == nil) {
-                returnValue = [[NSMutableData alloc] initWithCapacity:ceil(length / 2)];
+    CFStringRef string = (__bridge CFStringRef)self;
+    CFIndex length = CFStringGetLength(string);
+    uint8_t *bytes = (uint8_t *)malloc(MAX(length / 2, 1));
+    size_t written = 0;
+    // Hex is ASCII, so when the string is stored that way, we can decode it in place.
+    const char *characters = CFStringGetCStringPtr(string, kCFStringEncodingASCII);
+
+    if (characters != NULL) {
+        written = AJRHexDecodeCharacters(characters, length, bytes, NULL);
+    } else {
+        // Otherwise, convert a block at a time. The conversion stops at the first character that isn't ASCII, which couldn't have been a digit anyway.
+        char buffer[1024];
+        CFIndex location = 0;
+        while (location < length) {
+            CFIndex converted = CFStringGetBytes(string, CFRangeMake(location, MIN(length - location, (CFIndex)sizeof(buffer))), kCFStringEncodingASCII, 0, false, (UInt8 *)buffer, sizeof(buffer), NULL);
+            size_t consumed = 0;
+            written += AJRHexDecodeCharacters(buffer, converted, bytes + written, &consumed);
+            if (converted == 0 || consumed < (size_t)converted) {
+                break;
             }
-            [returnValue appendBytes:&byte length:1];
-        } else {
-            break;
+            location += converted;
         }
     }
 
-    return returnValue;
+    if (written == 0) {
+        free(bytes);
+        return nil;
+    }
+    return [[NSData alloc] initWithBytesNoCopy:bytes length:written freeWhenDone:YES];
 }
 
 #pragma mark - Word Counting
@@ -779,28 +932,15 @@ static inline BOOL _AJRIsHexStringCharacter(unichar character) {
 #pragma mark - Numeric Conversions
 
 - (NSTimeInterval)timeIntervalValue {
-    NSTimeInterval returnValue = 0.0;
-
-    if ([self rangeOfString:@":"].location != NSNotFound) {
-        NSArray *parts = [self componentsSeparatedByString:@":"];
-        NSInteger count = parts.count;
-        double seconds = [parts[parts.count - 1] doubleValue];
-        double minutes = [parts[parts.count - 2] longLongValue];
-        double hours   = count > 2 ? [parts[parts.count - 3] longLongValue] : 0.0;
-        double days    = count > 3 ? [parts[parts.count - 4] longLongValue] : 0.0;
-        return returnValue = ((seconds)
-                              + (minutes * AJRSecondsPerMinute)
-                              + (hours * AJRSecondsPerHour)
-                              + (days * AJRSecondsPerDay));
-    } else {
-        returnValue = [NSDate timeIntervalForTimePeriodString:self defaultValue:0.0];
-    }
-
-    return returnValue;
+    AJRTimePeriod period;
+    AJRParseTimePeriod(self, &period);
+    return period.timeInterval;
 }
 
 - (long long)millisecondsValue {
-    return [NSDate millisecondsForTimePeriodString:self defaultValue:0.0];
+    AJRTimePeriod period;
+    AJRParseTimePeriod(self, &period);
+    return period.milliseconds;
 }
 
 - (NSNumber *)ajr_numberFromValue:(unsigned long long)value negative:(BOOL)negative {
@@ -117,15 +117,12 @@ BOOL AJRLogShouldOutputForDomain(NSString *domain, AJRLogLevel level) {
 static void AJRLog_fvp(NSString *domain, AJRLogLevel level, NSString *format, va_list ap) {
     [_logLock lock];
     @try {
-        NSString *formattedString;
-        
         if (!_logIsOpen) {
             setlogmask(LOG_UPTO(_globalLogLevel));
             openlog([[[NSProcessInfo processInfo] processName] UTF8String], LOG_NDELAY, LOG_USER);
             _logIsOpen = YES;
         }
         
-        formattedString = AJRFormatv(format, ap);
         switch (level) {
             case AJRLogLevelDefault:    _defaultCount++; break;
             case AJRLogLevelEmergency:  _emergencyCount++; break;
@@ -140,21 +137,61 @@ static void AJRLog_fvp(NSString *domain, AJRLogLevel level, NSString *format, va
         
         
         if (AJRLogShouldOutputForDomain(domain, level)) {
-            // When building for debug, just log to the console.
-            BOOL needsNewline = ![formattedString hasSuffix:@"\n"];
-            NSString *logString;
-            if (domain != nil) {
-                logString = [[NSString alloc] initWithFormat:@"%@ <%@>: %@%@", domain, AJRStringFromLogLevel(level), formattedString, needsNewline ? @"\n" : @""];
-            } else {
-                logString = [[NSString alloc] initWithFormat:@"<%@>: %@%@", AJRStringFromLogLevel(level), formattedString, needsNewline ? @"\n" : @""];
-            }
-            NSData *data = [logString dataUsingEncoding:NSUTF8StringEncoding];
-            
             NSOutputStream *stream = AJRLogGetOutputStream(level);
+            NSString *formattedString;
+            
             // If there's an output stream, log to it, otherwise, just log to syslog.
             if (stream) {
-                [AJRLogGetOutputStream(level) write:[data bytes] maxLength:[data length]];
+                // Most messages fit in a small buffer, so format them straight into one, and save building and then encoding a string.
+                char buffer[1024];
+                char *message;
+                NSUInteger prefixLength, length;
+                
+                if (domain != nil) {
+                    prefixLength = AJRFormatToBuffer(buffer, sizeof(buffer), @"%@ <%@>: ", domain, AJRStringFromLogLevel(level));
+                } else {
+                    prefixLength = AJRFormatToBuffer(buffer, sizeof(buffer), @"<%@>: ", AJRStringFromLogLevel(level));
+                }
+                if (prefixLength < sizeof(buffer)) {
+                    va_list copy;
+                    BOOL needsNewline;
+                    
+                    // Longer messages move to the heap as they're formatted, so each message is only formatted once.
+                    va_copy(copy, ap);
+                    length = AJRFormatToGrowableBufferv(buffer + prefixLength, sizeof(buffer) - prefixLength, &message, format, copy);
+                    va_end(copy);
+                    needsNewline = length == 0 || message[length - 1] != '\n';
+                    if (message == buffer + prefixLength) {
+                        length += prefixLength;
+                        // Leave room for a newline.
+                        if (needsNewline && length + 1 < sizeof(buffer)) {
+                            buffer[length++] = '\n';
+                            needsNewline = NO;
+                        }
+                        [stream write:(const uint8_t *)buffer maxLength:length];
+                    } else {
+                        [stream write:(const uint8_t *)buffer maxLength:prefixLength];
+                        [stream write:(const uint8_t *)message maxLength:length];
+                        free(message);
+                    }
+                    if (needsNewline) {
+                        [stream write:(const uint8_t *)"\n" maxLength:1];
+                    }
+                } else {
+                    // Only an absurdly long domain gets here, and we haven't formatted the message yet.
+                    formattedString = AJRFormatv(format, ap);
+                    BOOL needsNewline = ![formattedString hasSuffix:@"\n"];
+                    NSString *logString;
+                    if (domain != nil) {
+                        logString = [[NSString alloc] initWithFormat:@"%@ <%@>: %@%@", domain, AJRStringFromLogLevel(level), formattedString, needsNewline ? @"\n" : @""];
+                    } else {
+                        logString = [[NSString alloc] initWithFormat:@"<%@>: %@%@", AJRStringFromLogLevel(level), formattedString, needsNewline ? @"\n" : @""];
+                    }
+                    NSData *data = [logString dataUsingEncoding:NSUTF8StringEncoding];
+                    [stream write:[data bytes] maxLength:[data length]];
+                }
             } else {
+                formattedString = AJRFormatv(format, ap);
                 if (domain == nil) {
                     syslog(level, "<%s> %s", [AJRStringFromLogLevel(level) UTF8String], [formattedString UTF8String]);
                 } else {
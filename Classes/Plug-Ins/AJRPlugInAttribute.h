@@ -29,7 +29,7 @@
  ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#import <Foundation/Foundation.h>
+#import <AJRFoundation/AJRPlugInManager.h>
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -41,6 +41,12 @@ NS_ASSUME_NONNULL_BEGIN
 @property (nullable,nonatomic,strong) NSString *rawDefaultValue;
 @property (nonatomic,assign) BOOL required;
 
+/*! The transformer registered for type. This is looked up once, and then again only if a new transformer is registered. */
+@property (nullable,nonatomic,readonly) AJRPlugInValueTransformer valueTransformer;
+
+/*! Converts raw into a value of the receiver's type. If no transformer is registered for the type, this warns and returns raw. */
+- (nullable id)valueForString:(nullable NSString *)raw bundle:(nullable NSBundle *)bundle error:(NSError * _Nullable * _Nullable)error;
+
 @end
 
 NS_ASSUME_NONNULL_END
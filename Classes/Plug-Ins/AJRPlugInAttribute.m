@@ -32,8 +32,58 @@
 #import "AJRPlugInAttribute.h"
 
 #import "AJRFormat.h"
+#import "AJRFunctions.h"
+#import "AJRLogging.h"
+#import "AJRPlugInManagerP.h"
 
-@implementation AJRPlugInAttribute
+@implementation AJRPlugInAttribute {
+    AJRPlugInValueTransformer _valueTransformer;
+    NSInteger _valueTransformerGeneration;
+}
+
+- (instancetype)init {
+    if ((self = [super init])) {
+        _valueTransformerGeneration = -1;
+    }
+    return self;
+}
+
+#pragma mark - Properties
+
+- (void)setType:(NSString *)type {
+    _type = type;
+    _valueTransformer = nil;
+    _valueTransformerGeneration = -1;
+}
+
+- (AJRPlugInValueTransformer)valueTransformer {
+    NSInteger generation = AJRPlugInTransformersGeneration();
+    if (_valueTransformerGeneration != generation) {
+        _valueTransformer = _type ? AJRPlugInTransformerForType(_type) : nil;
+        _valueTransformerGeneration = generation;
+    }
+    return _valueTransformer;
+}
+
+#pragma mark - Values
+
+- (id)valueForString:(NSString *)raw bundle:(NSBundle *)bundle error:(NSError **)error {
+    AJRPlugInValueTransformer transformer;
+    NSError *localError = nil;
+    id value = nil;
+    
+    if (raw != nil) {
+        transformer = [self valueTransformer];
+        if (transformer) {
+            value = transformer(raw, bundle, &localError);
+        } else {
+            AJRLog(AJRLoggingDomainPlugInManager, AJRLogLevelWarning, @"Asked to produce a value for an unknown type: %@, returning \"%@\" as string.\n", _type, raw);
+            value = raw;
+        }
+    }
+    
+    return AJRAssertOrPropagateError(value, error, localError);
+}
 
 #pragma mark - NSObject
 
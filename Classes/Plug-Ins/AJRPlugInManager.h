@@ -37,18 +37,35 @@ NS_ASSUME_NONNULL_BEGIN
 
 extern const AJRLoggingDomain AJRLoggingDomainPlugInManager;
 extern NSString * const AJRPlugInManagerErrorDomain;
+/*! User default controlling whether parsed plug-in data is cached between launches. Defaults to YES. */
+extern NSString * const AJRPlugInManagerUsesCacheKey;
+/*! User default that, when YES, causes the shared plug-in manager to register extension-points lazily. Defaults to NO. */
+extern NSString * const AJRPlugInManagerRegistersLazilyKey;
 
 typedef id _Nullable (^AJRPlugInValueTransformer)(NSString *rawValue, NSBundle * _Nullable bundle, NSError * _Nullable * _Nullable error);
 
+/*! Registers transformer as the way to convert plug-in data attributes of type. This may replace one of the built in types: string, boolean, integer, float, bundle, class and url. */
 extern void AJRRegisterPluinTransformer(NSString *type, AJRPlugInValueTransformer transformer);
+/*! Returns the transformer registered for type, or nil if there isn't one. */
+extern AJRPlugInValueTransformer _Nullable AJRPlugInTransformerForType(NSString *type);
 
 @interface AJRPlugInManager : NSObject
 
 /*! Does the initial setup of the plugin manager. */
 + (void)initializePlugInManager;
+/*! Does the initial setup of the plug-in manager, and makes sure the named extension-points are registered, which matters when registering lazily. Like +initializePlugInManager, this does nothing if called while the plug-in manager is initializing. */
++ (void)initializePlugInManagerRegisteringExtensionPointsNamed:(NSArray<NSString *> *)names;
 
 @property (nonatomic,class,readonly) AJRPlugInManager *sharedPlugInManager NS_SWIFT_NAME(shared);
 
+/*!
+ When YES, launching only indexes extension-point names. An extension-point, and all of its extensions, are registered the first time it's requested by -extensionPointForName: or -extensionPointForClass:, which is also when its registry selector is first called. Code that relies on those registry side effects without asking for the extension-point should request it first.
+ */
+@property (nonatomic,readonly) BOOL registersLazily;
+
+/*! The names of all known extension-points, whether or not they've been registered yet. */
+@property (nonatomic,readonly) NSArray<NSString *> *extensionPointNames;
+
 - (void)registerExtensionPoint:(NSString *)factoryClassName
                       withName:(NSString *)name
         registrySelectorString:(nullable NSString *)registrySelectorString
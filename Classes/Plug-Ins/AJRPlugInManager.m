@@ -29,7 +29,7 @@
  ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#import "AJRPlugInManager.h"
+#import "AJRPlugInManagerP.h"
 
 #import "AJRFormat.h"
 #import "AJRLogging.h"
@@ -37,76 +37,142 @@
 #import "AJRPlugInElement.h"
 #import "AJRPlugInExtension.h"
 #import "AJRPlugInExtensionPoint.h"
+#import "AJRPlugInManifest.h"
+#import "NSError+Extensions.h"
 #import "NSMutableDictionary+Extensions.h"
-#import "NSObject+AJRUserInfo.h"
 #import <AJRFoundation/AJRFoundation-Swift.h>
 
 #import <objc/runtime.h>
+#import <stdatomic.h>
 
 const AJRLoggingDomain AJRLoggingDomainPlugInManager = @"AJRPlugInManager";
 NSString * const AJRPlugInManagerErrorDomain = @"AJRPlugInManager";
+NSString * const AJRPlugInManagerUsesCacheKey = @"AJRPlugInManagerUsesCache";
+NSString * const AJRPlugInManagerRegistersLazilyKey = @"AJRPlugInManagerRegistersLazily";
+
+#pragma mark - Value Transformers
+
+static _Atomic(NSInteger) AJRValueTransformersGeneration = 0;
 
 static NSMutableDictionary<NSString *, AJRPlugInValueTransformer> *AJRGetValueTransformers(void) {
     static NSMutableDictionary<NSString *, AJRPlugInValueTransformer> *transformers = nil;
     static dispatch_once_t onceToken;
     dispatch_once(&onceToken, ^{
         transformers = [NSMutableDictionary dictionary];
+        transformers[@"string"] = ^id(NSString *raw, NSBundle *bundle, NSError **error) {
+            return raw;
+        };
+        transformers[@"boolean"] = ^id(NSString *raw, NSBundle *bundle, NSError **error) {
+            return [NSNumber numberWithBool:[raw boolValue]];
+        };
+        transformers[@"integer"] = ^id(NSString *raw, NSBundle *bundle, NSError **error) {
+            return [NSNumber numberWithLongLong:[raw longLongValue]];
+        };
+        transformers[@"float"] = ^id(NSString *raw, NSBundle *bundle, NSError **error) {
+            return [NSNumber numberWithDouble:[raw doubleValue]];
+        };
+        transformers[@"bundle"] = ^id(NSString *raw, NSBundle *bundle, NSError **error) {
+            if ([raw isEqualToString:@"$xml-bundle"]) {
+                return bundle;
+            } else if ([raw isEqualToString:@"$main-bundle"]) {
+                return [NSBundle mainBundle];
+            }
+            return [NSBundle bundleWithIdentifier:raw];
+        };
+        transformers[@"class"] = ^id(NSString *raw, NSBundle *bundle, NSError **error) {
+            Class value = NSClassFromString(raw);
+            if (value == Nil) {
+                AJRLog(AJRLoggingDomainPlugInManager, AJRLogLevelWarning, @"Unable to find class: \"%@\"", raw);
+            }
+            return value;
+        };
+        transformers[@"url"] = ^id(NSString *raw, NSBundle *bundle, NSError **error) {
+            NSURL *value = [NSURL URLWithString:raw];
+            if (value == nil) {
+                AJRLog(AJRLoggingDomainPlugInManager, AJRLogLevelWarning, @"Unable to create URL from: \"%@\"", raw);
+            }
+            return value;
+        };
     });
     return transformers;
 }
 
 void AJRRegisterPluinTransformer(NSString *type, AJRPlugInValueTransformer transformer) {
-    AJRGetValueTransformers()[type] = transformer;
+    NSMutableDictionary<NSString *, AJRPlugInValueTransformer> *transformers = AJRGetValueTransformers();
+    @synchronized (transformers) {
+        transformers[type] = [transformer copy];
+        // Lets AJRPlugInAttribute know its cached transformer may be out of date.
+        atomic_fetch_add(&AJRValueTransformersGeneration, 1);
+    }
 }
 
-static id AJRValueForString(NSString *raw, NSString *type, NSBundle *bundle, NSError **error) {
-    id value = nil;
-    NSError *localError = nil;
-    
-    if (raw == nil) {
-        value = nil;
-    } else if ([type isEqualToString:@"string"]) {
-        value = raw;
-    } else if ([type isEqualToString:@"boolean"]) {
-        value = [NSNumber numberWithBool:[raw boolValue]];
-    } else if ([type isEqualToString:@"integer"]) {
-        value = [NSNumber numberWithLongLong:[raw longLongValue]];
-    } else if ([type isEqualToString:@"float"]) {
-        value = [NSNumber numberWithDouble:[raw doubleValue]];
-    } else if ([type isEqualToString:@"bundle"]) {
-        if ([raw isEqualToString:@"$xml-bundle"]) {
-            value = bundle;
-        } else if ([raw isEqualToString:@"$main-bundle"]) {
-            value = [NSBundle mainBundle];
-        } else {
-            value = [NSBundle bundleWithIdentifier:raw];
-        }
-    } else if ([type isEqualToString:@"class"]) {
-        value = NSClassFromString(raw);
-        if (value == Nil) {
-            AJRLog(AJRLoggingDomainPlugInManager, AJRLogLevelWarning, @"Unable to find class: \"%@\"", raw);
-        }
-    } else if ([type isEqualToString:@"url"]) {
-        value = [NSURL URLWithString:raw];
-        if (value == nil) {
-            AJRLog(AJRLoggingDomainPlugInManager, AJRLogLevelWarning, @"Unable to create URL from: \"%@\"", raw);
-        }
-    } else if (AJRGetValueTransformers()[type] != nil) {
-        value = AJRGetValueTransformers()[type](raw, bundle, &localError);
-    } else {
-        AJRLog(AJRLoggingDomainPlugInManager, AJRLogLevelWarning, @"Asked to produce a value for an unknown type: %@, returning \"%@\" as string.\n", type, raw);
-        value = raw;
+AJRPlugInValueTransformer AJRPlugInTransformerForType(NSString *type) {
+    NSMutableDictionary<NSString *, AJRPlugInValueTransformer> *transformers = AJRGetValueTransformers();
+    @synchronized (transformers) {
+        return transformers[type];
     }
-    
-    return AJRAssertOrPropagateError(value, error, localError);
 }
 
+NSInteger AJRPlugInTransformersGeneration(void) {
+    return atomic_load(&AJRValueTransformersGeneration);
+}
+
+/*! A manifest node that's waiting on an extension-point, along with the bundle that supplied it. */
+@interface AJRPlugInPendingNode : NSObject
+
++ (instancetype)pendingNode:(AJRPlugInManifestNode *)node sourceBundle:(NSBundle *)bundle;
+
+@property (nonatomic,readonly) AJRPlugInManifestNode *node;
+@property (nonatomic,readonly) NSBundle *bundle;
+
+@end
+
+@implementation AJRPlugInPendingNode
+
++ (instancetype)pendingNode:(AJRPlugInManifestNode *)node sourceBundle:(NSBundle *)bundle {
+    AJRPlugInPendingNode *pending = [[self alloc] init];
+    pending->_node = node;
+    pending->_bundle = bundle;
+    return pending;
+}
+
+@end
+
+/*! The manifests found in a bundle, in the order the bundle listed them. Each result is either the AJRPlugInManifest, or the NSError explaining why it couldn't be loaded. */
+@interface AJRPlugInBundleRecord : NSObject
+
++ (instancetype)recordWithBundle:(NSBundle *)bundle urls:(NSArray<NSURL *> *)urls results:(NSArray<id> *)results;
+
+@property (nonatomic,readonly) NSBundle *bundle;
+@property (nonatomic,readonly) NSArray<NSURL *> *urls;
+@property (nonatomic,readonly) NSArray<id> *results;
+
+@end
+
+@implementation AJRPlugInBundleRecord
+
++ (instancetype)recordWithBundle:(NSBundle *)bundle urls:(NSArray<NSURL *> *)urls results:(NSArray<id> *)results {
+    AJRPlugInBundleRecord *record = [[self alloc] init];
+    record->_bundle = bundle;
+    record->_urls = urls;
+    record->_results = results;
+    return record;
+}
+
+@end
+
 @interface AJRPlugInManager ()
 
 @property (nonatomic,strong) NSMutableDictionary<NSString *, AJRPlugInExtensionPoint *> *extensionPoints;
 @property (nonatomic,strong) NSMapTable<Class, AJRPlugInExtensionPoint *> *extensionPointsByClass;
 @property (nonatomic,strong) NSMutableSet<NSURL *> *scannedBundleURLs;
-@property (nonatomic,strong) NSMutableOrderedSet<NSXMLElement *> *extensionsToReprocess;
+/*! Extensions whose extension-point hasn't been registered yet, keyed by the extension-point's name, in the order they were scanned. */
+@property (nonatomic,strong) NSMutableDictionary<NSString *, NSMutableArray<AJRPlugInPendingNode *> *> *pendingExtensions;
+/*! When registering lazily, the extension-point definitions we've seen, but not yet registered. */
+@property (nonatomic,strong) NSMutableDictionary<NSString *, NSMutableArray<AJRPlugInPendingNode *> *> *pendingExtensionPoints;
+/*! When registering lazily, maps an extension-point's class name to its name, so that -extensionPointForClass: can find unregistered extension-points. */
+@property (nonatomic,strong) NSMutableDictionary<NSString *, NSString *> *extensionPointNamesByClassName;
+@property (nonatomic,strong,nullable) AJRPlugInManifestCache *manifestCache;
 
 @end
 
@@ -120,6 +186,15 @@ static BOOL isInitializing = NO;
     }
 }
 
++ (void)initializePlugInManagerRegisteringExtensionPointsNamed:(NSArray<NSString *> *)names {
+    if (!isInitializing) {
+        AJRPlugInManager *plugInManager = [self sharedPlugInManager];
+        for (NSString *name in names) {
+            [plugInManager extensionPointForName:name];
+        }
+    }
+}
+
 + (id)sharedPlugInManager {
     static AJRPlugInManager  *sharedPlugInManager = nil;
     static dispatch_once_t  onceToken;
@@ -135,13 +210,34 @@ static BOOL isInitializing = NO;
 }
 
 - (instancetype)init {
+    return [self _initWithBundles:nil registeringLazily:[[NSUserDefaults standardUserDefaults] boolForKey:AJRPlugInManagerRegistersLazilyKey] usingCache:YES];
+}
+
+/*! When bundles is nil, all loaded frameworks and bundles are scanned. */
+- (instancetype)_initWithBundles:(NSArray<NSBundle *> *)bundles registeringLazily:(BOOL)registersLazily usingCache:(BOOL)usesCache {
     if ((self = [super init])) {
+        _registersLazily = registersLazily;
         _extensionPoints = [[NSMutableDictionary alloc] init];
         _extensionPointsByClass = [[NSMapTable alloc] initWithKeyOptions:NSPointerFunctionsStrongMemory valueOptions:NSPointerFunctionsStrongMemory capacity:0];
         _scannedBundleURLs = [NSMutableSet set];
-        _extensionsToReprocess = [NSMutableOrderedSet orderedSet];
+        _pendingExtensions = [NSMutableDictionary dictionary];
+        _pendingExtensionPoints = [NSMutableDictionary dictionary];
+        _extensionPointNamesByClassName = [NSMutableDictionary dictionary];
+        if (usesCache
+            && ([[NSUserDefaults standardUserDefaults] objectForKey:AJRPlugInManagerUsesCacheKey] == nil
+                || [[NSUserDefaults standardUserDefaults] boolForKey:AJRPlugInManagerUsesCacheKey])) {
+            NSURL *cacheURL = [AJRPlugInManifestCache defaultCacheURL];
+            if (cacheURL) {
+                _manifestCache = [[AJRPlugInManifestCache alloc] initWithURL:cacheURL];
+            }
+        }
         
-        [self _scanBundles];
+        if (bundles == nil) {
+            // Frameworks go first, because they're what define the the extension points.
+            bundles = [[NSBundle allFrameworks] arrayByAddingObjectsFromArray:[NSBundle allBundles]];
+        }
+        [self _scanBundles:bundles];
+        [self _synchronizeManifestCache];
         
         [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(bundleDidLoad:) name:NSBundleDidLoadNotification object:nil];
     }
@@ -153,40 +249,44 @@ static BOOL isInitializing = NO;
         registrySelectorString:(NSString *)registrySelectorString
                     attributes:(NSDictionary<NSString *, AJRPlugInAttribute *> *)attributes
                       elements:(NSDictionary<NSString *, AJRPlugInElement *> *)elements {
-    AJRPlugInExtensionPoint *extensionPoint = [_extensionPoints objectForKey:name];
+    @synchronized (self) {
+        AJRPlugInExtensionPoint *extensionPoint = [_extensionPoints objectForKey:name];
     
-    if (extensionPoint && [extensionPoint registered]) {
-        AJRLog(AJRLoggingDomainPlugInManager, AJRLogLevelWarning, @"There's already an extension-point named \"%@\" registered with the plug-in manager.", name);
-    } else {
-        if (!extensionPoint) {
-            extensionPoint = [[AJRPlugInExtensionPoint alloc] init];
-        }
-        if (extensionPointClassName) {
-            extensionPoint.extensionPointClass = NSClassFromString(extensionPointClassName);
-            if (extensionPoint.extensionPointClass == Nil) {
-                AJRLog(AJRLoggingDomainPlugInManager, AJRLogLevelWarning, @"Couldn't find class named \"%@\" for extension-point \"%@\".", extensionPointClassName, name);
+        if (extensionPoint && [extensionPoint registered]) {
+            AJRLog(AJRLoggingDomainPlugInManager, AJRLogLevelWarning, @"There's already an extension-point named \"%@\" registered with the plug-in manager.", name);
+        } else {
+            if (!extensionPoint) {
+                extensionPoint = [[AJRPlugInExtensionPoint alloc] init];
             }
-        }
-        extensionPoint.name = name;
-        extensionPoint.registrySelector = NSSelectorFromString(registrySelectorString);
-        extensionPoint.attributes = attributes;
-        extensionPoint.elements = elements;
-        extensionPoint.registered = YES;
+            if (extensionPointClassName) {
+                extensionPoint.extensionPointClass = NSClassFromString(extensionPointClassName);
+                if (extensionPoint.extensionPointClass == Nil) {
+                    AJRLog(AJRLoggingDomainPlugInManager, AJRLogLevelWarning, @"Couldn't find class named \"%@\" for extension-point \"%@\".", extensionPointClassName, name);
+                }
+            }
+            extensionPoint.name = name;
+            extensionPoint.registrySelector = NSSelectorFromString(registrySelectorString);
+            extensionPoint.attributes = attributes;
+            extensionPoint.elements = elements;
+            extensionPoint.registered = YES;
         
-        [_extensionPoints setObject:extensionPoint forKey:name];
-        if ([extensionPoint extensionPointClass]) {
-            [_extensionPointsByClass setObject:extensionPoint forKey:[extensionPoint extensionPointClass]];
+            [_extensionPoints setObject:extensionPoint forKey:name];
+            if ([extensionPoint extensionPointClass]) {
+                [_extensionPointsByClass setObject:extensionPoint forKey:[extensionPoint extensionPointClass]];
+            }
+        
+            [self _addPendingExtensionsToExtensionPoint:extensionPoint];
         }
     }
 }
 
-- (AJRPlugInAttribute *)_attributeFromNode:(NSXMLElement *)child XMLIdentifier:(NSString *)XMLIdentifier sourceBundle:(NSBundle *)bundle failures:(NSMutableArray<NSString *> *)fails {
+- (AJRPlugInAttribute *)_attributeFromNode:(AJRPlugInManifestNode *)child XMLIdentifier:(NSString *)XMLIdentifier sourceBundle:(NSBundle *)bundle failures:(NSMutableArray<NSString *> *)fails {
     AJRPlugInAttribute *attribute = nil;
-    NSString *attributeName = [[child attributeForName:@"name"] stringValue];
-    NSString *attributeType = [[child attributeForName:@"type"] stringValue];
-    NSString *attributeDefaultValue = [[child attributeForName:@"defaultValue"] stringValue];
-    BOOL attributeDefaultValueIsLazy = [child attributeForName:@"defaultValueIsLazy"].stringValue.boolValue;
-    BOOL propertyRequired = [[[child attributeForName:@"required"] stringValue] boolValue];
+    NSString *attributeName = [child valueForAttribute:@"name"];
+    NSString *attributeType = [child valueForAttribute:@"type"];
+    NSString *attributeDefaultValue = [child valueForAttribute:@"defaultValue"];
+    BOOL attributeDefaultValueIsLazy = [child valueForAttribute:@"defaultValueIsLazy"].boolValue;
+    BOOL propertyRequired = [[child valueForAttribute:@"required"] boolValue];
     
     if (attributeName == nil) {
         [fails addObject:AJRFormat(@"Missing \"name\" for attribute in extension-point \"%@\"", XMLIdentifier)];
@@ -204,7 +304,7 @@ static BOOL isInitializing = NO;
             if (attributeDefaultValueIsLazy) {
                 attribute.rawDefaultValue = attributeDefaultValue;
             } else {
-                attribute.defaultValue = AJRValueForString(attributeDefaultValue, attribute.type, bundle, &localError);
+                attribute.defaultValue = [attribute valueForString:attributeDefaultValue bundle:bundle error:&localError];
                 if (attribute.defaultValue == nil) {
                     [fails addObject:[localError localizedDescription]];
                 }
@@ -216,16 +316,16 @@ static BOOL isInitializing = NO;
     return attribute;
 }
 
-- (AJRPlugInElement *)_elementFromNode:(NSXMLElement *)child
+- (AJRPlugInElement *)_elementFromNode:(AJRPlugInManifestNode *)child
                           sourceBundle:(NSBundle *)bundle
                               failures:(NSMutableArray<NSString *> *)fails {
     AJRPlugInElement *element = nil;
-    NSString *name = [[child attributeForName:@"name"] stringValue];
-    NSString *key = [[child attributeForName:@"key"] stringValue];
-    NSString *type = [[child attributeForName:@"type"] stringValue];
+    NSString *name = [child valueForAttribute:@"name"];
+    NSString *key = [child valueForAttribute:@"key"];
+    NSString *type = [child valueForAttribute:@"type"];
     NSMutableDictionary<NSString *, AJRPlugInAttribute *> *attributes = [NSMutableDictionary dictionary];
     NSMutableDictionary<NSString *, AJRPlugInElement *> *elements = [NSMutableDictionary dictionary];
-    BOOL required = [[[child attributeForName:@"required"] stringValue] boolValue];
+    BOOL required = [[child valueForAttribute:@"required"] boolValue];
     
     if (name == nil) {
         [fails addObject:AJRFormat(@"No \"name\" attribute specified for node: %@", child)];
@@ -253,10 +353,10 @@ static BOOL isInitializing = NO;
 
 - (void)_populateAttributes:(NSMutableDictionary<NSString *, AJRPlugInAttribute *> *)attributes
                 andElements:(NSMutableDictionary<NSString *, AJRPlugInElement *> *)elements
-                   fromNode:(NSXMLElement *)node named:(NSString *)name
+                   fromNode:(AJRPlugInManifestNode *)node named:(NSString *)name
                sourceBundle:(NSBundle *)bundle
                    failures:(NSMutableArray<NSString *> *)fails {
-    for (NSXMLElement *child in [node children]) {
+    for (AJRPlugInManifestNode *child in [node children]) {
         NSString *childName = [child name];
         
         if ([childName isEqualToString:@"attribute"]) {
@@ -273,20 +373,18 @@ static BOOL isInitializing = NO;
             } else {
                 [fails addObject:AJRFormat(@"Unable to create element on extension-point \"%@\": %@", name, child)];
             }
-        } else if (child.kind == NSXMLCommentKind) {
-            // Ignore comments
         } else {
             [fails addObject:AJRFormat(@"Unknown child in extension-point definition: %@: %@", name, childName)];
         }
     }
 }
 
-- (void)_registerExtensionPointFromNode:(NSXMLElement *)node sourceBundle:(NSBundle *)bundle {
-    NSString *name = [[node attributeForName:@"name"] stringValue];
-    NSString *className = [[node attributeForName:@"class"] stringValue];
+- (void)_registerExtensionPointFromNode:(AJRPlugInManifestNode *)node sourceBundle:(NSBundle *)bundle {
+    NSString *name = [node valueForAttribute:@"name"];
+    NSString *className = [node valueForAttribute:@"class"];
     NSMutableDictionary<NSString *, AJRPlugInAttribute *> *attributes = [NSMutableDictionary dictionary];
     NSMutableDictionary<NSString *, AJRPlugInElement *> *elements = [NSMutableDictionary dictionary];
-    NSString *selectorName = [[node attributeForName:@"registrySelector"] stringValue];
+    NSString *selectorName = [node valueForAttribute:@"registrySelector"];
     NSMutableArray *fails = [NSMutableArray array];
     
     if (name == nil) {
@@ -311,15 +409,17 @@ static BOOL isInitializing = NO;
     }
 }
 
-- (NSDictionary<NSString *, id> *)_dictionaryFromNode:(NSXMLElement *)node
+- (NSDictionary<NSString *, id> *)_dictionaryFromNode:(AJRPlugInManifestNode *)node
                                                schema:(id <AJRPlugInSchemaObject>)schema
                                      skipNameAndClass:(BOOL)skipNameAndClass
                                          sourceBundle:(NSBundle *)bundle {
     NSMutableDictionary *properties = [NSMutableDictionary dictionary];
     
-    for (NSXMLNode *attribute in [node attributes]) {
-        NSString *name = [attribute name];
-        NSString *value = [attribute stringValue];
+    NSArray<NSString *> *attributeNames = [node attributeNames];
+    NSArray<NSString *> *attributeValues = [node attributeValues];
+    for (NSUInteger x = 0; x < [attributeNames count]; x++) {
+        NSString *name = attributeNames[x];
+        NSString *value = attributeValues[x];
         
         // Skip, unless the schema excplicitly declares these values.
         if (skipNameAndClass && [name isEqualToString:@"class"] && ![schema attributeForName:@"class"]) {
@@ -330,7 +430,7 @@ static BOOL isInitializing = NO;
             AJRPlugInAttribute *attribute = [schema attributeForName:name];
             if (attribute) {
                 NSError *localError = nil;
-                id convertedValue = AJRValueForString(value, [attribute type], bundle, &localError);
+                id convertedValue = [attribute valueForString:value bundle:bundle error:&localError];
                 if (convertedValue) {
                     [properties setObject:convertedValue forKey:name];
                 } else {
@@ -347,7 +447,7 @@ static BOOL isInitializing = NO;
             id possibleDefault;
             if (attribute.rawDefaultValue) {
                 NSError *localError = nil;
-                possibleDefault = AJRValueForString(attribute.rawDefaultValue, attribute.type, bundle, &localError);
+                possibleDefault = [attribute valueForString:attribute.rawDefaultValue bundle:bundle error:&localError];
                 if (possibleDefault == nil) {
                     AJRLog(AJRLoggingDomainPlugInManager, AJRLogLevelWarning, @"Failed to create attribute of type \"%@\" from rawValue \"%@\".", attribute.type, attribute.rawDefaultValue);
                 }
@@ -362,7 +462,7 @@ static BOOL isInitializing = NO;
         }
     }
     
-    for (NSXMLElement *child in [node children]) {
+    for (AJRPlugInManifestNode *child in [node children]) {
         NSString *name = [child name];
         AJRPlugInElement *element = [schema elementForName:name];
         
@@ -390,7 +490,7 @@ static BOOL isInitializing = NO;
     return properties;
 }
 
-- (AJRPlugInExtension *)_extensionFromNode:(NSXMLElement *)node
+- (AJRPlugInExtension *)_extensionFromNode:(AJRPlugInManifestNode *)node
                          forExtensionPoint:(AJRPlugInExtensionPoint *)extensionPoint
                               sourceBundle:(NSBundle *)bundle {
     NSDictionary<NSString *, id> *properties;
@@ -398,7 +498,7 @@ static BOOL isInitializing = NO;
     NSString *extensionName = nil;
     NSString *value;
     
-    value = [[node attributeForName:@"class"] stringValue];
+    value = [node valueForAttribute:@"class"];
     extensionClass = value ? NSClassFromString(value) : Nil;
     if (extensionClass == nil) {
         // If there's no class defined by the extension, let's see if there's a default value defined by the extenion point.
@@ -408,7 +508,7 @@ static BOOL isInitializing = NO;
         AJRLog(AJRLoggingDomainPlugInManager, AJRLogLevelWarning, @"Unable to find class \"%@\" specified by extension: %@", value, node);
     }
 
-    extensionName = [[node attributeForName:@"name"] stringValue];
+    extensionName = [node valueForAttribute:@"name"];
     if (extensionName == nil && extensionClass == nil) {
         AJRLog(AJRLoggingDomainPlugInManager, AJRLogLevelWarning, @"All extensions must define a name or a class, this node didn't: %@", node);
     }
@@ -418,95 +518,205 @@ static BOOL isInitializing = NO;
     return (extensionName || extensionClass) ? [AJRPlugInExtension extensionWithName:extensionName class:extensionClass properties:properties owner:extensionPoint] : nil;
 }
 
-- (void)_processExtensionNode:(NSXMLElement *)element sourceBundle:(NSBundle *)bundle {
+- (void)_addExtensionFromNode:(AJRPlugInManifestNode *)node toExtensionPoint:(AJRPlugInExtensionPoint *)extensionPoint sourceBundle:(NSBundle *)bundle {
+    AJRPlugInExtension *extension = [self _extensionFromNode:node forExtensionPoint:extensionPoint sourceBundle:bundle];
+    if (extension) {
+        [extensionPoint addExtension:extension];
+    }
+}
+
+/*!
+ Extensions only depend on their extension-point, so rather than repeatedly re-walking everything that failed to resolve, each unresolved extension waits in a bucket keyed by its extension-point's name. Registering the extension-point releases the whole bucket, in scan order, which is a topological ordering of the extension-point / extension graph. Extensions that never see their extension-point simply stay put, since a bundle loaded later may yet define it.
+ */
+- (void)_addPendingExtensionsToExtensionPoint:(AJRPlugInExtensionPoint *)extensionPoint {
+    NSString *name = [extensionPoint name];
+    NSArray<AJRPlugInPendingNode *> *pendingExtensions = [_pendingExtensions objectForKey:name];
+    
+    if (pendingExtensions) {
+        [_pendingExtensions removeObjectForKey:name];
+        for (AJRPlugInPendingNode *pending in pendingExtensions) {
+            [self _addExtensionFromNode:[pending node] toExtensionPoint:extensionPoint sourceBundle:[pending bundle]];
+        }
+    }
+}
+
+- (void)_processExtensionNode:(AJRPlugInManifestNode *)element sourceBundle:(NSBundle *)bundle {
     NSString *name = [element name];
     
     if ([name isEqualToString:@"extension-point"]) {
-        [self _registerExtensionPointFromNode:element sourceBundle:bundle];
+        NSString *extensionPointName = [element valueForAttribute:@"name"];
+        
+        // Nameless extension-points can't be looked up, so those go straight through, which gets them the usual warning.
+        if (_registersLazily && extensionPointName != nil && [_extensionPoints objectForKey:extensionPointName] == nil) {
+            NSString *className = [element valueForAttribute:@"class"];
+            NSMutableArray<AJRPlugInPendingNode *> *definitions = [_pendingExtensionPoints objectForKey:extensionPointName];
+            
+            if (definitions == nil) {
+                definitions = [NSMutableArray array];
+                [_pendingExtensionPoints setObject:definitions forKey:extensionPointName];
+            }
+            [definitions addObject:[AJRPlugInPendingNode pendingNode:element sourceBundle:bundle]];
+            if (className != nil && [_extensionPointNamesByClassName objectForKey:className] == nil) {
+                [_extensionPointNamesByClassName setObject:extensionPointName forKey:className];
+            }
+        } else {
+            [self _registerExtensionPointFromNode:element sourceBundle:bundle];
+        }
     } else {
         AJRPlugInExtensionPoint *extensionPoint = [_extensionPoints objectForKey:name];
         
         if (extensionPoint == nil) {
-            [element setInstanceObject:bundle forKey:@"bundle"];
-            [_extensionsToReprocess addObject:element];
-        } else {
-            AJRPlugInExtension *extension = [self _extensionFromNode:element forExtensionPoint:extensionPoint sourceBundle:bundle];
-            if (extension) {
-                [extensionPoint addExtension:extension];
+            NSMutableArray<AJRPlugInPendingNode *> *pendingExtensions = [_pendingExtensions objectForKey:name];
+            if (pendingExtensions == nil) {
+                pendingExtensions = [NSMutableArray array];
+                [_pendingExtensions setObject:pendingExtensions forKey:name];
             }
-            [_extensionsToReprocess removeObject:element];
+            [pendingExtensions addObject:[AJRPlugInPendingNode pendingNode:element sourceBundle:bundle]];
+        } else {
+            [self _addExtensionFromNode:element toExtensionPoint:extensionPoint sourceBundle:bundle];
         }
     }
 }
 
-- (void)_scanNodes:(NSArray *)nodes sourceBundle:(NSBundle *)bundle {
-    for (NSXMLNode *node in nodes) {
-        for (NSXMLElement *element in [node children]) {
-            if ([element kind] == NSXMLElementKind) {
-                [self _processExtensionNode:element sourceBundle:bundle];
+- (void)_scanNodes:(NSArray<AJRPlugInManifestNode *> *)nodes sourceBundle:(NSBundle *)bundle {
+    for (AJRPlugInManifestNode *node in nodes) {
+        [self _processExtensionNode:node sourceBundle:bundle];
+    }
+}
+
+- (AJRPlugInBundleRecord *)_recordForBundle:(NSBundle *)bundle skippingURLs:(NSSet<NSURL *> *)scannedURLs {
+    NSMutableArray<NSURL *> *urls = [NSMutableArray array];
+    NSMutableArray<id> *results = [NSMutableArray array];
+    
+    for (NSURL *url in [bundle URLsForResourcesWithExtension:@"ajrplugindata" subdirectory:@""]) {
+        if (![scannedURLs containsObject:url]) {
+            NSError *error = nil;
+            AJRPlugInManifest *manifest;
+            
+            if (_manifestCache) {
+                manifest = [_manifestCache manifestForURL:url error:&error];
+            } else {
+                manifest = [AJRPlugInManifest manifestWithContentsOfURL:url error:&error];
             }
+            [urls addObject:url];
+            [results addObject:manifest ?: error ?: [NSError errorWithDomain:AJRPlugInManagerErrorDomain message:@"Unknown error"]];
         }
     }
+    
+    return [AJRPlugInBundleRecord recordWithBundle:bundle urls:urls results:results];
 }
 
-- (void)_scanBundles:(NSArray *)bundles {
-    for (NSBundle *bundle in bundles) {
-        //AJRLog(AJRLoggingDomainPlugInManager, AJRLogLevelDebug@"%@: %@", bundle, [bundle URLsForResourcesWithExtension:@"ajrplugindata" subdirectory:@""]);
-        for (NSURL *url in [bundle URLsForResourcesWithExtension:@"ajrplugindata" subdirectory:@""]) {
+- (void)_scanBundles:(NSArray<NSBundle *> *)bundles {
+    NSSet<NSURL *> *scannedURLs = [_scannedBundleURLs copy];
+    NSMutableArray<AJRPlugInBundleRecord *> *records = [NSMutableArray arrayWithCapacity:[bundles count]];
+    
+    // Finding and parsing manifests doesn't touch our registry, so do that for all the bundles at once. dispatch_apply() keeps the number of threads in line with the number of cores.
+    for (NSUInteger x = 0; x < [bundles count]; x++) {
+        [records addObject:(id)[NSNull null]];
+    }
+    if ([bundles count] > 1) {
+        static dispatch_queue_t scanQueue;
+        static dispatch_once_t onceToken;
+        NSLock *recordsLock = [[NSLock alloc] init];
+        
+        dispatch_once(&onceToken, ^{
+            scanQueue = dispatch_queue_create("AJRPlugInManager.scan", DISPATCH_QUEUE_CONCURRENT);
+            dispatch_set_target_queue(scanQueue, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0));
+        });
+        dispatch_apply([bundles count], scanQueue, ^(size_t index) {
+            AJRPlugInBundleRecord *record = [self _recordForBundle:bundles[index] skippingURLs:scannedURLs];
+            [recordsLock lock];
+            records[index] = record;
+            [recordsLock unlock];
+        });
+    } else if ([bundles count] == 1) {
+        records[0] = [self _recordForBundle:bundles[0] skippingURLs:scannedURLs];
+    }
+    
+    // Then merge the results in bundle order, so that the registry comes out the same no matter how the work was scheduled.
+    for (AJRPlugInBundleRecord *record in records) {
+        for (NSUInteger x = 0; x < [[record urls] count]; x++) {
+            NSURL *url = [record urls][x];
+            id result = [record results][x];
+            
+            // Registering can load a bundle, which rescans it before we get here, so check again.
             if (![_scannedBundleURLs containsObject:url]) {
-                NSError *error = nil;
-                NSXMLDocument *document;
-                
                 AJRLog(AJRLoggingDomainPlugInManager, AJRLogLevelDebug, @"Adding plugins: %@", [url lastPathComponent]);
-
+                
                 // Do this early, because scanning an unloaded bundle can cause it to load, which means we'd rescan, and we want to avoid scanning twice.
                 [_scannedBundleURLs addObject:url];
                 
-                document = [[NSXMLDocument alloc] initWithContentsOfURL:url options:0 error:&error];
-                if (document) {
-                    [self _scanNodes:[document nodesForXPath:@"plugindata" error:NULL] sourceBundle:bundle];
+                if ([result isKindOfClass:[AJRPlugInManifest class]]) {
+                    [self _scanNodes:[(AJRPlugInManifest *)result nodes] sourceBundle:[record bundle]];
                 } else {
-                    AJRLog(AJRLoggingDomainPlugInManager, AJRLogLevelError, @"Unable to load plug-in data: %@: %@", url, [error localizedDescription]);
+                    AJRLog(AJRLoggingDomainPlugInManager, AJRLogLevelError, @"Unable to load plug-in data: %@: %@", url, [(NSError *)result localizedDescription]);
                 }
             }
         }
     }
 }
 
-- (void)_processLateExtensionPoints {
-    while ([_extensionsToReprocess count] > 0) {
-        NSOrderedSet *extensionToReprocess = [_extensionsToReprocess copy];
-        
-        for (NSXMLElement *element in extensionToReprocess) {
-            [self _processExtensionNode:element sourceBundle:[element instanceObjectForKey:@"bundle"]];
-        }
-        
-        if ([_extensionsToReprocess count] == [extensionToReprocess count]) {
-            // Nothing reprocessed, so break out of our loop. Note we may still have extensions that haven't been defined, but we can't warn about those, because we may yet load a bundle that defines the associated extension point. This, really, is less than ideal, but it's either do this, or have sometimes spurious warnings.
-            break;
+- (void)bundleDidLoad:(NSNotification *)notification {
+    @synchronized (self) {
+        [self _scanBundles:@[[notification object]]];
+        [self _synchronizeManifestCache];
+    }
+}
+
+- (void)_synchronizeManifestCache {
+    if (_manifestCache) {
+        NSError *error = nil;
+        AJRLog(AJRLoggingDomainPlugInManager, AJRLogLevelDebug, @"Plug-in cache: %lu hits, %lu misses", (unsigned long)[_manifestCache hitCount], (unsigned long)[_manifestCache missCount]);
+        // A cache we can't write isn't fatal, we'll just parse again next time.
+        if (![_manifestCache synchronizeWithError:&error]) {
+            AJRLog(AJRLoggingDomainPlugInManager, AJRLogLevelDebug, @"Unable to write plug-in cache: %@: %@", [_manifestCache url], [error localizedDescription]);
         }
     }
 }
 
-- (void)_scanBundles {
-    // Scan frameworks first, because they're what define the the extension points.
-    [self _scanBundles:[NSBundle allFrameworks]];
-    [self _scanBundles:[NSBundle allBundles]];
+#pragma mark - Extension Points
+
+/*! Registers any deferred definitions of the named extension-point, which in turn picks up its pending extensions. */
+- (AJRPlugInExtensionPoint *)_registerPendingExtensionPointNamed:(NSString *)name {
+    NSArray<AJRPlugInPendingNode *> *definitions = [_pendingExtensionPoints objectForKey:name];
+    
+    if (definitions) {
+        AJRLog(AJRLoggingDomainPlugInManager, AJRLogLevelDebug, @"Registering extension-point on demand: %@", name);
+        [_pendingExtensionPoints removeObjectForKey:name];
+        for (AJRPlugInPendingNode *definition in definitions) {
+            [self _registerExtensionPointFromNode:[definition node] sourceBundle:[definition bundle]];
+        }
+    }
     
-    [self _processLateExtensionPoints];
+    return [_extensionPoints objectForKey:name];
 }
 
-- (void)bundleDidLoad:(NSNotification *)notification {
-    [self _scanBundles:@[[notification object]]];
-    [self _processLateExtensionPoints];
+- (NSArray<NSString *> *)extensionPointNames {
+    @synchronized (self) {
+        NSMutableSet<NSString *> *names = [NSMutableSet setWithArray:[_extensionPoints allKeys]];
+        [names addObjectsFromArray:[_pendingExtensionPoints allKeys]];
+        return [[names allObjects] sortedArrayUsingSelector:@selector(compare:)];
+    }
 }
 
 - (AJRPlugInExtensionPoint *)extensionPointForClass:(Class)class {
-    return [_extensionPointsByClass objectForKey:class];
+    @synchronized (self) {
+        AJRPlugInExtensionPoint *extensionPoint = [_extensionPointsByClass objectForKey:class];
+        if (extensionPoint == nil && class != Nil && [_pendingExtensionPoints count] > 0) {
+            NSString *name = [_extensionPointNamesByClassName objectForKey:NSStringFromClass(class)];
+            if (name) {
+                [self _registerPendingExtensionPointNamed:name];
+                extensionPoint = [_extensionPointsByClass objectForKey:class];
+            }
+        }
+        return extensionPoint;
+    }
 }
 
 - (AJRPlugInExtensionPoint *)extensionPointForName:(NSString *)name {
-    return [_extensionPoints objectForKey:name];
+    @synchronized (self) {
+        return [_extensionPoints objectForKey:name] ?: [self _registerPendingExtensionPointNamed:name];
+    }
 }
 
 @end
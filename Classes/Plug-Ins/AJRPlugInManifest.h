@@ -0,0 +1,116 @@
+/*
+ AJRPlugInManifest.h
+ AJRFoundation
+
+ Copyright © 2023, AJ Raftis and AJRFoundation authors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of AJRFoundation nor the names of its contributors may be
+   used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL AJ RAFTIS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*!
+ A lightweight, immutable copy of an element in an .ajrplugindata file. The plug-in manager works from these rather than from NSXMLElement, which means a manifest can be restored from the manifest cache without touching the XML parser. Only elements are kept; comments and whitespace carry no meaning in plug-in data.
+ */
+@interface AJRPlugInManifestNode : NSObject
+
+- (instancetype)initWithName:(NSString *)name
+              attributeNames:(NSArray<NSString *> *)attributeNames
+             attributeValues:(NSArray<NSString *> *)attributeValues
+                    children:(NSArray<AJRPlugInManifestNode *> *)children NS_DESIGNATED_INITIALIZER;
+- (instancetype)init NS_UNAVAILABLE;
+
++ (instancetype)nodeWithXMLElement:(NSXMLElement *)element;
+
+@property (nonatomic,readonly) NSString *name;
+/*! Attribute names, in document order. */
+@property (nonatomic,readonly) NSArray<NSString *> *attributeNames;
+/*! Attribute values, parallel to attributeNames. */
+@property (nonatomic,readonly) NSArray<NSString *> *attributeValues;
+@property (nonatomic,readonly) NSArray<AJRPlugInManifestNode *> *children;
+
+- (nullable NSString *)valueForAttribute:(NSString *)name;
+
+/*! Renders the node back to XML. This matches what NSXMLElement would have produced, so log messages read the same whether or not the node came from the cache. */
+@property (nonatomic,readonly) NSString *XMLString;
+
+@end
+
+/*!
+ The parsed contents of a single .ajrplugindata file, along with the file's size and modification time, which are used to decide whether a cached copy is still valid.
+ */
+@interface AJRPlugInManifest : NSObject
+
+- (instancetype)initWithURL:(NSURL *)url fileSize:(unsigned long long)fileSize modificationTime:(struct timespec)modificationTime nodes:(NSArray<AJRPlugInManifestNode *> *)nodes NS_DESIGNATED_INITIALIZER;
+- (instancetype)init NS_UNAVAILABLE;
+
+/*! Parses the manifest at url. */
++ (nullable instancetype)manifestWithContentsOfURL:(NSURL *)url error:(NSError * _Nullable * _Nullable)error;
+
+@property (nonatomic,readonly) NSURL *url;
+@property (nonatomic,readonly) unsigned long long fileSize;
+@property (nonatomic,readonly) struct timespec modificationTime;
+/*! The top level elements of the manifest's <plugindata> node. */
+@property (nonatomic,readonly) NSArray<AJRPlugInManifestNode *> *nodes;
+
+/*! Returns YES if the manifest's file still has the size and modification time recorded in the receiver. */
+- (BOOL)isValid;
+
+@end
+
+/*!
+ A persistent cache of parsed manifests. The cache is a single binary file that's memory mapped when opened. Entries are keyed by the manifest's path and only returned when the file on disk still has the size and modification time recorded in the cache, so editing or replacing a plug-in simply causes that one manifest to be parsed again. Entries are only decoded when requested.
+
+ Call -synchronize once a batch of manifests has been requested to write out any new entries.
+ */
+@interface AJRPlugInManifestCache : NSObject
+
+/*! The cache used by the shared plug-in manager, which lives in the application's cache directory. */
+@property (nonatomic,class,readonly,nullable) NSURL *defaultCacheURL;
+
+- (instancetype)initWithURL:(NSURL *)url NS_DESIGNATED_INITIALIZER;
+- (instancetype)init NS_UNAVAILABLE;
+
+@property (nonatomic,readonly) NSURL *url;
+
+/*! Returns the cached manifest for url when it's still valid, otherwise parses the manifest and records it for the next call to -synchronize. This may be called from several threads at once. */
+- (nullable AJRPlugInManifest *)manifestForURL:(NSURL *)url error:(NSError * _Nullable * _Nullable)error;
+
+/*! The number of manifests served from the cache file. */
+@property (nonatomic,readonly) NSUInteger hitCount;
+/*! The number of manifests that had to be parsed. */
+@property (nonatomic,readonly) NSUInteger missCount;
+
+/*! Returns YES if manifests were parsed since the cache was last written. */
+@property (nonatomic,readonly) BOOL needsSynchronize;
+
+/*! Writes the cache back to disk if anything changed. */
+- (BOOL)synchronizeWithError:(NSError * _Nullable * _Nullable)error;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,536 @@
+/*
+ AJRPlugInManifest.m
+ AJRFoundation
+
+ Copyright © 2023, AJ Raftis and AJRFoundation authors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of AJRFoundation nor the names of its contributors may be
+   used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL AJ RAFTIS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import "AJRPlugInManifest.h"
+
+#import "AJRFunctions.h"
+#import "AJRLogging.h"
+#import "AJRPlugInManager.h"
+#import "NSError+Extensions.h"
+
+#import <sys/stat.h>
+
+// 'AJPM', stored little endian.
+#define AJRManifestCacheMagic 0x4D504A41
+#define AJRManifestCacheVersion 1
+// Plug-in data is never deeply nested, so anything past this is a corrupt cache.
+#define AJRManifestCacheMaxDepth 64
+
+static BOOL AJRStatManifest(NSURL *url, unsigned long long *size, struct timespec *modificationTime) {
+    struct stat info;
+    if (stat(url.fileSystemRepresentation, &info) != 0) {
+        return NO;
+    }
+    *size = (unsigned long long)info.st_size;
+    *modificationTime = info.st_mtimespec;
+    return YES;
+}
+
+#pragma mark - AJRPlugInManifestNode
+
+@implementation AJRPlugInManifestNode
+
+- (instancetype)initWithName:(NSString *)name
+              attributeNames:(NSArray<NSString *> *)attributeNames
+             attributeValues:(NSArray<NSString *> *)attributeValues
+                    children:(NSArray<AJRPlugInManifestNode *> *)children {
+    if ((self = [super init])) {
+        _name = [name copy];
+        _attributeNames = [attributeNames copy];
+        _attributeValues = [attributeValues copy];
+        _children = [children copy];
+    }
+    return self;
+}
+
++ (instancetype)nodeWithXMLElement:(NSXMLElement *)element {
+    NSArray<NSXMLNode *> *attributes = [element attributes];
+    NSMutableArray<NSString *> *names = [NSMutableArray arrayWithCapacity:[attributes count]];
+    NSMutableArray<NSString *> *values = [NSMutableArray arrayWithCapacity:[attributes count]];
+    NSMutableArray<AJRPlugInManifestNode *> *children = [NSMutableArray array];
+
+    for (NSXMLNode *attribute in attributes) {
+        [names addObject:[attribute name] ?: @""];
+        [values addObject:[attribute stringValue] ?: @""];
+    }
+    for (NSXMLNode *child in [element children]) {
+        if ([child kind] == NSXMLElementKind) {
+            [children addObject:[self nodeWithXMLElement:(NSXMLElement *)child]];
+        }
+    }
+
+    return [[self alloc] initWithName:[element name] ?: @"" attributeNames:names attributeValues:values children:children];
+}
+
+- (NSString *)valueForAttribute:(NSString *)name {
+    NSUInteger index = [_attributeNames indexOfObject:name];
+    return index == NSNotFound ? nil : _attributeValues[index];
+}
+
+static void AJRAppendEscaped(NSMutableString *string, NSString *value) {
+    NSUInteger length = [value length];
+    NSUInteger start = 0;
+
+    for (NSUInteger x = 0; x < length; x++) {
+        NSString *replacement = nil;
+        switch ([value characterAtIndex:x]) {
+            case '&': replacement = @"&amp;"; break;
+            case '<': replacement = @"&lt;"; break;
+            case '>': replacement = @"&gt;"; break;
+            case '"': replacement = @"&quot;"; break;
+        }
+        if (replacement) {
+            [string appendString:[value substringWithRange:(NSRange){start, x - start}]];
+            [string appendString:replacement];
+            start = x + 1;
+        }
+    }
+    [string appendString:start == 0 ? value : [value substringFromIndex:start]];
+}
+
+- (void)_appendXMLToString:(NSMutableString *)string {
+    [string appendFormat:@"<%@", _name];
+    for (NSUInteger x = 0; x < [_attributeNames count]; x++) {
+        [string appendFormat:@" %@=\"", _attributeNames[x]];
+        AJRAppendEscaped(string, _attributeValues[x]);
+        [string appendString:@"\""];
+    }
+    [string appendString:@">"];
+    for (AJRPlugInManifestNode *child in _children) {
+        [child _appendXMLToString:string];
+    }
+    [string appendFormat:@"</%@>", _name];
+}
+
+- (NSString *)XMLString {
+    NSMutableString *string = [NSMutableString string];
+    [self _appendXMLToString:string];
+    return string;
+}
+
+- (NSString *)description {
+    return [self XMLString];
+}
+
+@end
+
+#pragma mark - AJRPlugInManifest
+
+@implementation AJRPlugInManifest
+
+- (instancetype)initWithURL:(NSURL *)url fileSize:(unsigned long long)fileSize modificationTime:(struct timespec)modificationTime nodes:(NSArray<AJRPlugInManifestNode *> *)nodes {
+    if ((self = [super init])) {
+        _url = url;
+        _fileSize = fileSize;
+        _modificationTime = modificationTime;
+        _nodes = [nodes copy];
+    }
+    return self;
+}
+
++ (instancetype)manifestWithContentsOfURL:(NSURL *)url error:(NSError **)error {
+    AJRPlugInManifest *manifest = nil;
+    NSError *localError = nil;
+    unsigned long long size;
+    struct timespec modificationTime;
+
+    // Stat before parsing. If the file changes underneath us, we'll record the old time and simply parse again next time.
+    if (!AJRStatManifest(url, &size, &modificationTime)) {
+        localError = [NSError errorWithDomain:NSPOSIXErrorDomain errorNumber:errno];
+    } else {
+        NSXMLDocument *document = [[NSXMLDocument alloc] initWithContentsOfURL:url options:0 error:&localError];
+        if (document) {
+            NSXMLElement *root = [document rootElement];
+            NSMutableArray<AJRPlugInManifestNode *> *nodes = [NSMutableArray array];
+            if ([[root name] isEqualToString:@"plugindata"]) {
+                for (NSXMLNode *child in [root children]) {
+                    if ([child kind] == NSXMLElementKind) {
+                        [nodes addObject:[AJRPlugInManifestNode nodeWithXMLElement:(NSXMLElement *)child]];
+                    }
+                }
+            }
+            manifest = [[self alloc] initWithURL:url fileSize:size modificationTime:modificationTime nodes:nodes];
+        }
+    }
+
+    return AJRAssertOrPropagateError(manifest, error, localError);
+}
+
+- (BOOL)isValid {
+    unsigned long long size;
+    struct timespec modificationTime;
+
+    return (AJRStatManifest(_url, &size, &modificationTime)
+            && size == _fileSize
+            && modificationTime.tv_sec == _modificationTime.tv_sec
+            && modificationTime.tv_nsec == _modificationTime.tv_nsec);
+}
+
+@end
+
+#pragma mark - Cache Encoding
+
+typedef struct _ajrManifestCursor {
+    const uint8_t *bytes;
+    size_t length;
+    size_t offset;
+    BOOL failed;
+} AJRManifestCursor;
+
+static uint32_t AJRManifestReadUInt32(AJRManifestCursor *cursor) {
+    uint32_t value = 0;
+    if (cursor->failed || cursor->length - cursor->offset < sizeof(value)) {
+        cursor->failed = YES;
+    } else {
+        memcpy(&value, cursor->bytes + cursor->offset, sizeof(value));
+        cursor->offset += sizeof(value);
+    }
+    return CFSwapInt32LittleToHost(value);
+}
+
+static uint64_t AJRManifestReadUInt64(AJRManifestCursor *cursor) {
+    uint64_t value = 0;
+    if (cursor->failed || cursor->length - cursor->offset < sizeof(value)) {
+        cursor->failed = YES;
+    } else {
+        memcpy(&value, cursor->bytes + cursor->offset, sizeof(value));
+        cursor->offset += sizeof(value);
+    }
+    return CFSwapInt64LittleToHost(value);
+}
+
+static void AJRManifestWriteUInt32(NSMutableData *data, uint32_t value) {
+    value = CFSwapInt32HostToLittle(value);
+    [data appendBytes:&value length:sizeof(value)];
+}
+
+static void AJRManifestWriteUInt64(NSMutableData *data, uint64_t value) {
+    value = CFSwapInt64HostToLittle(value);
+    [data appendBytes:&value length:sizeof(value)];
+}
+
+/*! Where an entry lives in the mapped cache file, and what it was recorded against. */
+@interface AJRPlugInManifestCacheEntry : NSObject {
+@public
+    unsigned long long _fileSize;
+    struct timespec _modificationTime;
+    size_t _payloadOffset;
+    size_t _payloadLength;
+}
+@end
+
+@implementation AJRPlugInManifestCacheEntry
+@end
+
+#pragma mark - AJRPlugInManifestCache
+
+@interface AJRPlugInManifestCache ()
+
+@property (nonatomic,strong) NSData *data;
+@property (nonatomic,strong) NSArray<NSString *> *strings;
+@property (nonatomic,strong) NSDictionary<NSString *, AJRPlugInManifestCacheEntry *> *entries;
+@property (nonatomic,strong) NSMutableDictionary<NSString *, AJRPlugInManifest *> *manifests;
+/*! Protects manifests, the counts, and needsSynchronize. Everything read from the mapped file is immutable once loaded. */
+@property (nonatomic,strong) NSLock *lock;
+
+@end
+
+@implementation AJRPlugInManifestCache
+
++ (NSURL *)defaultCacheURL {
+    return [AJRApplicationCacheURL() URLByAppendingPathComponent:@"AJRPlugInManager.cache"];
+}
+
+- (instancetype)initWithURL:(NSURL *)url {
+    if ((self = [super init])) {
+        _url = url;
+        _manifests = [NSMutableDictionary dictionary];
+        _lock = [[NSLock alloc] init];
+        [self _load];
+    }
+    return self;
+}
+
+- (void)_load {
+    NSData *data = [NSData dataWithContentsOfURL:_url options:NSDataReadingMappedAlways error:NULL];
+    AJRManifestCursor cursor = { data.bytes, data.length, 0, NO };
+    NSMutableArray<NSString *> *strings;
+    NSMutableDictionary<NSString *, AJRPlugInManifestCacheEntry *> *entries;
+    uint32_t stringCount, manifestCount;
+
+    if (data == nil) {
+        return;
+    }
+    if (AJRManifestReadUInt32(&cursor) != AJRManifestCacheMagic || AJRManifestReadUInt32(&cursor) != AJRManifestCacheVersion) {
+        AJRLog(AJRLoggingDomainPlugInManager, AJRLogLevelDebug, @"Ignoring plug-in cache with an unknown format: %@", _url.path);
+        return;
+    }
+
+    stringCount = AJRManifestReadUInt32(&cursor);
+    manifestCount = AJRManifestReadUInt32(&cursor);
+
+    strings = [NSMutableArray arrayWithCapacity:MIN(stringCount, 4096)];
+    for (uint32_t x = 0; x < stringCount && !cursor.failed; x++) {
+        uint32_t length = AJRManifestReadUInt32(&cursor);
+        if (cursor.failed || cursor.length - cursor.offset < length) {
+            cursor.failed = YES;
+        } else {
+            NSString *string = [[NSString alloc] initWithBytes:cursor.bytes + cursor.offset length:length encoding:NSUTF8StringEncoding];
+            if (string == nil) {
+                cursor.failed = YES;
+            } else {
+                [strings addObject:string];
+                cursor.offset += length;
+            }
+        }
+    }
+
+    entries = [NSMutableDictionary dictionaryWithCapacity:MIN(manifestCount, 4096)];
+    for (uint32_t x = 0; x < manifestCount && !cursor.failed; x++) {
+        uint32_t pathIndex = AJRManifestReadUInt32(&cursor);
+        AJRPlugInManifestCacheEntry *entry = [[AJRPlugInManifestCacheEntry alloc] init];
+        entry->_fileSize = AJRManifestReadUInt64(&cursor);
+        entry->_modificationTime.tv_sec = (time_t)AJRManifestReadUInt64(&cursor);
+        entry->_modificationTime.tv_nsec = (long)AJRManifestReadUInt64(&cursor);
+        entry->_payloadLength = AJRManifestReadUInt32(&cursor);
+        entry->_payloadOffset = cursor.offset;
+        if (cursor.failed || pathIndex >= [strings count] || cursor.length - cursor.offset < entry->_payloadLength) {
+            cursor.failed = YES;
+        } else {
+            entries[strings[pathIndex]] = entry;
+            cursor.offset += entry->_payloadLength;
+        }
+    }
+
+    if (cursor.failed) {
+        AJRLog(AJRLoggingDomainPlugInManager, AJRLogLevelDebug, @"Ignoring corrupt plug-in cache: %@", _url.path);
+    } else {
+        _data = data;
+        _strings = strings;
+        _entries = entries;
+    }
+}
+
+- (AJRPlugInManifestNode *)_decodeNode:(AJRManifestCursor *)cursor depth:(NSUInteger)depth {
+    NSUInteger stringCount = [_strings count];
+    uint32_t nameIndex = AJRManifestReadUInt32(cursor);
+    uint32_t attributeCount = AJRManifestReadUInt32(cursor);
+    NSMutableArray<NSString *> *names = [NSMutableArray arrayWithCapacity:MIN(attributeCount, 64)];
+    NSMutableArray<NSString *> *values = [NSMutableArray arrayWithCapacity:MIN(attributeCount, 64)];
+    NSMutableArray<AJRPlugInManifestNode *> *children;
+    uint32_t childCount;
+
+    if (depth > AJRManifestCacheMaxDepth || nameIndex >= stringCount) {
+        cursor->failed = YES;
+    }
+    for (uint32_t x = 0; x < attributeCount && !cursor->failed; x++) {
+        uint32_t name = AJRManifestReadUInt32(cursor);
+        uint32_t value = AJRManifestReadUInt32(cursor);
+        if (name >= stringCount || value >= stringCount) {
+            cursor->failed = YES;
+        } else {
+            [names addObject:_strings[name]];
+            [values addObject:_strings[value]];
+        }
+    }
+    childCount = AJRManifestReadUInt32(cursor);
+    children = [NSMutableArray arrayWithCapacity:MIN(childCount, 64)];
+    for (uint32_t x = 0; x < childCount && !cursor->failed; x++) {
+        AJRPlugInManifestNode *child = [self _decodeNode:cursor depth:depth + 1];
+        if (child) {
+            [children addObject:child];
+        }
+    }
+
+    return cursor->failed ? nil : [[AJRPlugInManifestNode alloc] initWithName:_strings[nameIndex] attributeNames:names attributeValues:values children:children];
+}
+
+- (AJRPlugInManifest *)_decodeEntry:(AJRPlugInManifestCacheEntry *)entry forURL:(NSURL *)url {
+    AJRManifestCursor cursor = { (const uint8_t *)_data.bytes + entry->_payloadOffset, entry->_payloadLength, 0, NO };
+    uint32_t count = AJRManifestReadUInt32(&cursor);
+    NSMutableArray<AJRPlugInManifestNode *> *nodes = [NSMutableArray arrayWithCapacity:MIN(count, 4096)];
+
+    for (uint32_t x = 0; x < count && !cursor.failed; x++) {
+        AJRPlugInManifestNode *node = [self _decodeNode:&cursor depth:0];
+        if (node) {
+            [nodes addObject:node];
+        }
+    }
+
+    return cursor.failed ? nil : [[AJRPlugInManifest alloc] initWithURL:url fileSize:entry->_fileSize modificationTime:entry->_modificationTime nodes:nodes];
+}
+
+- (BOOL)_entry:(AJRPlugInManifestCacheEntry *)entry isValidForURL:(NSURL *)url {
+    unsigned long long size;
+    struct timespec modificationTime;
+
+    return (AJRStatManifest(url, &size, &modificationTime)
+            && size == entry->_fileSize
+            && modificationTime.tv_sec == entry->_modificationTime.tv_sec
+            && modificationTime.tv_nsec == entry->_modificationTime.tv_nsec);
+}
+
+- (AJRPlugInManifest *)manifestForURL:(NSURL *)url error:(NSError **)error {
+    NSString *path = [url path];
+    AJRPlugInManifestCacheEntry *entry = _entries[path];
+    AJRPlugInManifest *manifest = nil;
+    NSError *localError = nil;
+
+    if (entry != nil && [self _entry:entry isValidForURL:url]) {
+        manifest = [self _decodeEntry:entry forURL:url];
+    }
+    if (manifest) {
+        [_lock lock];
+        _hitCount += 1;
+        _manifests[path] = manifest;
+        [_lock unlock];
+    } else {
+        manifest = [AJRPlugInManifest manifestWithContentsOfURL:url error:&localError];
+        if (manifest) {
+            [_lock lock];
+            _missCount += 1;
+            _needsSynchronize = YES;
+            _manifests[path] = manifest;
+            [_lock unlock];
+        }
+    }
+
+    return AJRAssertOrPropagateError(manifest, error, localError);
+}
+
+#pragma mark - Writing
+
+static uint32_t AJRManifestStringIndex(NSString *string, NSMutableDictionary<NSString *, NSNumber *> *indexes, NSMutableArray<NSString *> *strings) {
+    NSNumber *index = indexes[string];
+    if (index == nil) {
+        index = @([strings count]);
+        indexes[string] = index;
+        [strings addObject:string];
+    }
+    return (uint32_t)[index unsignedIntValue];
+}
+
+static void AJRManifestEncodeNode(AJRPlugInManifestNode *node, NSMutableData *data, NSMutableDictionary<NSString *, NSNumber *> *indexes, NSMutableArray<NSString *> *strings) {
+    AJRManifestWriteUInt32(data, AJRManifestStringIndex(node.name, indexes, strings));
+    AJRManifestWriteUInt32(data, (uint32_t)[node.attributeNames count]);
+    for (NSUInteger x = 0; x < [node.attributeNames count]; x++) {
+        AJRManifestWriteUInt32(data, AJRManifestStringIndex(node.attributeNames[x], indexes, strings));
+        AJRManifestWriteUInt32(data, AJRManifestStringIndex(node.attributeValues[x], indexes, strings));
+    }
+    AJRManifestWriteUInt32(data, (uint32_t)[node.children count]);
+    for (AJRPlugInManifestNode *child in node.children) {
+        AJRManifestEncodeNode(child, data, indexes, strings);
+    }
+}
+
+- (NSData *)_encodeManifests:(NSDictionary<NSString *, AJRPlugInManifest *> *)manifests {
+    NSMutableDictionary<NSString *, NSNumber *> *indexes = [NSMutableDictionary dictionary];
+    NSMutableArray<NSString *> *strings = [NSMutableArray array];
+    NSMutableData *body = [NSMutableData data];
+    NSMutableData *payload = [NSMutableData data];
+    NSMutableData *data;
+
+    // Sorted, so that the same set of manifests always produces the same file.
+    for (NSString *path in [[manifests allKeys] sortedArrayUsingSelector:@selector(compare:)]) {
+        AJRPlugInManifest *manifest = manifests[path];
+
+        [payload setLength:0];
+        AJRManifestWriteUInt32(payload, (uint32_t)[manifest.nodes count]);
+        for (AJRPlugInManifestNode *node in manifest.nodes) {
+            AJRManifestEncodeNode(node, payload, indexes, strings);
+        }
+
+        AJRManifestWriteUInt32(body, AJRManifestStringIndex(path, indexes, strings));
+        AJRManifestWriteUInt64(body, manifest.fileSize);
+        AJRManifestWriteUInt64(body, (uint64_t)manifest.modificationTime.tv_sec);
+        AJRManifestWriteUInt64(body, (uint64_t)manifest.modificationTime.tv_nsec);
+        AJRManifestWriteUInt32(body, (uint32_t)[payload length]);
+        [body appendData:payload];
+    }
+
+    data = [NSMutableData dataWithCapacity:[body length] + 16 * [strings count]];
+    AJRManifestWriteUInt32(data, AJRManifestCacheMagic);
+    AJRManifestWriteUInt32(data, AJRManifestCacheVersion);
+    AJRManifestWriteUInt32(data, (uint32_t)[strings count]);
+    AJRManifestWriteUInt32(data, (uint32_t)[manifests count]);
+    for (NSString *string in strings) {
+        const char *utf8 = [string UTF8String];
+        uint32_t length = (uint32_t)strlen(utf8);
+        AJRManifestWriteUInt32(data, length);
+        [data appendBytes:utf8 length:length];
+    }
+    [data appendData:body];
+
+    return data;
+}
+
+- (BOOL)synchronizeWithError:(NSError **)error {
+    NSMutableDictionary<NSString *, AJRPlugInManifest *> *manifests;
+    NSError *localError = nil;
+    BOOL success = YES;
+
+    [_lock lock];
+    if (!_needsSynchronize) {
+        [_lock unlock];
+        return YES;
+    }
+    manifests = [_manifests mutableCopy];
+    _needsSynchronize = NO;
+    [_lock unlock];
+
+    // Carry forward anything from the previous file we weren't asked about, as long as it's still good. Other code paths in the process, or the next launch, may well still want it.
+    [_entries enumerateKeysAndObjectsUsingBlock:^(NSString *path, AJRPlugInManifestCacheEntry *entry, BOOL *stop) {
+        if (manifests[path] == nil) {
+            NSURL *url = [NSURL fileURLWithPath:path];
+            if ([self _entry:entry isValidForURL:url]) {
+                AJRPlugInManifest *manifest = [self _decodeEntry:entry forURL:url];
+                if (manifest) {
+                    manifests[path] = manifest;
+                }
+            }
+        }
+    }];
+
+    success = [[NSFileManager defaultManager] createDirectoryAtURL:[_url URLByDeletingLastPathComponent] withIntermediateDirectories:YES attributes:nil error:&localError];
+    if (success) {
+        // Atomic, so that our own mapping, and anyone else's, keeps seeing the old file.
+        success = [[self _encodeManifests:manifests] writeToURL:_url options:NSDataWritingAtomic error:&localError];
+    }
+    if (!success) {
+        [_lock lock];
+        _needsSynchronize = YES;
+        [_lock unlock];
+    }
+
+    return AJRAssertOrPropagateError(success, error, localError);
+}
+
+@end
@@ -0,0 +1,185 @@
+/*
+ XMLAttributeMap.swift
+ AJRFoundation
+
+ Copyright © 2023, AJ Raftis and AJRFoundation authors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of AJRFoundation nor the names of its contributors may be
+   used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL AJ RAFTIS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#if os(Linux) || os(iOS) || os(tvOS) || os(watchOS)
+
+import Foundation
+
+/**
+ An ordered name → node map for an element's attributes.
+
+ Elements rarely have more than a handful of attributes, so names and nodes are kept in parallel arrays in document order and looked up with a linear scan, which beats hashing at that size. Only once an element grows past `linearSearchLimit` attributes do we build a hashed index, and that's dropped whenever a removal shifts positions.
+ */
+internal struct XMLAttributeMap : Sequence, AJREquatable {
+
+    static let linearSearchLimit = 8
+
+    private var names = [String]()
+    private var nodes = [XMLNode]()
+    private var positions : [String:Int]? = nil
+
+    var count : Int {
+        return names.count
+    }
+
+    var isEmpty : Bool {
+        return names.isEmpty
+    }
+
+    /// The attribute nodes in document order.
+    var values : [XMLNode] {
+        return nodes
+    }
+
+    private func position(of name: String) -> Int? {
+        if let positions = positions {
+            return positions[name]
+        }
+        return names.firstIndex(of: name)
+    }
+
+    private mutating func reindex() -> Void {
+        if names.count > XMLAttributeMap.linearSearchLimit {
+            var positions = [String:Int](minimumCapacity: names.count)
+            for (index, name) in names.enumerated() {
+                positions[name] = index
+            }
+            self.positions = positions
+        } else {
+            positions = nil
+        }
+    }
+
+    subscript(name: String) -> XMLNode? {
+        get {
+            if let index = position(of: name) {
+                return nodes[index]
+            }
+            return nil
+        }
+        set(newValue) {
+            if let newValue = newValue {
+                updateValue(newValue, forKey: name)
+            } else {
+                removeValue(forKey: name)
+            }
+        }
+    }
+
+    /// Replaces the value for `name` in place, or appends it if it's new. Returns the previous value, if any.
+    @discardableResult
+    mutating func updateValue(_ node: XMLNode, forKey name: String) -> XMLNode? {
+        if let index = position(of: name) {
+            let old = nodes[index]
+            nodes[index] = node
+            return old
+        }
+        names.append(name)
+        nodes.append(node)
+        if positions != nil {
+            positions![name] = names.count - 1
+        } else if names.count > XMLAttributeMap.linearSearchLimit {
+            reindex()
+        }
+        return nil
+    }
+
+    /// Replaces the value for `name` with `node`, renaming it to `newName` but keeping its position. If `name` isn't present, `node` is appended under `newName`.
+    @discardableResult
+    mutating func updateValue(_ node: XMLNode, forKey name: String, newKey newName: String) -> XMLNode? {
+        guard let index = position(of: name) else {
+            updateValue(node, forKey: newName)
+            return nil
+        }
+        let old = nodes[index]
+        if name != newName, let existing = position(of: newName) {
+            // Renaming onto another attribute replaces it, otherwise we'd have the name twice.
+            names.remove(at: existing)
+            nodes.remove(at: existing)
+            let adjusted = existing < index ? index - 1 : index
+            names[adjusted] = newName
+            nodes[adjusted] = node
+            reindex()
+        } else {
+            names[index] = newName
+            nodes[index] = node
+            if name != newName && positions != nil {
+                positions![name] = nil
+                positions![newName] = index
+            }
+        }
+        return old
+    }
+
+    @discardableResult
+    mutating func removeValue(forKey name: String) -> XMLNode? {
+        guard let index = position(of: name) else {
+            return nil
+        }
+        let old = nodes[index]
+        names.remove(at: index)
+        nodes.remove(at: index)
+        if positions != nil {
+            reindex()
+        }
+        return old
+    }
+
+    mutating func removeAll() -> Void {
+        names.removeAll()
+        nodes.removeAll()
+        positions = nil
+    }
+
+    // MARK: - Sequence
+
+    func makeIterator() -> Zip2Sequence<[String], [XMLNode]>.Iterator {
+        return zip(names, nodes).makeIterator()
+    }
+
+    // MARK: - AJREquatable
+
+    /// Attribute order isn't significant in XML, so two maps are equal when they have the same names with equal nodes, regardless of order.
+    func isEqual(_ other: Any?) -> Bool {
+        guard let other = other as? XMLAttributeMap, other.count == count else {
+            return false
+        }
+        for (name, node) in self {
+            if !AJRAnyEquals(node, other[name]) {
+                return false
+            }
+        }
+        return true
+    }
+
+}
+
+#endif
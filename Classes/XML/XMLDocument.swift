@@ -295,42 +295,55 @@ open class XMLDocument : XMLNode, XMLParserDelegate, XMLNodeWithChildren {
         }
         
         // Don't pass an encoding here. Let libxml2 figure it out.
-        if let reader = XMLReader(withData: data, baseURL: baseURL, encoding: nil, options: 0, delegate: self) {
-            var hasSetVersion = false
-            var hasSetEncoding = false
-            elementStack = [XMLElement]()
-            isStandalone = true
-            while reader.read() {
-                if !hasSetVersion {
-                    if let rawVersion = reader.xmlVersion {
-                        version = rawVersion
-                        hasSetVersion = true
-                    }
-                }
-                if !hasSetEncoding {
-                    if let rawEncoding = reader.encoding {
-                        characterEncoding = rawEncoding
-                        hasSetEncoding = true
-                    }
+        try XMLReader.withReader(for: data, baseURL: baseURL, encoding: nil, options: 0, delegate: self) { reader in
+            try parse(from: reader)
+        }
+    }
+    
+    private func parse(from reader: XMLReader) throws -> Void {
+        var hasSetVersion = false
+        var hasSetEncoding = false
+        elementStack = [XMLElement]()
+        isStandalone = true
+        defer {
+            // We're done with these.
+            elementStack = nil;
+        }
+        while reader.read() {
+            if !hasSetVersion {
+                if let rawVersion = reader.xmlVersion {
+                    version = rawVersion
+                    hasSetVersion = true
                 }
-                try processNode(from: reader)
-                if let parseError = parseError {
-                    throw XMLError.generic(parseError)
+            }
+            if !hasSetEncoding {
+                if let rawEncoding = reader.encoding {
+                    characterEncoding = rawEncoding
+                    hasSetEncoding = true
                 }
             }
-            
+            try processNode(from: reader)
             if let parseError = parseError {
                 throw XMLError.generic(parseError)
             }
+        }
+        
+        if let parseError = parseError {
+            throw XMLError.generic(parseError)
+        }
 
-            // Grab some final, potential information.
-            isStandalone = reader.isStandalone
-            
-            // We're done with these.
-            elementStack = nil;
-            
-            // And close down the reader
-            reader.close()
+        // Grab some final, potential information.
+        isStandalone = reader.isStandalone
+    }
+    
+    private func parse(using makeReader: () -> XMLReader?) throws -> Void {
+        if let reader = makeReader() {
+            defer {
+                reader.close()
+            }
+            try parse(from: reader)
+        } else {
+            throw XMLError.invalidInput("Could not open \(baseURL?.absoluteString ?? "input") for reading.")
         }
     }
     
@@ -352,16 +365,44 @@ open class XMLDocument : XMLNode, XMLParserDelegate, XMLNodeWithChildren {
     }
 
     public convenience init(contentsOf url: URL, options mask: XMLNode.Options = []) throws {
-        let data = try Data(contentsOf: url)
-        try self.init(data:data, options:mask)
-        baseURL = url
+        if url.isFileURL && !mask.contains(.documentInjectHTMLDocType) {
+            // Let libxml2 read the file itself, rather than loading the whole thing into memory first.
+            try self.init(fileURL: url, options: mask)
+        } else {
+            let data = try Data(contentsOf: url)
+            try self.init(data:data, options:mask)
+            baseURL = url
+        }
     }
 
     @objc(initWithContentsOfURL:options:error:)
     public convenience init(contentsOf url: URL, options: NSXMLNodeOptions) throws {
-        let data = try Data(contentsOf: url)
-        try self.init(data: data, options: XMLNode.Options(rawValue: options))
+        try self.init(contentsOf: url, options: XMLNode.Options(rawValue: options))
+    }
+    
+    private init(fileURL url: URL, options mask: XMLNode.Options) throws {
+        super.init(kind: .document, options: mask)
         baseURL = url
+        try parse { XMLReader(withURL: url, encoding: nil, options: 0, delegate: self) }
+    }
+    
+    /// Parses the document by reading from `fileDescriptor`, which is left open. `baseURL` is used to resolve relative references, such as external DTDs.
+    ///
+    /// Like `init(contentsOf:options:)`, this lets libxml2 read the descriptor directly, except when `mask` contains `.documentInjectHTMLDocType`. Injecting the DOCTYPE means prepending it to the input, so in that case the descriptor is read to the end and parsed as `Data`.
+    public convenience init(fileDescriptor: Int32, baseURL: URL? = nil, options mask: XMLNode.Options = []) throws {
+        if mask.contains(.documentInjectHTMLDocType) {
+            let data = try FileHandle(fileDescriptor: fileDescriptor, closeOnDealloc: false).readToEnd() ?? Data()
+            try self.init(data: data, options: mask)
+            self.baseURL = baseURL
+        } else {
+            try self.init(readingFileDescriptor: fileDescriptor, baseURL: baseURL, options: mask)
+        }
+    }
+
+    private init(readingFileDescriptor fileDescriptor: Int32, baseURL: URL?, options mask: XMLNode.Options) throws {
+        super.init(kind: .document, options: mask)
+        self.baseURL = baseURL
+        try parse { XMLReader(withFileDescriptor: fileDescriptor, baseURL: baseURL, encoding: nil, options: 0, delegate: self) }
     }
 
     public init(data: Data, options mask: XMLNode.Options = []) throws {
@@ -427,18 +468,11 @@ open class XMLDocument : XMLNode, XMLParserDelegate, XMLNodeWithChildren {
         return xmlData(options:.none)
     }
     
-    open func xmlData(options: XMLNode.Options = []) -> Data {
-        let encoding = String.Encoding.utf8
-        /* Not sure how to do this yet.
-        if let characterEncoding = characterEncoding {
-            let possible = CFStringConvertIANACharSetNameToEncoding(characterEncoding)
-        } else {
-            encoding = .utf8
-        }
-        CFStringEncoding encoding = _characterEncoding ? CFStringConvertIANACharSetNameToEncoding((__bridge CFStringRef)_characterEncoding) : kCFStringEncodingASCII;
-        */
-        let string = xmlString(options: options)
-        return string.data(using: encoding)!
+    open override func xmlData(options: XMLNode.Options = []) -> Data {
+        // The writer always produces UTF-8, whatever characterEncoding says, which matches what xmlString(options:) has always produced.
+        let writer = XMLWriter()
+        write(to: writer, options: options)
+        return writer.data
     }
     
     open override var stringValue: String? {
@@ -464,50 +498,54 @@ open class XMLDocument : XMLNode, XMLParserDelegate, XMLNodeWithChildren {
     }
     
     open override func xmlString(options: XMLNode.Options = []) -> String {
-        var string = ""
+        let writer = XMLWriter()
+        write(to: writer, options: options)
+        return writer.string
+    }
+    
+    open override func write(to writer: XMLWriter, options: XMLNode.Options = []) -> Void {
+        let start = writer.byteCount
         
         if (_children != nil && children!.count > 0) || (_dtds != nil && _dtds!.count > 0) {
             if (version != nil || characterEncoding != nil || isStandalone) && documentContentKind != .html {
-                string += "<?xml"
+                writer.write("<?xml")
                 if let version = version {
-                    string += " version=\""
-                    string += version
-                    string += "\""
+                    writer.write(" version=\"")
+                    writer.write(version)
+                    writer.write("\"")
                 }
                 if let characterEncoding = characterEncoding {
-                    string += " encoding=\""
+                    writer.write(" encoding=\"")
                     // Try to match the input file, if possible, otherwise lookup the correct string.
-                    string += characterEncoding
-                    string += "\""
+                    writer.write(characterEncoding)
+                    writer.write("\"")
                 }
                 if isStandalone {
-                    string += " standalone=\"yes\""
+                    writer.write(" standalone=\"yes\"")
                 }
-                string += "?>"
+                writer.write("?>")
             }
             if var dtds = _dtds {
                 if injectedDTD {
                     dtds.removeFirst()
                 }
                 if dtds.count > 0 {
-                    string += "\n"
+                    writer.write("\n")
                 }
                 for child in dtds {
-                    string += child.xmlString(options: options)
-                    string += "\n"
+                    child.write(to: writer, options: options)
+                    writer.write("\n")
                 }
             }
             if let children = _children {
                 for child in children {
-                    if options.contains(.nodePrettyPrint) && !string.isEmpty {
-                        string += "\n"
+                    if options.contains(.nodePrettyPrint) && writer.byteCount > start {
+                        writer.write("\n")
                     }
-                    string += child.xmlString(options: options)
+                    child.write(to: writer, options: options)
                 }
             }
         }
-        
-        return string;
     }
     
     // MARK: - XSLT
@@ -38,7 +38,7 @@ import libxml2
 @objc(NSXMLElement)
 public class XMLElement : XMLNode, XMLParserDelegate, XMLNodeWithChildren {
     
-    private var _attributes = OrderedDictionary<String, XMLNode>()
+    private var _attributes = XMLAttributeMap()
     public var attributes : [XMLNode]? {
         get {
             return Array(_attributes.values)
@@ -76,9 +76,19 @@ public class XMLElement : XMLNode, XMLParserDelegate, XMLNodeWithChildren {
     // These two variables are tansient and only used during xml parsing
     private var parseError: String? = nil
     private var elementStack: [XMLElement]? = nil
+    // Documents repeat the same handful of element and attribute names over and over, so while parsing we share one copy of each.
+    private var internedNames: [String:String]? = nil
+    
+    private func intern(_ name: String) -> String {
+        if let interned = internedNames?[name] {
+            return interned
+        }
+        internedNames?[name] = name
+        return name
+    }
     
     private func processElement(from reader: XMLReader) throws -> Void {
-        if let name = reader.name {
+        if let name = reader.name.map(intern) {
             var element: XMLElement? = nil
             let isEmpty = reader.isEmptyElement // This means the element was immediate terminate, i.e. <br />
             
@@ -95,7 +105,7 @@ public class XMLElement : XMLNode, XMLParserDelegate, XMLNodeWithChildren {
             while reader.moveToNextAttribute(){
                 let attributeNodeType = reader.nodeType
                 if attributeNodeType == .attribute {
-                    if let attributeName = reader.name {
+                    if let attributeName = reader.name.map(intern) {
                         element?.addAttribute(XMLNode.attribute(withName: attributeName, stringValue: reader.value) as! XMLNode)
                     }
                 } else {
@@ -188,22 +198,25 @@ public class XMLElement : XMLNode, XMLParserDelegate, XMLNodeWithChildren {
     }
     
     private func parse(data: Data) throws -> Void {
-        if let reader = XMLReader(withData: data, baseURL: nil, encoding: "utf8", options: 0, delegate: self) {
-            defer {
-                // And close down the reader
-                reader.close()
-                
-                // For everything to potentially garbage collect.
-                elementStack = nil
-            }
-            
-            elementStack = [XMLElement]()
-            
-            while reader.read() {
-                try processNode(from: reader)
-                if let parseError = parseError {
-                    throw XMLError.generic(parseError)
-                }
+        try XMLReader.withReader(for: data, baseURL: nil, encoding: "utf8", options: 0, delegate: self) { reader in
+            try parse(from: reader)
+        }
+    }
+    
+    private func parse(from reader: XMLReader) throws -> Void {
+        defer {
+            // For everything to potentially garbage collect.
+            elementStack = nil
+            internedNames = nil
+        }
+        
+        elementStack = [XMLElement]()
+        internedNames = [String:String]()
+        
+        while reader.read() {
+            try processNode(from: reader)
+            if let parseError = parseError {
+                throw XMLError.generic(parseError)
             }
         }
     }
@@ -223,6 +236,19 @@ public class XMLElement : XMLNode, XMLParserDelegate, XMLNodeWithChildren {
         }
     }
     
+    /// Parses the element from the file at `url`. The file is read incrementally by libxml2 rather than being loaded into memory first.
+    public convenience init?(contentsOf url: URL) throws {
+        self.init(kind: .element, options: .none)
+        if let reader = XMLReader(withURL: url, encoding: nil, options: 0, delegate: self) {
+            defer {
+                reader.close()
+            }
+            try parse(from: reader)
+        } else {
+            throw XMLError.invalidInput("Could not open \(url) for reading.")
+        }
+    }
+    
     public convenience init?(xmlString string: String) throws {
         self.init(kind: .element, options: .none)
         if let data = string.data(using: .utf8) {
@@ -241,9 +267,20 @@ public class XMLElement : XMLNode, XMLParserDelegate, XMLNodeWithChildren {
     // MARK: - Elements by name
     
     public func elements(forName name: String) -> [XMLElement]? {
-        return _children?.filter { (object) -> Bool in
-                return object.kind == .element && AJRAnyEquals(object.name, name)
-            } as! [XMLElement]?
+        guard let children = _childStorage else {
+            return nil
+        }
+        if _childrenByName == nil {
+            // Build the whole index in one pass, so repeated queries, such as those made in nested loops, don't each rescan our children.
+            var index = [String:[XMLElement]]()
+            for child in children {
+                if child.kind == .element, let element = child as? XMLElement, let childName = element.name {
+                    index[childName, default: []].append(element)
+                }
+            }
+            _childrenByName = index
+        }
+        return _childrenByName![name] ?? []
     }
 
     public func elements(forLocalName localName: String, url: String?) -> [XMLElement]? {
@@ -357,38 +394,68 @@ public class XMLElement : XMLNode, XMLParserDelegate, XMLNodeWithChildren {
     
     // MARK: - Children
     
-    public var _children : [XMLNode]?
+    private var _childStorage : [XMLNode]? = nil
+    // Lazily built by elements(forName:), and discarded whenever our children change.
+    private var _childrenByName : [String:[XMLElement]]? = nil
+    
+    public var _children : [XMLNode]? {
+        get {
+            return _childStorage
+        }
+        set(newValue) {
+            _childStorage = newValue
+            invalidateChildIndex()
+        }
+    }
+    
     public func manipulateChildren(_ block: (inout [XMLNode]?) -> Void) {
-        block(&_children)
+        block(&_childStorage)
+        invalidateChildIndex()
+    }
+    
+    public func readChildren(_ block: ([XMLNode]?) -> Void) {
+        block(_childStorage)
+    }
+    
+    internal func invalidateChildIndex() -> Void {
+        _childrenByName = nil
+    }
+    
+    public override var name: String? {
+        didSet {
+            if oldValue != name, let parent = parent as? XMLElement {
+                parent.invalidateChildIndex()
+            }
+        }
     }
 
     public func normalizeAdjacentTextNodesPreservingCDATA(_ preserve: Bool) -> Void {
-        if _children != nil {
-            var count = _children!.count
+        if _childStorage != nil {
+            var count = _childStorage!.count
             var x = 0
             while x < count - 1 {
-                let child = _children![x]
+                let child = _childStorage![x]
                 if child.kind == .text {
-                    var nextChild : XMLNode = _children![x + 1]
+                    var nextChild : XMLNode = _childStorage![x + 1]
                     while x < count - 1 && nextChild.kind == .text {
                         let value = nextChild.stringValue
                         if value != nil && !value!.isEmpty {
                             child.stringValue = child.stringValue! + value!
                         }
-                        _children!.remove(at:x + 1)
+                        _childStorage!.remove(at:x + 1)
                         count -= 1
                         if x < count - 1 {
-                            nextChild = _children![x + 1]
+                            nextChild = _childStorage![x + 1]
                         }
                     }
                 }
                 x += 1
             }
             // OK, we've merged nodes, now lets see if we should delete any blank nodes
-            if _children!.count > 0 {
+            if _childStorage!.count > 0 {
                 x = 0
-                while x < _children!.count {
-                    let child = _children![x]
+                while x < _childStorage!.count {
+                    let child = _childStorage![x]
                     if child.kind == .text && child.stringValue?.trimmingCharacters(in: CharacterSet.whitespacesAndNewlines).count == 0 {
                         removeChild(at: x)
                         x -= 1
@@ -397,6 +464,7 @@ public class XMLElement : XMLNode, XMLParserDelegate, XMLNodeWithChildren {
                 }
             }
             // Do we trim off the end, too?
+            invalidateChildIndex()
         }
     }
     
@@ -427,49 +495,56 @@ public class XMLElement : XMLNode, XMLParserDelegate, XMLNodeWithChildren {
     }
     
     public override func xmlString(options: XMLNode.Options = []) -> String {
-        var string = ""
+        let writer = XMLWriter()
+        write(to: writer, options: options)
+        return writer.string
+    }
+    
+    public override func write(to writer: XMLWriter, options: XMLNode.Options = []) -> Void {
         var indent = 0
         let allChildrenAreText = self.allChildrenAreText()
+        let savedDepth = writer.elementDepth
         
         if options.contains(.nodePrettyPrint) {
-            indent = self.depthToRoot()
+            // Only the element we start serializing from has to walk up to the root, after that, the depth is handed down through the writer.
+            indent = savedDepth ?? self.depthToRoot()
         }
         
-        string += "<"
-        string += self.name!
+        writer.write("<")
+        writer.write(self.name!)
         for (_, namespace) in _namespaces {
-            string += " "
-            string += namespace.xmlString(options:options)
+            writer.write(" ")
+            namespace.write(to: writer, options: options)
         }
         for (_, attribute) in _attributes {
-            string += " "
-            string += attribute.xmlString(options:options)
+            writer.write(" ")
+            attribute.write(to: writer, options: options)
         }
-        string += ">"
+        writer.write(">")
         if let children = _children {
+            writer.elementDepth = indent + 1
             for child in children {
                 if indent > 0 && !allChildrenAreText {
-                    if !string.hasSuffix("\n") {
+                    if writer.lastByte != UInt8(ascii: "\n") {
                         // Only append a newline if our previous child didn't provide a newline.
-                        string += "\n"
+                        writer.write("\n")
                     }
-                    string += "".padding(toLength: indent * 4, withPad: " ", startingAt: 0)
+                    writer.writeIndent(indent * 4)
                 }
-                string += child.xmlString(options:options)
+                child.write(to: writer, options: options)
             }
+            writer.elementDepth = savedDepth
         }
         if indent > 0 && (_children != nil && _children!.count > 0) && !allChildrenAreText {
-            if !string.hasSuffix("\n") {
+            if writer.lastByte != UInt8(ascii: "\n") {
                 // Only append a newline if our last child didn't provide a newline.
-                string += "\n"
+                writer.write("\n")
             }
-            string += "".padding(toLength: (indent - 1) * 4, withPad: " ", startingAt: 0)
+            writer.writeIndent((indent - 1) * 4)
         }
-        string += "</"
-        string += self.name!
-        string += ">"
-        
-        return string
+        writer.write("</")
+        writer.write(self.name!)
+        writer.write(">")
     }
     
     // MARK: - Additions to Foundation API
@@ -87,48 +87,52 @@ public class XMLNamedNode : XMLNode {
     // MARK: - Output
 
     public override func xmlString(options: XMLNode.Options = []) -> String {
-        var string = ""
-        
+        let writer = XMLWriter(capacity: 64)
+        write(to: writer, options: options)
+        return writer.string
+    }
+    
+    public override func write(to writer: XMLWriter, options: XMLNode.Options = []) -> Void {
         if kind == .attribute {
+            var wroteName = false
             if let name = name {
                 if !name.isEmpty {
-                    string += name
+                    writer.write(name)
+                    wroteName = true
                 }
             }
             if let stringValue = stringValue {
-                if !string.isEmpty {
-                    string += "="
+                if wroteName {
+                    writer.write("=")
                 }
-                string += "\""
-                string += XMLEscapedString(stringValue, document: self.rootDocument, kind: kind)
-                string += "\""
+                writer.write("\"")
+                writer.writeEscaped(stringValue, kind: kind)
+                writer.write("\"")
             }
         } else if kind == .processingInstruction {
-            string += "<?"
+            writer.write("<?")
             if let name = name {
-                string += name
+                writer.write(name)
             }
             if let stringValue = stringValue {
-                if string.count > 0 {
-                    string += " "
+                if let name = name, !name.isEmpty {
+                    writer.write(" ")
                 }
-                string += stringValue
+                writer.write(stringValue)
             }
-            string += "?>"
+            writer.write("?>")
         } else if kind == .namespace {
-            string += "xmlns"
+            writer.write("xmlns")
             if let name = name {
                 if !name.isEmpty {
-                    string += ":"
-                    string += name
+                    writer.write(":")
+                    writer.write(name)
                 }
             }
-            string += "=\""
-            string += stringValue!
-            string += "\""
+            writer.write("=\"")
+            writer.write(stringValue!)
+            writer.write("\"")
         }
-        
-        return string
     }
     
     // MARK: - Equatable
@@ -201,7 +201,7 @@ open class XMLNode: NSObject, NSCopying, AJREquatable {
         get {
             if let childBearer = self as? XMLNodeWithChildren {
                 var children : [XMLNode]? = nil
-                childBearer.manipulateChildren { (actualChildren) in
+                childBearer.readChildren { (actualChildren) in
                     children = actualChildren
                 }
                 return children
@@ -364,23 +364,52 @@ open class XMLNode: NSObject, NSCopying, AJREquatable {
     public override var description : String { return xmlString(options: [.none]) }
     
     public func xmlString(options: XMLNode.Options = []) -> String {
-        var result = ""
-        
+        let writer = XMLWriter()
+        writeContent(to: writer)
+        return writer.string
+    }
+    
+    /// Serializes the receiver into `writer`. Nodes that render themselves by overriding `xmlString(options:)` are written through that, while elements, attributes and documents write straight into the writer's buffer.
+    public func write(to writer: XMLWriter, options: XMLNode.Options = []) -> Void {
+        if kind == .comment || kind == .text {
+            writeContent(to: writer)
+        } else {
+            writer.write(xmlString(options: options))
+        }
+    }
+    
+    private func writeContent(to writer: XMLWriter) -> Void {
         if kind == .comment {
-            result += "<!--"
+            writer.write("<!--")
             if let stringValue = stringValue {
-                result += stringValue
+                writer.write(stringValue)
             } else {
-                result += " "
+                writer.write(" ")
             }
-            result += "-->"
+            writer.write("-->")
         } else if kind == .text {
             if let stringValue = stringValue {
-                result += XMLEscapedString(stringValue, document: self.rootDocument, kind: kind)
+                writer.writeEscaped(stringValue, kind: kind)
             }
         }
-        
-        return result
+    }
+    
+    public func xmlData(options: XMLNode.Options = []) -> Data {
+        let writer = XMLWriter()
+        write(to: writer, options: options)
+        return writer.data
+    }
+    
+    public func write(to fileHandle: FileHandle, options: XMLNode.Options = []) throws -> Void {
+        let writer = XMLWriter(fileHandle: fileHandle)
+        write(to: writer, options: options)
+        try writer.flush()
+    }
+    
+    public func write(to outputStream: OutputStream, options: XMLNode.Options = []) throws -> Void {
+        let writer = XMLWriter(outputStream: outputStream)
+        write(to: writer, options: options)
+        try writer.flush()
     }
     
     public func canonicalXMLString(preservingComments comments: Bool) -> String {
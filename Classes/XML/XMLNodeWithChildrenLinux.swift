@@ -36,6 +36,8 @@ import Foundation
 protocol XMLNodeWithChildren {
     
     func manipulateChildren(_: (inout [XMLNode]?) -> Void) -> Void
+    /// Like `manipulateChildren(_:)`, but promises not to modify the children, so implementors can keep state derived from them, such as indexes, across the call.
+    func readChildren(_: ([XMLNode]?) -> Void) -> Void
     
     var children : [XMLNode]? { get set }
     var childCount : Int { get }
@@ -51,6 +53,12 @@ protocol XMLNodeWithChildren {
 
 extension XMLNodeWithChildren {
     
+    public func readChildren(_ block: ([XMLNode]?) -> Void) -> Void {
+        manipulateChildren { (children) in
+            block(children)
+        }
+    }
+    
     // Beacuse we also have to call this from XMLNode
     internal func set(children newValue: [XMLNode]?) -> Void {
         manipulateChildren { (children) in
@@ -76,7 +84,7 @@ extension XMLNodeWithChildren {
     public var chlidren : [XMLNode]? {
         get {
             var result: [XMLNode]? = nil
-            manipulateChildren { (children) in
+            readChildren { (children) in
                 result = children
             }
             return result
@@ -88,7 +96,7 @@ extension XMLNodeWithChildren {
     
     public var childCount : Int {
         var index: Int = 0
-        manipulateChildren { (children) in
+        readChildren { (children) in
             index = children?.count ?? 0
         }
         return index
@@ -96,7 +104,7 @@ extension XMLNodeWithChildren {
     
     public func index(ofChild child: XMLNode) -> Int? {
         var index : Int? = nil
-        manipulateChildren { (children) in
+        readChildren { (children) in
             index = children?.firstIndex(where: { $0 === child })
         }
         return index
@@ -105,7 +113,7 @@ extension XMLNodeWithChildren {
     public func child(at index: Int) -> XMLNode? {
         var child : XMLNode? = nil
         
-        manipulateChildren { (children) in
+        readChildren { (children) in
             child = children?[index]
         }
         
@@ -189,7 +197,7 @@ extension XMLNodeWithChildren {
     public func copyChildren() -> [XMLNode]? {
         var newChildren : [XMLNode]? = nil
         
-        manipulateChildren { (children) in
+        readChildren { (children) in
             newChildren = children?.map({ (child) -> XMLNode in
                 let newChild = child.copy() as! XMLNode
                 newChild.parent = self as? XMLNode
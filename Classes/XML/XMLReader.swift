@@ -94,30 +94,84 @@ internal var XMLParserErrorHandler : xmlTextReaderErrorFunc = { (arg, messageIn,
     }
 }
 
+internal let XMLReaderLoggingDomain = AJRLoggingDomain("XMLReader")
+
+/// What a single parse cost, gathered as the reader runs and logged to the `XMLReader` domain at debug level when it closes.
+internal struct XMLReaderStatistics {
+    
+    /// The number of input bytes libxml2 has consumed.
+    var bytesConsumed : Int = 0
+    /// The number of nodes returned by `read()`.
+    var nodesRead : Int = 0
+    /// Wall clock time from creating the reader to closing it.
+    var duration : TimeInterval = 0
+    
+}
+
 internal class XMLReader : XMLParserDelegate {
     
     var reader : xmlTextReaderPtr?
-    var unsafeData : UnsafeMutablePointer<Int8>? // A pointer to the data passed to us.
     var delegate : XMLParserDelegate? = nil
+    private let source : String
+    private let startTime : Date
+    private(set) var statistics = XMLReaderStatistics()
     
-    internal init?(withData data: Data, baseURL: URL? = nil, encoding: String? = "utf8", options: Int = 0, delegate: XMLParserDelegate? = nil) {
-        let count = data.count
-        self.unsafeData = UnsafeMutablePointer<Int8>.allocate(capacity: data.count)
-        self.unsafeData?.withMemoryRebound(to: UInt8.self, capacity: count) { retypedData in
-            data.copyBytes(to: retypedData, count: count)
-        }
+    private static func parseOptions(_ options: Int) -> Int32 {
+        return Int32(options | Int(XML_PARSE_RECOVER.rawValue))
+    }
+    
+    private init?(reader: xmlTextReaderPtr?, source: String, delegate: XMLParserDelegate?) {
+        self.startTime = Date()
+        self.source = source
         self.delegate = delegate
-        self.reader = xmlReaderForMemory(self.unsafeData, Int32(count), baseURL?.absoluteString, encoding, Int32(options | Int(XML_PARSE_RECOVER.rawValue)))
-        print("\(xmlTextReaderGetParserProp(self.reader, Int32(XML_PARSER_SUBST_ENTITIES.rawValue)))")
+        self.reader = reader
         if let reader = reader {
-            xmlTextReaderSetErrorHandler(reader, XMLParserErrorHandler, Unmanaged.passRetained(self).toOpaque())
+            // Unretained, because the libxml2 reader never outlives us. We free it in close() or deinit.
+            xmlTextReaderSetErrorHandler(reader, XMLParserErrorHandler, Unmanaged.passUnretained(self).toOpaque())
         } else {
             return nil
         }
     }
     
     deinit {
-        unsafeData?.deallocate()
+        if let reader = reader {
+            xmlFreeTextReader(reader)
+        }
+    }
+    
+    /**
+     Parses directly out of `bytes` without copying them. The caller must keep `bytes` valid until the reader is closed, which is what `withReader(for:baseURL:encoding:options:delegate:_:)` arranges, so prefer that.
+     */
+    internal convenience init?(withBytes bytes: UnsafeRawBufferPointer, baseURL: URL? = nil, encoding: String? = "utf8", options: Int = 0, delegate: XMLParserDelegate? = nil) {
+        let pointer = bytes.baseAddress?.assumingMemoryBound(to: Int8.self)
+        self.init(reader: xmlReaderForMemory(pointer, Int32(bytes.count), baseURL?.absoluteString, encoding, XMLReader.parseOptions(options)), source: baseURL?.absoluteString ?? "memory", delegate: delegate)
+    }
+    
+    /// Parses from an open file descriptor, letting libxml2 read it incrementally. The descriptor isn't closed when the reader is.
+    internal convenience init?(withFileDescriptor fileDescriptor: Int32, baseURL: URL? = nil, encoding: String? = nil, options: Int = 0, delegate: XMLParserDelegate? = nil) {
+        self.init(reader: xmlReaderForFd(fileDescriptor, baseURL?.absoluteString, encoding, XMLReader.parseOptions(options)), source: baseURL?.absoluteString ?? "fd \(fileDescriptor)", delegate: delegate)
+    }
+    
+    /// Parses the file at `url`, which must be a file URL, without loading it into memory first.
+    internal convenience init?(withURL url: URL, encoding: String? = nil, options: Int = 0, delegate: XMLParserDelegate? = nil) {
+        if !url.isFileURL {
+            return nil
+        }
+        self.init(reader: xmlReaderForFile(url.path, encoding, XMLReader.parseOptions(options)), source: url.path, delegate: delegate)
+    }
+    
+    /// Creates a reader over `data` and calls `body` with it while the data's bytes are pinned, so nothing is copied. The reader is closed when `body` returns. Returns `nil` if the reader couldn't be created.
+    @discardableResult
+    internal static func withReader<Result>(for data: Data, baseURL: URL? = nil, encoding: String? = "utf8", options: Int = 0, delegate: XMLParserDelegate? = nil, _ body: (XMLReader) throws -> Result) rethrows -> Result? {
+        return try data.withUnsafeBytes { (bytes) -> Result? in
+            guard let reader = XMLReader(withBytes: bytes, baseURL: baseURL, encoding: encoding, options: options, delegate: delegate) else {
+                return nil
+            }
+            defer {
+                reader.close()
+            }
+            return try body(reader)
+        }
     }
     
     func read() -> Bool {
@@ -125,7 +179,11 @@ internal class XMLReader : XMLParserDelegate {
 //        if result < 0 {
 //            print("hard failure: \(result)")
 //        }
-        return result == 1
+        if result == 1 {
+            statistics.nodesRead += 1
+            return true
+        }
+        return false
     }
     
     var nodeType : XMLNodeType {
@@ -175,7 +233,15 @@ internal class XMLReader : XMLParserDelegate {
     }
     
     func close() -> Void {
-        xmlTextReaderClose(reader)
+        if let reader = reader {
+            let consumed = xmlTextReaderByteConsumed(reader)
+            statistics.bytesConsumed = consumed > 0 ? Int(consumed) : 0
+            statistics.duration = Date().timeIntervalSince(startTime)
+            xmlTextReaderClose(reader)
+            xmlFreeTextReader(reader)
+            self.reader = nil
+            AJRLog.debug(in: XMLReaderLoggingDomain, "Parsed \(source): \(statistics.bytesConsumed) bytes, \(statistics.nodesRead) nodes in \(String(format: "%.3f", statistics.duration * 1000.0))ms")
+        }
     }
     
     func parser(reader: xmlTextReaderLocatorPtr, parseErrorOccurred error: String?) {
@@ -59,51 +59,10 @@ internal extension String {
     
 }
 
-internal var xmlSpecials : CharacterSet = {
-    return CharacterSet(charactersIn: "<>&\"'")
-}()
-
 internal func XMLEscapedString(_ string:String, document : XMLDocument?, kind : XMLNode.Kind) -> String {
-    var newString = ""
-    var range: Range<String.Index>?
-    var searchRange: Range<String.Index> = Range(uncheckedBounds: (lower: string.startIndex, upper: string.endIndex))
-    repeat {
-        range = string.rangeOfCharacter(from: xmlSpecials, options: .caseInsensitive, range: searchRange)
-        if let range = range {
-            newString += string[searchRange.lowerBound ..< range.lowerBound]
-            for character in string[range] {
-                switch character {
-                case "\"":
-                    if kind == .text {
-                        newString += "\""
-                    } else {
-                        newString += "&quot;"
-                    }
-                case "'":
-                    if kind == .text || kind == .attribute {
-                        newString += "'"
-                    } else {
-                        newString += "&apos;"
-                    }
-                case "<":
-                    newString += "&lt;"
-                case ">":
-                    newString += "&gt;"
-                case "&":
-                    newString += "&amp;"
-                default:
-                    newString += String(character)
-                }
-            }
-            searchRange = Range(uncheckedBounds: (lower: range.upperBound, upper: string.endIndex))
-        }
-    } while range != nil && range!.lowerBound < string.endIndex
-
-    if searchRange.lowerBound < string.endIndex {
-        newString += string[searchRange.lowerBound ..< string.endIndex]
-    }
-    
-    return newString
+    let writer = XMLWriter(capacity: string.utf8.count + 16)
+    writer.writeEscaped(string, kind: kind)
+    return writer.string
 }
 
 internal func XMLStringForEntity(rawEntity: String, document: XMLDocument?) throws -> String? {
@@ -191,16 +150,14 @@ internal func XMLStringByResolvingEntities(input string: String, document: XMLDo
 }
 
 internal func XMLParseDTDNode(from data:Data) throws -> xmlDtdPtr? {
-    var dtd : xmlDtdPtr?
-    let unsafeData = UnsafeMutablePointer<Int8>.allocate(capacity: data.count)
-    unsafeData.withMemoryRebound(to: UInt8.self, capacity: data.count) { retypedData in
-        data.copyBytes(to: retypedData, count: data.count)
-    }
-
-    if let buf = xmlParserInputBufferCreateMem(unsafeData, Int32(data.count), XML_CHAR_ENCODING_NONE) {
-        dtd = xmlIOParseDTD(nil, buf, XML_CHAR_ENCODING_NONE);
+    // The DTD is completely parsed before we return, so we can hand libxml2 the data's own bytes, rather than a copy.
+    return data.withUnsafeBytes { (bytes) -> xmlDtdPtr? in
+        var dtd : xmlDtdPtr?
+        if let buf = xmlParserInputBufferCreateMem(bytes.baseAddress?.assumingMemoryBound(to: Int8.self), Int32(bytes.count), XML_CHAR_ENCODING_NONE) {
+            dtd = xmlIOParseDTD(nil, buf, XML_CHAR_ENCODING_NONE);
+        }
+        return dtd
     }
-    return dtd
 }
 
 internal extension UnsafeMutablePointer where Pointee == xmlNode {
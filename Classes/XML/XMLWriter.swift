@@ -0,0 +1,219 @@
+/*
+ XMLWriter.swift
+ AJRFoundation
+
+ Copyright © 2023, AJ Raftis and AJRFoundation authors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of AJRFoundation nor the names of its contributors may be
+   used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL AJ RAFTIS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#if os(Linux) || os(iOS) || os(tvOS) || os(watchOS)
+
+import Foundation
+
+/**
+ Accumulates serialized XML as UTF-8 bytes.
+
+ A writer either collects everything into its buffer, which you can then fetch as `data` or `string`, or it's created with a sink, in which case it hands its buffer to the sink whenever it fills, so a document of any size can be written using a fixed amount of memory. The buffer is kept between uses, so a writer can be `reset()` and reused without reallocating.
+
+ Writing methods don't throw, since they're called all the way down the node tree. Instead, the first error raised by a sink is remembered, further output is dropped, and the error is rethrown by `flush()`.
+ */
+public final class XMLWriter {
+
+    public typealias Sink = (UnsafeRawBufferPointer) throws -> Void
+
+    private var buffer : [UInt8]
+    private let sink : Sink?
+    private let bufferSize : Int
+    public private(set) var error : Error? = nil
+    /// The last byte written, which lets pretty printing check for a trailing newline without looking back through the output.
+    public private(set) var lastByte : UInt8? = nil
+    /// The total number of bytes written since the writer was created or last reset, including any already handed to the sink.
+    public var byteCount : Int {
+        return flushedCount + buffer.count
+    }
+    private var flushedCount : Int = 0
+
+    /// Used by XMLElement to carry the pretty printing depth down the tree, so that it only has to walk up to the root once per serialization.
+    internal var elementDepth : Int? = nil
+
+    private static let spaces = [UInt8](repeating: UInt8(ascii: " "), count: 256)
+
+    public init(capacity: Int = 16 * 1024) {
+        self.buffer = [UInt8]()
+        self.buffer.reserveCapacity(capacity)
+        self.bufferSize = capacity
+        self.sink = nil
+    }
+
+    public init(bufferSize: Int = 64 * 1024, sink: @escaping Sink) {
+        self.buffer = [UInt8]()
+        self.buffer.reserveCapacity(bufferSize)
+        self.bufferSize = bufferSize
+        self.sink = sink
+    }
+
+    public convenience init(fileHandle: FileHandle, bufferSize: Int = 64 * 1024) {
+        self.init(bufferSize: bufferSize) { bytes in
+            let data = Data(bytes)
+            if #available(iOS 13.4, tvOS 13.4, watchOS 6.2, *) {
+                try fileHandle.write(contentsOf: data)
+            } else {
+                fileHandle.write(data)
+            }
+        }
+    }
+
+    public convenience init(outputStream: OutputStream, bufferSize: Int = 64 * 1024) {
+        self.init(bufferSize: bufferSize) { bytes in
+            guard var pointer = bytes.bindMemory(to: UInt8.self).baseAddress else { return }
+            var remaining = bytes.count
+            while remaining > 0 {
+                let written = outputStream.write(pointer, maxLength: remaining)
+                if written <= 0 {
+                    throw outputStream.streamError ?? XMLError.generic("Failed to write to output stream.")
+                }
+                pointer += written
+                remaining -= written
+            }
+        }
+    }
+
+    // MARK: - Output
+
+    /// The bytes written so far. When the writer has a sink, this is only what hasn't been flushed yet.
+    public var data : Data {
+        return Data(buffer)
+    }
+
+    public var string : String {
+        return String(decoding: buffer, as: UTF8.self)
+    }
+
+    /// Empties the buffer, but keeps its storage for the next document.
+    public func reset() -> Void {
+        buffer.removeAll(keepingCapacity: true)
+        flushedCount = 0
+        lastByte = nil
+        error = nil
+        elementDepth = nil
+    }
+
+    public func flush() throws -> Void {
+        if let sink = sink, buffer.count > 0 {
+            // Once the sink has failed, we just discard output, so we don't buffer the rest of the document for nothing.
+            if error == nil {
+                do {
+                    try buffer.withUnsafeBytes { bytes in
+                        try sink(bytes)
+                    }
+                } catch {
+                    self.error = error
+                }
+            }
+            flushedCount += buffer.count
+            buffer.removeAll(keepingCapacity: true)
+        }
+        if let error = error {
+            throw error
+        }
+    }
+
+    private func flushIfNeeded() -> Void {
+        if sink != nil && buffer.count >= bufferSize {
+            try? flush()
+        }
+    }
+
+    // MARK: - Writing
+
+    public func write(_ byte: UInt8) -> Void {
+        buffer.append(byte)
+        lastByte = byte
+        flushIfNeeded()
+    }
+
+    public func write(_ string: String) -> Void {
+        if let last = string.utf8.last {
+            buffer.append(contentsOf: string.utf8)
+            lastByte = last
+            flushIfNeeded()
+        }
+    }
+
+    /// Writes `count` spaces from a preallocated run, rather than building a padding string for each line.
+    public func writeIndent(_ count: Int) -> Void {
+        var remaining = count
+        while remaining > 0 {
+            let chunk = min(remaining, XMLWriter.spaces.count)
+            buffer.append(contentsOf: XMLWriter.spaces[0 ..< chunk])
+            remaining -= chunk
+        }
+        if count > 0 {
+            lastByte = UInt8(ascii: " ")
+            flushIfNeeded()
+        }
+    }
+
+    /// Writes `string` with XML's special characters replaced by entities. Quotes are only escaped where `kind` requires it. This makes a single pass over the string's UTF-8, copying unescaped runs in bulk.
+    public func writeEscaped(_ string: String, kind: XMLNode.Kind) -> Void {
+        var string = string
+        string.withUTF8 { bytes in
+            var runStart = 0
+            for index in 0 ..< bytes.count {
+                let replacement : StaticString
+                switch bytes[index] {
+                case UInt8(ascii: "<"):
+                    replacement = "&lt;"
+                case UInt8(ascii: ">"):
+                    replacement = "&gt;"
+                case UInt8(ascii: "&"):
+                    replacement = "&amp;"
+                case UInt8(ascii: "\"") where kind != .text:
+                    replacement = "&quot;"
+                case UInt8(ascii: "'") where kind != .text && kind != .attribute:
+                    replacement = "&apos;"
+                default:
+                    continue
+                }
+                if runStart < index {
+                    buffer.append(contentsOf: UnsafeBufferPointer(rebasing: bytes[runStart ..< index]))
+                }
+                replacement.withUTF8Buffer { buffer.append(contentsOf: $0) }
+                runStart = index + 1
+            }
+            if runStart < bytes.count {
+                buffer.append(contentsOf: UnsafeBufferPointer(rebasing: bytes[runStart ..< bytes.count]))
+            }
+            if !bytes.isEmpty {
+                lastByte = buffer.last
+            }
+        }
+        flushIfNeeded()
+    }
+
+}
+
+#endif
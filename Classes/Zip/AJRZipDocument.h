@@ -38,7 +38,7 @@
 
 #import <Cocoa/Cocoa.h>
 
-@class AJRZipEntry, AJRZipEntryView, AJRZipFileBuffer;
+@class AJRZipEntry, AJRZipEntryReader, AJRZipEntryView, AJRZipFileBuffer;
 
 extern NSString * const AJRZipErrorDomain;
 
@@ -60,5 +60,7 @@ extern NSString * const AJRZipErrorDomain;
 
 - (AJRZipEntry *)entryForPath:(NSString *)path;
 - (NSData *)dataForEntry:(AJRZipEntry *)entry error:(NSError **)error;
+/*! Returns a reader that can fetch arbitrary byte ranges of the entry's uncompressed contents without loading the whole entry. Only stored and deflated entries are supported. */
+- (AJRZipEntryReader *)readerForEntry:(AJRZipEntry *)entry error:(NSError **)error;
 
 @end
@@ -39,6 +39,7 @@
 #import "AJRZipDocument.h"
 
 #import "AJRZipEntry.h"
+#import "AJRZipEntryReader.h"
 #import "AJRZipFileBuffer.h"
 
 #import <zlib.h>
@@ -105,11 +106,27 @@ NSString * const AJRZipErrorDomain = @"AJRZipErrorDomain";
 
 /* Document reading methods */
 
+- (AJRZipEntry *)_directoryEntryForPath:(NSString *)path
+{
+    // Directories are registered in _entriesByPath as they're created, so finding an entry's parent is a single hash lookup, and we only walk up the path for directories we haven't seen yet.
+    AJRZipEntry *directoryEntry = [_entriesByPath objectForKey:path];
+    if (!directoryEntry) {
+        directoryEntry = [[AJRZipEntry alloc] initWithPath:path headerOffset:0 CRC:0 compressedSize:0 uncompressedSize:0 compressionType:0];
+        [[self _directoryEntryForPath:[directoryEntry parentDirectoryPath]] addChildEntry:directoryEntry];
+        [_entriesByPath setObject:directoryEntry forKey:path];
+        [directoryEntry release];
+    }
+    return directoryEntry;
+}
+
 - (void)_addEntries:(NSArray *)array
 {
     for (AJRZipEntry *entry in array) {
-        [entry addToRootEntry:_rootEntry];
-        [_entriesByPath setObject:entry forKey:[entry path]];
+        NSString *path = [entry path];
+        // Archives may list a directory explicitly after we've already implied it from one of its children. Keep the first one, so the tree doesn't end up with two copies of the directory.
+        if (![entry isLeaf] && [_entriesByPath objectForKey:path]) continue;
+        [[self _directoryEntryForPath:[entry parentDirectoryPath]] addChildEntry:entry];
+        [_entriesByPath setObject:entry forKey:path];
         //PagesPrintf(@"added path: %@\n", [entry path]);
     }
 }
@@ -275,52 +292,67 @@ static inline uint32_t _crcFromData(NSData *data)
     return [_entriesByPath objectForKey:path];
 }
 
+- (BOOL)_getDataOffset:(unsigned long long *)dataOffset forEntry:(AJRZipEntry *)zipEntry
+{
+    // Validates the entry's local file header and locates its data, which follows the header's variable length name and extra fields.
+    unsigned long long  length = [fileBuffer fileLength];
+    uint16_t            compression = [zipEntry compressionType],
+                        namelen,
+                        extralen;
+    uint32_t            csize = [zipEntry compressedSize],
+                        usize = [zipEntry uncompressedSize],
+                        headeridx = [zipEntry headerOffset],
+                        dataidx;
+
+    if (headeridx < length && headeridx + FILE_HEADER_LENGTH > headeridx && headeridx + FILE_HEADER_LENGTH < length && csize > 0 && usize > 0 && [fileBuffer littleUnsignedIntAtOffset:headeridx] == FILE_ENTRY_TAG && [fileBuffer littleUnsignedShortAtOffset:headeridx + 8] == compression) {
+        namelen = [fileBuffer littleUnsignedShortAtOffset:headeridx + 26];
+        extralen = [fileBuffer littleUnsignedShortAtOffset:headeridx + 28];
+        dataidx = headeridx + FILE_HEADER_LENGTH + namelen + extralen;
+
+        if (dataidx < length && dataidx + csize > dataidx && dataidx + csize > headeridx && dataidx + csize < length) {
+            if (dataOffset) *dataOffset = dataidx;
+            return YES;
+        }
+    }
+    return NO;
+}
+
 - (NSData *)dataForEntry:(AJRZipEntry *)zipEntry error:(NSError **)error
 {
     // This method is called in the background to uncompress an individual zip entry and write it to disk as a result of a drag
-    unsigned long long    length = [fileBuffer fileLength];
-    uint16_t            compression = [zipEntry compressionType], 
-                        namelen, 
-                        extralen;
+    uint16_t            compression = [zipEntry compressionType];
     uint32_t            crcval = [zipEntry CRC], 
                         csize = [zipEntry compressedSize], 
-                        usize = [zipEntry uncompressedSize], 
-                        headeridx = [zipEntry headerOffset], 
-                        dataidx;
+                        usize = [zipEntry uncompressedSize];
+    unsigned long long  dataidx;
     NSData                *compressedData = nil, *uncompressedData = nil;
     NSMutableData        *mutableData = nil;
     NSError                *localError = nil;
     z_stream            stream;
     
-    if (headeridx < length && headeridx + FILE_HEADER_LENGTH > headeridx && headeridx + FILE_HEADER_LENGTH < length && csize > 0 && usize > 0 && [fileBuffer littleUnsignedIntAtOffset:headeridx] == FILE_ENTRY_TAG && [fileBuffer littleUnsignedShortAtOffset:headeridx + 8] == compression) {
-        namelen = [fileBuffer littleUnsignedShortAtOffset:headeridx + 26];
-        extralen = [fileBuffer littleUnsignedShortAtOffset:headeridx + 28];
-        dataidx = headeridx + FILE_HEADER_LENGTH + namelen + extralen;
-        
-        if (dataidx < length && dataidx + csize > dataidx && dataidx + csize > headeridx && dataidx + csize < length) {
-            // Currently this is all done in memory, but it could potentially be done block-by-block as a stream
-            compressedData = [fileBuffer dataAtOffset:dataidx length:csize];
-            if (0 == compression && compressedData && [compressedData length] == csize && usize == csize && _crcFromData(compressedData) == crcval) {
-                // If the entry is stored uncompressed, we write it out verbatim
-                uncompressedData = compressedData;
-            } else if (8 == compression && compressedData && [compressedData length] == csize && usize / 64 < csize) {
-                // If the entry is stored deflated, we inflate it and write out the results
-                mutableData = [NSMutableData dataWithLength:usize];
-                bzero(&stream, sizeof(stream));
-                stream.next_in = (Bytef *)[compressedData bytes];
-                stream.avail_in = [compressedData length];
-                stream.next_out = (Bytef *)[mutableData mutableBytes];
-                stream.avail_out = usize;
-                
-                if (mutableData && Z_OK == inflateInit2(&stream, -15)) {
-                    if (Z_STREAM_END == inflate(&stream, Z_FINISH)) {
-                        if (Z_OK == inflateEnd(&stream) && usize == stream.total_out && _crcFromData(mutableData) == crcval) uncompressedData = mutableData;
-                    } else {
-                        (void)inflateEnd(&stream);
-                    }
+    if ([self _getDataOffset:&dataidx forEntry:zipEntry]) {
+        // Currently this is all done in memory, but it could potentially be done block-by-block as a stream
+        compressedData = [fileBuffer dataAtOffset:dataidx length:csize];
+        if (0 == compression && compressedData && [compressedData length] == csize && usize == csize && _crcFromData(compressedData) == crcval) {
+            // If the entry is stored uncompressed, we write it out verbatim
+            uncompressedData = compressedData;
+        } else if (8 == compression && compressedData && [compressedData length] == csize && usize / 64 < csize) {
+            // If the entry is stored deflated, we inflate it and write out the results
+            mutableData = [NSMutableData dataWithLength:usize];
+            bzero(&stream, sizeof(stream));
+            stream.next_in = (Bytef *)[compressedData bytes];
+            stream.avail_in = [compressedData length];
+            stream.next_out = (Bytef *)[mutableData mutableBytes];
+            stream.avail_out = usize;
+            
+            if (mutableData && Z_OK == inflateInit2(&stream, -15)) {
+                if (Z_STREAM_END == inflate(&stream, Z_FINISH)) {
+                    if (Z_OK == inflateEnd(&stream) && usize == stream.total_out && _crcFromData(mutableData) == crcval) uncompressedData = mutableData;
                 } else {
-                    uncompressedData = nil;
+                    (void)inflateEnd(&stream);
                 }
+            } else {
+                uncompressedData = nil;
             }
         }
     }
@@ -333,4 +365,18 @@ static inline uint32_t _crcFromData(NSData *data)
     return uncompressedData;
 }
 
+- (AJRZipEntryReader *)readerForEntry:(AJRZipEntry *)zipEntry error:(NSError **)error
+{
+    unsigned long long dataidx;
+    uint16_t compression = [zipEntry compressionType];
+
+    if ([self _getDataOffset:&dataidx forEntry:zipEntry] && (0 == compression || 8 == compression)) {
+        return [[[AJRZipEntryReader alloc] initWithDocument:self fileBuffer:fileBuffer entry:zipEntry dataOffset:dataidx] autorelease];
+    }
+    if (error) {
+        *error = [NSError errorWithDomain:NSCocoaErrorDomain code:NSFileReadCorruptFileError userInfo:[NSDictionary dictionaryWithObjectsAndKeys:documentURL, NSURLErrorKey, nil]];
+    }
+    return nil;
+}
+
 @end
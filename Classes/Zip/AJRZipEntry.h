@@ -42,7 +42,10 @@
 {
     NSString        *name;
     NSString        *leadingPath;
+    NSString        *path;
     NSMutableArray  *childEntries;
+    NSMutableDictionary *childDirectoriesByName;
+    BOOL            childEntriesNeedSorting;
     uint32_t        headerOffset;
     uint32_t        CRC;
     uint32_t        compressedSize;
@@ -59,7 +62,14 @@
 
 @property (readonly) NSString *name;
 @property (readonly) NSString *path;
+/*! The path of the directory containing the receiver, without a trailing slash. */
+@property (readonly) NSString *leadingPath;
+/*! The path of the directory entry containing the receiver, in the same form as that entry's path. */
+@property (readonly) NSString *parentDirectoryPath;
+/*! The receiver's children, sorted by name. Sorting is deferred until this is called after a mutation. */
 @property (readonly) NSArray *childEntries;
+/*! The receiver's children in the order they were added. Cheaper than childEntries when order doesn't matter. */
+@property (readonly) NSArray *unsortedChildEntries;
 @property (readonly) uint32_t headerOffset;
 @property (readonly) uint32_t CRC;
 @property (readonly) uint32_t compressedSize;
@@ -45,15 +45,24 @@
     return [[self alloc] initWithPath:@"/" headerOffset:0 CRC:0 compressedSize:0 uncompressedSize:0 compressionType:0];
 }
 
-- (id)initWithPath:(NSString *)path headerOffset:(uint32_t)headeridx CRC:(uint32_t)crcval compressedSize:(uint32_t)csize uncompressedSize:(uint32_t)usize compressionType:(uint16_t)compression
+- (id)initWithPath:(NSString *)aPath headerOffset:(uint32_t)headeridx CRC:(uint32_t)crcval compressedSize:(uint32_t)csize uncompressedSize:(uint32_t)usize compressionType:(uint16_t)compression
 {
     self = [super init];
     if (self) {
-        isLeaf = ([path hasSuffix:@"/"] && compressedSize == 0) ? NO : YES;
-        path = [@"/" stringByAppendingPathComponent:path];
-        name = [[path lastPathComponent] copy];
-        leadingPath = [[path stringByDeletingLastPathComponent] copy];
-        if (!isLeaf) childEntries = [[NSMutableArray alloc] init];
+        isLeaf = ([aPath hasSuffix:@"/"] && csize == 0) ? NO : YES;
+        aPath = [@"/" stringByAppendingPathComponent:aPath];
+        name = [[aPath lastPathComponent] copy];
+        leadingPath = [[aPath stringByDeletingLastPathComponent] copy];
+        // The full path is requested for every entry as it's indexed, so build it once here rather than on each access.
+        if ([aPath isEqualToString:@"/"]) {
+            path = @"/";
+        } else {
+            path = isLeaf ? [aPath copy] : [[aPath stringByAppendingString:@"/"] retain];
+        }
+        if (!isLeaf) {
+            childEntries = [[NSMutableArray alloc] init];
+            childDirectoriesByName = [[NSMutableDictionary alloc] init];
+        }
         headerOffset = headeridx;
         CRC = crcval;
         compressedSize = csize;
@@ -63,13 +72,25 @@
     return self;
 }
 
-- (NSString *)path
+@synthesize path;
+@synthesize leadingPath;
+
+- (NSString *)parentDirectoryPath
 {
-    NSString *path = [leadingPath stringByAppendingPathComponent:name];
-    return isLeaf ? path : [path stringByAppendingString:@"/"];
+    return [leadingPath isEqualToString:@"/"] ? @"/" : [leadingPath stringByAppendingString:@"/"];
 }
 
 - (NSArray *)childEntries
+{
+    // Sorting on every insert makes building a large directory O(n^2 log n), so we only sort when someone actually asks for the ordered children.
+    if (childEntriesNeedSorting) {
+        [childEntries sortUsingSelector:@selector(compare:)];
+        childEntriesNeedSorting = NO;
+    }
+    return childEntries;
+}
+
+- (NSArray *)unsortedChildEntries
 {
     return childEntries;
 }
@@ -91,19 +112,16 @@
 {
     if (!childEntries) return NO;
     [childEntries addObject:entry];
-    [childEntries sortUsingSelector:@selector(compare:)];
+    childEntriesNeedSorting = [childEntries count] > 1;
+    if (![entry isLeaf] && ![childDirectoriesByName objectForKey:[entry name]]) {
+        [childDirectoriesByName setObject:entry forKey:[entry name]];
+    }
     return YES;
 }
 
 - (AJRZipEntry *)childDirectoryEntryWithName:(NSString *)str createIfNotPresent:(BOOL)flag
 {
-    AJRZipEntry *childEntry = nil;
-    for (AJRZipEntry *entry in childEntries) {
-        if ([[entry name] isEqualToString:str] && ![entry isLeaf]) {
-            childEntry = (AJRZipEntry *)entry;
-            break;
-        }
-    }
+    AJRZipEntry *childEntry = [childDirectoriesByName objectForKey:str];
     if (!childEntry && flag && !isLeaf) {
         childEntry = [[AJRZipEntry alloc] initWithPath:[[[self path] stringByAppendingPathComponent:str] stringByAppendingString:@"/"] headerOffset:0 CRC:0 compressedSize:0 uncompressedSize:0 compressionType:0];
         [self addChildEntry:childEntry];
@@ -0,0 +1,69 @@
+/*
+ AJRZipEntryReader.h
+ AJRFoundation
+
+ Copyright © 2023, AJ Raftis and AJRFoundation authors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of AJRFoundation nor the names of its contributors may be
+   used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL AJ RAFTIS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import <Cocoa/Cocoa.h>
+
+@class AJRZipDocument, AJRZipEntry, AJRZipFileBuffer;
+
+/*!
+ Provides pread(2) style random access to the uncompressed contents of a single zip entry.
+
+ Stored entries map directly onto the archive file, so any range can be read at the cost of a single read. Deflated entries have to be inflated from a point where the decompressor's state is known. By default that's the start of the entry, but when buildsCheckpointIndex is enabled, the reader records the inflater's state (the bit position and the previous 32K of output) at deflate block boundaries roughly every checkpointSpacing bytes as it passes through the entry. Later seeks then resume from the nearest checkpoint at or before the target, rather than from the start.
+
+ Reads aren't CRC checked, since a random read doesn't see the whole entry. Use -[AJRZipDocument dataForEntry:error:] if you need the data validated. A reader isn't thread safe, but separate readers on the same document may be used concurrently.
+ */
+@interface AJRZipEntryReader : NSObject
+
+- (id)initWithDocument:(AJRZipDocument *)document fileBuffer:(AJRZipFileBuffer *)fileBuffer entry:(AJRZipEntry *)entry dataOffset:(unsigned long long)dataOffset;
+
+@property (readonly) AJRZipEntry *entry;
+/*! The uncompressed length of the entry. */
+@property (readonly) unsigned long long length;
+/*! YES when the entry is stored, in which case reads go straight to the archive file. */
+@property (readonly) BOOL isStored;
+
+/*! When YES, deflated entries record checkpoints while they're inflated. Defaults to NO. */
+@property (nonatomic,assign) BOOL buildsCheckpointIndex;
+/*! The minimum number of uncompressed bytes between checkpoints. Defaults to 1MB. Each checkpoint costs a little over 32K of memory. */
+@property (nonatomic,assign) NSUInteger checkpointSpacing;
+/*! The number of checkpoints recorded so far. */
+@property (readonly) NSUInteger checkpointCount;
+
+/*!
+ Copies up to length bytes starting at offset into buffer. Returns the number of bytes copied, which is only less than length when the read extends past the end of the entry, or -1 on error.
+ */
+- (NSInteger)readBytes:(void *)buffer length:(NSUInteger)length atOffset:(unsigned long long)offset error:(NSError **)error;
+- (NSData *)dataOfLength:(NSUInteger)length atOffset:(unsigned long long)offset error:(NSError **)error;
+
+/*! Inflates the whole entry once, recording checkpoints as it goes. Does nothing for stored entries. */
+- (BOOL)buildCheckpointIndex:(NSError **)error;
+
+@end
@@ -0,0 +1,314 @@
+/*
+ AJRZipEntryReader.m
+ AJRFoundation
+
+ Copyright © 2023, AJ Raftis and AJRFoundation authors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of AJRFoundation nor the names of its contributors may be
+   used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL AJ RAFTIS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import "AJRZipEntryReader.h"
+
+#import "AJRZipDocument.h"
+#import "AJRZipEntry.h"
+#import "AJRZipFileBuffer.h"
+
+#import <zlib.h>
+
+#define WINDOW_SIZE                 32768
+#define INPUT_CHUNK                 16384
+#define DEFAULT_CHECKPOINT_SPACING  (1024 * 1024)
+
+typedef struct _ajrZipCheckpoint {
+    unsigned long long  uncompressedOffset;
+    unsigned long long  compressedOffset;
+    int                 bits;
+    uint8_t             partialByte;
+    uint8_t             window[WINDOW_SIZE];
+} AJRZipCheckpoint;
+
+@implementation AJRZipEntryReader
+{
+    AJRZipDocument      *_document;
+    AJRZipFileBuffer    *_fileBuffer;
+    unsigned long long  _dataOffset;
+    unsigned long long  _compressedLength;
+
+    // Inflater state for deflated entries. _window is circular: output byte n lives at _window[n % WINDOW_SIZE], so it always holds the last 32K of output, which is both what we copy reads from and what a checkpoint needs to save.
+    z_stream            _stream;
+    BOOL                _streamActive;
+    BOOL                _streamFinished;
+    unsigned long long  _inOffset;
+    unsigned long long  _outOffset;
+    uint8_t             *_input;
+    uint8_t             *_window;
+
+    AJRZipCheckpoint    *_checkpoints;
+    NSUInteger          _checkpointCount;
+    NSUInteger          _checkpointCapacity;
+}
+
+- (id)initWithDocument:(AJRZipDocument *)document fileBuffer:(AJRZipFileBuffer *)fileBuffer entry:(AJRZipEntry *)entry dataOffset:(unsigned long long)dataOffset
+{
+    self = [super init];
+    if (self) {
+        // We retain the document, because it closes the file buffer when it's deallocated.
+        _document = [document retain];
+        _fileBuffer = [fileBuffer retain];
+        _entry = [entry retain];
+        _dataOffset = dataOffset;
+        _compressedLength = [entry compressedSize];
+        _length = [entry uncompressedSize];
+        _isStored = [entry compressionType] == 0;
+        _checkpointSpacing = DEFAULT_CHECKPOINT_SPACING;
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    if (_streamActive) (void)inflateEnd(&_stream);
+    free(_input);
+    free(_window);
+    free(_checkpoints);
+    [_entry release];
+    [_fileBuffer release];
+    [_document release];
+
+    [super dealloc];
+}
+
+@synthesize entry = _entry;
+@synthesize length = _length;
+@synthesize isStored = _isStored;
+@synthesize buildsCheckpointIndex = _buildsCheckpointIndex;
+@synthesize checkpointSpacing = _checkpointSpacing;
+
+- (NSUInteger)checkpointCount
+{
+    return _checkpointCount;
+}
+
+- (NSError *)_corruptEntryError
+{
+    return [NSError errorWithDomain:NSCocoaErrorDomain code:NSFileReadCorruptFileError userInfo:[NSDictionary dictionaryWithObjectsAndKeys:[_entry path], NSFilePathErrorKey, nil]];
+}
+
+/* Inflater management */
+
+- (BOOL)_resetToCheckpoint:(AJRZipCheckpoint *)checkpoint
+{
+    if (_streamActive) {
+        (void)inflateEnd(&_stream);
+        _streamActive = NO;
+    }
+    if (!_input) _input = malloc(INPUT_CHUNK);
+    if (!_window) _window = calloc(1, WINDOW_SIZE);
+    if (!_input || !_window) return NO;
+
+    bzero(&_stream, sizeof(_stream));
+    if (Z_OK != inflateInit2(&_stream, -15)) return NO;
+    _streamActive = YES;
+    _streamFinished = NO;
+
+    if (checkpoint) {
+        NSUInteger position = checkpoint->uncompressedOffset % WINDOW_SIZE;
+
+        _inOffset = checkpoint->compressedOffset;
+        _outOffset = checkpoint->uncompressedOffset;
+        // The checkpoint lies part way through a byte, so feed the inflater the bits it hadn't consumed yet.
+        if (checkpoint->bits && Z_OK != inflatePrime(&_stream, checkpoint->bits, checkpoint->partialByte >> (8 - checkpoint->bits))) return NO;
+        if (Z_OK != inflateSetDictionary(&_stream, checkpoint->window, WINDOW_SIZE)) return NO;
+        // Restore the circular window, so reads just before the checkpoint can be served from it.
+        memcpy(_window + position, checkpoint->window, WINDOW_SIZE - position);
+        memcpy(_window, checkpoint->window + WINDOW_SIZE - position, position);
+    } else {
+        _inOffset = 0;
+        _outOffset = 0;
+    }
+    return YES;
+}
+
+- (void)_recordCheckpoint
+{
+    AJRZipCheckpoint *checkpoint;
+    NSUInteger position = _outOffset % WINDOW_SIZE;
+    unsigned long long consumed = _inOffset - _stream.avail_in;
+
+    if (_checkpointCount == _checkpointCapacity) {
+        NSUInteger capacity = _checkpointCapacity ? _checkpointCapacity * 2 : 8;
+        AJRZipCheckpoint *checkpoints = realloc(_checkpoints, capacity * sizeof(AJRZipCheckpoint));
+        if (!checkpoints) return;
+        _checkpoints = checkpoints;
+        _checkpointCapacity = capacity;
+    }
+    checkpoint = &_checkpoints[_checkpointCount++];
+    checkpoint->uncompressedOffset = _outOffset;
+    checkpoint->compressedOffset = consumed;
+    checkpoint->bits = _stream.data_type & 7;
+    checkpoint->partialByte = 0;
+    if (checkpoint->bits) {
+        if (_stream.next_in > _input) {
+            checkpoint->partialByte = _stream.next_in[-1];
+        } else {
+            (void)[_fileBuffer readBytes:&checkpoint->partialByte length:1 atOffset:_dataOffset + consumed - 1];
+        }
+    }
+    // Before the first 32K of output this includes some of the zeroed window, which is harmless, since nothing can refer back past the start of the stream.
+    memcpy(checkpoint->window, _window + position, WINDOW_SIZE - position);
+    memcpy(checkpoint->window + WINDOW_SIZE - position, _window, position);
+}
+
+- (AJRZipCheckpoint *)_checkpointForOffset:(unsigned long long)offset
+{
+    // Checkpoints are recorded in increasing order, so binary search for the last one at or before offset.
+    NSUInteger low = 0, high = _checkpointCount;
+    while (low < high) {
+        NSUInteger middle = (low + high) / 2;
+        if (_checkpoints[middle].uncompressedOffset <= offset) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low > 0 ? &_checkpoints[low - 1] : NULL;
+}
+
+- (BOOL)_positionForOffset:(unsigned long long)offset
+{
+    AJRZipCheckpoint *checkpoint = [self _checkpointForOffset:offset];
+    unsigned long long windowStart = _outOffset > WINDOW_SIZE ? _outOffset - WINDOW_SIZE : 0;
+
+    if (_streamActive) {
+        // We can continue from where we are if the target is in the window or still ahead of us, unless a checkpoint gets us meaningfully closer.
+        if (offset >= windowStart && (!checkpoint || checkpoint->uncompressedOffset <= _outOffset || offset < _outOffset)) return YES;
+    }
+    return [self _resetToCheckpoint:checkpoint];
+}
+
+- (BOOL)_inflateInto:(uint8_t *)buffer length:(NSUInteger)length atOffset:(unsigned long long)offset
+{
+    unsigned long long end = offset + length;
+    unsigned long long windowStart = _outOffset > WINDOW_SIZE ? _outOffset - WINDOW_SIZE : 0;
+    unsigned long long lastCheckpoint = _checkpointCount ? _checkpoints[_checkpointCount - 1].uncompressedOffset : 0;
+
+    // First, copy anything that's already sitting in the window.
+    for (unsigned long long index = MAX(offset, windowStart); index < MIN(end, _outOffset); index++) {
+        buffer[index - offset] = _window[index % WINDOW_SIZE];
+    }
+
+    while (_outOffset < end) {
+        NSUInteger position = _outOffset % WINDOW_SIZE;
+        unsigned long long produceStart = _outOffset;
+        uInt availableIn;
+        int status;
+
+        if (_streamFinished) return NO;
+        if (_stream.avail_in == 0 && _inOffset < _compressedLength) {
+            NSUInteger chunk = (NSUInteger)MIN((unsigned long long)INPUT_CHUNK, _compressedLength - _inOffset);
+            NSInteger count = [_fileBuffer readBytes:_input length:chunk atOffset:_dataOffset + _inOffset];
+            if (count <= 0) return NO;
+            _stream.next_in = _input;
+            _stream.avail_in = (uInt)count;
+            _inOffset += count;
+        }
+        // Once the input is exhausted, inflate() may still be holding output it couldn't fit in the window last time, so keep calling it with avail_in == 0 until it either finishes or stops making progress.
+        availableIn = _stream.avail_in;
+        _stream.next_out = _window + position;
+        _stream.avail_out = (uInt)(WINDOW_SIZE - position);
+        // Z_BLOCK makes inflate() return at each deflate block boundary, which are the only places we can checkpoint.
+        status = inflate(&_stream, _buildsCheckpointIndex ? Z_BLOCK : Z_NO_FLUSH);
+        if (status == Z_NEED_DICT || status == Z_DATA_ERROR || status == Z_MEM_ERROR || status == Z_BUF_ERROR) return NO;
+        if (status != Z_STREAM_END && _stream.avail_out == WINDOW_SIZE - position && _stream.avail_in == availableIn) return NO;
+        _outOffset += (WINDOW_SIZE - position) - _stream.avail_out;
+        if (status == Z_STREAM_END) _streamFinished = YES;
+
+        for (unsigned long long index = MAX(offset, produceStart); index < MIN(end, _outOffset); index++) {
+            buffer[index - offset] = _window[index % WINDOW_SIZE];
+        }
+
+        if (_buildsCheckpointIndex && !_streamFinished && (_stream.data_type & 128) && !(_stream.data_type & 64) && _outOffset >= lastCheckpoint + _checkpointSpacing) {
+            [self _recordCheckpoint];
+            lastCheckpoint = _outOffset;
+        }
+    }
+    return YES;
+}
+
+/* Reading */
+
+- (NSInteger)readBytes:(void *)buffer length:(NSUInteger)length atOffset:(unsigned long long)offset error:(NSError **)error
+{
+    BOOL success;
+
+    if (offset >= _length) return 0;
+    if (length > _length - offset) length = (NSUInteger)(_length - offset);
+    if (length == 0) return 0;
+
+    if (_isStored) {
+        success = [_fileBuffer readBytes:buffer length:length atOffset:_dataOffset + offset] == (NSInteger)length;
+    } else {
+        success = [self _positionForOffset:offset] && [self _inflateInto:buffer length:length atOffset:offset];
+        if (!success && _streamActive) {
+            // Leave the inflater in a known state for the next read.
+            (void)inflateEnd(&_stream);
+            _streamActive = NO;
+        }
+    }
+    if (!success) {
+        if (error) *error = [self _corruptEntryError];
+        return -1;
+    }
+    return length;
+}
+
+- (NSData *)dataOfLength:(NSUInteger)length atOffset:(unsigned long long)offset error:(NSError **)error
+{
+    NSMutableData *data = [NSMutableData dataWithLength:offset < _length ? MIN((unsigned long long)length, _length - offset) : 0];
+    NSInteger count = [data length] ? [self readBytes:[data mutableBytes] length:[data length] atOffset:offset error:error] : 0;
+    return count < 0 ? nil : data;
+}
+
+- (BOOL)buildCheckpointIndex:(NSError **)error
+{
+    BOOL saved = _buildsCheckpointIndex;
+    BOOL success = YES;
+    uint8_t byte;
+
+    if (_isStored || _length == 0) return YES;
+
+    // Inflate through the whole entry once. Reads that land on the last byte drag the inflater all the way to the end, and the checkpoints fall out along the way.
+    _buildsCheckpointIndex = YES;
+    if ([self _resetToCheckpoint:_checkpointCount ? &_checkpoints[_checkpointCount - 1] : NULL]) {
+        success = [self readBytes:&byte length:1 atOffset:_length - 1 error:error] == 1;
+    } else {
+        success = NO;
+        if (error) *error = [self _corruptEntryError];
+    }
+    _buildsCheckpointIndex = saved;
+    return success;
+}
+
+@end
@@ -53,5 +53,7 @@
 - (uint16_t)littleUnsignedShortAtOffset:(unsigned long long)offset;
 - (uint32_t)littleUnsignedIntAtOffset:(unsigned long long)offset;
 - (NSData *)dataAtOffset:(unsigned long long)offset length:(NSUInteger)length;
+/*! Reads directly from the file with pread(2), bypassing both the cache and the file handle's offset. Returns the number of bytes read, or -1 on error. */
+- (NSInteger)readBytes:(void *)buffer length:(NSUInteger)length atOffset:(unsigned long long)offset;
 
 @end
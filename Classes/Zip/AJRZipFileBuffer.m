@@ -38,6 +38,8 @@
 
 #import "AJRZipFileBuffer.h"
 
+#import <unistd.h>
+
 #define FILE_BUFFER_QUANTUM 512
 
 @implementation AJRZipFileBuffer 
@@ -162,4 +164,24 @@
     return data;
 }
 
+- (NSInteger)readBytes:(void *)buffer length:(NSUInteger)length atOffset:(unsigned long long)offset
+{
+    NSInteger total = 0;
+    int fd;
+
+    if (!fileHandle) return -1;
+    fd = [fileHandle fileDescriptor];
+    while (length > 0) {
+        ssize_t count = pread(fd, buffer + total, length, (off_t)(offset + total));
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (count == 0) break;
+        total += count;
+        length -= count;
+    }
+    return total;
+}
+
 @end